@@ -15,6 +15,7 @@
 #include "common/renesas.hpp"
 #include "common/cmt_mgr.hpp"
 #include "common/sci_io.hpp"
+#include "common/rtos_stream.hpp"
 #include "common/format.hpp"
 #include "common/command.hpp"
 #include "common/spi_io2.hpp"
@@ -58,7 +59,7 @@ namespace {
 
 	// マスターバッファはでサービスできる時間間隔を考えて余裕のあるサイズとする（8192）
 	// DMAC でループ転送できる最大数の２倍（1024）
-	typedef sound::sound_out<int16_t, 8192, 1024> SOUND_OUT;
+	typedef sound::sound_out<int16_t, 8192, 1024, utils::stream_fifo<sound::wave_t<int16_t>, 8192>> SOUND_OUT;
 	static constexpr int16_t ZERO_LEVEL = 0x8000;
 
 	#define USE_DAC
@@ -66,7 +67,7 @@ namespace {
 #elif defined(SIG_RX71M)
 	// マスターバッファはでサービスできる時間間隔を考えて余裕のあるサイズとする（8192）
 	// DMAC でループ転送できる最大数の２倍（1024）
-	typedef sound::sound_out<int16_t, 8192, 1024> SOUND_OUT;
+	typedef sound::sound_out<int16_t, 8192, 1024, utils::stream_fifo<sound::wave_t<int16_t>, 8192>> SOUND_OUT;
 	static constexpr int16_t ZERO_LEVEL = 0x8000;
 
 	#define USE_DAC
@@ -81,7 +82,7 @@ namespace {
 
 	// マスターバッファはでサービスできる時間間隔を考えて余裕のあるサイズとする（8192）
 	// DMAC でループ転送できる最大数の２倍（1024）
-	typedef sound::sound_out<int16_t, 8192, 1024> SOUND_OUT;
+	typedef sound::sound_out<int16_t, 8192, 1024, utils::stream_fifo<sound::wave_t<int16_t>, 8192>> SOUND_OUT;
 	static constexpr int16_t ZERO_LEVEL = 0x8000;
 
 	#define USE_DAC
@@ -99,7 +100,7 @@ namespace {
 
 	// マスターバッファはサービスできる時間間隔を考えて余裕のあるサイズとする（8192）
 	// SSIE の FIFO サイズの２倍以上（1024）
-	typedef sound::sound_out<int16_t, 8192, 1024> SOUND_OUT;
+	typedef sound::sound_out<int16_t, 8192, 1024, utils::stream_fifo<sound::wave_t<int16_t>, 8192>> SOUND_OUT;
 	static constexpr int16_t ZERO_LEVEL = 0x0000;
 
 	#define USE_SSIE
@@ -118,24 +119,26 @@ namespace {
 	SDC		sdc_(sdc_spi_, 20'000'000);
 
 	// D/A 出力では、無音出力は、中間電圧とする。
-	typedef sound::sound_out<int16_t, 8192, 1024> SOUND_OUT;
+	typedef sound::sound_out<int16_t, 8192, 1024, utils::stream_fifo<sound::wave_t<int16_t>, 8192>> SOUND_OUT;
 	static constexpr int16_t ZERO_LEVEL = 0x8000;
 
 	#define USE_DAC
 
 #endif
 
-	typedef utils::fixed_fifo<char, 1024> RECV_BUFF;
-	typedef utils::fixed_fifo<char, 2048> SEND_BUFF;
+	// 受信、送信待ちは、タスク通知で行う
+	typedef utils::stream_fifo<char, 1024> RECV_BUFF;
+	typedef utils::stream_fifo<char, 2048> SEND_BUFF;
 	typedef device::sci_io<board_profile::SCI_CH, RECV_BUFF, SEND_BUFF, board_profile::SCI_ORDER> SCI;
 	SCI			sci_;
 
 	typedef device::cmt_mgr<board_profile::CMT_CH> CMT;
 	CMT			cmt_;
 
-	SemaphoreHandle_t	putch_sync_;
-	SemaphoreHandle_t	puts_sync_;
-	SemaphoreHandle_t	getch_sync_;
+	// 出力の排他制御（入力はメイン・タスクだけが行う）
+	SemaphoreHandle_t	sci_sync_;
+
+	TaskHandle_t		codec_task_handle_;
 
 	// コマンドライン
 	typedef utils::command<256> CMD;
@@ -244,7 +247,7 @@ namespace {
 	void start_audio_()
 	{
 		auto dmac_intl = device::ICU::LEVEL::_4;
-		auto mtu_intl  = device::ICU::LEVEL::_5;
+		auto mtu_intl  = device::ICU::LEVEL::_5;  // FIFO の通知は DMAC 割り込みから行う
 		if(dac_stream_.start(48'000, dmac_intl, mtu_intl)) {
 			utils::format("Start D/A Stream\n");
 		} else {
@@ -260,7 +263,7 @@ namespace {
 	void start_audio_()
 	{
 		{  // SSIE 設定 RX72N Envision kit では、I2S, 48KHz, 32/16 ビットフォーマット固定
-			auto intr = device::ICU::LEVEL::_5;
+			auto intr = device::ICU::LEVEL::_5;  // FIFO の通知は無し、デコーダーはタイムアウト（10ms）で空きを見る
 			uint32_t aclk = 24'576'000;
 			uint32_t lrclk = 48'000;
 			auto ret = ssie_io_.start(aclk, lrclk, SSIE_IO::BFORM::I2S_32, intr);
@@ -338,26 +341,24 @@ extern "C" {
 
 	void sci_putch(char ch)
 	{
-		xSemaphoreTake(putch_sync_, (TickType_t)0 );
+		xSemaphoreTake(sci_sync_, portMAX_DELAY);
         sci_.putch(ch);
-		xSemaphoreGive(putch_sync_);
+		xSemaphoreGive(sci_sync_);
 	}
 
 
 	void sci_puts(const char* str)
 	{
-		xSemaphoreTake(puts_sync_, (TickType_t)0 );
+		xSemaphoreTake(sci_sync_, portMAX_DELAY);
         sci_.puts(str);
-		xSemaphoreGive(puts_sync_);
+		xSemaphoreGive(sci_sync_);
 	}
 
 
 	char sci_getch(void)
 	{
-		xSemaphoreTake(getch_sync_, (TickType_t)0 );
-        auto ch = sci_.getch();
-		xSemaphoreGive(getch_sync_);
-        return ch;
+		// 受信が無ければ、RXI 割り込みからの通知を待つ
+        return sci_.getch();
 	}
 
 
@@ -468,7 +469,8 @@ extern "C" {
 			}
 			codec_mgr_.service();
 
-			vTaskDelay(10 / portTICK_PERIOD_MS);
+			// ファイル名が送られたら、すぐに起きる
+			ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
 		}
 	}
 
@@ -493,6 +495,7 @@ extern "C" {
 				// オーディオ・タスクに、ファイル名を送る。
 				strncpy(name_t_.filename_, gui_.get_filename(), sizeof(name_t_.filename_));
 				name_t_.put_++;
+				xTaskNotifyGive(codec_task_handle_);
 			}
 			if(audio_t != audio_t_) {
 				gui_.render_time(audio_t_, codec_mgr_.get_audio_info().total_second);
@@ -518,9 +521,7 @@ int main(int argc, char** argv)
 	SYSTEM_IO::boost_master_clock();
 
 	{  // SCI 設定
-		putch_sync_ = xSemaphoreCreateBinary();
-		puts_sync_  = xSemaphoreCreateBinary();
-		getch_sync_ = xSemaphoreCreateBinary();
+		sci_sync_ = xSemaphoreCreateMutex();
 		auto sci_level = device::ICU::LEVEL::_2;
 		sci_.start(115200, sci_level);
 	}
@@ -535,7 +536,7 @@ int main(int argc, char** argv)
         uint32_t stack_size = 4096;
         void* param = nullptr;
         uint32_t prio = 2;
-        xTaskCreate(codec_task_, "Codec", stack_size, param, prio, nullptr);
+        xTaskCreate(codec_task_, "Codec", stack_size, param, prio, &codec_task_handle_);
     }
 
     {
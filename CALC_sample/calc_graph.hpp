@@ -4,28 +4,81 @@
     @brief  グラフ 関数電卓・クラス @n
 			calc_graph
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2021 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2021, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
+#include <cmath>
+#include "common/vtx.hpp"
+#include "graphics/color.hpp"
 
 namespace app {
 
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
     /*!
-        @brief  CALC Graph クラス
+        @brief  CALC Graph クラス @n
+				式は一度だけコンパイルし、x の列をまとめて評価する。
+		@param[in]	RENDER	レンダラー型
+		@param[in]	ARITH	数式解析型
+		@param[in]	NVAL	数値型
     */
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class RENDER, class ARITH, class NVAL>
     class calc_graph {
+	public:
+		static constexpr uint32_t SAMPLE_MAX = 480;	///< サンプルの最大数
+		static constexpr uint32_t CHUNK = 16;		///< 一度に評価する要素数
+		static constexpr int16_t  STEP = 2;			///< サンプル間隔（ピクセル）
+
+	private:
+		typedef graphics::def_color DEF_COLOR;
+
+		RENDER&		render_;
+		ARITH&		arith_;
+
+		float		ys_[SAMPLE_MAX];
+		bool		valid_[SAMPLE_MAX];
+
+		template <class T>
+		static double get_(const T& v) noexcept { return v.get_double(); }
+		static double get_(float v) noexcept { return v; }
+		static double get_(double v) noexcept { return v; }
+
+		// x の列を、CHUNK 個ずつ評価
+		template <class NAME>
+		uint32_t eval_(const typename ARITH::code_t& code, NAME var, double xmin, double xmax, uint32_t n) noexcept
+		{
+			uint32_t cnt = 0;
+			for(uint32_t i = 0; i < n; i += CHUNK) {
+				uint32_t k = (n - i) > CHUNK ? CHUNK : (n - i);
+				NVAL src[CHUNK];
+				NVAL dst[CHUNK];
+				bool ok[CHUNK];
+				for(uint32_t j = 0; j < k; ++j) {
+					src[j] = NVAL(xmin + (xmax - xmin) * static_cast<double>(i + j) / static_cast<double>(n - 1));
+				}
+				arith_.run(code, var, src, dst, k, ok);
+				for(uint32_t j = 0; j < k; ++j) {
+					auto y = ok[j] ? get_(dst[j]) : 0.0;
+					valid_[i + j] = ok[j] && std::isfinite(y);
+					ys_[i + j] = y;
+					if(valid_[i + j]) ++cnt;
+				}
+			}
+			return cnt;
+		}
 
 	public:
 		//-------------------------------------------------------------//
 		/*!
 			@brief  graph コンストラクタ
+			@param[in]	render	レンダラー
+			@param[in]	arith	数式解析
 		*/
 		//-------------------------------------------------------------//
-		calc_graph() noexcept
+		calc_graph(RENDER& render, ARITH& arith) noexcept :
+			render_(render), arith_(arith), ys_{ }, valid_{ }
         { }
 
 
@@ -37,5 +90,72 @@ namespace app {
         void start() noexcept
         {
         }
+
+
+		//-------------------------------------------------------------//
+		/*!
+			@brief  グラフの描画 @n
+					シンボル「var」に x を与えて評価し、y は自動でスケールする。
+			@param[in]	code	コンパイル済みコード
+			@param[in]	var		x を与えるシンボル
+			@param[in]	area	描画領域
+			@param[in]	xmin	x の最小値
+			@param[in]	xmax	x の最大値
+			@return 描画した点の数
+		*/
+		//-------------------------------------------------------------//
+		template <class NAME>
+		uint32_t plot(const typename ARITH::code_t& code, NAME var, const vtx::srect& area,
+			double xmin, double xmax) noexcept
+		{
+			render_.set_fore_color(DEF_COLOR::Black);
+			render_.fill_box(area);
+
+			uint32_t n = area.size.x / STEP + 1;
+			if(n > SAMPLE_MAX) n = SAMPLE_MAX;
+			if(n < 2 || !(xmax > xmin)) return 0;
+
+			auto cnt = eval_(code, var, xmin, xmax, n);
+			if(cnt == 0) return 0;
+
+			float ymin = 0.0f;
+			float ymax = 0.0f;
+			bool first = true;
+			for(uint32_t i = 0; i < n; ++i) {
+				if(!valid_[i]) continue;
+				if(first || ys_[i] < ymin) ymin = ys_[i];
+				if(first || ys_[i] > ymax) ymax = ys_[i];
+				first = false;
+			}
+			if((ymax - ymin) < 1e-6f) {
+				ymin -= 1.0f;
+				ymax += 1.0f;
+			}
+
+			auto h = area.size.y - 1;
+			auto ypos = [=](float y) {
+				return static_cast<int16_t>(area.org.y + h - static_cast<int16_t>((y - ymin) * h / (ymax - ymin)));
+			};
+
+			// 軸
+			render_.set_fore_color(DEF_COLOR::Gray);
+			if(xmin <= 0.0 && 0.0 <= xmax) {
+				auto x = static_cast<int16_t>(area.org.x + (-xmin) * (area.size.x - 1) / (xmax - xmin));
+				render_.line_v(x, area.org.y, area.size.y);
+			}
+			if(ymin <= 0.0f && 0.0f <= ymax) {
+				render_.line_h(ypos(0.0f), area.org.x, area.size.x);
+			}
+
+			// 連続した有効な点を結ぶ
+			render_.set_fore_color(DEF_COLOR::Yellow);
+			for(uint32_t i = 1; i < n; ++i) {
+				if(!valid_[i - 1] || !valid_[i]) continue;
+				vtx::spos org(area.org.x + (i - 1) * STEP, ypos(ys_[i - 1]));
+				vtx::spos end(area.org.x + i * STEP, ypos(ys_[i]));
+				render_.line(org, end);
+			}
+			return cnt;
+		}
     };
 }
@@ -34,6 +34,7 @@
 #include "common/mpfr.hpp"
 #include "calc_func.hpp"
 #include "calc_symbol.hpp"
+#include "calc_graph.hpp"
 
 #include "resource.hpp"
 
@@ -67,6 +68,9 @@ namespace app {
 		static constexpr uint32_t LCD_ORG = 0x0000'0100;
 		typedef device::PORT<device::PORT0, device::bitpos::B7> FT5206_RESET;
 		typedef device::sci_i2c_io<device::SCI6, RB64, SB64, device::port_map::ORDER::FIRST> FT5206_I2C;
+		// FT5206 INT 端子: P02(IRQ10)
+		static constexpr auto FT5206_INT = device::ICU::VECTOR::IRQ10;
+		static constexpr auto FT5206_INT_ORDER = device::port_map::ORDER::SECOND;
 		typedef device::glcdc_mgr<device::GLCDC, LCD_X, LCD_Y, PIX> GLCDC;
 
 #elif defined(SIG_RX72N)
@@ -75,6 +79,9 @@ namespace app {
 		static constexpr uint32_t LCD_ORG = 0x0080'0000;
 		typedef device::PORT<device::PORT6, device::bitpos::B6> FT5206_RESET;
 		typedef device::sci_i2c_io<device::SCI6, RB64, SB64, device::port_map::ORDER::SECOND> FT5206_I2C;
+		// FT5206 INT 端子: P34(IRQ4)
+		static constexpr auto FT5206_INT = device::ICU::VECTOR::IRQ4;
+		static constexpr auto FT5206_INT_ORDER = device::port_map::ORDER::THIRD;
 		typedef device::glcdc_mgr<device::GLCDC, LCD_X, LCD_Y, PIX> GLCDC;
 #endif
 
@@ -126,6 +133,10 @@ namespace app {
 				vtx::spos	pos;
 			};
 
+			struct gesture_t {
+				vtx::spos	pos;
+			};
+
 		private:
 			touch_t	touch_[4];
 			uint32_t	num_;
@@ -140,6 +151,14 @@ namespace app {
 				return touch_[idx];
 			}
 
+			uint32_t get_point_num() const { return num_; }
+
+			const auto& get_point(uint32_t idx) const { return get_touch_pos(idx); }
+
+			const auto& get_primary() const { return touch_[0]; }
+
+			bool get_gesture(gesture_t& /* g */) { return false; }
+
 			void update() { }
 
 			void set_pos(const vtx::spos& pos)
@@ -153,8 +172,27 @@ namespace app {
 		typedef touch_emu TOUCH;
 #endif
 		TOUCH	touch_;
-		// RX65N Envision Kit: INT to P02(IRQ10), not use
-		// RX72N Envision Kit: INT to P34(IRQ4), not use
+#ifndef EMU
+		// FT5206 INT 端子の割り込み（新しいタッチ情報毎にパルス）
+		static INTERRUPT_FUNC void ft5206_intr_()
+		{
+			TOUCH::notify();
+		}
+
+		static bool start_ft5206_intr_(device::ICU::LEVEL lvl)
+		{
+			if(!device::port_map_irq::turn(FT5206_INT, true, FT5206_INT_ORDER)) {
+				return false;
+			}
+#if defined(SIG_RX65N)
+			device::ICU::IRQCR10.IRQMD = 0b01;  // 立下りエッジ
+#elif defined(SIG_RX72N)
+			device::ICU::IRQCR4.IRQMD = 0b01;  // 立下りエッジ
+#endif
+			device::icu_mgr::set_interrupt(FT5206_INT, ft5206_intr_, lvl);
+			return true;
+		}
+#endif
 
 		typedef gui::simple_dialog<RENDER, TOUCH> DIALOG;
 		DIALOG	dialog_;
@@ -243,6 +281,11 @@ namespace app {
 
 		typedef utils::basic_arith<NVAL, SYMBOL, FUNC> ARITH;
 		ARITH	arith_;
+		ARITH::code_t	code_;
+
+		typedef calc_graph<RENDER, ARITH, NVAL> GRAPH;
+		GRAPH	graph_;
+		bool	graph_on_;
 
 		typedef utils::fixed_string<256> STR;
 		STR			cbackup_;
@@ -277,6 +320,7 @@ namespace app {
 			}
 			symbol_idx_ = 0;
 			shift_ = 0;
+			graph_on_ = false;
 		}
 
 		typedef utils::fixed_string<512> OUTSTR;
@@ -351,6 +395,15 @@ namespace app {
 		{
 			if(cbuff_pos_ == cbuff_.size()) return;
 
+			if(graph_on_) {  // グラフを消して、入力中の式を描き直す
+				graph_on_ = false;
+				render_.set_fore_color(DEF_COLOR::Darkgray);
+				render_.round_box(vtx::srect(0, 0, 480, 16 * 5 + 6), 8);
+				cur_pos_.set(0);
+				cbuff_pos_ = 0;
+				del_len_ = 0;
+			}
+
 			if(cbuff_pos_ > cbuff_.size()) {
 				if(del_len_ > 0) {
 					auto x = cur_pos_.x - del_len_;
@@ -439,7 +492,7 @@ namespace app {
 			while(nest_ > 0) { cbuff_ += ')'; nest_--; }
 			update_calc_();
 
-			auto ok = arith_.analize(cbuff_.c_str());
+			auto ok = arith_.compile(cbuff_.c_str(), code_) && arith_.run(code_);
 			auto ans = arith_();
 			symbol_.set_value(SYMBOL::NAME::ANS, ans);
 			draw_ans_(ans, ok);
@@ -462,6 +515,18 @@ namespace app {
 		}
 
 
+		// 最後の式を、選択中のシンボルを x としてグラフ表示
+		void plot_()
+		{
+			if(cbackup_.empty()) return;
+			if(!arith_.compile(cbackup_.c_str(), code_)) return;
+
+			auto var = static_cast<SYMBOL::NAME>(static_cast<uint32_t>(SYMBOL::NAME::V0) + symbol_idx_);
+			graph_.plot(code_, var, vtx::srect(4, 4, 480 - 8, 16 * 5 + 6 - 8), -10.0, 10.0);
+			graph_on_ = true;
+		}
+
+
 		void update_fc_()
 		{
 			if(fc_mode_) {
@@ -540,12 +605,12 @@ namespace app {
 			pin_(vtx::srect(LOC_X(2), LOC_Y(3), BTN_W, BTN_H), "（"),
 			pot_(vtx::srect(LOC_X(3), LOC_Y(3), BTN_W, BTN_H), "）"),
 
-			setup_   (vtx::srect(LOC_X(0), LOC_Y(2), BTN_W, BTN_H), "＠"),
+			setup_   (vtx::srect(LOC_X(0), LOC_Y(2), BTN_W, BTN_H), "Plot"),
 			sym_     (vtx::srect(LOC_X(1), LOC_Y(0), BTN_W, BTN_H), "V0"),
 			sym_in_  (vtx::srect(LOC_X(1), LOC_Y(1), BTN_W, BTN_H), "Min"),
 			sym_out_ (vtx::srect(LOC_X(1), LOC_Y(2), BTN_W, BTN_H), "Rcl"),
 
-			symbol_(), func_(), arith_(symbol_, func_),
+			symbol_(), func_(), arith_(symbol_, func_), code_(), graph_(render_, arith_), graph_on_(false),
 			cbackup_(), cbuff_(), cbuff_pos_(0), del_len_(0), cur_pos_(0),
 			fc_mode_(false), nest_(0), symbol_idx_(0), shift_(0)
 		{ }
@@ -633,7 +698,11 @@ namespace app {
 				if(!ft5206_i2c_.start(FT5206_I2C::MODE::MASTER, FT5206_I2C::SPEED::STANDARD, intr_lvl)) {
 					utils::format("FT5206 I2C Start Fail...\n");
 				}
-				if(!touch_.start()) {
+				auto intr = start_ft5206_intr_(intr_lvl);
+				if(!intr) {
+					utils::format("FT5206 INT Start Fail...\n");
+				}
+				if(!touch_.start(intr)) {
 					utils::format("FT5206 Start Fail...\n");
 				}
 			}
@@ -894,9 +963,10 @@ namespace app {
 				}
 			};
 
-			setup_.set_layer(WIDGET::LAYER::_0);  // 設定
+			setup_.set_layer(WIDGET::LAYER::_0);  // グラフ
 			setup_.set_base_color(graphics::def_color::SafeColor);
 			setup_.at_select_func() = [=](uint32_t id) {
+				plot_();
 			};
 			sym_.set_layer(WIDGET::LAYER::_0);  // シンボル変更
 			sym_.set_base_color(graphics::def_color::SafeColor);
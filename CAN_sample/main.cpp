@@ -320,10 +320,10 @@ namespace {
 				if(!cmd_.get_integer(1, val, false)) {
 					error = true;
 				} else {
-					analize_.list(val);
+					analize_.list(val, true);
 				}				
 			} else {
-				analize_.list_all();
+				analize_.list_all(true);
 			}
 		} else if(cmd_.cmp_word(0, "clear")) {
 			if(cmdn >= 2) {
@@ -349,6 +349,35 @@ namespace {
 			} else {
 				error = true;
 			}
+		} else if(cmd_.cmp_word(0, "capture")) {
+			if(cmdn >= 2 && cmd_.cmp_word(1, "free")) {
+				analize_.start_capture(ANALIZE::CAPTURE::FREE);
+			} else if(cmdn >= 3 && cmd_.cmp_word(1, "trig")) {
+				uint32_t id = 0;
+				int32_t post = 128;
+				if(!get_cmd_id_(2, id)) {
+					error = true;
+				} else if(cmdn >= 4 && !cmd_.get_integer(3, post, false)) {
+					error = true;
+				} else {
+					analize_.start_capture(ANALIZE::CAPTURE::TRIGGER, id, 0x1fff'ffff, post);
+				}
+			} else if(cmdn >= 2 && cmd_.cmp_word(1, "stop")) {
+				analize_.stop_capture();
+			} else if(cmdn == 1) {
+				static const char* mode[] = { "stop", "free", "trigger" };
+				utils::format("Capture: %s, %u frames\n")
+					% mode[static_cast<uint32_t>(analize_.get_capture_mode())]
+					% analize_.get_capture_num();
+			} else {
+				error = true;
+			}
+		} else if(cmd_.cmp_word(0, "export")) {
+			auto fmt = ANALIZE::EXPORT::CANDUMP;
+			if(cmdn >= 2 && cmd_.cmp_word(1, "asc")) {
+				fmt = ANALIZE::EXPORT::ASC;
+			}
+			analize_.export_capture(fmt, [](const char* line) { utils::format("%s") % line; });
 		} else if(cmd_.cmp_word(0, "send_loop")) {
 			if(cmdn >= 2) {
 				int32_t val;
@@ -383,6 +412,9 @@ namespace {
 			utils::format("    clear [CAN-ID]         clear map\n");
 			utils::format("    map [CAN-ID]           Display all collected IDs\n");
 			utils::format("    dump CAN-ID            dump frame data\n");
+			utils::format("    capture [free/stop]    capture frames (free running/stop)\n");
+			utils::format("    capture trig CAN-ID [post] capture frames, stop after trigger\n");
+			utils::format("    export [asc]           output captured frames (candump/asc)\n");
 			utils::format("    send_loop NUM [-rtr]   random ID, random DATA, send loop (RTR)\n");
 			utils::format("    help                   command list (this)\n");
 			utils::format("\n");
@@ -32,6 +32,7 @@
 #include "common/fixed_fifo.hpp"
 #include "common/sci_io.hpp"
 #include "common/cmt_mgr.hpp"
+#include "common/scheduler.hpp"
 #include "common/command.hpp"
 
 #include "common/format.hpp"
@@ -50,6 +51,9 @@ namespace {
 	typedef device::cmt_mgr<board_profile::CMT_CH> CMT;
 	CMT		cmt_;
 
+	typedef utils::scheduler<4> SCHEDULER;
+	SCHEDULER	sch_;
+
 	const uint32_t PARAM_SIZE = 1024;
 	int32_t	parama_[PARAM_SIZE];
 	int32_t	paramb_[PARAM_SIZE];
@@ -168,18 +172,14 @@ int main(int argc, char** argv)
 		utils::format("CPU %d loops: ans = %d, (%u [ms])\n") % loop % a % (et - st); 
 	}
 
-	uint16_t cnt = 0;
+	// LED の点滅（250 ティック毎に反転、1000Hz で 2Hz）
+	auto led = sch_.add([]() { LED::P = !LED::P(); });
+	sch_.start(cmt_.get_counter());
+	sch_.start_timer(led, 250, 250);
+
 	while(1) {
 		cmt_.sync();
 
-		++cnt;
-		if(cnt >= (50 * 10)) {
-			cnt = 0;
-		}
-		if(cnt < (25 * 10)) {
-			LED::P = 0;
-		} else {
-			LED::P = 1;
-		}
+		sch_.service(cmt_.get_counter());
 	}
 }
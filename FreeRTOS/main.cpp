@@ -2,14 +2,14 @@
 /*! @file
     @brief  FreeRTOS sample（Flash LED, Output SCI）
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2018, 2022 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2018, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
 #include "common/renesas.hpp"
 
-#include "common/fixed_fifo.hpp"
+#include "common/rtos_stream.hpp"
 #include "common/sci_io.hpp"
 #include "common/cmt_mgr.hpp"
 
@@ -25,18 +25,15 @@ namespace {
 	typedef device::cmt_mgr<board_profile::CMT_CH> CMT;
 	CMT			cmt_;
 
-	typedef utils::fixed_fifo<char, 512> RXB;  // RX (RECV) バッファの定義
-	typedef utils::fixed_fifo<char, 256> TXB;  // TX (SEND) バッファの定義
+	// 受信、送信待ちは、割り込みからのタスク通知で行う（ポーリングしない）
+	typedef utils::stream_fifo<char, 512> RXB;  // RX (RECV) バッファの定義
+	typedef utils::stream_fifo<char, 256> TXB;  // TX (SEND) バッファの定義
 	typedef device::sci_io<board_profile::SCI_CH, RXB, TXB, board_profile::SCI_ORDER> SCI;
 	SCI			sci_;
 
 //  StaticSemaphore を使う場合、「configSUPPORT_STATIC_ALLOCATION」を「1」にする必要がある。
-//	StaticSemaphore_t	putch_semaphore_;
-	SemaphoreHandle_t	putch_sync_;
-//	StaticSemaphore_t	puts_semaphore_;
-	SemaphoreHandle_t	puts_sync_;
-//	StaticSemaphore_t	getch_semaphore_;
-	SemaphoreHandle_t	getch_sync_;
+//	StaticSemaphore_t	sci_semaphore_;
+	SemaphoreHandle_t	sci_sync_;  // 出力の排他制御（文字単位で混ざらないようにする）
 
 }
 
@@ -45,27 +42,25 @@ extern "C" {
 	// syscalls.c から呼ばれる、標準出力（stdout, stderr）
 	void sci_putch(char ch)
 	{
-		xSemaphoreTake(putch_sync_, (TickType_t)0 );  // ポーリング 
+		xSemaphoreTake(sci_sync_, portMAX_DELAY);
 		sci_.putch(ch);
-		xSemaphoreGive(putch_sync_);
+		xSemaphoreGive(sci_sync_);
 	}
 
 
 	void sci_puts(const char* str)
 	{
-		xSemaphoreTake(puts_sync_, (TickType_t)0 );  // ポーリング 
+		xSemaphoreTake(sci_sync_, portMAX_DELAY);
 		sci_.puts(str);
-		xSemaphoreGive(puts_sync_);
+		xSemaphoreGive(sci_sync_);
 	}
 
 
 	// syscalls.c から呼ばれる、標準入力（stdin）
 	char sci_getch(void)
 	{
-		xSemaphoreTake(getch_sync_, (TickType_t)0 );  // ポーリング
-		auto ch = sci_.getch();
-		xSemaphoreGive(getch_sync_);
-		return ch;
+		// 受信が無ければ、RXI 割り込みからの通知を待つ
+		return sci_.getch();
 	}
 
 
@@ -229,9 +224,7 @@ int main(int argc, char** argv)
 #endif
 
 	{  // SCI の開始
-		putch_sync_ = xSemaphoreCreateBinary();	// putch 排他制御のリソースを作成
-		puts_sync_  = xSemaphoreCreateBinary();	// puts  排他制御のリソースを作成
-		getch_sync_ = xSemaphoreCreateBinary();	// getch 排他制御のリソースを作成
+		sci_sync_ = xSemaphoreCreateMutex();	// 出力の排他制御のリソースを作成
 		auto intr = device::ICU::LEVEL::_2;
 		uint32_t baud = 115200;  // ボーレート
 		sci_.start(baud, intr);
@@ -52,6 +52,9 @@ namespace {
 	static const uint32_t LCD_ORG = 0x0000'0100;
 	typedef device::PORT<device::PORT0, device::bitpos::B7> FT5206_RESET;
 	typedef device::sci_i2c_io<device::SCI6, RB64, SB64, device::port_map::ORDER::FIRST> FT5206_I2C;
+	// FT5206 INT 端子: P02(IRQ10)
+	static constexpr auto FT5206_INT = device::ICU::VECTOR::IRQ10;
+	static constexpr auto FT5206_INT_ORDER = device::port_map::ORDER::SECOND;
 
 #elif defined(SIG_RX72N)
 	// SDHI 関係定義（RX72N Envision Kit の SDHI ポートは、候補３で指定できる）
@@ -65,6 +68,9 @@ namespace {
 	static const uint32_t LCD_ORG = 0x0080'0000;
 	typedef device::PORT<device::PORT6, device::bitpos::B6> FT5206_RESET;
 	typedef device::sci_i2c_io<device::SCI6, RB64, SB64, device::port_map::ORDER::SECOND> FT5206_I2C;
+	// FT5206 INT 端子: P34(IRQ4)
+	static constexpr auto FT5206_INT = device::ICU::VECTOR::IRQ4;
+	static constexpr auto FT5206_INT_ORDER = device::port_map::ORDER::THIRD;
 
 #endif
 
@@ -113,6 +119,26 @@ namespace {
 	typedef gui::simple_dialog<RENDER, TOUCH> DIALOG;
 	DIALOG		dialog_(render_, touch_);
 
+	// FT5206 INT 端子の割り込み（新しいタッチ情報毎にパルス）
+	INTERRUPT_FUNC void ft5206_intr_()
+	{
+		TOUCH::notify();
+	}
+
+	bool start_ft5206_intr_(device::ICU::LEVEL lvl)
+	{
+		if(!device::port_map_irq::turn(FT5206_INT, true, FT5206_INT_ORDER)) {
+			return false;
+		}
+#if defined(SIG_RX65N)
+		device::ICU::IRQCR10.IRQMD = 0b01;  // 立下りエッジ
+#elif defined(SIG_RX72N)
+		device::ICU::IRQCR4.IRQMD = 0b01;  // 立下りエッジ
+#endif
+		device::icu_mgr::set_interrupt(FT5206_INT, ft5206_intr_, lvl);
+		return true;
+	}
+
 	// 最大３２個の Widget 管理
 	typedef gui::widget_director<RENDER, TOUCH, 32> WIDD;
 	WIDD		widd_(render_, touch_);
@@ -551,7 +577,11 @@ int main(int argc, char** argv)
 		if(!ft5206_i2c_.start(FT5206_I2C::MODE::MASTER, FT5206_I2C::SPEED::STANDARD, intr_lvl)) {
 			utils::format("FT5206 I2C Start Fail...\n");
 		}
-		if(!touch_.start()) {
+		auto intr = start_ft5206_intr_(intr_lvl);
+		if(!intr) {
+			utils::format("FT5206 INT Start Fail...\n");
+		}
+		if(!touch_.start(intr)) {
 			utils::format("FT5206 Start Fail...\n");
 		}
 	}
@@ -50,6 +50,94 @@
 /* the NES PPU */
 static ppu_t ppu;
 
+/* Decoded pattern tile cache
+** The 8KB pattern space ($0000-$1FFF) holds 512 tiles of 8 rows.
+** Each row is decoded once into eight 2-bit color indices (one per
+** byte), and reused until the CHR page is switched or CHR-RAM is
+** written.
+*/
+#define  PPU_CACHE_TILES      512
+#define  PPU_CACHE_PAGETILES  64
+
+static uint32 ppu_tilecache[PPU_CACHE_TILES * 8][2];
+static uint32 ppu_tilevalid[PPU_CACHE_TILES / 32];
+static ppu_cachestat_t ppu_cachestat;
+
+static void ppu_invalidatepage(int page_num)
+{
+   ppu_tilevalid[page_num * 2] = 0;
+   ppu_tilevalid[page_num * 2 + 1] = 0;
+   ppu_cachestat.invalidate++;
+}
+
+/* CHR-RAM may be mapped into more than one page, so drop the tile in
+** every pattern page that refers to the written byte
+*/
+static void ppu_invalidatechr(uint32 address)
+{
+   uint8 *location = &PPU_MEM(address);
+   int i;
+
+   for (i = 0; i < 8; i++)
+   {
+      uint8 *page_org = ppu.page[i] + (i << 10);
+
+      if (location >= page_org && location < page_org + 0x400)
+      {
+         uint32 tile = (i * PPU_CACHE_PAGETILES) + ((location - page_org) >> 4);
+         ppu_tilevalid[tile >> 5] &= ~(1 << (tile & 31));
+      }
+   }
+}
+
+void ppu_invalidatetiles(void)
+{
+   memset(ppu_tilevalid, 0, sizeof(ppu_tilevalid));
+   ppu_cachestat.invalidate++;
+}
+
+static void ppu_decodetile(uint32 tile)
+{
+   const uint8 *data_ptr = &PPU_MEM(tile << 4);
+   uint8 *dst = (uint8 *) ppu_tilecache[tile << 3];
+   int row, i;
+
+   for (row = 0; row < 8; row++)
+   {
+      uint8 pat1 = data_ptr[row];
+      uint8 pat2 = data_ptr[row + 8];
+
+      for (i = 7; i >= 0; i--)
+         *dst++ = ((pat1 >> i) & 1) | (((pat2 >> i) & 1) << 1);
+   }
+
+   ppu_tilevalid[tile >> 5] |= 1 << (tile & 31);
+   ppu_cachestat.decode++;
+}
+
+/* get the decoded row at pattern address (bit 3 is the plane select,
+** and must be clear)
+*/
+INLINE const uint32 *ppu_getrow(uint32 address)
+{
+   uint32 tile = (address >> 4) & (PPU_CACHE_TILES - 1);
+
+   if (0 == (ppu_tilevalid[tile >> 5] & (1 << (tile & 31))))
+      ppu_decodetile(tile);
+
+   return ppu_tilecache[(tile << 3) + (address & 7)];
+}
+
+void ppu_getcachestat(ppu_cachestat_t *stat)
+{
+   *stat = ppu_cachestat;
+}
+
+void ppu_resetcachestat(void)
+{
+   memset(&ppu_cachestat, 0, sizeof(ppu_cachestat));
+}
+
 void ppu_displaysprites(bool display)
 {
    ppu.drawsprites = display;
@@ -110,6 +198,8 @@ int ppu_create(void)
 
 	ppu_setdefaultpal();
 
+	ppu_invalidatetiles();
+
 #if 0
 	int nametab[4];
 	nametab[0] = (ppu.page[8]  - ppu.nametab + 0x2000) >> 10;
@@ -133,6 +223,15 @@ int ppu_create(void)
 
 void ppu_setpage(int size, int page_num, uint8 *location)
 {
+   int i;
+
+   /* pattern pages whose mapping changes lose their decoded tiles */
+   for (i = page_num; i < (page_num + size) && i < 8; i++)
+   {
+      if (ppu.page[i] != location)
+         ppu_invalidatepage(i);
+   }
+
    /* deliberately fall through */
    switch (size)
    {
@@ -203,6 +302,8 @@ void ppu_reset(int reset_type)
 
    ppu.latch = 0;
    ppu.vram_accessible = true;
+
+   ppu_invalidatetiles();
 }
 
 /* we render a scanline of graphics first so we know exactly
@@ -462,6 +563,8 @@ void ppu_write(uint32 address, uint8 value)
 //            log_printf("VRAM write to $%04X, scanline %d\n", 
 //                       ppu.vaddr, nes_getcontext()->scanline);
             PPU_MEM(ppu.vaddr) = 0xFF; /* corrupt */
+            if (ppu.vaddr < 0x2000)
+               ppu_invalidatechr(ppu.vaddr);
          }
          else 
          {
@@ -471,6 +574,8 @@ void ppu_write(uint32 address, uint8 value)
                ppu.vaddr -= 0x1000;
 
             PPU_MEM(addr) = value;
+            if (addr < 0x2000)
+               ppu_invalidatechr(addr);
          }
       }
       else
@@ -545,126 +650,111 @@ void ppu_setvromswitch(ppuvromswitch_t func)
 }
 
 /* rendering routines */
-INLINE void draw_bgtile(uint8 *surface, uint8 pat1, uint8 pat2, 
-                        const uint8 *colors)
+
+/* draw 8 pixels of a decoded BG row */
+INLINE void draw_bgspan(uint8 *surface, const uint32 *row, const uint8 *colors)
 {
-   uint32 pattern = ((pat2 & 0xAA) << 8) | ((pat2 & 0x55) << 1)
-                    | ((pat1 & 0xAA) << 7) | (pat1 & 0x55);
-   
-   *surface++ = colors[(pattern >> 14) & 3];
-   *surface++ = colors[(pattern >> 6) & 3];
-   *surface++ = colors[(pattern >> 12) & 3];
-   *surface++ = colors[(pattern >> 4) & 3];
-   *surface++ = colors[(pattern >> 10) & 3];
-   *surface++ = colors[(pattern >> 2) & 3];
-   *surface++ = colors[(pattern >> 8) & 3];
-   *surface = colors[pattern & 3];
+   const uint8 *pix = (const uint8 *) row;
+
+   /* fully transparent rows are common, fill them with color 0 */
+   if (0 == (row[0] | row[1]))
+   {
+      uint8 c = colors[0];
+
+      surface[0] = c; surface[1] = c; surface[2] = c; surface[3] = c;
+      surface[4] = c; surface[5] = c; surface[6] = c; surface[7] = c;
+      return;
+   }
+
+   surface[0] = colors[pix[0]];
+   surface[1] = colors[pix[1]];
+   surface[2] = colors[pix[2]];
+   surface[3] = colors[pix[3]];
+   surface[4] = colors[pix[4]];
+   surface[5] = colors[pix[5]];
+   surface[6] = colors[pix[6]];
+   surface[7] = colors[pix[7]];
 }
 
-INLINE int draw_oamtile(uint8 *surface, uint8 attrib, uint8 pat1, 
-                        uint8 pat2, const uint8 *col_tbl, bool check_strike)
+/* composite 8 pixels of a decoded sprite row */
+INLINE int draw_oamspan(uint8 *surface, uint8 attrib, const uint32 *row,
+                        const uint8 *col_tbl, bool check_strike)
 {
+   const uint8 *pix = (const uint8 *) row;
+   uint8 colors[8];
    int strike_pixel = -1;
-   uint32 color = ((pat2 & 0xAA) << 8) | ((pat2 & 0x55) << 1)
-                  | ((pat1 & 0xAA) << 7) | (pat1 & 0x55);
+   int i;
 
-   /* sprite is not 100% transparent */
-   if (color)
-   {
-      uint8 colors[8];
+   /* sprite is 100% transparent */
+   if (0 == (row[0] | row[1]))
+      return -1;
 
-      /* swap pixels around if our tile is flipped */
-      if (0 == (attrib & OAMF_HFLIP))
-      {
-         colors[0] = (color >> 14) & 3;
-         colors[1] = (color >> 6) & 3;
-         colors[2] = (color >> 12) & 3;
-         colors[3] = (color >> 4) & 3;
-         colors[4] = (color >> 10) & 3;
-         colors[5] = (color >> 2) & 3;
-         colors[6] = (color >> 8) & 3;
-         colors[7] = color & 3;
-      }
-      else
-      {
-         colors[7] = (color >> 14) & 3;
-         colors[6] = (color >> 6) & 3;
-         colors[5] = (color >> 12) & 3;
-         colors[4] = (color >> 4) & 3;
-         colors[3] = (color >> 10) & 3;
-         colors[2] = (color >> 2) & 3;
-         colors[1] = (color >> 8) & 3;
-         colors[0] = color & 3;
-      }
+   /* swap pixels around if our tile is flipped */
+   if (0 == (attrib & OAMF_HFLIP))
+   {
+      for (i = 0; i < 8; i++)
+         colors[i] = pix[i];
+   }
+   else
+   {
+      for (i = 0; i < 8; i++)
+         colors[i] = pix[7 - i];
+   }
 
-      /* check for solid sprite pixel overlapping solid bg pixel */
-      if (check_strike)
+   /* check for solid sprite pixel overlapping solid bg pixel */
+   if (check_strike)
+   {
+      for (i = 0; i < 8; i++)
       {
-         if (colors[0] && BG_SOLID(surface[0]))
-            strike_pixel = 0;
-         else if (colors[1] && BG_SOLID(surface[1]))
-            strike_pixel = 1;
-         else if (colors[2] && BG_SOLID(surface[2]))
-            strike_pixel = 2;
-         else if (colors[3] && BG_SOLID(surface[3]))
-            strike_pixel = 3;
-         else if (colors[4] && BG_SOLID(surface[4]))
-            strike_pixel = 4;
-         else if (colors[5] && BG_SOLID(surface[5]))
-            strike_pixel = 5;
-         else if (colors[6] && BG_SOLID(surface[6]))
-            strike_pixel = 6;
-         else if (colors[7] && BG_SOLID(surface[7]))
-            strike_pixel = 7;
+         if (colors[i] && BG_SOLID(surface[i]))
+         {
+            strike_pixel = i;
+            break;
+         }
       }
+   }
 
-      /* draw the character */
-      if (attrib & OAMF_BEHIND)
+   /* draw the character */
+   if (attrib & OAMF_BEHIND)
+   {
+      for (i = 0; i < 8; i++)
       {
-         if (colors[0])
-            surface[0] = SP_PIXEL | (BG_CLEAR(surface[0]) ? col_tbl[colors[0]] : surface[0]);
-         if (colors[1])
-            surface[1] = SP_PIXEL | (BG_CLEAR(surface[1]) ? col_tbl[colors[1]] : surface[1]);
-         if (colors[2])
-            surface[2] = SP_PIXEL | (BG_CLEAR(surface[2]) ? col_tbl[colors[2]] : surface[2]);
-         if (colors[3])
-            surface[3] = SP_PIXEL | (BG_CLEAR(surface[3]) ? col_tbl[colors[3]] : surface[3]);
-         if (colors[4])
-            surface[4] = SP_PIXEL | (BG_CLEAR(surface[4]) ? col_tbl[colors[4]] : surface[4]);
-         if (colors[5])
-            surface[5] = SP_PIXEL | (BG_CLEAR(surface[5]) ? col_tbl[colors[5]] : surface[5]);
-         if (colors[6])
-            surface[6] = SP_PIXEL | (BG_CLEAR(surface[6]) ? col_tbl[colors[6]] : surface[6]);
-         if (colors[7])
-            surface[7] = SP_PIXEL | (BG_CLEAR(surface[7]) ? col_tbl[colors[7]] : surface[7]);
+         if (colors[i])
+            surface[i] = SP_PIXEL | (BG_CLEAR(surface[i]) ? col_tbl[colors[i]] : surface[i]);
       }
-      else
+   }
+   else
+   {
+      for (i = 0; i < 8; i++)
       {
-         if (colors[0] && SP_CLEAR(surface[0]))
-            surface[0] = SP_PIXEL | col_tbl[colors[0]];
-         if (colors[1] && SP_CLEAR(surface[1]))
-            surface[1] = SP_PIXEL | col_tbl[colors[1]];
-         if (colors[2] && SP_CLEAR(surface[2]))
-            surface[2] = SP_PIXEL | col_tbl[colors[2]];
-         if (colors[3] && SP_CLEAR(surface[3]))
-            surface[3] = SP_PIXEL | col_tbl[colors[3]];
-         if (colors[4] && SP_CLEAR(surface[4]))
-            surface[4] = SP_PIXEL | col_tbl[colors[4]];
-         if (colors[5] && SP_CLEAR(surface[5]))
-            surface[5] = SP_PIXEL | col_tbl[colors[5]];
-         if (colors[6] && SP_CLEAR(surface[6]))
-            surface[6] = SP_PIXEL | col_tbl[colors[6]];
-         if (colors[7] && SP_CLEAR(surface[7]))
-            surface[7] = SP_PIXEL | col_tbl[colors[7]];
+         if (colors[i] && SP_CLEAR(surface[i]))
+            surface[i] = SP_PIXEL | col_tbl[colors[i]];
       }
    }
 
    return strike_pixel;
 }
 
+INLINE void draw_bgtile(uint8 *surface, uint8 pat1, uint8 pat2, 
+                        const uint8 *colors)
+{
+   uint32 pattern = ((pat2 & 0xAA) << 8) | ((pat2 & 0x55) << 1)
+                    | ((pat1 & 0xAA) << 7) | (pat1 & 0x55);
+   
+   *surface++ = colors[(pattern >> 14) & 3];
+   *surface++ = colors[(pattern >> 6) & 3];
+   *surface++ = colors[(pattern >> 12) & 3];
+   *surface++ = colors[(pattern >> 4) & 3];
+   *surface++ = colors[(pattern >> 10) & 3];
+   *surface++ = colors[(pattern >> 2) & 3];
+   *surface++ = colors[(pattern >> 8) & 3];
+   *surface = colors[pattern & 3];
+}
+
 static void ppu_renderbg(uint8 *vidbuf)
 {
-   uint8 *bmp_ptr, *data_ptr, *tile_ptr, *attrib_ptr;
+   uint8 *bmp_ptr, *tile_ptr, *attrib_ptr;
+   const uint32 *row_ptr;
    uint32 refresh_vaddr, bg_offset, attrib_base;
    int tile_count;
    uint8 tile_index, x_tile, y_tile;
@@ -697,13 +787,13 @@ static void ppu_renderbg(uint8 *vidbuf)
    {
       /* Tile number from nametable */
       tile_index = *tile_ptr++;
-      data_ptr = &PPU_MEM(bg_offset + (tile_index << 4));
+      row_ptr = ppu_getrow(bg_offset + (tile_index << 4));
 
       /* Handle $FD/$FE tile VROM switching (PunchOut) */
       if (ppu.latchfunc)
          ppu.latchfunc(ppu.bg_base, tile_index);
 
-      draw_bgtile(bmp_ptr, data_ptr[0], data_ptr[8], ppu.palette + col_high);
+      draw_bgspan(bmp_ptr, row_ptr, ppu.palette + col_high);
       bmp_ptr += 8;
 
       x_tile++;
@@ -782,7 +872,8 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
 
    for (sprite_num = 0; sprite_num < 64; sprite_num++, sprite_ptr++)
    {
-      uint8 *data_ptr, *bmp_ptr;
+      uint8 *bmp_ptr;
+      const uint32 *row_ptr;
       uint32 vram_adr;
       int y_offset;
       uint8 tile_index, attrib, col_high;
@@ -816,9 +907,6 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
       else
          vram_adr = vram_offset + (tile_index << 4);
 
-      /* Get the address of the tile */
-      data_ptr = &PPU_MEM(vram_adr);
-
       /* Calculate offset (line within the sprite) */
       y_offset = scanline - sprite_y;
       if (y_offset > 7)
@@ -832,18 +920,21 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
          else
             y_offset -= 7;
 
-         data_ptr -= y_offset;
+         vram_adr -= y_offset;
       }
       else
       {
-         data_ptr += y_offset;
+         vram_adr += y_offset;
       }
 
+      /* Get the decoded row of the tile */
+      row_ptr = ppu_getrow(vram_adr);
+
       /* if we're on sprite 0 and sprite 0 strike flag isn't set,
       ** check for a strike 
       */
       check_strike = (0 == sprite_num) && (false == ppu.strikeflag);
-      strike_pixel = draw_oamtile(bmp_ptr, attrib, data_ptr[0], data_ptr[8], ppu.palette + 16 + col_high, check_strike);
+      strike_pixel = draw_oamspan(bmp_ptr, attrib, row_ptr, ppu.palette + 16 + col_high, check_strike);
       if (strike_pixel >= 0)
          ppu_setstrike(strike_pixel);
 
@@ -108,6 +108,13 @@ typedef struct ppu_s
    bool drawsprites;
 } ppu_t;
 
+/* decoded tile cache statistics */
+typedef struct ppu_cachestat_s
+{
+   uint32 decode;       /* number of tiles decoded */
+   uint32 invalidate;   /* number of page/whole invalidations */
+} ppu_cachestat_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -127,6 +134,11 @@ extern void ppu_mirror(int nt1, int nt2, int nt3, int nt4);
 extern void ppu_setpage(int size, int page_num, uint8 *location);
 extern uint8 *ppu_getpage(int page);
 
+/* Decoded tile cache */
+extern void ppu_invalidatetiles(void);
+extern void ppu_getcachestat(ppu_cachestat_t *stat);
+extern void ppu_resetcachestat(void);
+
 
 /* control */
 extern void ppu_reset(int reset_type);
@@ -252,6 +252,8 @@ namespace {
 		} else if(cmd_.cmp_word(0, "info")) {
 			const char* str = nesemu_.get_info();
 			utils::format("%s\n") % str;
+		} else if(cmd_.cmp_word(0, "tile")) {
+			nesemu_.list_tile_cache(cmdn >= 2 && cmd_.cmp_word(1, "reset"));
 		} else if(cmd_.cmp_word(0, "call-151")) {
 			if(nesemu_.probe()) {
 				cmd_.set_prompt("$");
@@ -267,6 +269,7 @@ namespace {
 			utils::format("    save [slot-no]  Save NES State (slot-no:0 to 9)\n");
 			utils::format("    load [slot-no]  Load NES State (slot-no:0 to 9)\n");
 			utils::format("    info            Cartrige Infomations\n");
+			utils::format("    tile [reset]    PPU Tile Cache Statistics\n");
 			utils::format("    call-151        Goto Monitor\n");
 		} else {
 			utils::format("Command error: '%s'\n") % cmd_.get_command();
@@ -3,7 +3,7 @@
 /*!	@file
 	@brief	NES Emulator ハンドラー
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2018, 2019 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2018, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -151,6 +151,24 @@ namespace emu {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  PPU タイル・キャッシュの状態を表示
+			@param[in]	reset	表示後に統計をリセットする場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		void list_tile_cache(bool reset = false) noexcept
+		{
+			ppu_cachestat_t st;
+			ppu_getcachestat(&st);
+			utils::format("Tile decode: %u, invalidate: %u\n")
+				% static_cast<uint32_t>(st.decode) % static_cast<uint32_t>(st.invalidate);
+			if(reset) {
+				ppu_resetcachestat();
+			}
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  エミュレーターを終了
@@ -208,7 +208,8 @@ int main(int argc, char** argv)
 
 #ifdef LCD_MONO
 		if(nn >= 4) {
-			lcd_.copy(bitmap_.fb(), bitmap_.page_num());
+			lcd_.flush(bitmap_.fb(), bitmap_.get_dirty());
+			bitmap_.clear_dirty();
 			nn = 0;
 		}
 		++nn;
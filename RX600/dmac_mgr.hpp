@@ -234,6 +234,64 @@ namespace device {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	割り込み要因による単発転送（ノーマル転送） @n
+					※事前に「start(lvl)」で開始しておく事。@n
+					※周辺機能の FIFO などと、メモリー間の転送に使う。
+			@param[in]	trg		転送開始要因
+			@param[in]	tft		転送タイプ
+			@param[in]	src		元アドレス
+			@param[in]	dst		先アドレス
+			@param[in]	num		転送数（※カウント数なので注意、最大 65535）
+			@param[in]	tae		終了時タスクを起動する場合「true」
+			@return 成功なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool start_trans(ICU::VECTOR trg, trans_type tft, uint32_t src, uint32_t dst, uint32_t num,
+			bool tae = false) noexcept
+		{
+			if(num == 0 || num > 65535) return false;
+
+			DMAC::DMCNT.DTE = 0;  // 念のため停止させる。
+
+			uint8_t dm = 0;
+			uint8_t sm = 0;
+			uint8_t sz = 0;
+			switch(tft) {
+			case trans_type::SN_DP_8:  sm = 0b00; dm = 0b10; sz = 0; break;
+			case trans_type::SP_DN_8:  sm = 0b10; dm = 0b00; sz = 0; break;
+			case trans_type::SN_DP_16: sm = 0b00; dm = 0b10; sz = 1; break;
+			case trans_type::SP_DN_16: sm = 0b10; dm = 0b00; sz = 1; break;
+			case trans_type::SN_DP_32: sm = 0b00; dm = 0b10; sz = 2; break;
+			case trans_type::SP_DN_32: sm = 0b10; dm = 0b00; sz = 2; break;
+			default:
+				break;
+			}
+
+			DMAC::DMAMD = DMAC::DMAMD.DM.b(dm) | DMAC::DMAMD.SM.b(sm);
+			// ノーマル転送、周辺機能の割り込みで起動
+			DMAC::DMTMD = DMAC::DMTMD.DCTG.b(0b01) | DMAC::DMTMD.SZ.b(sz) |
+						  DMAC::DMTMD.DTS.b(0b10)  | DMAC::DMTMD.MD.b(0b00);
+			DMAC::DMSAR = src;
+			DMAC::DMDAR = dst;
+			DMAC::DMCRA = num;
+
+			icu_mgr::set_dmac(DMAC::PERIPHERAL, trg);
+			if(tae && level_ != ICU::LEVEL::NONE) {
+				DMAC::DMINT = DMAC::DMINT.DTIE.b();
+			} else {
+				DMAC::DMINT = 0x00;
+			}
+			DMAC::DMCSL.DISEL = 0;
+
+			DMAC::DMSTS.DTIF = 0;
+			DMAC::DMCNT.DTE = 1;
+
+			return true;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	転送再開 @n
@@ -457,6 +515,46 @@ namespace device {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	I/O レジスタ（固定アドレス）への連続書き込み @n
+					ソフトウェア起動で、ソース＋、ディストネーション固定（8 bits）で転送する。 @n
+					※ポート出力などに使う。
+			@param[in]	src		転送元
+			@param[in]	dst		転送先アドレス（I/O レジスタ）
+			@param[in]	len		転送数（バイト、最大 65535）
+			@param[in]	tae		終了時タスクを起動する場合「true」
+			@return 転送が出来ない場合「false」（パラメーターが異常）
+		 */
+		//-----------------------------------------------------------------//
+		bool copy_io(const void* src, uint32_t dst, uint32_t len, bool tae = false) const noexcept
+		{
+			if(len == 0 || len > 65535 || src == nullptr) return false;
+
+			DMAC::DMCNT.DTE = 0;  // 念のため停止させる。
+
+			// 転送元 (+1)、転送先 (固定)
+			DMAC::DMAMD = DMAC::DMAMD.DM.b(0b00) | DMAC::DMAMD.SM.b(0b10);
+			DMAC::DMTMD = DMAC::DMTMD.DCTG.b(0b00) | DMAC::DMTMD.SZ.b(0) |
+						  DMAC::DMTMD.DTS.b(0b10)  | DMAC::DMTMD.MD.b(0b00);
+			DMAC::DMSAR = reinterpret_cast<uint32_t>(src);
+			DMAC::DMDAR = dst;
+			DMAC::DMCRA = len;
+
+			if(tae && level_ != ICU::LEVEL::NONE) {
+				DMAC::DMINT.DTIE = 1;
+			} else {
+				DMAC::DMINT = 0x00;
+			}
+
+			DMAC::DMCNT.DTE = 1;
+
+			DMAC::DMREQ = DMAC::DMREQ.SWREQ.b() | DMAC::DMREQ.CLRS.b();
+
+			return true;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  TASK クラスの参照
@@ -327,6 +327,16 @@ namespace device {
         const value_type* fb() const noexcept { return fb_; }
 
 
+		//-----------------------------------------------------------------//
+        /*!
+            @brief  フレームバッファへの参照（CPU で直接描画する場合）@n
+					※DRW2D の描画と重ならないように「flush」で同期を取る事
+            @return フレームバッファ・アドレス
+        */
+        //-----------------------------------------------------------------//
+        value_type* at_fb() noexcept { return fb_; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	フォア・カラーの取得
@@ -108,15 +108,14 @@ int main(int argc, char** argv)
 				if(command_.cmp_word(0, "log")) {
 					auto len = log_man_.get_length();
 					utils::format("LOG length: %d\n") % len;
-					uint16_t pos = 0;
-					while(pos < len) {
-						char ch = log_man_.getch(pos);
-						if(ch == '\n') {
-							sci_putch('\r');
+					log_man_.stream([](const char* src, uint32_t n) {
+						for(uint32_t i = 0; i < n; ++i) {
+							if(src[i] == '\n') {
+								sci_putch('\r');
+							}
+							sci_putch(src[i]);
 						}
-						sci_putch(ch);
-						++pos;
-					}
+					});
 				} else if(command_.cmp_word(0, "start")) {
 					utils::format("Start LOG\n");
 					loge = true;
@@ -38,6 +38,7 @@
 #include "common/rspi_io.hpp"
 #include "common/command.hpp"
 #include "common/shell.hpp"
+#include "ff14/sector_cache.hpp"
 
 #include "common/iica_io.hpp"
 #include "chip/DS3231.hpp"
@@ -175,6 +176,14 @@ namespace {
 	typedef chip::DS3231<I2C> RTC;
 #endif
 
+	// FAT、ディレクトリのセクターをキャッシュする
+#if defined(SIG_RX24T)
+	typedef fatfs::sector_cache<SDC, 2, 1, 0> CACHE;  // RAM が少ないので最小構成
+#else
+	typedef fatfs::sector_cache<SDC> CACHE;
+#endif
+	CACHE	cache_(sdc_);
+
 	typedef utils::fixed_fifo<char, 512> RXB;  // RX (RECV) バッファの定義
 	typedef utils::fixed_fifo<char, 256> TXB;  // TX (SEND) バッファの定義
 	typedef device::sci_io<board_profile::SCI_CH, RXB, TXB, board_profile::SCI_ORDER> SCI;
@@ -407,10 +416,20 @@ namespace {
 					utils::str::print_date_time(t);
 				}
 			}
+		} else if(cmd_.cmp_word(0, "cache")) { // セクター・キャッシュの統計
+			const auto& st = cache_.get_stat();
+			utils::format("Hit: %u, Miss: %u, Evict: %u, Write back: %u\n")
+				% st.hit_ % st.miss_ % st.evict_ % st.write_back_;
+			utils::format("Read ahead: %u, Device read: %u, Device write: %u, Dirty: %u\n")
+				% st.ahead_ % st.read_cmd_ % st.write_cmd_ % cache_.get_dirty_num();
+			if(cmdn >= 2 && cmd_.cmp_word(1, "reset")) {
+				cache_.reset_stat();
+			}
 		} else if(cmd_.cmp_word(0, "help")) {
 			shell_.help();
 			utils::format("    write filename      test for write\n");
 			utils::format("    read filename       test for read\n");
+			utils::format("    cache [reset]       sector cache status\n");
 			utils::format("    time [yyyy/mm/dd hh:mm[:ss]]   set date/time\n");
 		} else {
 			utils::format("Command error: '%s'\n") % cmd_.get_command();
@@ -445,7 +464,7 @@ extern "C" {
 
 	// FatFs から呼ばれるファイル操作関数
 	DSTATUS disk_initialize(BYTE drv) {
-		return sdc_.disk_initialize(drv);
+		return cache_.disk_initialize(drv);
 	}
 
 	DSTATUS disk_status(BYTE drv) {
@@ -453,15 +472,15 @@ extern "C" {
 	}
 
 	DRESULT disk_read(BYTE drv, BYTE* buff, DWORD sector, UINT count) {
-		return sdc_.disk_read(drv, buff, sector, count);
+		return cache_.disk_read(drv, buff, sector, count);
 	}
 
 	DRESULT disk_write(BYTE drv, const BYTE* buff, DWORD sector, UINT count) {
-		return sdc_.disk_write(drv, buff, sector, count);
+		return cache_.disk_write(drv, buff, sector, count);
 	}
 
 	DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) {
-		return sdc_.disk_ioctl(drv, ctrl, buff);
+		return cache_.disk_ioctl(drv, ctrl, buff);
 	}
 
 	DWORD get_fattime(void) {
@@ -576,9 +595,14 @@ int main(int argc, char** argv)
 	LED::DIR = 1;
 
 	uint8_t cnt = 0;
+	bool mount_back = false;
 	while(1) {
 
 		bool mount = sdc_.service();
+		if(mount && !mount_back) {  // マウントしたら、FAT 領域をピン留めする
+			cache_.set_pin(&sdc_.get_fatfs());
+		}
+		mount_back = mount;
 
 #ifdef TOUCH_FILER
 		render_.sync_frame();
@@ -22,6 +22,13 @@
 InvadersMachine::InvadersMachine()
 {
     cpu_ = new I8080( *this );
+
+    // ROM and RAM are read directly by the CPU, as is the work RAM for writes.
+    // Writes to ROM are ignored and writes to video RAM must also update the
+    // normalized video buffer, so they go through writeByte().
+    mapMemory( 0x00, 0x40, ram_, 0 );
+    mapMemory( 0x20, 0x04, ram_ + 0x2000, ram_ + 0x2000 );
+
     reset();
     memset( ram_, 0, 0x2000 );  // Clear the ROM area
     setFrameRate( 60 );
@@ -144,8 +151,7 @@ void InvadersMachine::step()
     // Before a frame is fully rendered, two interrupts have to occur
     for( int i=0; i<2; i++ ) {
         // Go on until an interrupt occurs
-        while( cpu_->getCycles() < cycles_per_interrupt_ )
-            cpu_->step();
+        cpu_->run( cycles_per_interrupt_ );
 
         // Adjust the cycles count
         cpu_->setCycles( cpu_->getCycles() - cycles_per_interrupt_ );
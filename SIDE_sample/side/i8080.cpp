@@ -22,6 +22,7 @@
 I8080::I8080( I8080Environment & env )
     : env_( env )
 {
+    initTables();
     reset();
 }
 
@@ -67,18 +68,6 @@ void I8080::reset()
     cycles_ = 0;
 }
 
-void I8080::step()
-{
-    unsigned op = env_.readByte( PC++ );
-
-    // Execute
-    cycles_ += Opcode_[ op ].cycles;
-    if( Opcode_[ op ].handler )
-        (this->*(Opcode_[ op ].handler))();
-
-    PC &= 0xFFFF;
-}
-
 void I8080::interrupt( unsigned address )
 {
     if( F & Interrupt ) {
@@ -86,8 +75,8 @@ void I8080::interrupt( unsigned address )
             PC++;
             halted_ = 0;
         }
-        env_.writeByte( --SP, (PC >> 8) & 0xFF );
-        env_.writeByte( --SP, PC & 0xFF );
+        writeMem( --SP, (PC >> 8) & 0xFF );
+        writeMem( --SP, PC & 0xFF );
         PC = address & 0xFFFF;
     }
 }
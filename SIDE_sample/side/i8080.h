@@ -30,10 +30,16 @@
     ports: users of the I8080 emulator should provide the desired behaviour by writing a
     descendant of this class that overrides the required functions.
 
+    For speed, plain RAM and ROM areas can be declared with <i>mapMemory()</i>: the
+    CPU then reads and writes those 256-byte pages directly, and the virtual functions
+    are only called for pages that are not mapped (memory mapped I/O, video, etc.).
+
     @author Alessandro Scotti
 */
 class I8080Environment
 {
+    friend class I8080;
+
 public:
     /** 
         Constructor. 
@@ -42,6 +48,10 @@ public:
         ports.
     */
     I8080Environment() {
+        for( unsigned i=0; i<256; i++ ) {
+            readPage_[i] = 0;
+            writePage_[i] = 0;
+        }
     }
 
     /** Destructor. */
@@ -145,6 +155,29 @@ public:
     */
     virtual void writePort( unsigned port, unsigned char value ) {
     }
+
+protected:
+    /**
+        Maps a memory area for direct access by the CPU.
+
+        Pages are 256 bytes long. A null pointer removes the mapping, so that accesses
+        to those pages go through <i>readByte()</i> or <i>writeByte()</i> again.
+
+        @param  page    first page (address >> 8)
+        @param  count   number of pages
+        @param  read    memory for reads of the first page (or null)
+        @param  write   memory for writes of the first page (or null, e.g. for ROM)
+    */
+    void mapMemory( unsigned page, unsigned count, const unsigned char * read, unsigned char * write ) {
+        for( unsigned i=0; i<count && (page + i) < 256; i++ ) {
+            readPage_[page + i] = read ? read + (i << 8) : 0;
+            writePage_[page + i] = write ? write + (i << 8) : 0;
+        }
+    }
+
+private:
+    const unsigned char *   readPage_[256];     // Direct read pages (null: use readByte)
+    unsigned char *         writePage_[256];    // Direct write pages (null: use writeByte)
 };
 
 /**
@@ -213,6 +246,19 @@ public:
     /** Executes one CPU instruction. */
     virtual void step();
 
+    /**
+        Executes instructions until the cycle counter reaches the specified value.
+
+        This is much faster than calling <i>step()</i> in a loop, because the fetch and
+        dispatch loop stays inside the emulator.
+
+        @param  cycles  cycle counter value to run to
+
+        @return the cycle counter value on exit (may exceed <i>cycles</i> by the length
+                of the last instruction)
+    */
+    unsigned run( unsigned cycles );
+
     /** 
         Informs the CPU that an interrupt has occurred.
 
@@ -544,17 +590,58 @@ protected:
     /** Subtracts byte OP from accumulator, with borrow CF. Flags are updated. */
     unsigned char subByte( unsigned char OP, unsigned char CF );
 
+    /** Reads one byte of memory, directly if the page is mapped. */
+    unsigned char readMem( unsigned addr ) {
+        unsigned page = addr >> 8;
+        if( page < 256 && env_.readPage_[page] )
+            return env_.readPage_[page][addr & 0xFF];
+        return env_.readByte( addr );
+    }
+
+    /** Reads a 16-bit word of memory, directly if it lies in a mapped page. */
+    unsigned readMemWord( unsigned addr ) {
+        unsigned page = addr >> 8;
+        if( page < 256 && (addr & 0xFF) != 0xFF && env_.readPage_[page] ) {
+            const unsigned char * p = env_.readPage_[page] + (addr & 0xFF);
+            return p[0] | ((unsigned)p[1] << 8);
+        }
+        return env_.readWord( addr );
+    }
+
+    /** Writes one byte of memory, directly if the page is mapped. */
+    void writeMem( unsigned addr, unsigned char value ) {
+        unsigned page = addr >> 8;
+        if( page < 256 && env_.writePage_[page] )
+            env_.writePage_[page][addr & 0xFF] = value;
+        else
+            env_.writeByte( addr, value );
+    }
+
+    /** Writes a 16-bit word of memory, directly if it lies in a mapped page. */
+    void writeMemWord( unsigned addr, unsigned value ) {
+        unsigned page = addr >> 8;
+        if( page < 256 && (addr & 0xFF) != 0xFF && env_.writePage_[page] ) {
+            unsigned char * p = env_.writePage_[page] + (addr & 0xFF);
+            p[0] = value & 0xFF;
+            p[1] = (value >> 8) & 0xFF;
+        }
+        else
+            env_.writeWord( addr, value );
+    }
+
 private:
-    typedef void (I8080::* OpcodeHandler)();
+    /** Decodes and executes the specified opcode. */
+    void execute( unsigned op );
 
-    typedef struct {
-        OpcodeHandler   handler;
-        unsigned        cycles;
-    } OpcodeInfo;
+    /** Builds the flag lookup tables. */
+    static void initTables();
 
-    static OpcodeInfo   Opcode_[256];   // Opcode table
+    static const unsigned char  Cycles_[256];   // Base cycles for each opcode
 
     static unsigned char    PSZ_[256];  // Parity, sign, zero table
+    static unsigned char    ZS_[256];   // Zero, sign table
+    static unsigned char    IncF_[256]; // Flags after increment, indexed by the result
+    static unsigned char    DecF_[256]; // Flags after decrement, indexed by the result
 
     unsigned            halted_;
     unsigned            cycles_;
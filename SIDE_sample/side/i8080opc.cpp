@@ -19,263 +19,263 @@
 */
 #include "i8080.h"
 
-I8080::OpcodeInfo I8080::Opcode_[256] = {
-    { &I8080::opcode_00,  4 },   // NOP
-    { &I8080::opcode_01, 10 },   // LD   BC,nn
-    { &I8080::opcode_02,  7 },   // LD   (BC),A
-    { &I8080::opcode_03,  6 },   // INC  BC
-    { &I8080::opcode_04,  5 },   // INC  B
-    { &I8080::opcode_05,  5 },   // DEC  B
-    { &I8080::opcode_06,  7 },   // LD   B,n
-    { &I8080::opcode_07,  4 },   // RLCA
-    { 0, 4 },
-    { &I8080::opcode_09, 11 },   // ADD  HL,BC
-    { &I8080::opcode_0a,  7 },   // LD   A,(BC)
-    { &I8080::opcode_0b,  6 },   // DEC  BC
-    { &I8080::opcode_0c,  5 },   // INC  C
-    { &I8080::opcode_0d,  5 },   // DEC  C
-    { &I8080::opcode_0e,  7 },   // LD   C,n
-    { &I8080::opcode_0f,  4 },   // RRCA
-    { 0, 4 },
-    { &I8080::opcode_11, 10 },   // LD   DE,nn
-    { &I8080::opcode_12,  7 },   // LD   (DE),A
-    { &I8080::opcode_13,  6 },   // INC  DE
-    { &I8080::opcode_14,  5 },   // INC  D
-    { &I8080::opcode_15,  5 },   // DEC  D
-    { &I8080::opcode_16,  7 },   // LD   D,n
-    { &I8080::opcode_17,  4 },   // RLA
-    { 0, 4 },
-    { &I8080::opcode_19, 11 },   // ADD  HL,DE
-    { &I8080::opcode_1a,  7 },   // LD   A,(DE)
-    { &I8080::opcode_1b,  6 },   // DEC  DE
-    { &I8080::opcode_1c,  5 },   // INC  E
-    { &I8080::opcode_1d,  5 },   // DEC  E
-    { &I8080::opcode_1e,  7 },   // LD   E,n
-    { &I8080::opcode_1f,  4 },   // RRA
-    { 0, 4 },
-    { &I8080::opcode_21, 10 },   // LD   HL,nn
-    { &I8080::opcode_22, 16 },   // LD   (nn),HL
-    { &I8080::opcode_23,  6 },   // INC  HL
-    { &I8080::opcode_24,  5 },   // INC  H
-    { &I8080::opcode_25,  5 },   // DEC  H
-    { &I8080::opcode_26,  7 },   // LD   H,n
-    { &I8080::opcode_27,  4 },   // DAA
-    { 0, 4 },
-    { &I8080::opcode_29, 11 },   // ADD  HL,HL
-    { &I8080::opcode_2a, 16 },   // LD   HL,(nn)
-    { &I8080::opcode_2b,  6 },   // DEC  HL
-    { &I8080::opcode_2c,  5 },   // INC  L
-    { &I8080::opcode_2d,  5 },   // DEC  L
-    { &I8080::opcode_2e,  7 },   // LD   L,n
-    { &I8080::opcode_2f,  4 },   // CPL
-    { 0, 4 },
-    { &I8080::opcode_31, 10 },   // LD   SP,nn
-    { &I8080::opcode_32, 13 },   // LD   (nn),A
-    { &I8080::opcode_33,  6 },   // INC  SP
-    { &I8080::opcode_34, 10 },   // INC  (HL)
-    { &I8080::opcode_35, 10 },   // DEC  (HL)
-    { &I8080::opcode_36, 10 },   // LD   (HL),n
-    { &I8080::opcode_37,  4 },   // SCF
-    { 0, 4 },
-    { &I8080::opcode_39, 11 },   // ADD  HL,SP
-    { &I8080::opcode_3a, 13 },   // LD   A,(nn)
-    { &I8080::opcode_3b,  6 },   // DEC  SP
-    { &I8080::opcode_3c,  5 },   // INC  A
-    { &I8080::opcode_3d,  5 },   // DEC  A
-    { &I8080::opcode_3e,  7 },   // LD   A,n
-    { &I8080::opcode_3f,  4 },   // CCF
-    { &I8080::opcode_40,  5 },   // LD   B,B
-    { &I8080::opcode_41,  5 },   // LD   B,C
-    { &I8080::opcode_42,  5 },   // LD   B,D
-    { &I8080::opcode_43,  5 },   // LD   B,E
-    { &I8080::opcode_44,  5 },   // LD   B,H
-    { &I8080::opcode_45,  5 },   // LD   B,L
-    { &I8080::opcode_46,  7 },   // LD   B,(HL)
-    { &I8080::opcode_47,  5 },   // LD   B,A
-    { &I8080::opcode_48,  5 },   // LD   C,B
-    { &I8080::opcode_49,  5 },   // LD   C,C
-    { &I8080::opcode_4a,  5 },   // LD   C,D
-    { &I8080::opcode_4b,  5 },   // LD   C,E
-    { &I8080::opcode_4c,  5 },   // LD   C,H
-    { &I8080::opcode_4d,  5 },   // LD   C,L
-    { &I8080::opcode_4e,  7 },   // LD   C,(HL)
-    { &I8080::opcode_4f,  5 },   // LD   C,A
-    { &I8080::opcode_50,  5 },   // LD   D,B
-    { &I8080::opcode_51,  5 },   // LD   D,C
-    { &I8080::opcode_52,  5 },   // LD   D,D
-    { &I8080::opcode_53,  5 },   // LD   D,E
-    { &I8080::opcode_54,  5 },   // LD   D,H
-    { &I8080::opcode_55,  5 },   // LD   D,L
-    { &I8080::opcode_56,  7 },   // LD   D,(HL)
-    { &I8080::opcode_57,  5 },   // LD   D,A
-    { &I8080::opcode_58,  5 },   // LD   E,B
-    { &I8080::opcode_59,  5 },   // LD   E,C
-    { &I8080::opcode_5a,  5 },   // LD   E,D
-    { &I8080::opcode_5b,  5 },   // LD   E,E
-    { &I8080::opcode_5c,  5 },   // LD   E,H
-    { &I8080::opcode_5d,  5 },   // LD   E,L
-    { &I8080::opcode_5e,  7 },   // LD   E,(HL)
-    { &I8080::opcode_5f,  5 },   // LD   E,A
-    { &I8080::opcode_60,  5 },   // LD   H,B
-    { &I8080::opcode_61,  5 },   // LD   H,C
-    { &I8080::opcode_62,  5 },   // LD   H,D
-    { &I8080::opcode_63,  5 },   // LD   H,E
-    { &I8080::opcode_64,  5 },   // LD   H,H
-    { &I8080::opcode_65,  5 },   // LD   H,L
-    { &I8080::opcode_66,  7 },   // LD   H,(HL)
-    { &I8080::opcode_67,  5 },   // LD   H,A
-    { &I8080::opcode_68,  5 },   // LD   L,B
-    { &I8080::opcode_69,  5 },   // LD   L,C
-    { &I8080::opcode_6a,  5 },   // LD   L,D
-    { &I8080::opcode_6b,  5 },   // LD   L,E
-    { &I8080::opcode_6c,  5 },   // LD   L,H
-    { &I8080::opcode_6d,  5 },   // LD   L,L
-    { &I8080::opcode_6e,  7 },   // LD   L,(HL)
-    { &I8080::opcode_6f,  5 },   // LD   L,A
-    { &I8080::opcode_70,  7 },   // LD   (HL),B
-    { &I8080::opcode_71,  7 },   // LD   (HL),C
-    { &I8080::opcode_72,  7 },   // LD   (HL),D
-    { &I8080::opcode_73,  7 },   // LD   (HL),E
-    { &I8080::opcode_74,  7 },   // LD   (HL),H
-    { &I8080::opcode_75,  7 },   // LD   (HL),L
-    { &I8080::opcode_76,  7 },   // HALT
-    { &I8080::opcode_77,  7 },   // LD   (HL),A
-    { &I8080::opcode_78,  5 },   // LD   A,B
-    { &I8080::opcode_79,  5 },   // LD   A,C
-    { &I8080::opcode_7a,  5 },   // LD   A,D
-    { &I8080::opcode_7b,  5 },   // LD   A,E
-    { &I8080::opcode_7c,  5 },   // LD   A,H
-    { &I8080::opcode_7d,  5 },   // LD   A,L
-    { &I8080::opcode_7e,  7 },   // LD   A,(HL)
-    { &I8080::opcode_7f,  5 },   // LD   A,A
-    { &I8080::opcode_80,  4 },   // ADD  A,B
-    { &I8080::opcode_81,  4 },   // ADD  A,C
-    { &I8080::opcode_82,  4 },   // ADD  A,D
-    { &I8080::opcode_83,  4 },   // ADD  A,E
-    { &I8080::opcode_84,  4 },   // ADD  A,H
-    { &I8080::opcode_85,  4 },   // ADD  A,L
-    { &I8080::opcode_86,  7 },   // ADD  A,(HL)
-    { &I8080::opcode_87,  4 },   // ADD  A,A
-    { &I8080::opcode_88,  4 },   // ADC  A,B
-    { &I8080::opcode_89,  4 },   // ADC  A,C
-    { &I8080::opcode_8a,  4 },   // ADC  A,D
-    { &I8080::opcode_8b,  4 },   // ADC  A,E
-    { &I8080::opcode_8c,  4 },   // ADC  A,H
-    { &I8080::opcode_8d,  4 },   // ADC  A,L
-    { &I8080::opcode_8e,  7 },   // ADC  A,(HL)
-    { &I8080::opcode_8f,  4 },   // ADC  A,A
-    { &I8080::opcode_90,  4 },   // SUB  B
-    { &I8080::opcode_91,  4 },   // SUB  C
-    { &I8080::opcode_92,  4 },   // SUB  D
-    { &I8080::opcode_93,  4 },   // SUB  E
-    { &I8080::opcode_94,  4 },   // SUB  H
-    { &I8080::opcode_95,  4 },   // SUB  L
-    { &I8080::opcode_96,  7 },   // SUB  (HL)
-    { &I8080::opcode_97,  4 },   // SUB  A
-    { &I8080::opcode_98,  4 },   // SBC  A,B
-    { &I8080::opcode_99,  4 },   // SBC  A,C
-    { &I8080::opcode_9a,  4 },   // SBC  A,D
-    { &I8080::opcode_9b,  4 },   // SBC  A,E
-    { &I8080::opcode_9c,  4 },   // SBC  A,H
-    { &I8080::opcode_9d,  4 },   // SBC  A,L
-    { &I8080::opcode_9e,  7 },   // SBC  A,(HL)
-    { &I8080::opcode_9f,  4 },   // SBC  A,A
-    { &I8080::opcode_a0,  4 },   // AND  B
-    { &I8080::opcode_a1,  4 },   // AND  C
-    { &I8080::opcode_a2,  4 },   // AND  D
-    { &I8080::opcode_a3,  4 },   // AND  E
-    { &I8080::opcode_a4,  4 },   // AND  H
-    { &I8080::opcode_a5,  4 },   // AND  L
-    { &I8080::opcode_a6,  7 },   // AND  (HL)
-    { &I8080::opcode_a7,  4 },   // AND  A
-    { &I8080::opcode_a8,  4 },   // XOR  B
-    { &I8080::opcode_a9,  4 },   // XOR  C
-    { &I8080::opcode_aa,  4 },   // XOR  D
-    { &I8080::opcode_ab,  4 },   // XOR  E
-    { &I8080::opcode_ac,  4 },   // XOR  H
-    { &I8080::opcode_ad,  4 },   // XOR  L
-    { &I8080::opcode_ae,  7 },   // XOR  (HL)
-    { &I8080::opcode_af,  4 },   // XOR  A
-    { &I8080::opcode_b0,  4 },   // OR   B
-    { &I8080::opcode_b1,  4 },   // OR   C
-    { &I8080::opcode_b2,  4 },   // OR   D
-    { &I8080::opcode_b3,  4 },   // OR   E
-    { &I8080::opcode_b4,  4 },   // OR   H
-    { &I8080::opcode_b5,  4 },   // OR   L
-    { &I8080::opcode_b6,  7 },   // OR   (HL)
-    { &I8080::opcode_b7,  4 },   // OR   A
-    { &I8080::opcode_b8,  4 },   // CP   B
-    { &I8080::opcode_b9,  4 },   // CP   C
-    { &I8080::opcode_ba,  4 },   // CP   D
-    { &I8080::opcode_bb,  4 },   // CP   E
-    { &I8080::opcode_bc,  4 },   // CP   H
-    { &I8080::opcode_bd,  4 },   // CP   L
-    { &I8080::opcode_be,  7 },   // CP   (HL)
-    { &I8080::opcode_bf,  4 },   // CP   A
-    { &I8080::opcode_c0,  5 },   // RET  NZ
-    { &I8080::opcode_c1, 10 },   // POP  BC
-    { &I8080::opcode_c2, 10 },   // JP   NZ,nn
-    { &I8080::opcode_c3, 10 },   // JP   nn
-    { &I8080::opcode_c4, 11 },   // CALL NZ,nn
-    { &I8080::opcode_c5, 11 },   // PUSH BC
-    { &I8080::opcode_c6,  7 },   // ADD  A,n
-    { &I8080::opcode_c7, 11 },   // RST  0
-    { &I8080::opcode_c8,  5 },   // RET  Z
-    { &I8080::opcode_c9, 10 },   // RET
-    { &I8080::opcode_ca, 10 },   // JP   Z,nn
-    { 0, 4 },
-    { &I8080::opcode_cc, 11 },   // CALL Z,nn
-    { &I8080::opcode_cd, 17 },   // CALL nn
-    { &I8080::opcode_ce,  7 },   // ADC  A,n
-    { &I8080::opcode_cf, 11 },   // RST  8
-    { &I8080::opcode_d0,  5 },   // RET  NC
-    { &I8080::opcode_d1, 10 },   // POP  DE
-    { &I8080::opcode_d2, 10 },   // JP   NC,nn
-    { &I8080::opcode_d3, 10 },   // OUT  (n),A
-    { &I8080::opcode_d4, 11 },   // CALL NC,nn
-    { &I8080::opcode_d5, 11 },   // PUSH DE
-    { &I8080::opcode_d6,  7 },   // SUB  n
-    { &I8080::opcode_d7, 11 },   // RST  10H
-    { &I8080::opcode_d8,  5 },   // RET  C
-    { 0, 4 },
-    { &I8080::opcode_da, 10 },   // JP   C,nn
-    { &I8080::opcode_db, 10 },   // IN   A,(n)
-    { &I8080::opcode_dc, 11 },   // CALL C,nn
-    { 0, 4 },
-    { &I8080::opcode_de,  7 },   // SBC  A,n
-    { &I8080::opcode_df, 11 },   // RST  18H
-    { &I8080::opcode_e0,  5 },   // RET  PO
-    { &I8080::opcode_e1, 10 },   // POP  HL
-    { &I8080::opcode_e2, 10 },   // JP   PO,nn
-    { &I8080::opcode_e3,  4 },   // EX   (SP),HL
-    { &I8080::opcode_e4, 11 },   // CALL PO,nn
-    { &I8080::opcode_e5, 11 },   // PUSH HL
-    { &I8080::opcode_e6,  7 },   // AND  n
-    { &I8080::opcode_e7, 11 },   // RST  20H
-    { &I8080::opcode_e8,  5 },   // RET  PE
-    { &I8080::opcode_e9,  4 },   // JP   (HL)
-    { &I8080::opcode_ea, 10 },   // JP   PE,nn
-    { &I8080::opcode_eb,  4 },   // EX   DE,HL
-    { &I8080::opcode_ec, 11 },   // CALL PE,nn
-    { 0, 4 },
-    { &I8080::opcode_ee,  7 },   // XOR  n
-    { &I8080::opcode_ef, 11 },   // RST  28H
-    { &I8080::opcode_f0,  5 },   // RET  P
-    { &I8080::opcode_f1, 10 },   // POP  AF
-    { &I8080::opcode_f2, 10 },   // JP   P,nn
-    { &I8080::opcode_f3,  4 },   // DI
-    { &I8080::opcode_f4, 11 },   // CALL P,nn
-    { &I8080::opcode_f5, 11 },   // PUSH AF
-    { &I8080::opcode_f6,  7 },   // OR   n
-    { &I8080::opcode_f7, 11 },   // RST  30H
-    { &I8080::opcode_f8,  5 },   // RET  M
-    { &I8080::opcode_f9,  6 },   // LD   SP,HL
-    { &I8080::opcode_fa, 10 },   // JP   M,nn
-    { &I8080::opcode_fb,  4 },   // EI
-    { &I8080::opcode_fc, 11 },   // CALL M,nn
-    { 0, 4 },
-    { &I8080::opcode_fe,  7 },   // CP   n
-    { &I8080::opcode_ff, 11 }    // RST  38H
+const unsigned char I8080::Cycles_[256] = {
+     4,   // NOP
+    10,   // LD   BC,nn
+     7,   // LD   (BC),A
+     6,   // INC  BC
+     5,   // INC  B
+     5,   // DEC  B
+     7,   // LD   B,n
+     4,   // RLCA
+     4,   // 0x08
+    11,   // ADD  HL,BC
+     7,   // LD   A,(BC)
+     6,   // DEC  BC
+     5,   // INC  C
+     5,   // DEC  C
+     7,   // LD   C,n
+     4,   // RRCA
+     4,   // 0x10
+    10,   // LD   DE,nn
+     7,   // LD   (DE),A
+     6,   // INC  DE
+     5,   // INC  D
+     5,   // DEC  D
+     7,   // LD   D,n
+     4,   // RLA
+     4,   // 0x18
+    11,   // ADD  HL,DE
+     7,   // LD   A,(DE)
+     6,   // DEC  DE
+     5,   // INC  E
+     5,   // DEC  E
+     7,   // LD   E,n
+     4,   // RRA
+     4,   // 0x20
+    10,   // LD   HL,nn
+    16,   // LD   (nn),HL
+     6,   // INC  HL
+     5,   // INC  H
+     5,   // DEC  H
+     7,   // LD   H,n
+     4,   // DAA
+     4,   // 0x28
+    11,   // ADD  HL,HL
+    16,   // LD   HL,(nn)
+     6,   // DEC  HL
+     5,   // INC  L
+     5,   // DEC  L
+     7,   // LD   L,n
+     4,   // CPL
+     4,   // 0x30
+    10,   // LD   SP,nn
+    13,   // LD   (nn),A
+     6,   // INC  SP
+    10,   // INC  (HL)
+    10,   // DEC  (HL)
+    10,   // LD   (HL),n
+     4,   // SCF
+     4,   // 0x38
+    11,   // ADD  HL,SP
+    13,   // LD   A,(nn)
+     6,   // DEC  SP
+     5,   // INC  A
+     5,   // DEC  A
+     7,   // LD   A,n
+     4,   // CCF
+     5,   // LD   B,B
+     5,   // LD   B,C
+     5,   // LD   B,D
+     5,   // LD   B,E
+     5,   // LD   B,H
+     5,   // LD   B,L
+     7,   // LD   B,(HL)
+     5,   // LD   B,A
+     5,   // LD   C,B
+     5,   // LD   C,C
+     5,   // LD   C,D
+     5,   // LD   C,E
+     5,   // LD   C,H
+     5,   // LD   C,L
+     7,   // LD   C,(HL)
+     5,   // LD   C,A
+     5,   // LD   D,B
+     5,   // LD   D,C
+     5,   // LD   D,D
+     5,   // LD   D,E
+     5,   // LD   D,H
+     5,   // LD   D,L
+     7,   // LD   D,(HL)
+     5,   // LD   D,A
+     5,   // LD   E,B
+     5,   // LD   E,C
+     5,   // LD   E,D
+     5,   // LD   E,E
+     5,   // LD   E,H
+     5,   // LD   E,L
+     7,   // LD   E,(HL)
+     5,   // LD   E,A
+     5,   // LD   H,B
+     5,   // LD   H,C
+     5,   // LD   H,D
+     5,   // LD   H,E
+     5,   // LD   H,H
+     5,   // LD   H,L
+     7,   // LD   H,(HL)
+     5,   // LD   H,A
+     5,   // LD   L,B
+     5,   // LD   L,C
+     5,   // LD   L,D
+     5,   // LD   L,E
+     5,   // LD   L,H
+     5,   // LD   L,L
+     7,   // LD   L,(HL)
+     5,   // LD   L,A
+     7,   // LD   (HL),B
+     7,   // LD   (HL),C
+     7,   // LD   (HL),D
+     7,   // LD   (HL),E
+     7,   // LD   (HL),H
+     7,   // LD   (HL),L
+     7,   // HALT
+     7,   // LD   (HL),A
+     5,   // LD   A,B
+     5,   // LD   A,C
+     5,   // LD   A,D
+     5,   // LD   A,E
+     5,   // LD   A,H
+     5,   // LD   A,L
+     7,   // LD   A,(HL)
+     5,   // LD   A,A
+     4,   // ADD  A,B
+     4,   // ADD  A,C
+     4,   // ADD  A,D
+     4,   // ADD  A,E
+     4,   // ADD  A,H
+     4,   // ADD  A,L
+     7,   // ADD  A,(HL)
+     4,   // ADD  A,A
+     4,   // ADC  A,B
+     4,   // ADC  A,C
+     4,   // ADC  A,D
+     4,   // ADC  A,E
+     4,   // ADC  A,H
+     4,   // ADC  A,L
+     7,   // ADC  A,(HL)
+     4,   // ADC  A,A
+     4,   // SUB  B
+     4,   // SUB  C
+     4,   // SUB  D
+     4,   // SUB  E
+     4,   // SUB  H
+     4,   // SUB  L
+     7,   // SUB  (HL)
+     4,   // SUB  A
+     4,   // SBC  A,B
+     4,   // SBC  A,C
+     4,   // SBC  A,D
+     4,   // SBC  A,E
+     4,   // SBC  A,H
+     4,   // SBC  A,L
+     7,   // SBC  A,(HL)
+     4,   // SBC  A,A
+     4,   // AND  B
+     4,   // AND  C
+     4,   // AND  D
+     4,   // AND  E
+     4,   // AND  H
+     4,   // AND  L
+     7,   // AND  (HL)
+     4,   // AND  A
+     4,   // XOR  B
+     4,   // XOR  C
+     4,   // XOR  D
+     4,   // XOR  E
+     4,   // XOR  H
+     4,   // XOR  L
+     7,   // XOR  (HL)
+     4,   // XOR  A
+     4,   // OR   B
+     4,   // OR   C
+     4,   // OR   D
+     4,   // OR   E
+     4,   // OR   H
+     4,   // OR   L
+     7,   // OR   (HL)
+     4,   // OR   A
+     4,   // CP   B
+     4,   // CP   C
+     4,   // CP   D
+     4,   // CP   E
+     4,   // CP   H
+     4,   // CP   L
+     7,   // CP   (HL)
+     4,   // CP   A
+     5,   // RET  NZ
+    10,   // POP  BC
+    10,   // JP   NZ,nn
+    10,   // JP   nn
+    11,   // CALL NZ,nn
+    11,   // PUSH BC
+     7,   // ADD  A,n
+    11,   // RST  0
+     5,   // RET  Z
+    10,   // RET
+    10,   // JP   Z,nn
+     4,   // 0xCB
+    11,   // CALL Z,nn
+    17,   // CALL nn
+     7,   // ADC  A,n
+    11,   // RST  8
+     5,   // RET  NC
+    10,   // POP  DE
+    10,   // JP   NC,nn
+    10,   // OUT  (n),A
+    11,   // CALL NC,nn
+    11,   // PUSH DE
+     7,   // SUB  n
+    11,   // RST  10H
+     5,   // RET  C
+     4,   // 0xD9
+    10,   // JP   C,nn
+    10,   // IN   A,(n)
+    11,   // CALL C,nn
+     4,   // 0xDD
+     7,   // SBC  A,n
+    11,   // RST  18H
+     5,   // RET  PO
+    10,   // POP  HL
+    10,   // JP   PO,nn
+     4,   // EX   (SP),HL
+    11,   // CALL PO,nn
+    11,   // PUSH HL
+     7,   // AND  n
+    11,   // RST  20H
+     5,   // RET  PE
+     4,   // JP   (HL)
+    10,   // JP   PE,nn
+     4,   // EX   DE,HL
+    11,   // CALL PE,nn
+     4,   // 0xED
+     7,   // XOR  n
+    11,   // RST  28H
+     5,   // RET  P
+    10,   // POP  AF
+    10,   // JP   P,nn
+     4,   // DI
+    11,   // CALL P,nn
+    11,   // PUSH AF
+     7,   // OR   n
+    11,   // RST  30H
+     5,   // RET  M
+     6,   // LD   SP,HL
+    10,   // JP   M,nn
+     4,   // EI
+    11,   // CALL M,nn
+     4,   // 0xFD
+     7,   // CP   n
+    11   // RST  38H
 };
 
 void I8080::opcode_00()    // NOP
@@ -284,13 +284,13 @@ void I8080::opcode_00()    // NOP
 
 void I8080::opcode_01()    // LD   BC,nn
 {
-    C = env_.readByte( PC++ );
-    B = env_.readByte( PC++ );
+    C = readMem( PC++ );
+    B = readMem( PC++ );
 }
 
 void I8080::opcode_02()    // LD   (BC),A
 {
-    env_.writeByte( BC(), A );
+    writeMem( BC(), A );
 }
 
 void I8080::opcode_03()    // INC  BC
@@ -310,7 +310,7 @@ void I8080::opcode_05()    // DEC  B
 
 void I8080::opcode_06()    // LD   B,n
 {
-    B = env_.readByte( PC++ );
+    B = readMem( PC++ );
 }
 
 void I8080::opcode_07()    // RLCA
@@ -336,7 +336,7 @@ void I8080::opcode_09()    // ADD  HL,BC
 
 void I8080::opcode_0a()    // LD   A,(BC)
 {
-    A = env_.readByte( BC() );
+    A = readMem( BC() );
 }
 
 void I8080::opcode_0b()    // DEC  BC
@@ -356,7 +356,7 @@ void I8080::opcode_0d()    // DEC  C
 
 void I8080::opcode_0e()    // LD   C,n
 {
-    C = env_.readByte( PC++ );
+    C = readMem( PC++ );
 }
 
 void I8080::opcode_0f()    // RRCA
@@ -368,13 +368,13 @@ void I8080::opcode_0f()    // RRCA
 
 void I8080::opcode_11()    // LD   DE,nn
 {
-    E = env_.readByte( PC++ );
-    D = env_.readByte( PC++ );
+    E = readMem( PC++ );
+    D = readMem( PC++ );
 }
 
 void I8080::opcode_12()    // LD   (DE),A
 {
-    env_.writeByte( DE(), A );
+    writeMem( DE(), A );
 }
 
 void I8080::opcode_13()    // INC  DE
@@ -394,7 +394,7 @@ void I8080::opcode_15()    // DEC  D
 
 void I8080::opcode_16()    // LD   D,n
 {
-    D = env_.readByte( PC++ );
+    D = readMem( PC++ );
 }
 
 void I8080::opcode_17()    // RLA
@@ -423,7 +423,7 @@ void I8080::opcode_19()    // ADD  HL,DE
 
 void I8080::opcode_1a()    // LD   A,(DE)
 {
-    A = env_.readByte( DE() );
+    A = readMem( DE() );
 }
 
 void I8080::opcode_1b()    // DEC  DE
@@ -443,7 +443,7 @@ void I8080::opcode_1d()    // DEC  E
 
 void I8080::opcode_1e()    // LD   E,n
 {
-    E = env_.readByte( PC++ );
+    E = readMem( PC++ );
 }
 
 void I8080::opcode_1f()    // RRA
@@ -458,16 +458,16 @@ void I8080::opcode_1f()    // RRA
 
 void I8080::opcode_21()    // LD   HL,nn
 {
-    L = env_.readByte( PC++ );
-    H = env_.readByte( PC++ );
+    L = readMem( PC++ );
+    H = readMem( PC++ );
 }
 
 void I8080::opcode_22()    // LD   (nn),HL
 {
     unsigned x = nextWord();
 
-    env_.writeByte( x  , L );
-    env_.writeByte( x+1, H );
+    writeMem( x  , L );
+    writeMem( x+1, H );
 }
 
 void I8080::opcode_23()    // INC  HL
@@ -487,7 +487,7 @@ void I8080::opcode_25()    // DEC  H
 
 void I8080::opcode_26()    // LD   H,n
 {
-    H = env_.readByte( PC++ );
+    H = readMem( PC++ );
 }
 
 void I8080::opcode_27()    // DAA
@@ -529,8 +529,8 @@ void I8080::opcode_2a()    // LD   HL,(nn)
 {
     unsigned x = nextWord();
 
-    L = env_.readByte( x );
-    H = env_.readByte( x+1 );
+    L = readMem( x );
+    H = readMem( x+1 );
 }
 
 void I8080::opcode_2b()    // DEC  HL
@@ -550,7 +550,7 @@ void I8080::opcode_2d()    // DEC  L
 
 void I8080::opcode_2e()    // LD   L,n
 {
-    L = env_.readByte( PC++ );
+    L = readMem( PC++ );
 }
 
 void I8080::opcode_2f()    // CPL
@@ -566,7 +566,7 @@ void I8080::opcode_31()    // LD   SP,nn
 
 void I8080::opcode_32()    // LD   (nn),A
 {
-    env_.writeByte( nextWord(), A );
+    writeMem( nextWord(), A );
 }
 
 void I8080::opcode_33()    // INC  SP
@@ -576,17 +576,17 @@ void I8080::opcode_33()    // INC  SP
 
 void I8080::opcode_34()    // INC  (HL)
 {
-    env_.writeByte( HL(), incByte( env_.readByte( HL() ) ) );
+    writeMem( HL(), incByte( readMem( HL() ) ) );
 }
 
 void I8080::opcode_35()    // DEC  (HL)
 {
-    env_.writeByte( HL(), decByte( env_.readByte( HL() ) ) );
+    writeMem( HL(), decByte( readMem( HL() ) ) );
 }
 
 void I8080::opcode_36()    // LD   (HL),n
 {
-    env_.writeByte( HL(), env_.readByte( PC++ ) );
+    writeMem( HL(), readMem( PC++ ) );
 }
 
 void I8080::opcode_37()    // SCF
@@ -610,7 +610,7 @@ void I8080::opcode_39()    // ADD  HL,SP
 
 void I8080::opcode_3a()    // LD   A,(nn)
 {
-    A = env_.readByte( nextWord() );
+    A = readMem( nextWord() );
 }
 
 void I8080::opcode_3b()    // DEC  SP
@@ -630,7 +630,7 @@ void I8080::opcode_3d()    // DEC  A
 
 void I8080::opcode_3e()    // LD   A,n
 {
-    A = env_.readByte( PC++ );
+    A = readMem( PC++ );
 }
 
 void I8080::opcode_3f()    // CCF
@@ -669,7 +669,7 @@ void I8080::opcode_45()    // LD   B,L
 
 void I8080::opcode_46()    // LD   B,(HL)
 {
-    B = env_.readByte( HL() );
+    B = readMem( HL() );
 }
 
 void I8080::opcode_47()    // LD   B,A
@@ -708,7 +708,7 @@ void I8080::opcode_4d()    // LD   C,L
 
 void I8080::opcode_4e()    // LD   C,(HL)
 {
-    C = env_.readByte( HL() );
+    C = readMem( HL() );
 }
 
 void I8080::opcode_4f()    // LD   C,A
@@ -747,7 +747,7 @@ void I8080::opcode_55()    // LD   D,L
 
 void I8080::opcode_56()    // LD   D,(HL)
 {
-    D = env_.readByte( HL() );
+    D = readMem( HL() );
 }
 
 void I8080::opcode_57()    // LD   D,A
@@ -786,7 +786,7 @@ void I8080::opcode_5d()    // LD   E,L
 
 void I8080::opcode_5e()    // LD   E,(HL)
 {
-    E = env_.readByte( HL() );
+    E = readMem( HL() );
 }
 
 void I8080::opcode_5f()    // LD   E,A
@@ -825,7 +825,7 @@ void I8080::opcode_65()    // LD   H,L
 
 void I8080::opcode_66()    // LD   H,(HL)
 {
-    H = env_.readByte( HL() );
+    H = readMem( HL() );
 }
 
 void I8080::opcode_67()    // LD   H,A
@@ -864,7 +864,7 @@ void I8080::opcode_6d()    // LD   L,L
 
 void I8080::opcode_6e()    // LD   L,(HL)
 {
-    L = env_.readByte( HL() );
+    L = readMem( HL() );
 }
 
 void I8080::opcode_6f()    // LD   L,A
@@ -874,32 +874,32 @@ void I8080::opcode_6f()    // LD   L,A
 
 void I8080::opcode_70()    // LD   (HL),B
 {
-    env_.writeByte( HL(), B );
+    writeMem( HL(), B );
 }
 
 void I8080::opcode_71()    // LD   (HL),C
 {
-    env_.writeByte( HL(), C );
+    writeMem( HL(), C );
 }
 
 void I8080::opcode_72()    // LD   (HL),D
 {
-    env_.writeByte( HL(), D );
+    writeMem( HL(), D );
 }
 
 void I8080::opcode_73()    // LD   (HL),E
 {
-    env_.writeByte( HL(), E );
+    writeMem( HL(), E );
 }
 
 void I8080::opcode_74()    // LD   (HL),H
 {
-    env_.writeByte( HL(), H );
+    writeMem( HL(), H );
 }
 
 void I8080::opcode_75()    // LD   (HL),L
 {
-    env_.writeByte( HL(), L );
+    writeMem( HL(), L );
 }
 
 void I8080::opcode_76()    // HALT
@@ -910,7 +910,7 @@ void I8080::opcode_76()    // HALT
 
 void I8080::opcode_77()    // LD   (HL),A
 {
-    env_.writeByte( HL(), A );
+    writeMem( HL(), A );
 }
 
 void I8080::opcode_78()    // LD   A,B
@@ -945,7 +945,7 @@ void I8080::opcode_7d()    // LD   A,L
 
 void I8080::opcode_7e()    // LD   A,(HL)
 {
-    A = env_.readByte( HL() );
+    A = readMem( HL() );
 }
 
 void I8080::opcode_7f()    // LD   A,A
@@ -984,7 +984,7 @@ void I8080::opcode_85()    // ADD  A,L
 
 void I8080::opcode_86()    // ADD  A,(HL)
 {
-    addByte( env_.readByte( HL() ), 0 );
+    addByte( readMem( HL() ), 0 );
 }
 
 void I8080::opcode_87()    // ADD  A,A
@@ -1024,7 +1024,7 @@ void I8080::opcode_8d()    // ADC  A,L
 
 void I8080::opcode_8e()    // ADC  A,(HL)
 {
-    addByte( env_.readByte( HL() ), F & Carry );
+    addByte( readMem( HL() ), F & Carry );
 }
 
 void I8080::opcode_8f()    // ADC  A,A
@@ -1064,7 +1064,7 @@ void I8080::opcode_95()    // SUB  L
 
 void I8080::opcode_96()    // SUB  (HL)
 {
-    A = subByte( env_.readByte( HL() ), 0 );
+    A = subByte( readMem( HL() ), 0 );
 }
 
 void I8080::opcode_97()    // SUB  A
@@ -1104,7 +1104,7 @@ void I8080::opcode_9d()    // SBC  A,L
 
 void I8080::opcode_9e()    // SBC  A,(HL)
 {
-    A = subByte( env_.readByte( HL() ), F & Carry );
+    A = subByte( readMem( HL() ), F & Carry );
 }
 
 void I8080::opcode_9f()    // SBC  A,A
@@ -1150,7 +1150,7 @@ void I8080::opcode_a5()    // AND  L
 
 void I8080::opcode_a6()    // AND  (HL)
 {
-    A &= env_.readByte( HL() );
+    A &= readMem( HL() );
     clearAndSetFlagsPSZ();
 }
 
@@ -1197,7 +1197,7 @@ void I8080::opcode_ad()    // XOR  L
 
 void I8080::opcode_ae()    // XOR  (HL)
 {
-    A ^= env_.readByte( HL() );
+    A ^= readMem( HL() );
     clearAndSetFlagsPSZ();
 }
 
@@ -1245,7 +1245,7 @@ void I8080::opcode_b5()    // OR   L
 
 void I8080::opcode_b6()    // OR   (HL)
 {
-    A |= env_.readByte( HL() );
+    A |= readMem( HL() );
     clearAndSetFlagsPSZ();
 }
 
@@ -1286,7 +1286,7 @@ void I8080::opcode_bd()    // CP   L
 
 void I8080::opcode_be()    // CP   (HL)
 {
-    subByte( env_.readByte( HL() ), 0 );
+    subByte( readMem( HL() ), 0 );
 }
 
 void I8080::opcode_bf()    // CP   A
@@ -1304,8 +1304,8 @@ void I8080::opcode_c0()    // RET  NZ
 
 void I8080::opcode_c1()    // POP  BC
 {
-    C = env_.readByte( SP++ );
-    B = env_.readByte( SP++ );
+    C = readMem( SP++ );
+    B = readMem( SP++ );
 }
 
 void I8080::opcode_c2()    // JP   NZ,nn
@@ -1320,7 +1320,7 @@ void I8080::opcode_c2()    // JP   NZ,nn
 
 void I8080::opcode_c3()    // JP   nn
 {
-     PC = env_.readWord( PC );
+     PC = readMemWord( PC );
 }
 
 void I8080::opcode_c4()    // CALL NZ,nn
@@ -1335,13 +1335,13 @@ void I8080::opcode_c4()    // CALL NZ,nn
 
 void I8080::opcode_c5()    // PUSH BC
 {
-    env_.writeByte( --SP, B );
-    env_.writeByte( --SP, C );
+    writeMem( --SP, B );
+    writeMem( --SP, C );
 }
 
 void I8080::opcode_c6()    // ADD  A,n
 {
-    addByte( env_.readByte( PC++ ), 0 );
+    addByte( readMem( PC++ ), 0 );
 }
 
 void I8080::opcode_c7()    // RST  0
@@ -1389,7 +1389,7 @@ void I8080::opcode_cd()    // CALL nn
 
 void I8080::opcode_ce()    // ADC  A,n
 {
-    addByte( env_.readByte( PC++ ), F & Carry );
+    addByte( readMem( PC++ ), F & Carry );
 }
 
 void I8080::opcode_cf()    // RST  8
@@ -1407,8 +1407,8 @@ void I8080::opcode_d0()    // RET  NC
 
 void I8080::opcode_d1()    // POP  DE
 {
-    E = env_.readByte( SP++ );
-    D = env_.readByte( SP++ );
+    E = readMem( SP++ );
+    D = readMem( SP++ );
 }
 
 void I8080::opcode_d2()    // JP   NC,nn
@@ -1423,7 +1423,7 @@ void I8080::opcode_d2()    // JP   NC,nn
 
 void I8080::opcode_d3()    // OUT  (n),A
 {
-    env_.writePort( env_.readByte( PC++ ), A );
+    env_.writePort( readMem( PC++ ), A );
 }
 
 void I8080::opcode_d4()    // CALL NC,nn
@@ -1438,13 +1438,13 @@ void I8080::opcode_d4()    // CALL NC,nn
 
 void I8080::opcode_d5()    // PUSH DE
 {
-    env_.writeByte( --SP, D );
-    env_.writeByte( --SP, E );
+    writeMem( --SP, D );
+    writeMem( --SP, E );
 }
 
 void I8080::opcode_d6()    // SUB  n
 {
-    A = subByte( env_.readByte( PC++ ), 0 );
+    A = subByte( readMem( PC++ ), 0 );
 }
 
 void I8080::opcode_d7()    // RST  10H
@@ -1472,7 +1472,7 @@ void I8080::opcode_da()    // JP   C,nn
 
 void I8080::opcode_db()    // IN   A,(n)
 {
-    A = env_.readPort( env_.readByte( PC++ ) );
+    A = env_.readPort( readMem( PC++ ) );
 }
 
 void I8080::opcode_dc()    // CALL C,nn
@@ -1487,7 +1487,7 @@ void I8080::opcode_dc()    // CALL C,nn
 
 void I8080::opcode_de()    // SBC  A,n
 {
-    A = subByte( env_.readByte( PC++ ), F & Carry );
+    A = subByte( readMem( PC++ ), F & Carry );
 }
 
 void I8080::opcode_df()    // RST  18H
@@ -1505,8 +1505,8 @@ void I8080::opcode_e0()    // RET  PO
 
 void I8080::opcode_e1()    // POP  HL
 {
-    L = env_.readByte( SP++ );
-    H = env_.readByte( SP++ );
+    L = readMem( SP++ );
+    H = readMem( SP++ );
 }
 
 void I8080::opcode_e2()    // JP   PO,nn
@@ -1523,8 +1523,8 @@ void I8080::opcode_e3()    // EX   (SP),HL
 {
     unsigned char   x;
 
-    x = env_.readByte( SP   ); env_.writeByte( SP,   L ); L = x;
-    x = env_.readByte( SP+1 ); env_.writeByte( SP+1, H ); H = x;
+    x = readMem( SP   ); writeMem( SP,   L ); L = x;
+    x = readMem( SP+1 ); writeMem( SP+1, H ); H = x;
 }
 
 void I8080::opcode_e4()    // CALL PO,nn
@@ -1539,13 +1539,13 @@ void I8080::opcode_e4()    // CALL PO,nn
 
 void I8080::opcode_e5()    // PUSH HL
 {
-    env_.writeByte( --SP, H );
-    env_.writeByte( --SP, L );
+    writeMem( --SP, H );
+    writeMem( --SP, L );
 }
 
 void I8080::opcode_e6()    // AND  n
 {
-    A &= env_.readByte( PC++ );
+    A &= readMem( PC++ );
     clearAndSetFlagsPSZ();
 }
 
@@ -1597,7 +1597,7 @@ void I8080::opcode_ec()    // CALL PE,nn
 
 void I8080::opcode_ee()    // XOR  n
 {
-    A ^= env_.readByte( PC++ );
+    A ^= readMem( PC++ );
     clearAndSetFlagsPSZ();
 }
 
@@ -1616,8 +1616,8 @@ void I8080::opcode_f0()    // RET  P
 
 void I8080::opcode_f1()    // POP  AF
 {
-    F = env_.readByte( SP++ );
-    A = env_.readByte( SP++ );
+    F = readMem( SP++ );
+    A = readMem( SP++ );
 }
 
 void I8080::opcode_f2()    // JP   P,nn
@@ -1647,13 +1647,13 @@ void I8080::opcode_f4()    // CALL P,nn
 
 void I8080::opcode_f5()    // PUSH AF
 {
-    env_.writeByte( --SP, A );
-    env_.writeByte( --SP, F );
+    writeMem( --SP, A );
+    writeMem( --SP, F );
 }
 
 void I8080::opcode_f6()    // OR   n
 {
-    A |= env_.readByte( PC++ );
+    A |= readMem( PC++ );
     clearAndSetFlagsPSZ();
 }
 
@@ -1704,10 +1704,294 @@ void I8080::opcode_fc()    // CALL M,nn
 
 void I8080::opcode_fe()    // CP   n
 {
-    subByte( env_.readByte( PC++ ), 0 );
+    subByte( readMem( PC++ ), 0 );
 }
 
 void I8080::opcode_ff()    // RST  38H
 {
     callSub( 0x38 );
 }
+
+/*
+    Opcode dispatch.
+
+    A switch in the same translation unit as the opcode implementations lets the
+    compiler turn every handler into a direct (mostly inlined) call, instead of the
+    indirect member function call of a pointer table.
+*/
+inline void I8080::execute( unsigned op )
+{
+    switch( op ) {
+    case 0x00: opcode_00(); break;
+    case 0x01: opcode_01(); break;
+    case 0x02: opcode_02(); break;
+    case 0x03: opcode_03(); break;
+    case 0x04: opcode_04(); break;
+    case 0x05: opcode_05(); break;
+    case 0x06: opcode_06(); break;
+    case 0x07: opcode_07(); break;
+    case 0x09: opcode_09(); break;
+    case 0x0a: opcode_0a(); break;
+    case 0x0b: opcode_0b(); break;
+    case 0x0c: opcode_0c(); break;
+    case 0x0d: opcode_0d(); break;
+    case 0x0e: opcode_0e(); break;
+    case 0x0f: opcode_0f(); break;
+    case 0x11: opcode_11(); break;
+    case 0x12: opcode_12(); break;
+    case 0x13: opcode_13(); break;
+    case 0x14: opcode_14(); break;
+    case 0x15: opcode_15(); break;
+    case 0x16: opcode_16(); break;
+    case 0x17: opcode_17(); break;
+    case 0x19: opcode_19(); break;
+    case 0x1a: opcode_1a(); break;
+    case 0x1b: opcode_1b(); break;
+    case 0x1c: opcode_1c(); break;
+    case 0x1d: opcode_1d(); break;
+    case 0x1e: opcode_1e(); break;
+    case 0x1f: opcode_1f(); break;
+    case 0x21: opcode_21(); break;
+    case 0x22: opcode_22(); break;
+    case 0x23: opcode_23(); break;
+    case 0x24: opcode_24(); break;
+    case 0x25: opcode_25(); break;
+    case 0x26: opcode_26(); break;
+    case 0x27: opcode_27(); break;
+    case 0x29: opcode_29(); break;
+    case 0x2a: opcode_2a(); break;
+    case 0x2b: opcode_2b(); break;
+    case 0x2c: opcode_2c(); break;
+    case 0x2d: opcode_2d(); break;
+    case 0x2e: opcode_2e(); break;
+    case 0x2f: opcode_2f(); break;
+    case 0x31: opcode_31(); break;
+    case 0x32: opcode_32(); break;
+    case 0x33: opcode_33(); break;
+    case 0x34: opcode_34(); break;
+    case 0x35: opcode_35(); break;
+    case 0x36: opcode_36(); break;
+    case 0x37: opcode_37(); break;
+    case 0x39: opcode_39(); break;
+    case 0x3a: opcode_3a(); break;
+    case 0x3b: opcode_3b(); break;
+    case 0x3c: opcode_3c(); break;
+    case 0x3d: opcode_3d(); break;
+    case 0x3e: opcode_3e(); break;
+    case 0x3f: opcode_3f(); break;
+    case 0x40: opcode_40(); break;
+    case 0x41: opcode_41(); break;
+    case 0x42: opcode_42(); break;
+    case 0x43: opcode_43(); break;
+    case 0x44: opcode_44(); break;
+    case 0x45: opcode_45(); break;
+    case 0x46: opcode_46(); break;
+    case 0x47: opcode_47(); break;
+    case 0x48: opcode_48(); break;
+    case 0x49: opcode_49(); break;
+    case 0x4a: opcode_4a(); break;
+    case 0x4b: opcode_4b(); break;
+    case 0x4c: opcode_4c(); break;
+    case 0x4d: opcode_4d(); break;
+    case 0x4e: opcode_4e(); break;
+    case 0x4f: opcode_4f(); break;
+    case 0x50: opcode_50(); break;
+    case 0x51: opcode_51(); break;
+    case 0x52: opcode_52(); break;
+    case 0x53: opcode_53(); break;
+    case 0x54: opcode_54(); break;
+    case 0x55: opcode_55(); break;
+    case 0x56: opcode_56(); break;
+    case 0x57: opcode_57(); break;
+    case 0x58: opcode_58(); break;
+    case 0x59: opcode_59(); break;
+    case 0x5a: opcode_5a(); break;
+    case 0x5b: opcode_5b(); break;
+    case 0x5c: opcode_5c(); break;
+    case 0x5d: opcode_5d(); break;
+    case 0x5e: opcode_5e(); break;
+    case 0x5f: opcode_5f(); break;
+    case 0x60: opcode_60(); break;
+    case 0x61: opcode_61(); break;
+    case 0x62: opcode_62(); break;
+    case 0x63: opcode_63(); break;
+    case 0x64: opcode_64(); break;
+    case 0x65: opcode_65(); break;
+    case 0x66: opcode_66(); break;
+    case 0x67: opcode_67(); break;
+    case 0x68: opcode_68(); break;
+    case 0x69: opcode_69(); break;
+    case 0x6a: opcode_6a(); break;
+    case 0x6b: opcode_6b(); break;
+    case 0x6c: opcode_6c(); break;
+    case 0x6d: opcode_6d(); break;
+    case 0x6e: opcode_6e(); break;
+    case 0x6f: opcode_6f(); break;
+    case 0x70: opcode_70(); break;
+    case 0x71: opcode_71(); break;
+    case 0x72: opcode_72(); break;
+    case 0x73: opcode_73(); break;
+    case 0x74: opcode_74(); break;
+    case 0x75: opcode_75(); break;
+    case 0x76: opcode_76(); break;
+    case 0x77: opcode_77(); break;
+    case 0x78: opcode_78(); break;
+    case 0x79: opcode_79(); break;
+    case 0x7a: opcode_7a(); break;
+    case 0x7b: opcode_7b(); break;
+    case 0x7c: opcode_7c(); break;
+    case 0x7d: opcode_7d(); break;
+    case 0x7e: opcode_7e(); break;
+    case 0x7f: opcode_7f(); break;
+    case 0x80: opcode_80(); break;
+    case 0x81: opcode_81(); break;
+    case 0x82: opcode_82(); break;
+    case 0x83: opcode_83(); break;
+    case 0x84: opcode_84(); break;
+    case 0x85: opcode_85(); break;
+    case 0x86: opcode_86(); break;
+    case 0x87: opcode_87(); break;
+    case 0x88: opcode_88(); break;
+    case 0x89: opcode_89(); break;
+    case 0x8a: opcode_8a(); break;
+    case 0x8b: opcode_8b(); break;
+    case 0x8c: opcode_8c(); break;
+    case 0x8d: opcode_8d(); break;
+    case 0x8e: opcode_8e(); break;
+    case 0x8f: opcode_8f(); break;
+    case 0x90: opcode_90(); break;
+    case 0x91: opcode_91(); break;
+    case 0x92: opcode_92(); break;
+    case 0x93: opcode_93(); break;
+    case 0x94: opcode_94(); break;
+    case 0x95: opcode_95(); break;
+    case 0x96: opcode_96(); break;
+    case 0x97: opcode_97(); break;
+    case 0x98: opcode_98(); break;
+    case 0x99: opcode_99(); break;
+    case 0x9a: opcode_9a(); break;
+    case 0x9b: opcode_9b(); break;
+    case 0x9c: opcode_9c(); break;
+    case 0x9d: opcode_9d(); break;
+    case 0x9e: opcode_9e(); break;
+    case 0x9f: opcode_9f(); break;
+    case 0xa0: opcode_a0(); break;
+    case 0xa1: opcode_a1(); break;
+    case 0xa2: opcode_a2(); break;
+    case 0xa3: opcode_a3(); break;
+    case 0xa4: opcode_a4(); break;
+    case 0xa5: opcode_a5(); break;
+    case 0xa6: opcode_a6(); break;
+    case 0xa7: opcode_a7(); break;
+    case 0xa8: opcode_a8(); break;
+    case 0xa9: opcode_a9(); break;
+    case 0xaa: opcode_aa(); break;
+    case 0xab: opcode_ab(); break;
+    case 0xac: opcode_ac(); break;
+    case 0xad: opcode_ad(); break;
+    case 0xae: opcode_ae(); break;
+    case 0xaf: opcode_af(); break;
+    case 0xb0: opcode_b0(); break;
+    case 0xb1: opcode_b1(); break;
+    case 0xb2: opcode_b2(); break;
+    case 0xb3: opcode_b3(); break;
+    case 0xb4: opcode_b4(); break;
+    case 0xb5: opcode_b5(); break;
+    case 0xb6: opcode_b6(); break;
+    case 0xb7: opcode_b7(); break;
+    case 0xb8: opcode_b8(); break;
+    case 0xb9: opcode_b9(); break;
+    case 0xba: opcode_ba(); break;
+    case 0xbb: opcode_bb(); break;
+    case 0xbc: opcode_bc(); break;
+    case 0xbd: opcode_bd(); break;
+    case 0xbe: opcode_be(); break;
+    case 0xbf: opcode_bf(); break;
+    case 0xc0: opcode_c0(); break;
+    case 0xc1: opcode_c1(); break;
+    case 0xc2: opcode_c2(); break;
+    case 0xc3: opcode_c3(); break;
+    case 0xc4: opcode_c4(); break;
+    case 0xc5: opcode_c5(); break;
+    case 0xc6: opcode_c6(); break;
+    case 0xc7: opcode_c7(); break;
+    case 0xc8: opcode_c8(); break;
+    case 0xc9: opcode_c9(); break;
+    case 0xca: opcode_ca(); break;
+    case 0xcc: opcode_cc(); break;
+    case 0xcd: opcode_cd(); break;
+    case 0xce: opcode_ce(); break;
+    case 0xcf: opcode_cf(); break;
+    case 0xd0: opcode_d0(); break;
+    case 0xd1: opcode_d1(); break;
+    case 0xd2: opcode_d2(); break;
+    case 0xd3: opcode_d3(); break;
+    case 0xd4: opcode_d4(); break;
+    case 0xd5: opcode_d5(); break;
+    case 0xd6: opcode_d6(); break;
+    case 0xd7: opcode_d7(); break;
+    case 0xd8: opcode_d8(); break;
+    case 0xda: opcode_da(); break;
+    case 0xdb: opcode_db(); break;
+    case 0xdc: opcode_dc(); break;
+    case 0xde: opcode_de(); break;
+    case 0xdf: opcode_df(); break;
+    case 0xe0: opcode_e0(); break;
+    case 0xe1: opcode_e1(); break;
+    case 0xe2: opcode_e2(); break;
+    case 0xe3: opcode_e3(); break;
+    case 0xe4: opcode_e4(); break;
+    case 0xe5: opcode_e5(); break;
+    case 0xe6: opcode_e6(); break;
+    case 0xe7: opcode_e7(); break;
+    case 0xe8: opcode_e8(); break;
+    case 0xe9: opcode_e9(); break;
+    case 0xea: opcode_ea(); break;
+    case 0xeb: opcode_eb(); break;
+    case 0xec: opcode_ec(); break;
+    case 0xee: opcode_ee(); break;
+    case 0xef: opcode_ef(); break;
+    case 0xf0: opcode_f0(); break;
+    case 0xf1: opcode_f1(); break;
+    case 0xf2: opcode_f2(); break;
+    case 0xf3: opcode_f3(); break;
+    case 0xf4: opcode_f4(); break;
+    case 0xf5: opcode_f5(); break;
+    case 0xf6: opcode_f6(); break;
+    case 0xf7: opcode_f7(); break;
+    case 0xf8: opcode_f8(); break;
+    case 0xf9: opcode_f9(); break;
+    case 0xfa: opcode_fa(); break;
+    case 0xfb: opcode_fb(); break;
+    case 0xfc: opcode_fc(); break;
+    case 0xfe: opcode_fe(); break;
+    case 0xff: opcode_ff(); break;
+    default:    // Undocumented opcodes execute as NOP
+        break;
+    }
+}
+
+void I8080::step()
+{
+    unsigned op = readMem( PC++ );
+
+    // Execute
+    cycles_ += Cycles_[ op ];
+    execute( op );
+
+    PC &= 0xFFFF;
+}
+
+unsigned I8080::run( unsigned cycles )
+{
+    while( cycles_ < cycles ) {
+        unsigned op = readMem( PC++ );
+
+        cycles_ += Cycles_[ op ];
+        execute( op );
+
+        PC &= 0xFFFF;
+    }
+
+    return cycles_;
+}
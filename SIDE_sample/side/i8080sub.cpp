@@ -38,6 +38,34 @@ unsigned char I8080::PSZ_[256] = {
     Sign|Parity, Sign, Sign, Sign|Parity, Sign, Sign|Parity, Sign|Parity, Sign, Sign, Sign|Parity, Sign|Parity, Sign, Sign|Parity, Sign, Sign, Sign|Parity
 };
 
+unsigned char I8080::ZS_[256];
+unsigned char I8080::IncF_[256];
+unsigned char I8080::DecF_[256];
+
+void I8080::initTables()
+{
+    static bool done = false;
+
+    if( done ) return;
+
+    for( unsigned i=0; i<256; i++ ) {
+        unsigned char zs = PSZ_[i] & (Zero | Sign);
+
+        ZS_[i] = zs;
+
+        // Result of an increment: halfcarry when the low nibble wrapped to zero
+        IncF_[i] = zs;
+        if( (i & 0x0F) == 0 ) IncF_[i] |= HalfCarry;
+        if( i == 0x80 ) IncF_[i] |= Overflow;
+
+        // Result of a decrement: halfcarry when the low nibble wrapped from zero
+        DecF_[i] = zs;
+        if( (i & 0x0F) == 0x0F ) DecF_[i] |= HalfCarry;
+        if( i == 0x7F ) DecF_[i] |= Overflow;
+    }
+
+    done = true;
+}
 
 void I8080::addByte( unsigned char op, unsigned char cf )
 {
@@ -45,9 +73,7 @@ void I8080::addByte( unsigned char op, unsigned char cf )
 
     if( cf ) x++;
 
-    F &= (Flag3 | Flag5);
-    if( ! (x & 0xFF) ) F |= Zero;
-    if( x & 0x80 ) F |= Sign;
+    F = (F & (Flag3 | Flag5)) | ZS_[x & 0xFF];
     if( x >= 0x100 ) F |= Carry;
 
     /*
@@ -119,7 +145,7 @@ void I8080::addByte( unsigned char op, unsigned char cf )
 void I8080::callSub( unsigned addr )
 {
     SP -= 2;
-    env_.writeWord( SP, PC );
+    writeMemWord( SP, PC );
     PC = addr & 0xFFFF;
 }
 
@@ -130,12 +156,8 @@ void I8080::clearAndSetFlagsPSZ()
 
 unsigned char I8080::decByte( unsigned char b )
 {
-    F = (F & ~(Zero | Sign | HalfCarry | Overflow)) | AddSub;
-    if( (b & 0x0F) == 0 ) F |= HalfCarry;
     --b;
-    if( b == 0x7F ) F |= Overflow;
-    if( b & 0x80 ) F |= Sign;
-    if( b == 0 ) F |= Zero;
+    F = (F & ~(Zero | Sign | HalfCarry | Overflow)) | AddSub | DecF_[b];
 
     return b;
 }
@@ -143,25 +165,21 @@ unsigned char I8080::decByte( unsigned char b )
 unsigned char I8080::incByte( unsigned char b )
 {
     ++b;
-    F &= ~(AddSub | Zero | Sign | HalfCarry | Overflow);
-    if( ! (b & 0x0F) ) F |= HalfCarry;
-    if( b == 0x80 ) F |= Overflow;
-    if( b & 0x80 ) F |= Sign;
-    if( b == 0 ) F |= Zero;
+    F = (F & ~(AddSub | Zero | Sign | HalfCarry | Overflow)) | IncF_[b];
 
     return b;
 }
 
 unsigned I8080::nextWord()
 {
-    unsigned x = env_.readWord( PC );
+    unsigned x = readMemWord( PC );
     PC += 2;
     return x;
 }
 
 void I8080::retFromSub()
 {
-    PC = env_.readWord( SP );
+    PC = readMemWord( SP );
     SP += 2;
 }
 
@@ -176,9 +194,7 @@ unsigned char I8080::subByte( unsigned char op, unsigned char cf )
 
     if( cf ) x--;
 
-    F = Subtraction | (F & (Flag3 | Flag5));
-    if( x == 0 ) F |= Zero;
-    if( x & 0x80 ) F |= Sign;
+    F = Subtraction | (F & (Flag3 | Flag5)) | ZS_[x];
     if( (x >= A) && (op | cf)) F |= Carry;
 
     // See addByte() for an explanation of the halfcarry bit.
@@ -39,9 +39,13 @@ namespace {
 	static const uint16_t LCD_X = 480;
 	static const uint16_t LCD_Y = 272;
 	uint16_t* fb_ = reinterpret_cast<uint16_t*>(0x0080'0000);
+	static const uint32_t EXRAM_SIZE = 512 * 1024;  // 0x0080'0000 から 512K バイト
 	typedef device::PORT<device::PORTB, device::bitpos::B3> LCD_DISP;
 	typedef device::PORT<device::PORT6, device::bitpos::B7> LCD_LIGHT;
 	typedef device::glcdc_mgr<device::GLCDC, LCD_X, LCD_Y, graphics::pixel::TYPE::RGB565> GLCDC_MGR;
+	// ダブルバッファで EXRAM をほぼ使い切るので、Z バッファ（255K バイト）は内蔵 RAM に置く
+	static_assert((GLCDC_MGR::frame_size * 2) <= EXRAM_SIZE, "Frame buffer overflows EXRAM");
+	uint16_t	depth_[GLCDC_MGR::line_width * LCD_Y];
 	typedef device::drw2d_mgr<GLCDC_MGR, FONT> RENDER;
 
 	typedef utils::fixed_fifo<uint8_t, 64> RB64;
@@ -168,6 +172,12 @@ int main(int argc, char** argv)
 	{  // TGL 初期化
 		tgl_.start();
 
+		tgl_.set_depth_buffer(depth_);
+		tgl_.enable(TGL::CTRL::CULL_FACE);
+		tgl_.enable(TGL::CTRL::DEPTH_TEST);
+		tgl_.enable(TGL::CTRL::LIGHTING);
+		tgl_.Light(vtx::fvtx(0.3f, 0.5f, 1.0f), 0.25f);
+
 		// テクスチャーパターンの生成
 		for(int16_t y = 0; y < TEX_H; ++y) {
 			for(int16_t x = 0; x < TEX_W; ++x) {
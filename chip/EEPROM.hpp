@@ -1,14 +1,18 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	I2C EEPROM ドライバー
+	@brief	I2C EEPROM ドライバー @n
+			・書き込み完了は ACK ポーリングで検出し、次のアクセスの直前まで待たない。 @n
+			・SLOT_NUM を指定すると、put による書き込みをページ単位のバッファで @n
+			  まとめ（ライトバック）、service でページ毎に書き込む。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2017, 2021 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2017, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
 #include <cstdint>
+#include <cstring>
 #include "common/delay.hpp"
 
 namespace chip {
@@ -16,15 +20,42 @@ namespace chip {
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  EEPROM テンプレートクラス
-		@param[in]	I2C_IO	i2c I/O クラス
+		@param[in]	I2C_IO		i2c I/O クラス
+		@param[in]	SLOT_NUM	ライトバック・バッファのページ数（０なら使わない）
+		@param[in]	PAGE_MAX	ライトバック・バッファ１ページの最大サイズ
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class I2C_IO>
+	template <class I2C_IO, uint32_t SLOT_NUM = 0, uint32_t PAGE_MAX = 64>
 	class EEPROM {
 	public:
 		static constexpr uint8_t	I2C_ADR = 0x50;
 
 	private:
+		static constexpr uint32_t NO_PAGE = 0xffff'ffff;
+
+		struct slot_t {
+			uint32_t	page;	// ページ先頭アドレス（NO_PAGE なら空き）
+			uint32_t	seq;	// 確保した順番
+			uint16_t	lo;		// 書き込み範囲（ページ内オフセット）
+			uint16_t	hi;
+			uint8_t		data[PAGE_MAX];
+		};
+
+		// ライトバック・バッファ（SLOT_NUM が０の場合、ページのバッファを持たない）
+		template <uint32_t N, class DUMMY = void>
+		struct slot_buff_t {
+			slot_t	slot[N];
+
+			slot_buff_t() noexcept {
+				for(auto& t : slot) t.page = NO_PAGE;
+			}
+
+			slot_t& operator [] (uint32_t idx) noexcept { return slot[idx]; }
+			const slot_t& operator [] (uint32_t idx) const noexcept { return slot[idx]; }
+		};
+
+		template <class DUMMY>
+		struct slot_buff_t<0, DUMMY> { };
 
 		I2C_IO&	i2c_io_;
 
@@ -32,6 +63,11 @@ namespace chip {
 		bool	exp_;
 		bool	ad_mix_;
 		uint8_t	pagen_;
+		bool	busy_;
+		uint32_t	last_;	// 最後に書き込んだアドレス（ACK ポーリング用）
+
+		uint32_t	seq_;
+		slot_buff_t<SLOT_NUM>	slot_;
 
 		uint8_t i2c_adr_(uint32_t adr) const noexcept
 		{
@@ -42,6 +78,94 @@ namespace chip {
 			return a;
 		}
 
+		// ACK ポーリング（アドレスのみ送信し、デバイスが応答したら「true」）
+		bool poll_(uint32_t adr) noexcept
+		{
+			uint8_t tmp[2];
+			if(exp_) {
+				tmp[0] = (adr >> 8) & 255;
+				tmp[1] =  adr & 255;
+				return i2c_io_.send(i2c_adr_(adr), tmp, 2);
+			} else {
+				tmp[0] = adr & 255;
+				return i2c_io_.send(i2c_adr_(adr), tmp, 1);
+			}
+		}
+
+		bool ready_(uint32_t adr) noexcept
+		{
+			if(!busy_) return true;
+			if(!sync_write(adr)) return false;
+			return true;
+		}
+
+		bool write_page_(uint32_t adr, const uint8_t* src, uint16_t len) noexcept
+		{
+			if(!ready_(adr)) return false;
+			bool ok;
+			if(exp_) {
+				ok = i2c_io_.send(i2c_adr_(adr), adr >> 8, adr & 255, src, len);
+			} else {
+				ok = i2c_io_.send(i2c_adr_(adr), adr & 255, src, len);
+			}
+			busy_ = ok;
+			if(ok) last_ = adr;
+			return ok;
+		}
+
+		uint32_t buff_page_() const noexcept
+		{
+			return pagen_ < PAGE_MAX ? pagen_ : PAGE_MAX;
+		}
+
+		bool flush_slot_(slot_t& t) noexcept
+		{
+			if(t.page == NO_PAGE) return true;
+			bool ok = true;
+			if(t.hi > t.lo) {
+				ok = write_page_(t.page + t.lo, &t.data[t.lo], t.hi - t.lo);
+			}
+			if(ok) t.page = NO_PAGE;
+			return ok;
+		}
+
+		slot_t* oldest_() noexcept
+		{
+			slot_t* t = nullptr;
+			if constexpr (SLOT_NUM > 0) {
+				for(uint32_t i = 0; i < SLOT_NUM; ++i) {
+					if(slot_[i].page == NO_PAGE) continue;
+					if(t == nullptr || static_cast<int32_t>(slot_[i].seq - t->seq) < 0) {
+						t = &slot_[i];
+					}
+				}
+			}
+			return t;
+		}
+
+		bool read_dev_(uint32_t adr, void* dst, uint16_t len) noexcept
+		{
+			if(!ready_(adr)) return false;
+			if(exp_) {
+				uint8_t tmp[2];
+				tmp[0] = (adr >> 8) & 255;
+				tmp[1] =  adr & 255;
+				if(!i2c_io_.send(i2c_adr_(adr), tmp, 2)) {
+					return false;
+				}
+			} else {
+				uint8_t tmp[1];
+				tmp[0] = adr & 255;
+				if(!i2c_io_.send(i2c_adr_(adr), tmp, 1)) {
+					return false;
+				}
+			}
+			if(!i2c_io_.recv(i2c_adr_(adr), dst, len)) {
+				return false;
+			}
+			return true;
+		}
+
 	public:
 		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 		/*!
@@ -103,7 +227,8 @@ namespace chip {
 		 */
 		//-----------------------------------------------------------------//
 		EEPROM(I2C_IO& i2c_io) noexcept : i2c_io_(i2c_io), ds_(0),
-			exp_(false), ad_mix_(false), pagen_(1) { }
+			exp_(false), ad_mix_(false), pagen_(1), busy_(false), last_(0), seq_(0), slot_()
+		{ }
 
 
 		//-----------------------------------------------------------------//
@@ -161,99 +286,200 @@ namespace chip {
 			@return 「false」なら、書き込み中
 		 */
 		//-----------------------------------------------------------------//
-		bool get_write_state(uint32_t adr) const noexcept {
-			uint8_t tmp[1];
-			return read(adr, tmp, 1);
+		bool get_write_state(uint32_t adr) noexcept {
+			if(!busy_) return true;
+			if(poll_(adr)) {
+				busy_ = false;
+			}
+			return !busy_;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	書き込み同期
+			@brief	書き込み同期（ACK ポーリング）
 			@param[in]	adr	検査アドレス
-			@param[in]	delay 待ち時間（10us単位）
+			@param[in]	delay タイムアウト（10us単位）
 			@return デバイスエラーなら「false」
 		 */
 		//-----------------------------------------------------------------//
-		bool sync_write(uint32_t adr, uint16_t delay = 600) const noexcept {
-			bool ok = false;
+		bool sync_write(uint32_t adr, uint16_t delay = 600) noexcept {
 			for(uint16_t i = 0; i < delay; ++i) {
-				utils::delay::micro_second(10);
-				uint8_t tmp[1];
-				if(read(adr, tmp, 1)) {
-					ok = true;
-					break;
+				if(poll_(adr)) {
+					busy_ = false;
+					return true;
 				}
+				utils::delay::micro_second(10);
 			}
-			return ok;
+			return false;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	EEPROM 読み出し @n
-					※通常１バンク内のサイズを超えて読み出す事は出来ない。
+					※通常１バンク内のサイズを超えて読み出す事は出来ない。 @n
+					※ライトバック・バッファにあるデータは、バッファから読む。
 			@param[in]	adr	読み出しアドレス
 			@param[out]	dst	転送先
 			@param[in]	len	長さ
 			@return 成功なら「true」
 		 */
 		//-----------------------------------------------------------------//
-		bool read(uint32_t adr, void* dst, uint16_t len) const noexcept
+		bool read(uint32_t adr, void* dst, uint16_t len) noexcept
 		{
-			if(exp_) {
-				uint8_t tmp[2];
-				tmp[0] = (adr >> 8) & 255;
-				tmp[1] =  adr & 255;
-				if(!i2c_io_.send(i2c_adr_(adr), tmp, 2)) {
-					return false;
-				}
-			} else {
-				uint8_t tmp[1];
-				tmp[0] = adr & 255;
-				if(!i2c_io_.send(i2c_adr_(adr), tmp, 1)) {
-					return false;
+			if(!read_dev_(adr, dst, len)) return false;
+
+			if constexpr (SLOT_NUM > 0) {
+				auto out = static_cast<uint8_t*>(dst);
+				for(uint32_t i = 0; i < SLOT_NUM; ++i) {
+					const auto& t = slot_[i];
+					if(t.page == NO_PAGE || t.hi <= t.lo) continue;
+					uint32_t org = t.page + t.lo;
+					uint32_t end = t.page + t.hi;
+					if(org < adr) org = adr;
+					if(end > (adr + len)) end = adr + len;
+					if(org < end) {
+						std::memcpy(&out[org - adr], &t.data[org - t.page], end - org);
+					}
 				}
 			}
-			if(!i2c_io_.recv(i2c_adr_(adr), dst, len)) {
-				return false;
-			}
 			return true;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	EEPROM 書き込み
+			@brief	EEPROM 書き込み（ページ毎に書き込み、最後の書き込み完了は待たない）
 			@param[in]	adr	書き込みアドレス
 			@param[in]	src	転送元
 			@param[in]	len	長さ
 			@return 成功なら「true」
 		 */
 		//-----------------------------------------------------------------//
-		bool write(uint32_t adr, const void* src, uint16_t len) const noexcept
+		bool write(uint32_t adr, const void* src, uint16_t len) noexcept
 		{
+			if constexpr (SLOT_NUM > 0) {
+				if(!flush()) return false;
+			}
+
 			const uint8_t* p = static_cast<const uint8_t*>(src);
 			while(len > 0) {
 				uint16_t l = pagen_ - (adr & (pagen_ - 1));
 				if(len < l) l = len;
-				if(exp_) {
-					if(!i2c_io_.send(i2c_adr_(adr), adr >> 8, adr & 255, p, l)) {
-						return false;
-					}
-				} else {
-					if(!i2c_io_.send(i2c_adr_(adr), adr & 255, p, l)) {
-						return false;
-					}
+				if(!write_page_(adr, p, l)) {
+					return false;
 				}
 				p += l;
 				len -= l;
-				if(len) {  // 書き込み終了を待つポーリング
-					if(!sync_write(adr)) {
-						return false;
+				adr += l;
+			}
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライトバック書き込み（バッファに置き、書き込みは service で行う） @n
+					隣接する書き込みは、ページ単位にまとめられる。 @n
+					空きバッファが無い場合は、一番古いページを書き込む（待ちが発生する）。
+			@param[in]	adr	書き込みアドレス
+			@param[in]	src	転送元
+			@param[in]	len	長さ
+			@return 成功なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool put(uint32_t adr, const void* src, uint16_t len) noexcept
+		{
+			if constexpr (SLOT_NUM == 0) {
+				return write(adr, src, len);
+			} else {
+				const uint8_t* p = static_cast<const uint8_t*>(src);
+				uint32_t pg = buff_page_();
+				while(len > 0) {
+					uint32_t top = adr & ~(pg - 1);
+					uint16_t ofs = adr - top;
+					uint16_t l = pg - ofs;
+					if(len < l) l = len;
+
+					slot_t* t = nullptr;
+					slot_t* e = nullptr;
+					for(uint32_t i = 0; i < SLOT_NUM; ++i) {
+						if(slot_[i].page == top) { t = &slot_[i]; break; }
+						if(slot_[i].page == NO_PAGE && e == nullptr) e = &slot_[i];
+					}
+					if(t == nullptr) {
+						if(e == nullptr) {
+							e = oldest_();
+							if(!flush_slot_(*e)) return false;
+						}
+						t = e;
+						t->page = top;
+						t->seq = seq_++;
+						t->lo = ofs;
+						t->hi = ofs;
+					}
+					// 書き込み範囲の間に隙間がある場合は、デバイスから埋める
+					if(t->hi > t->lo) {
+						if(ofs > t->hi) {
+							if(!read_dev_(top + t->hi, &t->data[t->hi], ofs - t->hi)) return false;
+						} else if((ofs + l) < t->lo) {
+							if(!read_dev_(top + ofs + l, &t->data[ofs + l], t->lo - (ofs + l))) return false;
+						}
+						if(ofs < t->lo) t->lo = ofs;
+						if((ofs + l) > t->hi) t->hi = ofs + l;
+					} else {
+						t->lo = ofs;
+						t->hi = ofs + l;
 					}
+					std::memcpy(&t->data[ofs], p, l);
+					p += l;
+					adr += l;
+					len -= l;
 				}
-				adr += l;
+				return true;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	サービス（メインループから呼ぶ） @n
+					デバイスが書き込み中でなければ、一番古いページを書き込む。
+			@return 書き込み待ちのページがあれば「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool service() noexcept
+		{
+			if constexpr (SLOT_NUM > 0) {
+				auto t = oldest_();
+				if(t == nullptr) return false;
+				if(busy_ && !get_write_state(last_)) return true;
+				flush_slot_(*t);
+				return oldest_() != nullptr;
+			} else {
+				return false;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	全てのページを書き込み、完了を待つ
+			@return 成功なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool flush() noexcept
+		{
+			if constexpr (SLOT_NUM > 0) {
+				while(1) {
+					auto t = oldest_();
+					if(t == nullptr) break;
+					if(!flush_slot_(*t)) return false;
+				}
+			}
+			if(busy_) {
+				return sync_write(last_);
 			}
 			return true;
 		}
@@ -3,8 +3,11 @@
 /*!	@file
 	@brief	ロータリー・エンコーダーデコード クラス @n
 			※入力のプルアップ抵抗は外部に取り付ける（マイコン内蔵プルアップは、抵抗値が大きいので適さない） @n
-			※外部接続の抵抗は、通常５Ｋ～１０Ｋ、ロータリーエンコーダーのマニュアルを参照
-	@copyright	Copyright (C) 2021 Kunihito Hiramatsu @n
+			※外部接続の抵抗は、通常５Ｋ～１０Ｋ、ロータリーエンコーダーのマニュアルを参照 @n
+			・ソフトウェアデコードは、状態遷移テーブル（１６エントリー）で行う。 @n
+			・ENCODER_MTU は、MTU の位相計数モードを使い、エッジを取りこぼさない。 @n
+			・ENCODER_SPEED は、M/T 法による速度推定を行う。
+	@copyright	Copyright (C) 2021, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/R8C/blob/master/LICENSE
 */
@@ -30,6 +33,43 @@ namespace chip {
 			PHA_POS_NEG,	///< PHA の立ち上がり、立下りエッジで評価する
 			ALL,			///< PHA, PHB 全てのエッジで評価する
 		};
+
+	protected:
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  状態遷移テーブル @n
+					インデックスは（前回の B:A）<< 2 | （今回の B:A）、 @n
+					両相が同時に変化した場合は、不正として数えない。
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct lut_t {
+			int8_t	tbl[16];
+
+			constexpr lut_t(DECODE dec) noexcept : tbl{ 0 }
+			{
+				for(uint32_t i = 0; i < 16; ++i) {
+					uint32_t org = i >> 2;
+					uint32_t lvl = i & 3;
+					uint32_t pos = ~org & lvl;
+					uint32_t neg = org & ~lvl;
+					int8_t d = 0;
+					if((org ^ lvl) == 0b01) {  // A 相のみ変化
+						if(pos & 0b01) {
+							d = (lvl & 0b10) != 0 ? -1 : 1;
+						} else if(dec != DECODE::PHA_POS && (neg & 0b01) != 0) {
+							d = (lvl & 0b10) != 0 ? 1 : -1;
+						}
+					} else if((org ^ lvl) == 0b10 && dec == DECODE::ALL) {  // B 相のみ変化
+						if(pos & 0b10) {
+							d = (lvl & 0b01) != 0 ? 1 : -1;
+						} else if(neg & 0b10) {
+							d = (lvl & 0b01) != 0 ? -1 : 1;
+						}
+					}
+					tbl[i] = d;
+				}
+			}
+		};
 	};
 
 
@@ -45,11 +85,23 @@ namespace chip {
 	template <class PHA, class PHB, typename VTYPE = uint32_t, ENCODER_BASE::DECODE decode = ENCODER_BASE::DECODE::PHA_POS>
 	class ENCODER : public ENCODER_BASE {
 
+		static constexpr lut_t lut_ = lut_t(decode);
+
 		volatile VTYPE	count_;
+		volatile uint32_t	edge_tick_;
 		uint8_t	lvl_;
 
 		uint8_t input_() { return static_cast<uint8_t>(PHA::P()) | (static_cast<uint8_t>(PHB::P()) << 1); }
 
+		bool step_() noexcept
+		{
+			uint8_t lvl = input_();
+			int8_t d = lut_.tbl[(lvl_ << 2) | lvl];
+			lvl_ = lvl;
+			count_ = count_ + d;
+			return d != 0;
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -61,6 +113,7 @@ namespace chip {
 			PHA::DIR = 0;
 			PHB::DIR = 0;
 			count_ = 0;
+			edge_tick_ = 0;
 			lvl_ = input_();
 		}
 
@@ -74,31 +127,20 @@ namespace chip {
 		//-----------------------------------------------------------------//
 		void service() noexcept
 		{
-			uint8_t lvl = input_();
-			uint8_t pos = ~lvl_ &  lvl;
-			uint8_t neg =  lvl_ & ~lvl; 
-			lvl_ = lvl;
+			step_();
+		}
 
-			if((pos & 0b01) != 0) {  // A 相の立ち上がり
-				if((lvl & 0b10) != 0) count_--;
-				else count_++;
-			}
-			if(decode == DECODE::PHA_POS_NEG || decode == DECODE::ALL) {
-				if((neg & 0b01) != 0) {  // A 相の立ち下がり
-					if((lvl & 0b10) != 0) count_++;
-					else count_--;
-				}
-			}
-			if(decode == DECODE::ALL) {
-				if((pos & 0b10) != 0) {  // B 相の立ち上がり
-					if((lvl & 0b01) != 0) count_++;
-					else count_--;
-				}
-				if((neg & 0b10) != 0) {  // B 相の立ち下がり
-					if((lvl & 0b01) != 0) count_--;
-					else count_++;
-				}
-			}
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	サービス（エッジ時刻の記録付き） @n
+					※速度推定（ENCODER_SPEED）を使う場合
+			@param[in]	tick	フリーランタイマーの値
+		 */
+		//-----------------------------------------------------------------//
+		void service(uint32_t tick) noexcept
+		{
+			if(step_()) edge_tick_ = tick;
 		}
 
 
@@ -111,6 +153,15 @@ namespace chip {
 		auto get_count() const noexcept { return count_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	最後にカウントしたエッジの時刻を取得
+			@return エッジの時刻
+		 */
+		//-----------------------------------------------------------------//
+		uint32_t get_edge_tick() const noexcept { return edge_tick_; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	() オペレーター
@@ -120,4 +171,212 @@ namespace chip {
 			service();
 		}
 	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ロータリー・エンコーダー（MTU 位相計数モード）テンプレートクラス @n
+				・A/B 相の全エッジ（４逓倍）をハードウェアで数える。 @n
+				・TCNT は１６ビットなので、３２７６７エッジ以内の周期で service を呼ぶ。 @n
+				Ex: typedef device::mtu_io<device::MTU1> MTU_IO; @n
+				    chip::ENCODER_MTU<MTU_IO> enc_;
+		@param[in]	MTU_IO	mtu_io クラス（MTU1、又は MTU2）
+		@param[in]	VTYPE	カウンターの型
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class MTU_IO, typename VTYPE = int32_t>
+	class ENCODER_MTU {
+
+		typedef typename MTU_IO::mtu_type MTUX;
+
+		MTU_IO		mtu_io_;
+
+		volatile VTYPE	count_;
+		volatile uint32_t	edge_tick_;
+		uint16_t	tcnt_;
+
+		bool step_() noexcept
+		{
+			uint16_t tcnt = MTUX::TCNT();
+			int16_t d = static_cast<int16_t>(tcnt - tcnt_);
+			tcnt_ = tcnt;
+			count_ = count_ + d;
+			return d != 0;
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		 */
+		//-----------------------------------------------------------------//
+		ENCODER_MTU() noexcept : mtu_io_(), count_(0), edge_tick_(0), tcnt_(0) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	開始
+			@return 成功なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool start() noexcept
+		{
+			count_ = 0;
+			edge_tick_ = 0;
+			tcnt_ = 0;
+			return mtu_io_.start_count_phase();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	サービス（ハードウェアカウンターの拡張）
+		 */
+		//-----------------------------------------------------------------//
+		void service() noexcept
+		{
+			step_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	サービス（エッジ時刻の記録付き） @n
+					※エッジ時刻の分解能は、呼び出し周期になる。
+			@param[in]	tick	フリーランタイマーの値
+		 */
+		//-----------------------------------------------------------------//
+		void service(uint32_t tick) noexcept
+		{
+			if(step_()) edge_tick_ = tick;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	カウンターの取得
+			@return カウンター
+		 */
+		//-----------------------------------------------------------------//
+		auto get_count() const noexcept { return count_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	最後にカウントが変化した時刻を取得
+			@return エッジの時刻
+		 */
+		//-----------------------------------------------------------------//
+		uint32_t get_edge_tick() const noexcept { return edge_tick_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	() オペレーター
+		 */
+		//-----------------------------------------------------------------//
+		void operator () () {
+			service();
+		}
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  速度推定（M/T 法）クラス @n
+				一定周期でカウント（M）と、最後のエッジ時刻（T）を受け取り、 @n
+				「エッジ数 / エッジ間の時間」で速度を求める。 @n
+				低速では周期内にエッジが無いので、最後のエッジからの経過時間で @n
+				速度の上限を抑え、TIMEOUT を超えたら停止とする。
+		@param[in]	TICK_FREQ	時刻（tick）の周波数 [Hz]
+		@param[in]	TIMEOUT		停止と判断する時間 [tick]
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t TICK_FREQ, uint32_t TIMEOUT = TICK_FREQ / 2>
+	class ENCODER_SPEED {
+
+		int32_t		count_;
+		uint32_t	edge_tick_;
+		float		speed_;
+		bool		first_;
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		 */
+		//-----------------------------------------------------------------//
+		ENCODER_SPEED() noexcept : count_(0), edge_tick_(0), speed_(0.0f), first_(true) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リセット
+		 */
+		//-----------------------------------------------------------------//
+		void reset() noexcept
+		{
+			speed_ = 0.0f;
+			first_ = true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	更新（一定周期で呼ぶ）
+			@param[in]	count	エンコーダーのカウント
+			@param[in]	edge	最後のエッジ時刻
+			@param[in]	now		現在の時刻
+		 */
+		//-----------------------------------------------------------------//
+		void update(int32_t count, uint32_t edge, uint32_t now) noexcept
+		{
+			if(first_) {
+				count_ = count;
+				edge_tick_ = now;
+				first_ = false;
+				return;
+			}
+
+			int32_t dm = count - count_;
+			if(dm != 0) {
+				uint32_t dt = edge - edge_tick_;
+				if(dt == 0) dt = 1;
+				speed_ = static_cast<float>(dm) * static_cast<float>(TICK_FREQ) / static_cast<float>(dt);
+				count_ = count;
+				edge_tick_ = edge;
+			} else {
+				uint32_t et = now - edge_tick_;
+				if(et >= TIMEOUT) {
+					speed_ = 0.0f;
+				} else if(et > 0) {
+					float lim = static_cast<float>(TICK_FREQ) / static_cast<float>(et);
+					if(speed_ > lim) speed_ = lim;
+					else if(speed_ < -lim) speed_ = -lim;
+				}
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	速度の取得
+			@return 速度 [カウント/秒]
+		 */
+		//-----------------------------------------------------------------//
+		float get_speed() const noexcept { return speed_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	回転数の取得
+			@param[in]	cpr		１回転当たりのカウント数
+			@return 回転数 [RPM]
+		 */
+		//-----------------------------------------------------------------//
+		float get_rpm(uint32_t cpr) const noexcept
+		{
+			return speed_ * 60.0f / static_cast<float>(cpr);
+		}
+	};
 }
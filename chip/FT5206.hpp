@@ -4,10 +4,12 @@
 	@brief	FT5206 class @n
 			FocalTech @n
 			Capacitive Touch Panel Controller ドライバー @n
-			・I2C 割り込み対応（作業中） @n
-			・２点同時までのタッチ位置を補足
+			・２点同時までのタッチ位置を補足 @n
+			・INT 端子の割り込みから notify を呼ぶと、タッチ中以外は I2C の通信をしない。 @n
+			・タッチ位置は、不感帯とチャタリング除去のフィルターを通し、速度を求める。 @n
+			・タップ、長押し、ドラッグ、２点のピンチをジェスチャー・イベントとしてキューに積む。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2018, 2021 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2018, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -16,16 +18,19 @@
 #include "common/delay.hpp"
 #include "common/vtx.hpp"
 #include "common/format.hpp"
+#include "common/fixed_fifo.hpp"
+#include "common/intmath.hpp"
 
 namespace chip {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  FT5206 テンプレートクラス
-		@param[in]	I2C	I2C 制御クラス
+		@param[in]	I2C		I2C 制御クラス
+		@param[in]	QUEUE	ジェスチャー・イベントのキューサイズ
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class I2C>
+	template <class I2C, uint32_t QUEUE = 16>
 	class FT5206 {
 	public:
 		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
@@ -75,6 +80,80 @@ namespace chip {
 			} 
 		};
 
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  フィルター後のタッチ点
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct point_t {
+			vtx::spos	pos;		///< 位置（フィルター後）
+			vtx::spos	org;		///< タッチ開始位置
+			vtx::spos	vel;		///< 速度（ピクセル／update）
+			uint16_t	frame;		///< タッチしている update 回数
+			uint8_t		release;	///< 離した update 回数（チャタリング除去）
+			bool		level;		///< タッチ中なら「true」
+			bool		drag;		///< ドラッグ中なら「true」
+			bool		long_press;	///< 長押し済みなら「true」
+			uint8_t		id;			///< 対応する Touch ID
+
+			point_t() noexcept : pos(0), org(0), vel(0), frame(0), release(0),
+				level(false), drag(false), long_press(false), id(0) { }
+		};
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  ジェスチャーの種類
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		enum class GESTURE : uint8_t {
+			TAP,			///< タップ（pos）
+			LONG_PRESS,		///< 長押し（pos）
+			DRAG_BEGIN,		///< ドラッグ開始（pos: 開始位置）
+			DRAG,			///< ドラッグ（pos、delta: 移動量）
+			DRAG_END,		///< ドラッグ終了（pos、delta: 離した時の速度）
+			PINCH_BEGIN,	///< ピンチ開始（pos: ２点の中心）
+			PINCH,			///< ピンチ（pos: ２点の中心、scale: 開始時の距離との比）
+			PINCH_END,		///< ピンチ終了
+		};
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  ジェスチャー・イベント
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct gesture_t {
+			GESTURE		type;	///< 種類
+			vtx::spos	pos;	///< 位置
+			vtx::spos	delta;	///< 移動量
+			uint16_t	scale;	///< ピンチの拡大率（256 で等倍）
+
+			gesture_t() noexcept : type(GESTURE::TAP), pos(0), delta(0), scale(256) { }
+		};
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  フィルター、ジェスチャーのパラメーター（回数は update 単位）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct param_t {
+			uint8_t		dead;		///< 不感帯（ピクセル）
+			uint8_t		smooth;		///< 平滑化のシフト数（０で無効）
+			uint8_t		debounce;	///< 離したと判断する回数
+			uint8_t		drag;		///< ドラッグと判断する距離（ピクセル）
+			uint16_t	tap;		///< タップと判断する最大回数
+			uint16_t	long_press;	///< 長押しと判断する回数
+			uint16_t	poll;		///< 割り込みが無い場合に読み出す間隔（０で無効）
+
+			param_t() noexcept : dead(2), smooth(1), debounce(2), drag(10),
+				tap(15), long_press(40), poll(30) { }
+		};
+
+		static constexpr uint32_t POINT_NUM = 2;	///< フィルターするタッチ点の数
+
 	private:
 
 		static constexpr uint8_t	FT5206_ADR = 0x38;
@@ -150,6 +229,24 @@ namespace chip {
 		uint8_t		touch_tmp_[2 + 6 * TOUCH_NUM];
 		touch_t		t_[TOUCH_NUM];
 
+		bool		intr_;
+		bool		req_;
+		uint32_t	intr_count_;
+		uint16_t	idle_;
+
+		param_t		param_;
+		point_t		p_[POINT_NUM];
+		uint8_t		point_num_;
+		uint8_t		primary_;
+		bool		multi_;
+		uint16_t	pinch_len_;
+
+		typedef utils::fixed_fifo<gesture_t, QUEUE> GFIFO;
+		GFIFO		gesture_;
+		uint32_t	lost_;
+
+		static inline volatile uint32_t	notify_count_ = 0;
+
 
 		void write_(REG reg, uint8_t data) noexcept
 		{
@@ -202,6 +299,212 @@ namespace chip {
 			i2c_.recv(FT5206_ADR, touch_tmp_, sizeof(touch_tmp_));
 		}
 
+
+		void push_(GESTURE type, const vtx::spos& pos, const vtx::spos& delta = vtx::spos(0),
+			uint16_t scale = 256) noexcept
+		{
+			if(gesture_.space() == 0) {
+				++lost_;
+				return;
+			}
+			auto& g = gesture_.put_at();
+			g.type  = type;
+			g.pos   = pos;
+			g.delta = delta;
+			g.scale = scale;
+			gesture_.put_go();
+		}
+
+
+		static int16_t dead_(int16_t d, int16_t dead) noexcept
+		{
+			if(d > dead) return d - dead;
+			else if(d < -dead) return d + dead;
+			return 0;
+		}
+
+
+		static uint32_t dist_sqr_(const vtx::spos& a, const vtx::spos& b) noexcept
+		{
+			int32_t dx = a.x - b.x;
+			int32_t dy = a.y - b.y;
+			return static_cast<uint32_t>(dx * dx + dy * dy);
+		}
+
+
+		// 生のタッチ位置を、フィルター後のタッチ点に反映
+		void filter_(point_t& p, bool contact, const vtx::spos& raw) noexcept
+		{
+			if(contact) {
+				p.release = 0;
+				if(!p.level) {
+					p.level = true;
+					p.pos = raw;
+					p.org = raw;
+					p.vel.set(0);
+					p.frame = 0;
+					p.drag = false;
+					p.long_press = false;
+					return;
+				}
+				vtx::spos d(dead_(raw.x - p.pos.x, param_.dead), dead_(raw.y - p.pos.y, param_.dead));
+				if(param_.smooth > 0 && (d.x != 0 || d.y != 0)) {
+					// 小さな移動が０にならないように、丸める
+					d.x = d.x >= 0 ? (d.x + (1 << param_.smooth) - 1) >> param_.smooth
+						: -((-d.x + (1 << param_.smooth) - 1) >> param_.smooth);
+					d.y = d.y >= 0 ? (d.y + (1 << param_.smooth) - 1) >> param_.smooth
+						: -((-d.y + (1 << param_.smooth) - 1) >> param_.smooth);
+				}
+				p.pos += d;
+				p.vel = d;
+				if(p.frame < 0xffff) ++p.frame;
+			} else if(p.level) {
+				++p.release;  // 速度は、離す直前の値を保持
+				if(p.release >= param_.debounce) {
+					p.level = false;
+				}
+			}
+		}
+
+
+		void gesture_single_(point_t& p, bool before) noexcept
+		{
+			if(p.level) {
+				if(!before) return;
+				uint32_t drag = static_cast<uint32_t>(param_.drag) * param_.drag;
+				if(!p.drag && !p.long_press && dist_sqr_(p.pos, p.org) >= drag) {
+					p.drag = true;
+					push_(GESTURE::DRAG_BEGIN, p.org);
+				}
+				if(p.drag) {
+					if(p.release == 0 && (p.vel.x != 0 || p.vel.y != 0)) {
+						push_(GESTURE::DRAG, p.pos, p.vel);
+					}
+				} else if(!p.long_press && p.frame >= param_.long_press) {
+					p.long_press = true;
+					push_(GESTURE::LONG_PRESS, p.pos);
+				}
+			} else if(before) {
+				if(p.drag) {
+					push_(GESTURE::DRAG_END, p.pos, p.vel);
+				} else if(!p.long_press && p.frame <= param_.tap) {
+					push_(GESTURE::TAP, p.org);
+				}
+			}
+		}
+
+
+		void pinch_() noexcept
+		{
+			// 離している途中（チャタリング除去中）の点と、新しい点ではピンチを始めない
+			bool two = p_[0].level && p_[1].level &&
+				(multi_ || (p_[0].release == 0 && p_[1].release == 0));
+			vtx::spos c((p_[0].pos.x + p_[1].pos.x) / 2, (p_[0].pos.y + p_[1].pos.y) / 2);
+			if(two) {
+				uint16_t len = intmath::sqrt32(dist_sqr_(p_[0].pos, p_[1].pos)).val;
+				if(len == 0) len = 1;
+				if(!multi_) {
+					multi_ = true;
+					pinch_len_ = len;
+					for(uint32_t i = 0; i < POINT_NUM; ++i) {
+						if(p_[i].drag) push_(GESTURE::DRAG_END, p_[i].pos, p_[i].vel);
+					}
+					push_(GESTURE::PINCH_BEGIN, c);
+				} else if(p_[0].release == 0 && p_[1].release == 0 &&
+					(p_[0].vel.x != 0 || p_[0].vel.y != 0 || p_[1].vel.x != 0 || p_[1].vel.y != 0)) {
+					uint32_t scale = (static_cast<uint32_t>(len) << 8) / pinch_len_;
+					if(scale > 0xffff) scale = 0xffff;
+					push_(GESTURE::PINCH, c, vtx::spos(0), scale);
+				}
+				return;
+			}
+			if(multi_) {
+				// ピンチ後は、全ての点を離すまでシングルのジェスチャーを出さない
+				if(!p_[0].level && !p_[1].level) {
+					multi_ = false;
+					push_(GESTURE::PINCH_END, c);
+				}
+				for(uint32_t i = 0; i < POINT_NUM; ++i) {
+					p_[i].drag = false;
+					p_[i].long_press = true;
+				}
+				return;
+			}
+		}
+
+
+		bool contact_(uint32_t idx) const noexcept
+		{
+			return idx < touch_num_ && t_[idx].event != EVENT::UP && t_[idx].event != EVENT::NONE;
+		}
+
+
+		// タッチ点と報告を Touch ID で対応させる（報告の順番は、指を離すと詰められる）
+		void match_(int8_t map[POINT_NUM]) noexcept
+		{
+			bool used[TOUCH_NUM] = { };
+			for(uint32_t i = 0; i < POINT_NUM; ++i) {
+				map[i] = -1;
+				if(!p_[i].level) continue;
+				for(uint32_t j = 0; j < TOUCH_NUM; ++j) {
+					if(!used[j] && contact_(j) && t_[j].id == p_[i].id) {
+						map[i] = j;
+						used[j] = true;
+						break;
+					}
+				}
+			}
+			// 新しいタッチは、空いているタッチ点へ
+			for(uint32_t i = 0; i < POINT_NUM; ++i) {
+				if(map[i] >= 0 || p_[i].level) continue;
+				for(uint32_t j = 0; j < TOUCH_NUM; ++j) {
+					if(!used[j] && contact_(j)) {
+						map[i] = j;
+						used[j] = true;
+						p_[i].id = t_[j].id;
+						break;
+					}
+				}
+			}
+		}
+
+
+		void process_(bool fresh) noexcept
+		{
+			int8_t map[POINT_NUM];
+			if(fresh) match_(map);
+
+			bool before[POINT_NUM];
+			for(uint32_t i = 0; i < POINT_NUM; ++i) {
+				before[i] = p_[i].level;
+				if(fresh) {
+					if(map[i] >= 0) filter_(p_[i], true, t_[map[i]].pos);
+					else filter_(p_[i], false, p_[i].pos);
+				} else if(p_[i].level) {
+					p_[i].vel.set(0);
+					if(p_[i].frame < 0xffff) ++p_[i].frame;
+				}
+			}
+
+			pinch_();
+			if(!multi_) {  // ピンチ以外では、タッチ点毎にシングルのジェスチャー
+				for(uint32_t i = 0; i < POINT_NUM; ++i) {
+					gesture_single_(p_[i], before[i]);
+				}
+			}
+
+			point_num_ = 0;
+			for(uint32_t i = 0; i < POINT_NUM; ++i) {
+				if(p_[i].level) ++point_num_;
+			}
+			// 代表点は、離されたら押されている他の点へ移す（全て離れたら最後の点を保持）
+			if(!p_[primary_].level) {
+				for(uint32_t i = 0; i < POINT_NUM; ++i) {
+					if(p_[i].level) { primary_ = i; break; }
+				}
+			}
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -211,7 +514,10 @@ namespace chip {
 		//-----------------------------------------------------------------//
 		FT5206(I2C& i2c) noexcept : i2c_(i2c), touch_id_(0), touch_num_(0),
 			start_(false), startup_(false),
-			version_(0), chip_(0), touch_tmp_{ 0 }, t_{ } { }
+			version_(0), chip_(0), touch_tmp_{ 0 }, t_{ },
+			intr_(false), req_(false), intr_count_(0), idle_(0),
+			param_(), p_{ }, point_num_(0), primary_(0), multi_(false), pinch_len_(1),
+			gesture_(), lost_(0) { }
 
 
 		//-----------------------------------------------------------------//
@@ -260,10 +566,11 @@ namespace chip {
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	開始
+			@param[in]	intr	INT 端子の割り込みから notify を呼ぶ場合「true」
 			@return 成功なら「true」
 		 */
 		//-----------------------------------------------------------------//
-		bool start() noexcept
+		bool start(bool intr = false) noexcept
 		{
 // utils::format("Pass 0\n");
 			uint8_t tmp[3];
@@ -289,8 +596,21 @@ namespace chip {
 			chip_ = tmp[2];
 
 			write_(REG::DEVICE_MODE, 0x00);
+			// 割り込みはトリガーモード（新しいタッチ情報毎にパルス）
+			write_(REG::ID_G_MODE, intr ? 0x01 : 0x00);
 
 			touch_num_ = 0;
+			intr_ = intr;
+			req_ = false;
+			intr_count_ = notify_count_;
+			idle_ = 0;
+			for(uint32_t i = 0; i < POINT_NUM; ++i) {
+				p_[i] = point_t();
+			}
+			point_num_ = 0;
+			primary_ = 0;
+			multi_ = false;
+			gesture_.clear();
 
 			start_ = true;
 			startup_ = false;
@@ -299,6 +619,23 @@ namespace chip {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	INT 端子の割り込みから呼ぶ
+		 */
+		//-----------------------------------------------------------------//
+		static void notify() noexcept { ++notify_count_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	フィルター、ジェスチャーのパラメーターを参照
+			@return パラメーター
+		 */
+		//-----------------------------------------------------------------//
+		param_t& at_param() noexcept { return param_; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	アップデート
@@ -310,16 +647,38 @@ namespace chip {
 				return;
 			}
 
-			convert_touch_();
-			request_touch_();
+			bool fresh = req_;
+			if(req_) {
+				convert_touch_();
+				req_ = false;
+				for(uint8_t i = 0; i < TOUCH_NUM; ++i) {
+					if(t_[i].event == EVENT::DOWN) {
+						t_[i].org = t_[i].pos;
+					} else if(t_[i].event == EVENT::UP) {
+						t_[i].end = t_[i].pos;
+					}
+				}
+			}
 
-			for(uint8_t i = 0; i < TOUCH_NUM; ++i) {
-				if(t_[i].event == EVENT::DOWN) {
-					t_[i].org = t_[i].pos;
-				} else if(t_[i].event == EVENT::UP) {
-					t_[i].end = t_[i].pos;
+			// 割り込み通知が無く、タッチもしていなければ、I2C の通信を省く
+			bool req = true;
+			if(intr_) {
+				auto n = notify_count_;
+				bool touch = touch_num_ > 0 || point_num_ > 0;
+				++idle_;
+				if(n != intr_count_ || touch || (param_.poll > 0 && idle_ >= param_.poll)) {
+					intr_count_ = n;
+					idle_ = 0;
+				} else {
+					req = false;
 				}
 			}
+			if(req) {
+				request_touch_();
+				req_ = true;
+			}
+
+			process_(fresh || !intr_);
 		}
 
 
@@ -340,5 +699,59 @@ namespace chip {
 		 */
 		//-----------------------------------------------------------------//
 		const touch_t& get_touch_pos(uint8_t idx) const noexcept { return t_[idx & 3]; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	フィルター後のタッチ数を取得
+			@return タッチ数
+		 */
+		//-----------------------------------------------------------------//
+		uint8_t get_point_num() const noexcept { return point_num_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	フィルター後のタッチ点を取得 @n
+					※タッチ点は Touch ID で追跡するので、離すまで同じインデックス
+			@param[in]	idx	インデックス（０～１）
+			@return タッチ点
+		 */
+		//-----------------------------------------------------------------//
+		const point_t& get_point(uint8_t idx) const noexcept { return p_[idx % POINT_NUM]; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	代表のタッチ点を取得 @n
+					※押されている点、全て離された場合は最後に離した点
+			@return タッチ点
+		 */
+		//-----------------------------------------------------------------//
+		const point_t& get_primary() const noexcept { return p_[primary_]; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ジェスチャー・イベントを取得
+			@param[out]	g	イベント
+			@return イベントがあれば「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool get_gesture(gesture_t& g) noexcept
+		{
+			if(gesture_.length() == 0) return false;
+			g = gesture_.get();
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キューが溢れて失ったイベント数を取得
+			@return 失ったイベント数
+		 */
+		//-----------------------------------------------------------------//
+		uint32_t get_lost() const noexcept { return lost_; }
 	};
 }
@@ -11,40 +11,67 @@
 				 9: A      10: B     @n
 				11: C      12: D     @n
 				13: CLK    14: LAT   @n
-				15: /OE    16: GND
-	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+				15: /OE    16: GND   @n
+			・BCM (Binary Code Modulation) による階調表示 @n
+			  ビットプレーン b の表示時間を 2^b 単位とし、CMT の周期を毎回書き換える。 @n
+			  表示時間がシフト時間より短いプレーンは、CMCNT を監視して /OE パルスを作る。 @n
+			・データポート（８ビット）のビット配置 @n
+			  B0: R1, B1: G1, B2: B1, B3: R2, B4: G2, B5: B2, B6: CLK, B7: 未使用（０） @n
+			  ※データポートは、バイト単位で書き換えるので、他の信号を割り当ててはならない。 @n
+			・プレーン・データは、CLK=L/H の２バイトを１ピクセルとして事前に展開しておき、 @n
+			  CPU、又は DMAC でデータポートに書き込む。 @n
+			・フレームはダブルバッファで、copy() 後にフレームの切れ目で切り替える。 @n
+			Ex: 定義例（64x32, 1/16 スキャン） @n
+			  typedef device::PORT_BYTE<device::PORT2> DATA; @n
+			  typedef device::PORT<device::PORT3, device::bitpos::B0> LAT; @n
+			  typedef device::PORT<device::PORT3, device::bitpos::B1> OE; @n
+			  typedef chip::HUB75_ADR<A, B, C, D> ADR; @n
+			  typedef chip::HUB75<DATA, LAT, OE, ADR, device::CMT1, 64, 32, 8, device::DMAC0> HUB75; @n
+			  HUB75 hub75_; @n
+			  hub75_.start(200, device::ICU::LEVEL::_5);
+	@copyright	Copyright (C) 2018, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
-#include <cmath>
+#include "common/renesas.hpp"
+#include "common/cmt_mgr.hpp"
+
+namespace device {
+	template <class DMAC, class TASK> class dmac_mgr;
+}
 
 namespace chip {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
-		@brief  HUB75 カラム選択ポート・クラス
-		@param[in]	a	デコーダーＡ
-		@param[in]	b	デコーダーＢ
-		@param[in]	c	デコーダーＣ
-		@param[in]	d	デコーダーＤ
+		@brief  HUB75 行選択ポート・クラス
+		@param[in]	A	デコーダーＡ
+		@param[in]	B	デコーダーＢ
+		@param[in]	C	デコーダーＣ
+		@param[in]	D	デコーダーＤ
+		@param[in]	E	デコーダーＥ（1/32 スキャンの場合）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <PORT a, PORT b, PORT c, PORT d>
-	class PORTS {
+	template <class A, class B, class C, class D, class E = device::NULL_PORT>
+	class HUB75_ADR {
 	public:
-		static void init() {
-			a::DIR = 1;
-			b::DIR = 1;
-			c::DIR = 1;
-			d::DIR = 1;
+		static void init() noexcept
+		{
+			A::DIR = 1;
+			B::DIR = 1;
+			C::DIR = 1;
+			D::DIR = 1;
+			E::DIR = 1;
 		}
 
-		static void out(uint32_t v) {
-			a::P = v & 1;
-			b::P = (v >> 1) & 1;
-			c::P = (v >> 2) & 1;
-			d::P = (v >> 3) & 1;
+		static void out(uint32_t v) noexcept
+		{
+			A::P = v & 1;
+			B::P = (v >> 1) & 1;
+			C::P = (v >> 2) & 1;
+			D::P = (v >> 3) & 1;
+			E::P = (v >> 4) & 1;
 		}
 	};
 
@@ -52,43 +79,320 @@ namespace chip {
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  HUB75 テンプレートクラス
-		@param[in]	red		赤シリアル・ポート
-		@param[in]	green	緑シリアル・ポート
-		@param[in]	blue	青シリアル・ポート
-		@param[in]	sclk	シリアル・クロック・ポート
-		@param[in]	latch	ラッチ・ポート
-		@param[in]	blank	ブランキング・ポート
-		@param[in]	adr		カラム・デコーダー・ポート		
+		@param[in]	DATA	データポート（８ビット、R1, G1, B1, R2, G2, B2, CLK）
+		@param[in]	LATCH	ラッチ・ポート
+		@param[in]	OE		/OE（ブランキング）ポート
+		@param[in]	ADR		行デコーダー・ポート（HUB75_ADR）
+		@param[in]	CMT		BCM 周期に使う CMT チャネル
+		@param[in]	WIDTH	横幅
+		@param[in]	HEIGHT	高さ（２行同時に駆動する）
+		@param[in]	DEPTH	階調ビット数（１～１０）
+		@param[in]	DMAC	データ転送に使う DMAC チャネル（void の場合 CPU 転送）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <PORT red, PORT green, PORT blue, PORT sclk, PORT latch, PORT blank, PORTS adr>
+	template <class DATA, class LATCH, class OE, class ADR, class CMT,
+		uint32_t WIDTH, uint32_t HEIGHT, uint32_t DEPTH = 8, class DMAC = void>
 	class HUB75 {
+
+		static_assert(DEPTH >= 1 && DEPTH <= 10, "DEPTH range is 1 to 10.");
+		static_assert((HEIGHT & 1) == 0, "HEIGHT must be even.");
+
 	public:
+		static constexpr uint32_t ROWS = HEIGHT / 2;	///< スキャン行数
+		static constexpr uint32_t LINE = WIDTH * 2;		///< １行、１プレーンのバイト数
+		static constexpr uint8_t  CLK  = 0x40;			///< シリアル・クロック・ビット
+
+	private:
+		static constexpr bool USE_DMA = !std::is_void_v<DMAC>;
+		static constexpr uint32_t WORDS = (DEPTH + 3) / 4;	///< LUT のワード数（４プレーン／ワード）
+
+		typedef std::conditional_t<USE_DMA, device::dmac_mgr<DMAC, utils::null_task>, utils::null_task> DMAC_MGR;
+
+		struct frame_t {
+			uint8_t	plane_[ROWS][DEPTH][LINE];
+		};
+
+		class refresh_task {
+		public:
+			void operator() () noexcept {
+				service_();
+			}
+		};
+
+		typedef device::cmt_mgr<CMT, refresh_task> CMT_MGR;
+
+		CMT_MGR		cmt_mgr_;
+
+		static inline DMAC_MGR	dmac_mgr_;
+
+		static inline frame_t	frame_[2];
+		// ８ビット輝度 -> 各プレーンのビット（１バイト／プレーン）
+		static inline uint32_t	lut_[256][WORDS];
+
+		static inline volatile uint8_t	disp_;
+		static inline volatile bool		swap_;
+		static inline volatile uint32_t	frame_count_;
+
+		static inline uint16_t	unit_;
+		static inline uint16_t	min_slot_;
+		static inline uint32_t	row_;
+		static inline uint32_t	plane_;
+
+
+		static void shift_(const uint8_t* src) noexcept
+		{
+			if constexpr (USE_DMA) {
+				dmac_mgr_.copy_io(src, DATA::port_t::PO.address, LINE);
+			} else {
+				for(uint32_t i = 0; i < LINE; ++i) {
+					DATA::P = src[i];
+				}
+			}
+		}
+
+
+		// BCM １スロット分の処理（CMT 割り込み）
+		static void service_() noexcept
+		{
+			OE::P = 1;
+			LATCH::P = 1;
+			LATCH::P = 0;
+			ADR::out(row_);
+			OE::P = 0;
+			uint16_t org = CMT::CMCNT();
+
+			uint32_t w = static_cast<uint32_t>(unit_) << plane_;
+			if(w >= min_slot_) {
+				CMT::CMCOR = w - 1;
+			} else {
+				CMT::CMCOR = min_slot_ - 1;
+				while(static_cast<uint16_t>(CMT::CMCNT() - org) < w) ;
+				OE::P = 1;
+			}
+
+			++plane_;
+			if(plane_ >= DEPTH) {
+				plane_ = 0;
+				++row_;
+				if(row_ >= ROWS) {
+					row_ = 0;
+					++frame_count_;
+					if(swap_) {
+						disp_ ^= 1;
+						swap_ = false;
+					}
+				}
+			}
+			shift_(frame_[disp_].plane_[row_][plane_]);
+		}
+
+
+		static void make_lut_() noexcept
+		{
+			for(uint32_t v = 0; v < 256; ++v) {
+				uint32_t lvl = (v * ((1 << DEPTH) - 1) + 127) / 255;
+				for(uint32_t w = 0; w < WORDS; ++w) {
+					uint32_t t = 0;
+					for(uint32_t b = 0; b < 4; ++b) {
+						auto pos = w * 4 + b;
+						if(pos < DEPTH && (lvl & (1 << pos)) != 0) {
+							t |= 1 << (b * 8);
+						}
+					}
+					lut_[v][w] = t;
+				}
+			}
+		}
+
+
+		// 上下２ピクセルを、各プレーンの２バイト（CLK L/H）に展開
+		static void encode_(uint8_t* dst, uint32_t r1, uint32_t g1, uint32_t b1,
+			uint32_t r2, uint32_t g2, uint32_t b2) noexcept
+		{
+			for(uint32_t w = 0; w < WORDS; ++w) {
+				uint32_t t = lut_[r1][w] | (lut_[g1][w] << 1) | (lut_[b1][w] << 2)
+					| (lut_[r2][w] << 3) | (lut_[g2][w] << 4) | (lut_[b2][w] << 5);
+				for(uint32_t b = 0; b < 4; ++b) {
+					auto pos = w * 4 + b;
+					if(pos >= DEPTH) break;
+					uint8_t d = t & 0x3f;
+					dst[pos * LINE + 0] = d;
+					dst[pos * LINE + 1] = d | CLK;
+					t >>= 8;
+				}
+			}
+		}
+
+
+		void swap_wait_() noexcept
+		{
+			// 前回の切り替えが終わるまで、描画先（裏フレーム）は表示中
+			while(swap_) {
+				asm("nop");
+			}
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		 */
+		//-----------------------------------------------------------------//
+		HUB75() noexcept : cmt_mgr_() { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	開始 @n
+					シフト時間を計測し、BCM の単位時間を決める。
+			@param[in]	refresh	リフレッシュ・レート [Hz]
+			@param[in]	lvl		割り込みレベル
+			@return エラーがあれば「false」を返す。
+		 */
+		//-----------------------------------------------------------------//
+		bool start(uint32_t refresh, device::ICU::LEVEL lvl) noexcept
+		{
+			if(refresh == 0 || lvl == device::ICU::LEVEL::NONE) return false;
+
+			DATA::DIR = 0x7f;
+			DATA::P = 0;
+			LATCH::DIR = 1;
+			LATCH::P = 0;
+			OE::DIR = 1;
+			OE::P = 1;
+			ADR::init();
+
+			make_lut_();
+			for(uint32_t i = 0; i < 2; ++i) {
+				uint8_t* p = &frame_[i].plane_[0][0][0];
+				for(uint32_t j = 0; j < sizeof(frame_t); j += 2) {
+					p[j + 0] = 0;
+					p[j + 1] = CLK;
+				}
+			}
+			disp_ = 0;
+			swap_ = false;
+			frame_count_ = 0;
+			row_ = 0;
+			plane_ = 0;
+
+			if constexpr (USE_DMA) {
+				dmac_mgr_.start();
+			}
+
+			// シフト時間の計測（CMT はポーリングで動かす）
+			cmt_mgr_.start(CMT_MGR::DIRECT::MAX, CMT_MGR::DIVIDE::I8);
+			uint16_t org = CMT::CMCNT();
+			shift_(frame_[disp_].plane_[row_][plane_]);
+			if constexpr (USE_DMA) {
+				while(dmac_mgr_.probe()) ;
+			}
+			uint16_t t = CMT::CMCNT() - org;
+			// 割り込み処理のオーバーヘッド（約 2us）を加える
+			min_slot_ = t + t / 4 + CMT::PCLK / 8 / 500'000 + 1;
+
+			uint32_t unit = CMT::PCLK / 8 / refresh / ROWS / ((1 << DEPTH) - 1);
+			if(unit == 0) unit = 1;
+			if((unit << (DEPTH - 1)) > 65535) unit = 65535 >> (DEPTH - 1);
+			unit_ = unit;
+
+			return cmt_mgr_.start(static_cast<typename CMT_MGR::DIRECT>(min_slot_ - 1), CMT_MGR::DIVIDE::I8, lvl);
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	開始
+			@brief	フレームのコピー（RGB565） @n
+					裏フレームへ展開し、次のフレームの切れ目で表示を切り替える。
+			@param[in]	src		ソース（WIDTH x HEIGHT）
 		 */
 		//-----------------------------------------------------------------//
-		void start()
+		void copy(const uint16_t* src) noexcept
 		{
-			red::DIR = 1;
-			green::DIR = 1;
-			blue::DIR = 1;
-			sclk::DIR = 1;
-			latch::DIR = 1;
-			blank::DIR = 1;
-			adr::init();
+			if(src == nullptr) return;
+
+			swap_wait_();
+			auto& f = frame_[disp_ ^ 1];
+			for(uint32_t y = 0; y < ROWS; ++y) {
+				const uint16_t* up = &src[y * WIDTH];
+				const uint16_t* dn = &src[(y + ROWS) * WIDTH];
+				for(uint32_t x = 0; x < WIDTH; ++x) {
+					uint32_t c1 = up[x];
+					uint32_t c2 = dn[x];
+					uint32_t r1 = (c1 >> 8) & 0xf8; r1 |= r1 >> 5;
+					uint32_t g1 = (c1 >> 3) & 0xfc; g1 |= g1 >> 6;
+					uint32_t b1 = (c1 << 3) & 0xf8; b1 |= b1 >> 5;
+					uint32_t r2 = (c2 >> 8) & 0xf8; r2 |= r2 >> 5;
+					uint32_t g2 = (c2 >> 3) & 0xfc; g2 |= g2 >> 6;
+					uint32_t b2 = (c2 << 3) & 0xf8; b2 |= b2 >> 5;
+					encode_(&f.plane_[y][0][x * 2], r1, g1, b1, r2, g2, b2);
+				}
+			}
+			swap_ = true;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	コピー
-			@param[in]	src		ソース
+			@brief	フレームのコピー（RGB888、0x00RRGGBB） @n
+					裏フレームへ展開し、次のフレームの切れ目で表示を切り替える。
+			@param[in]	src		ソース（WIDTH x HEIGHT）
 		 */
 		//-----------------------------------------------------------------//
-		void copy(const void* src)
+		void copy(const uint32_t* src) noexcept
 		{
+			if(src == nullptr) return;
+
+			swap_wait_();
+			auto& f = frame_[disp_ ^ 1];
+			for(uint32_t y = 0; y < ROWS; ++y) {
+				const uint32_t* up = &src[y * WIDTH];
+				const uint32_t* dn = &src[(y + ROWS) * WIDTH];
+				for(uint32_t x = 0; x < WIDTH; ++x) {
+					uint32_t c1 = up[x];
+					uint32_t c2 = dn[x];
+					encode_(&f.plane_[y][0][x * 2],
+						(c1 >> 16) & 0xff, (c1 >> 8) & 0xff, c1 & 0xff,
+						(c2 >> 16) & 0xff, (c2 >> 8) & 0xff, c2 & 0xff);
+				}
+			}
+			swap_ = true;
 		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	フレームの切り替え待ちか検査
+			@return 切り替え待ちなら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool probe_swap() const noexcept { return swap_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	表示フレーム数の取得（リフレッシュ・レートの計測用）
+			@return 表示フレーム数
+		 */
+		//-----------------------------------------------------------------//
+		uint32_t get_frame_count() const noexcept { return frame_count_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	BCM 単位時間の取得（CMT カウント）
+			@return BCM 単位時間
+		 */
+		//-----------------------------------------------------------------//
+		uint16_t get_unit() const noexcept { return unit_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	最小スロット時間の取得（CMT カウント）
+			@return 最小スロット時間
+		 */
+		//-----------------------------------------------------------------//
+		uint16_t get_min_slot() const noexcept { return min_slot_; }
 	};
 }
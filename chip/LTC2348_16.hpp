@@ -2,9 +2,12 @@
 //=====================================================================//
 /*!	@file
 	@brief	LTC2348-16 ドライバー @n
-			LTC2348/16 bits A/D コンバーター
+			LTC2348/16 bits A/D コンバーター @n
+			・LTC2348_16: ソフトウェア起動、SDO ４レーンをポートで読み出す。 @n
+			・LTC2348_16_stream: MTU で CNV を周期駆動し、BUSY の立下りで @n
+			  RSPI を DMA 駆動して全８チャネルを読み出す連続変換モード。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2017, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -12,6 +15,7 @@
 #include <cstdint>
 #include "common/delay.hpp"
 #include "common/format.hpp"
+#include "common/renesas.hpp"
 
 /// F_ICLK は速度パラメーター計算で必要で、設定が無いとエラーにします。
 #ifndef F_ICLK
@@ -332,4 +336,414 @@ namespace chip {
 			return ((static_cast<float>(data_[ch & 7] >> 8) / 65535.0f) - ofs) * gain[span];
 		}
 	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  LTC2348-16 連続変換（ストリーミング）テンプレートクラス @n
+				・CNV は MTU の PWM 出力で周期駆動する。 @n
+				・BUSY の立下り（IRQ 端子）で CSN を「L」にして、RSPI の送受信を @n
+				  DMA（SPTI/SPRI 起動）で２４ビット×８チャネル行う。 @n
+				・受信 DMA の終了割り込みで、サンプル（変換番号＋８チャネル）を @n
+				  リングバッファへ格納する（割り込み側が書き込み、メイン側が読み出す）。 @n
+				・平均化（間引き）を設定すると、Ｎ回の平均を１サンプルとして格納する。 @n
+				※SPI は「rspi_io」、MTU_IO は「mtu_io」の型を渡す。 @n
+				※PD は０、SCKO は使わない。
+		@param[in]	CSN		デバイス選択
+		@param[in]	SPI		RSPI 制御クラス（rspi_io）
+		@param[in]	MTU_IO	CNV を生成する MTU 制御クラス（mtu_io）
+		@param[in]	BUSY	BUSY を接続する IRQ 端子の割り込みベクター（IRQ0 ～ IRQ7）
+		@param[in]	RXDMA	受信用 DMAC チャネル
+		@param[in]	TXDMA	送信用 DMAC チャネル
+		@param[in]	BUFN	リングバッファのサンプル数（２のべき乗）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class CSN, class SPI, class MTU_IO, device::ICU::VECTOR BUSY, class RXDMA, class TXDMA, uint32_t BUFN = 256>
+	class LTC2348_16_stream {
+
+		static_assert(BUFN >= 2 && (BUFN & (BUFN - 1)) == 0, "BUFN must be a power of two.");
+
+		typedef typename SPI::value_type RSPI;
+
+	public:
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  ソフト・スパン種別 @n
+					Internal VREFBUF: 4.096V
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		enum class span_type : uint8_t {
+			DISABLE,  		///< 000, Chanel Disable
+			P5_12,			///< 001, 1.25 * VREFBUF          (+0      to +5.12V)
+			M5P5,			///< 010, 2.5  * VREFBUF / 1.024  (-5V     to +5V)
+			P5_12M5_12,		///< 011, 2.5  * VREFBUF          (-5.12V  to +5.12V)
+			P10,			///< 100, 2.5  * VREFBUF / 1.024  (+0      to +10V)
+			P10_24,			///< 101, 2.5  * VREFBUF          (+0      to +10.24V)
+			M10P10,			///< 110, 5.0  * VREFBUF / 1.024  (-10V    to +10V)
+			M10_24P10_24,	///< 111, 5.0  * VREFBUF          (-10.24V to +10.24V)
+		};
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  サンプル構造体
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct sample_t {
+			uint32_t	seq;		///< 読み出した変換の通し番号（失われた変換は含まない、平均化時は先頭の変換）
+			uint16_t	data[8];	///< 変換値（ユニポーラ・スパンは０～６５５３５、バイポーラ・スパンは２の補数）
+		};
+
+	private:
+		static inline uint32_t	tx_[8];
+		static inline uint32_t	rx_[8];
+
+		static inline sample_t	ring_[BUFN];
+		static inline volatile uint32_t	put_ = 0;
+		static inline volatile uint32_t	get_ = 0;
+
+		static inline volatile uint32_t	seq_ = 0;
+		static inline volatile uint32_t	overrun_ = 0;
+		static inline volatile uint32_t	lost_ = 0;
+
+		static inline int32_t	acc_[8];
+		static inline uint32_t	acc_num_ = 0;
+		static inline uint32_t	acc_seq_ = 0;
+		static inline volatile uint32_t	decim_ = 1;
+
+		class recv_task;
+
+		typedef device::dmac_mgr<RXDMA, recv_task> RXDMA_MGR;
+		typedef device::dmac_mgr<TXDMA> TXDMA_MGR;
+
+		static inline RXDMA_MGR	rxdma_mgr_;
+		static inline TXDMA_MGR	txdma_mgr_;
+
+		static void busy_enable_(bool ena = true) noexcept
+		{
+			device::ICU::IR[BUSY] = 0;
+			device::ICU::IER.enable(BUSY, ena);
+		}
+
+		// BUSY 立下り割り込み（変換終了）
+		static INTERRUPT_FUNC void busy_task_() noexcept
+		{
+			// 読み出しが終わるまで、次の BUSY は受け付けない
+			device::ICU::IER.enable(BUSY, false);
+			device::ICU::IR[BUSY] = 0;
+
+			CSN::P = 0;
+			rxdma_mgr_.start_trans(RSPI::SPRI, RXDMA_MGR::trans_type::SN_DP_32,
+				RSPI::SPDR.address, reinterpret_cast<uint32_t>(rx_), 8, true);
+			txdma_mgr_.start_trans(RSPI::SPTI, TXDMA_MGR::trans_type::SP_DN_32,
+				reinterpret_cast<uint32_t>(tx_), RSPI::SPDR.address, 8);
+			// SPE の 0 -> 1 で、最初の SPTI が発生する
+			RSPI::SPCR.SPE = 0;
+			RSPI::SPCR.SPTIE = 1;
+			RSPI::SPCR.SPRIE = 1;
+			RSPI::SPCR.SPE = 1;
+		}
+
+		static bool set_busy_edge_() noexcept
+		{
+			switch(BUSY) {
+			case device::ICU::VECTOR::IRQ0: device::ICU::IRQCR0.IRQMD = 0b01; break;
+			case device::ICU::VECTOR::IRQ1: device::ICU::IRQCR1.IRQMD = 0b01; break;
+			case device::ICU::VECTOR::IRQ2: device::ICU::IRQCR2.IRQMD = 0b01; break;
+			case device::ICU::VECTOR::IRQ3: device::ICU::IRQCR3.IRQMD = 0b01; break;
+			case device::ICU::VECTOR::IRQ4: device::ICU::IRQCR4.IRQMD = 0b01; break;
+			case device::ICU::VECTOR::IRQ5: device::ICU::IRQCR5.IRQMD = 0b01; break;
+			case device::ICU::VECTOR::IRQ6: device::ICU::IRQCR6.IRQMD = 0b01; break;
+			case device::ICU::VECTOR::IRQ7: device::ICU::IRQCR7.IRQMD = 0b01; break;
+			default:
+				return false;
+			}
+			return true;
+		}
+
+		// 受信 DMA 終了割り込み（８チャネル読み出し完了）
+		class recv_task {
+		public:
+			void operator() () noexcept {
+				CSN::P = 1;
+				RSPI::SPCR.SPTIE = 0;
+				RSPI::SPCR.SPRIE = 0;
+
+				auto seq = seq_;
+				seq_ = seq + 1;
+
+				auto n = decim_;
+				if(acc_num_ == 0) {
+					acc_seq_ = seq;
+					for(uint32_t i = 0; i < 8; ++i) acc_[i] = 0;
+				}
+				// 上位１６ビットが変換値、下位３ビットがその変換の SoftSpan コード @n
+				// バイポーラ・スパン（010, 011, 110, 111）は２の補数なので、符号拡張して加える
+				for(uint32_t i = 0; i < 8; ++i) {
+					uint32_t w = rx_[i];
+					if(w & 0b010) {
+						acc_[i] += static_cast<int16_t>(w >> 8);
+					} else {
+						acc_[i] += static_cast<int32_t>((w >> 8) & 0xffff);
+					}
+				}
+				++acc_num_;
+				if(acc_num_ >= n) {
+					auto pos = put_;
+					if((pos - get_) >= BUFN) {
+						++overrun_;
+					} else {
+						auto& t = ring_[pos & (BUFN - 1)];
+						t.seq = acc_seq_;
+						for(uint32_t i = 0; i < 8; ++i) {
+							t.data[i] = static_cast<uint16_t>(acc_[i] / static_cast<int32_t>(acc_num_));
+						}
+						put_ = pos + 1;
+					}
+					acc_num_ = 0;
+				}
+
+				// 読み出し中に次の変換が終わっていたら、その変換は失われている
+				if(device::ICU::IR[BUSY] != 0) {
+					++lost_;
+				}
+				busy_enable_();
+			}
+		};
+
+		SPI			spi_;
+		MTU_IO		mtu_;
+
+		uint32_t	span_;
+		bool		run_;
+
+		void set_tx_() noexcept
+		{
+			// 先頭ワードの SDI で、全チャネルのスパン（２４ビット）を送る
+			tx_[0] = span_;
+			for(uint32_t i = 1; i < 8; ++i) tx_[i] = 0;
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		LTC2348_16_stream() noexcept : spi_(), mtu_(), span_(0), run_(false) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  連続変換を開始
+			@param[in]	rate	変換周期（サンプル／秒）
+			@param[in]	mch		MTU の周期チャネル
+			@param[in]	cnv		CNV を出力する MTU のチャネル
+			@param[in]	span	変換スパン種別（全てのチャネルに同一のスパンが設定される）
+			@param[in]	lvl		割り込みレベル（BUSY、DMA 終了）
+			@param[in]	speed	SPI クロック速度
+			@param[in]	odr		BUSY（IRQ 端子）のポート候補
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool start(uint32_t rate, typename MTU_IO::CHANNEL mch, typename MTU_IO::CHANNEL cnv,
+			span_type span, device::ICU::LEVEL lvl, uint32_t speed = 30'000'000,
+			device::port_map_irq::ORDER odr = device::port_map_irq::ORDER::FIRST) noexcept
+		{
+			if(run_ || lvl == device::ICU::LEVEL::NONE) return false;
+
+			uint32_t ss = 0;
+			for(int i = 0; i < 8; ++i) {
+				ss <<= 3;
+				ss |= static_cast<uint32_t>(span);
+			}
+			span_ = ss;
+			set_tx_();
+
+			CSN::DIR = 1;
+			CSN::P   = 1;
+
+			if(!spi_.start(speed, SPI::PHASE::TYPE1, SPI::DLEN::W24)) {
+				return false;
+			}
+
+			put_ = 0;
+			get_ = 0;
+			seq_ = 0;
+			overrun_ = 0;
+			lost_ = 0;
+			acc_num_ = 0;
+
+			rxdma_mgr_.start(lvl);
+			txdma_mgr_.start();
+			// SPTI/SPRI は DMAC の起動要因としてだけ使う
+			device::icu_mgr::set_interrupt(RSPI::SPRI, nullptr, lvl);
+			device::icu_mgr::set_interrupt(RSPI::SPTI, nullptr, lvl);
+
+			device::icu_mgr::set_level(BUSY, device::ICU::LEVEL::NONE);
+			if(!set_busy_edge_() || !device::port_map_irq::turn(BUSY, true, odr)) {
+				return false;
+			}
+			device::icu_mgr::set_interrupt(BUSY, busy_task_, lvl);
+			busy_enable_();
+
+			// CNV: 周期の先頭で「H」、1/16 周期で「L」
+			typedef typename MTU_IO::pwm_port_t PWM_PORT;
+			if(!mtu_.start_pwm2(mch, rate, PWM_PORT(cnv, MTU_IO::OUTPUT::HIGH_TO_LOW))) {
+				busy_enable_(false);
+				return false;
+			}
+			mtu_.set_pwm_duty(cnv, 0x1000);
+
+			run_ = true;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  連続変換を停止
+		*/
+		//-----------------------------------------------------------------//
+		void stop() noexcept
+		{
+			if(!run_) return;
+
+			mtu_.stop();
+			busy_enable_(false);
+			rxdma_mgr_.stop();
+			txdma_mgr_.stop();
+			RSPI::SPCR.SPTIE = 0;
+			RSPI::SPCR.SPRIE = 0;
+			device::icu_mgr::set_level(RSPI::SPRI, device::ICU::LEVEL::NONE);
+			device::icu_mgr::set_level(RSPI::SPTI, device::ICU::LEVEL::NONE);
+			CSN::P = 1;
+			run_ = false;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  連続変換中か検査
+			@return 変換中なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool probe() const noexcept { return run_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  チャネルにスパン種別を設定（次の変換から有効）
+			@param[in]	ch		チャネル
+			@param[in]	span	スパン種別
+		*/
+		//-----------------------------------------------------------------//
+		void set_span(uint8_t ch, span_type span) noexcept
+		{
+			span_ &= ~(0b111 << (ch * 3));
+			span_ |= static_cast<uint32_t>(span) << (ch * 3);
+			tx_[0] = span_;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  チャネルのスパン種別を取得
+			@param[in]	ch		チャネル
+			@return スパン種別
+		*/
+		//-----------------------------------------------------------------//
+		span_type get_span(uint8_t ch) const noexcept
+		{
+			return static_cast<span_type>((span_ >> (ch * 3)) & 0b111);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  平均化（間引き）数を設定 @n
+					※１で平均化しない
+			@param[in]	num		平均する変換回数
+		*/
+		//-----------------------------------------------------------------//
+		void set_decimation(uint32_t num) noexcept
+		{
+			if(num == 0) num = 1;
+			decim_ = num;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  格納されているサンプル数を取得
+			@return サンプル数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t length() const noexcept { return put_ - get_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サンプルを取得
+			@param[out]	t	サンプル
+			@return サンプルが無い場合「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool get(sample_t& t) noexcept
+		{
+			auto pos = get_;
+			if(pos == put_) return false;
+			t = ring_[pos & (BUFN - 1)];
+			get_ = pos + 1;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  読み出した変換の数を取得 @n
+					※CNV の回数は、これに get_lost() の値を加えた数（読み出し１回で @n
+					  失われる変換は、１回までしか検出できない）
+			@return 読み出した変換の数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_seq() const noexcept { return seq_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  リングバッファが溢れて捨てたサンプル数を取得
+			@return 捨てたサンプル数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_overrun() const noexcept { return overrun_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  読み出しが間に合わず失われた変換数を取得
+			@return 失われた変換数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_lost() const noexcept { return lost_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  変換値を電圧に変換
+			@param[in]	t	サンプル
+			@param[in]	ch	チャネル（０～７）
+			@return 変換電圧
+		*/
+		//-----------------------------------------------------------------//
+		float get_voltage(const sample_t& t, uint8_t ch) const noexcept {
+			ch &= 7;
+			uint32_t span = (span_ >> (ch * 3)) & 7;
+			static constexpr float gain[8] = { 0.0f, 5.12f, 5.0f, 5.12f, 10.0f, 10.24f, 10.0f, 10.24f };
+			if(span & 0b010) {  // バイポーラ（２の補数）
+				return static_cast<float>(static_cast<int16_t>(t.data[ch])) / 32768.0f * gain[span];
+			}
+			return static_cast<float>(t.data[ch]) / 65536.0f * gain[span];
+		}
+	};
 }
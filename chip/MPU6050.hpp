@@ -1,9 +1,13 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	MPU6050 ジャイロ、加速度センサ・ドライバー
+	@brief	MPU6050 ジャイロ、加速度センサ・ドライバー @n
+			・FIFO にサンプル（加速度、温度、ジャイロ）を溜め、まとめて１回の I2C 転送で @n
+			  読み出せる。 @n
+			・INT 端子（DATA_RDY）の割り込みから notify を呼び、probe が「true」になったら @n
+			  read_fifo で読み出す。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2016 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2016, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -18,9 +22,12 @@ namespace chip {
 	/*!
 		@brief  MPU6050 テンプレートクラス
 		@param[in]	I2C_IO	i2c I/O クラス
+		@param[in]	BATCH	FIFO から一度に読み出す最大サンプル数 @n
+							※１回の I2C 転送は BATCH * 14 バイトなので、I2C_IO の @n
+							バッファ（iica_io の TPSZ、標準で２５６）に収まる事（標準では１８まで）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class I2C_IO>
+	template <class I2C_IO, uint32_t BATCH = 8>
 	class MPU6050 {
 	public:
 		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
@@ -34,6 +41,23 @@ namespace chip {
 			int16_t z;
 		};
 
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	FIFO のサンプル（加速度、温度、ジャイロ）
+		 */
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct packet_t {
+			int16_vec	accel;
+			int16_t		temp;
+			int16_vec	gyro;
+		};
+
+		static constexpr uint32_t PACKET_SIZE = 14;		///< FIFO のサンプルのバイト数
+		static constexpr uint32_t FIFO_SIZE   = 1024;	///< FIFO の容量
+
+		static_assert(BATCH > 0 && (BATCH * PACKET_SIZE) <= FIFO_SIZE, "BATCH is out of range.");
+
 	private:
 		// R/W ビットを含まない７ビット値
 		static constexpr uint8_t MPU6050_ADR_ = 0x68;  // AD0 = 0; (GY-521 module default)
@@ -409,8 +433,37 @@ DMP_MEMORY_BANK_SIZE    256
 DMP_MEMORY_CHUNK_SIZE   16
 #endif
 
+		struct USER_CTRL {
+			enum {
+				FIFO_EN_BIT    = 6,
+				FIFO_RESET_BIT = 2,
+			};
+		};
+
+		struct INTR {
+			enum {
+				FIFO_OFLOW_BIT = 4,
+				DATA_RDY_BIT   = 0,
+			};
+		};
+
 		I2C_IO& i2c_;
 
+		uint32_t	intr_count_;
+		uint32_t	overflow_;
+		uint8_t		fifo_[BATCH * PACKET_SIZE];
+
+		static inline volatile uint32_t	notify_count_ = 0;
+
+		void reset_fifo_() {
+			send_(REG::USER_CTRL, 1 << USER_CTRL::FIFO_RESET_BIT);
+			send_(REG::USER_CTRL, 1 << USER_CTRL::FIFO_EN_BIT);
+		}
+
+		static int16_t be16_(const uint8_t* p) {
+			return static_cast<int16_t>((p[0] << 8) | p[1]);
+		}
+
 		uint8_t recv_(REG reg) const {
 			uint8_t tmp[1];
 			tmp[0] = static_cast<uint8_t>(reg);
@@ -441,7 +494,7 @@ DMP_MEMORY_CHUNK_SIZE   16
 			tmp[0] = static_cast<uint8_t>(reg);
 			i2c_.send(MPU6050_ADR_, tmp, 1);
 			i2c_.recv(MPU6050_ADR_, &tmp[1], 1);
-			tmp[1] &= ((1 << len) - 1) << bpos;
+			tmp[1] &= ~(((1 << len) - 1) << bpos);
 			tmp[1] |= v << bpos;
  			i2c_.send(MPU6050_ADR_, tmp, 2);
 		}
@@ -479,7 +532,7 @@ DMP_MEMORY_CHUNK_SIZE   16
 			@param[in]	i2c	iica_io クラスを参照で渡す
 		 */
 		//-----------------------------------------------------------------//
-		MPU6050(I2C_IO& i2c) : i2c_(i2c) { }
+		MPU6050(I2C_IO& i2c) : i2c_(i2c), intr_count_(0), overflow_(0), fifo_{ 0 } { }
 
 		void set_sleep_enable(bool f) { set_bit_(REG::PWR_MGMT_1, PWR1::SLEEP_BIT, f); }
 
@@ -558,6 +611,121 @@ DMP_MEMORY_CHUNK_SIZE   16
 			get_vec_(REG::GYRO_XOUT_H, vec);
 			return vec;
 		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	FIFO 動作の開始 @n
+					サンプリング周波数は、dlpf が０の場合 8KHz / (1 + div)、 @n
+					それ以外は 1KHz / (1 + div)
+			@param[in]	div		サンプリング周波数の分周（SMPLRT_DIV）
+			@param[in]	dlpf	デジタル・ローパスフィルター（CONFIG::DLPF_CFG、０～６）
+		 */
+		//-----------------------------------------------------------------//
+		void start_fifo(uint8_t div, uint8_t dlpf = 1) {
+			send_(REG::SMPLRT_DIV, div);
+			set_bits_(REG::CONFIG, 0, 3, dlpf & 7);
+			// TEMP, XG, YG, ZG, ACCEL
+			send_(REG::FIFO_EN, 0b1111'1000);
+			// INT 端子：アクティブ High、プッシュプル、50us パルス
+			send_(REG::INT_PIN_CFG, 0x00);
+			send_(REG::INT_ENABLE, (1 << INTR::FIFO_OFLOW_BIT) | (1 << INTR::DATA_RDY_BIT));
+			reset_fifo_();
+			intr_count_ = notify_count_;
+			overflow_ = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	データ準備完了の通知 @n
+					※INT 端子の割り込みから呼ぶ
+		 */
+		//-----------------------------------------------------------------//
+		static void notify() { ++notify_count_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	FIFO に BATCH 個以上のサンプルがあるか（通知の数で判断）
+			@return 読み出し可能なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool probe() const { return (notify_count_ - intr_count_) >= BATCH; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	FIFO に溜まっているバイト数を取得
+			@return バイト数
+		 */
+		//-----------------------------------------------------------------//
+		uint16_t get_fifo_count() const {
+			uint16_t v;
+			get_16_(REG::FIFO_COUNTH, v);
+			return v;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	FIFO からサンプルを読み出す（データは１回の I2C 転送） @n
+					オーバーフロー、又は、サンプルの境界がずれた場合は、 @n
+					FIFO をリセットして「０」を返す。
+			@param[out]	dst		サンプルの格納先
+			@param[in]	num		最大数
+			@return 読み出したサンプル数（I2C 転送に失敗した場合「０」）
+		 */
+		//-----------------------------------------------------------------//
+		uint32_t read_fifo(packet_t* dst, uint32_t num) {
+			uint32_t notify = notify_count_;
+
+			uint32_t cnt = get_fifo_count();
+			if(cnt >= FIFO_SIZE || (cnt % PACKET_SIZE) != 0) {
+				reset_fifo_();
+				intr_count_ = notify;
+				++overflow_;
+				return 0;
+			}
+			// FIFO が空なら、通知の数を合わせる
+			if(cnt == 0) {
+				intr_count_ = notify;
+				return 0;
+			}
+			cnt /= PACKET_SIZE;
+			if(cnt > num) cnt = num;
+			if(cnt > BATCH) cnt = BATCH;
+			if(cnt == 0) return 0;
+
+			uint8_t reg = static_cast<uint8_t>(REG::FIFO_R_W);
+			if(!i2c_.send(MPU6050_ADR_, &reg, 1)) return 0;
+			if(!i2c_.recv(MPU6050_ADR_, fifo_, cnt * PACKET_SIZE)) return 0;
+			// 読み出した分だけ、通知を消費する
+			if((notify - intr_count_) > cnt) intr_count_ += cnt;
+			else intr_count_ = notify;
+
+			const uint8_t* p = fifo_;
+			for(uint32_t i = 0; i < cnt; ++i) {
+				dst[i].accel.x = be16_(p + 0);
+				dst[i].accel.y = be16_(p + 2);
+				dst[i].accel.z = be16_(p + 4);
+				dst[i].temp    = be16_(p + 6);
+				dst[i].gyro.x  = be16_(p + 8);
+				dst[i].gyro.y  = be16_(p + 10);
+				dst[i].gyro.z  = be16_(p + 12);
+				p += PACKET_SIZE;
+			}
+			return cnt;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	FIFO をリセットした回数を取得
+			@return リセット回数
+		 */
+		//-----------------------------------------------------------------//
+		uint32_t get_overflow() const { return overflow_; }
 	};
 }
 
@@ -3,25 +3,41 @@
 /*!	@file
 	@brief	MX25L3233F class @n
 			Macronix International Co.,Ltd. @n
-			3V, 32M-BIT [x 1/x 2/x 4] FLASH MEMORY ドライバー
+			3V, 32M-BIT [x 1/x 2/x 4] FLASH MEMORY ドライバー @n
+			・読み出しは 4 x I/O（EBh）で、連続読み出しモード（コマンド省略）を使う。 @n
+			・書き込みは 4 x I/O ページプログラム（38h）、完了（WIP）は次のコマンドの @n
+			  直前まで待たないので、書き込み中に次のページを準備できる。 @n
+			・CACHE_NUM を指定すると、小さなランダム読み出し（フォントなど）を @n
+			  ライン（32 バイト）単位でキャッシュする。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2018 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2018, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
 #include <cstdint>
+#include <cstring>
 
 namespace chip {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  MX25L3233F テンプレートクラス
-		@param[in]	QSPI_IO	QSPI 制御クラス
+		@param[in]	QSPI_IO		QSPI 制御クラス
+		@param[in]	CACHE_NUM	読み出しキャッシュのライン数（０ならキャッシュしない）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class QSPI_IO>
+	template <class QSPI_IO, uint32_t CACHE_NUM = 0>
 	class MX25L3233F {
+	public:
+		static constexpr uint32_t CAPACITY   = 4 * 1024 * 1024;	///< 容量（バイト）
+		static constexpr uint32_t PAGE_SIZE  = 256;		///< プログラム・ページ
+		static constexpr uint32_t SECTOR_SIZE = 4096;	///< 消去セクター
+		static constexpr uint32_t BLOCK_SIZE = 65536;	///< 消去ブロック
+		static constexpr uint32_t CACHE_LINE = 32;		///< キャッシュ・ラインのサイズ
+
+	private:
+		typedef typename QSPI_IO::WIDTH WIDTH;
 
 		QSPI_IO&	qspi_io_;
 
@@ -34,13 +50,117 @@ namespace chip {
 			READQ = 0x6B,	// 1l / 4O read
 
 			WREN  = 0x06,	// write enable (1)
+			RDSR  = 0x05,	// read status register (1 + 1)
+			WRSR  = 0x01,	// write status register (1 + 1)
+			RDID  = 0x9F,	// read identification (1 + 3)
+			PP    = 0x02,	// page program (4 + n)
+			PP4   = 0x38,	// 4 x I/O page program (1 + 3 + n)
+			SE    = 0x20,	// sector erase (4K)
+			BE    = 0xD8,	// block erase (64K)
+			CE    = 0x60,	// chip erase
 		};
 
-		void send_command_(CMD cmd, uint32_t adr) noexcept
+		static constexpr uint8_t SR_WIP = 0x01;
+		static constexpr uint8_t SR_WEL = 0x02;
+		static constexpr uint8_t SR_QE  = 0x40;
+
+		static constexpr uint8_t MODE_CONT = 0xA5;	// 連続読み出しモードに入る（P7-4 != P3-0）
+		static constexpr uint8_t MODE_EXIT = 0xFF;	// 連続読み出しモードを抜ける
+
+		static constexpr uint32_t CACHE_BUFF = CACHE_NUM > 0 ? CACHE_NUM : 1;
+
+		bool		cont_;
+		bool		busy_;
+
+		uint32_t	tag_[CACHE_BUFF];
+		uint8_t		cache_[CACHE_BUFF][CACHE_LINE];
+
+		void send_command_(CMD cmd, bool last = true) noexcept
+		{
+			uint8_t tmp = static_cast<uint8_t>(cmd);
+			qspi_io_.send(&tmp, 1, WIDTH::SINGLE, last);
+		}
+
+		void send_command_(CMD cmd, uint32_t adr, WIDTH width = WIDTH::SINGLE, bool last = true) noexcept
+		{
+			send_command_(cmd, false);
+			uint8_t tmp[3];
+			tmp[0] = adr >> 16;
+			tmp[1] = adr >> 8;
+			tmp[2] = adr;
+			qspi_io_.send(tmp, 3, width, last);
+		}
+
+		uint8_t read_status_() noexcept
+		{
+			send_command_(CMD::RDSR, false);
+			uint8_t tmp;
+			qspi_io_.recv(&tmp, 1);
+			return tmp;
+		}
+
+		// 連続読み出しモードを抜けてから、書き込み／消去の完了を待つ
+		void ready_() noexcept
+		{
+			// 全て FFh なので、通常モードではコマンド FFh（無効）として無視される
+			if(cont_) {
+				uint8_t tmp[6] = { 0xff, 0xff, 0xff, MODE_EXIT, 0xff, 0xff };
+				qspi_io_.send(tmp, 6, WIDTH::QUAD, false);
+				qspi_io_.recv(tmp, 1, WIDTH::QUAD);
+				cont_ = false;
+			}
+			if(busy_) {
+				while((read_status_() & SR_WIP) != 0) ;
+				busy_ = false;
+			}
+		}
+
+		void write_enable_() noexcept
 		{
-			qspi_io_.xchg(static_cast<uint8_t>(cmd));
+			ready_();
+			send_command_(CMD::WREN);
+		}
 
+		void read_quad_(uint32_t adr, uint8_t* dst, uint32_t len) noexcept
+		{
+			if(busy_) ready_();
+			if(!cont_) {
+				send_command_(CMD::READ4, false);
+			}
+			// アドレス（3）、モード（1）、ダミー（4 クロック）
+			uint8_t tmp[6] = { static_cast<uint8_t>(adr >> 16), static_cast<uint8_t>(adr >> 8),
+				static_cast<uint8_t>(adr), MODE_CONT, 0, 0 };
+			qspi_io_.send(tmp, 6, WIDTH::QUAD, false);
+			qspi_io_.recv(dst, len, WIDTH::QUAD);
+			cont_ = true;
+		}
 
+		void invalidate_() noexcept
+		{
+			if constexpr (CACHE_NUM > 0) {
+				for(uint32_t i = 0; i < CACHE_NUM; ++i) {
+					tag_[i] = 0xffff'ffff;
+				}
+			}
+		}
+
+		void read_cache_(uint32_t adr, uint8_t* dst, uint32_t len) noexcept
+		{
+			while(len > 0) {
+				uint32_t top = adr & ~(CACHE_LINE - 1);
+				uint32_t idx = (top / CACHE_LINE) % CACHE_NUM;
+				if(tag_[idx] != top) {
+					read_quad_(top, cache_[idx], CACHE_LINE);
+					tag_[idx] = top;
+				}
+				uint32_t ofs = adr - top;
+				uint32_t n = CACHE_LINE - ofs;
+				if(n > len) n = len;
+				std::memcpy(dst, &cache_[idx][ofs], n);
+				adr += n;
+				dst += n;
+				len -= n;
+			}
 		}
 
 	public:
@@ -50,25 +170,91 @@ namespace chip {
 			@param[in]	qspi_io	qspi 制御クラスを参照で渡す
 		 */
 		//-----------------------------------------------------------------//
-		MX25L3233F(QSPI_IO& qspi_io) noexcept : qspi_io_(qspi_io) { }
+		MX25L3233F(QSPI_IO& qspi_io) noexcept : qspi_io_(qspi_io),
+			cont_(false), busy_(false), tag_{ 0 }, cache_{ { 0 } }
+		{ }
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	開始
+			@brief	開始（クアッド・イネーブル（QE）を設定）
+			@param[in]	speed	クロック周波数
 			@return 正常なら「true」
 		 */
 		//-----------------------------------------------------------------//
-		bool start() noexcept
+		bool start(uint32_t speed = 4'000'000) noexcept
 		{
-			if(!qspi_io_.start(4'000'000, QSPI_IO::PHASE::MODE0, QSPI_IO::DLEN::W8)) {
+			if(!qspi_io_.start(speed, QSPI_IO::PHASE::MODE0, QSPI_IO::DLEN::W8)) {
 				return false;
 			}
 
+			// リセット前の連続読み出しモードを抜ける
+			cont_ = true;
+			busy_ = false;
+			ready_();
+			invalidate_();
+
+			uint8_t id[3];
+			read_id(id);
+			if(id[0] != 0xC2) return false;  // Macronix
+
+			auto sr = read_status_();
+			if((sr & SR_QE) == 0) {
+				write_enable_();
+				send_command_(CMD::WRSR, false);
+				sr |= SR_QE;
+				qspi_io_.send(&sr, 1);
+				busy_ = true;
+				ready_();
+				if((read_status_() & SR_QE) == 0) return false;
+			}
+
 			return true;
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ID の読み出し
+			@param[out]	id	製造者 ID、メモリータイプ、容量（３バイト）
+		 */
+		//-----------------------------------------------------------------//
+		void read_id(uint8_t* id) noexcept
+		{
+			ready_();
+			send_command_(CMD::RDID, false);
+			qspi_io_.recv(id, 3);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	書き込み／消去中か検査
+			@return 書き込み／消去中なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool probe() noexcept
+		{
+			if(!busy_) return false;
+			if(cont_) ready_();
+			if((read_status_() & SR_WIP) == 0) {
+				busy_ = false;
+			}
+			return busy_;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	書き込み／消去の完了を待つ
+		 */
+		//-----------------------------------------------------------------//
+		void sync() noexcept
+		{
+			ready_();
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	読み出し
@@ -78,24 +264,87 @@ namespace chip {
 			@return 成功なら「true」
 		 */
 		//-----------------------------------------------------------------//
-		bool read(uint32_t adr, void* dst, uint32_t len) const
+		bool read(uint32_t adr, void* dst, uint32_t len) noexcept
 		{
+			if(dst == nullptr || adr >= CAPACITY || len > (CAPACITY - adr)) return false;
+			if(len == 0) return true;
+
+			auto p = static_cast<uint8_t*>(dst);
+			if constexpr (CACHE_NUM > 0) {
+				if(len <= CACHE_LINE) {
+					read_cache_(adr, p, len);
+					return true;
+				}
+			}
+			read_quad_(adr, p, len);
 			return true;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	書き込み
+			@brief	書き込み（消去済みの領域に書く） @n
+					ページ（256 バイト）毎に分割し、最後のページの完了は待たない。
 			@param[in]	adr	書き込みアドレス
 			@param[out]	src	元
 			@param[in]	len	長さ
 			@return 成功なら「true」
 		 */
 		//-----------------------------------------------------------------//
-		bool write(uint32_t adr, const void* src, uint32_t len) const
+		bool write(uint32_t adr, const void* src, uint32_t len) noexcept
 		{
+			if(src == nullptr || adr >= CAPACITY || len > (CAPACITY - adr)) return false;
+
+			invalidate_();
+			auto p = static_cast<const uint8_t*>(src);
+			while(len > 0) {
+				uint32_t n = PAGE_SIZE - (adr & (PAGE_SIZE - 1));
+				if(n > len) n = len;
+				write_enable_();
+				send_command_(CMD::PP4, adr, WIDTH::QUAD, false);
+				qspi_io_.send(p, n, WIDTH::QUAD);
+				busy_ = true;
+				adr += n;
+				p += n;
+				len -= n;
+			}
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	消去（完了は待たない）
+			@param[in]	adr		消去アドレス（セクター、又はブロックの先頭）
+			@param[in]	block	６４K ブロックを消去する場合「true」
+			@return 成功なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool erase(uint32_t adr, bool block = false) noexcept
+		{
+			if(adr >= CAPACITY) return false;
+			uint32_t size = block ? BLOCK_SIZE : SECTOR_SIZE;
+			if((adr & (size - 1)) != 0) return false;
+
+			invalidate_();
+			write_enable_();
+			send_command_(block ? CMD::BE : CMD::SE, adr);
+			busy_ = true;
 			return true;
 		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	全消去（完了は待たない）
+		 */
+		//-----------------------------------------------------------------//
+		void erase_chip() noexcept
+		{
+			invalidate_();
+			write_enable_();
+			send_command_(CMD::CE);
+			busy_ = true;
+		}
 	};
 }
@@ -2,12 +2,16 @@
 //=====================================================================//
 /*!	@file
 	@brief	NTC サーミスタ 温度計算 クラス @n
+			・A/D 変換値から温度への変換表をコンパイル時に作成し、実行時は @n
+			  固定小数点の直線補間だけで温度を求める（FPU を使わない）。 @n
+			・B 定数モデルと、Steinhart-Hart モデルに対応。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2017, 2018 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2017, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
+#include <cstdint>
 #include <cmath>
 
 namespace chip {
@@ -26,76 +30,275 @@ namespace chip {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
-		@brief  NTCTH テンプレートクラス
-		@param[in]	ADNUM	A/D 変換値の量子化最大値（１２ビットの場合４０９５ @n
-							１０ビットの場合、１０２３）
+		@brief  サーミスタ計算ユーティリティー（constexpr）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	struct ntc_utils {
+
+		static constexpr double T0 = 273.15;	///< ０℃の絶対温度
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	自然対数（コンパイル時計算用）
+			@param[in]	x	値（正）
+			@return ln(x)
+		*/
+		//-----------------------------------------------------------------//
+		static constexpr double log(double x) noexcept
+		{
+			if(x <= 0.0) return -1e300;
+			int k = 0;
+			while(x >= 2.0) { x *= 0.5; ++k; }
+			while(x < 1.0) { x *= 2.0; --k; }
+			// ln(x) = 2 * atanh((x - 1) / (x + 1))
+			double y = (x - 1.0) / (x + 1.0);
+			double y2 = y * y;
+			double term = y;
+			double sum = 0.0;
+			for(int n = 1; n < 40; n += 2) {
+				sum += term / static_cast<double>(n);
+				term *= y2;
+			}
+			return 2.0 * sum + static_cast<double>(k) * 0.69314718055994530942;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	自然対数の選択
+			@param[in]	EXACT	「true」なら std::log（実行時計算用）
+			@param[in]	x	値（正）
+			@return ln(x)
+		*/
+		//-----------------------------------------------------------------//
+		template <bool EXACT>
+		static constexpr double ln(double x) noexcept
+		{
+			if constexpr (EXACT) return std::log(x);
+			else return log(x);
+		}
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  B 定数モデル
 		@param[in]	THM		サーミスタの型
-		@param[in]	REFR	分圧抵抗値（単位オーム）
-		@param[in]	thup	サーミスタが VCC 側の場合「true」、GND 側の場合「false」
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <uint32_t ADNUM, thermistor THM, uint32_t REFR, bool thup>
-	class NTCTH {
+	template <thermistor THM>
+	struct ntc_b_model {
 
 		// サーミスタの型に応じたパラメーター
 		// THB:  B 定数
 		// TR25: ２５度における基準抵抗値
-		static void get_para_(float& THB, float& TR25)
+		static constexpr double THB  = THM == thermistor::NT103_34G ? 3435.0
+			: THM == thermistor::NT103_41G ? 4126.0 : 3380.0;
+		static constexpr double TR25 = 10e3;
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	抵抗値から絶対温度を計算
+			@param[in]	EXACT	「true」なら std::log を使う
+			@param[in]	r	抵抗値（オーム）
+			@return 絶対温度
+		*/
+		//-----------------------------------------------------------------//
+		template <bool EXACT = false>
+		static constexpr double kelvin(double r) noexcept
 		{
-			switch(THM) {
-			case thermistor::NT103_34G:
-				THB  = 3435.0f;  ///< サーミスタＢ定数
-				TR25 = 10e3;     ///< R25 サーミスタ２５℃基準抵抗値
-				break;
-			case thermistor::NT103_41G:
-				THB  = 4126.0f;  ///< サーミスタＢ定数
-				TR25 = 10e3;     ///< R25 サーミスタ２５℃基準抵抗値
-				break;
-			case thermistor::HX103_3380:
-				THB  = 3380.0f;  ///< サーミスタＢ定数
-				TR25 = 10e3;     ///< R25 サーミスタ２５℃基準抵抗値
-				break;
-			default:
-				break;
-			}
+			return 1.0 / (ntc_utils::ln<EXACT>(r / TR25) / THB + 1.0 / (ntc_utils::T0 + 25.0));
 		}
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  Steinhart-Hart モデル @n
+				1/T = A + B * ln(R) + C * ln(R)^3 @n
+				Ex: struct my_sh { static constexpr double A = 1.009249522e-03; @n
+				                   static constexpr double B = 2.378405444e-04; @n
+				                   static constexpr double C = 2.019202697e-07; };
+		@param[in]	COEF	係数（A、B、C を持つ型）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class COEF>
+	struct ntc_sh_model {
 
-		// サーミスターが VCC 側
-		static float thermistor_upper_(uint32_t raw)
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	抵抗値から絶対温度を計算
+			@param[in]	EXACT	「true」なら std::log を使う
+			@param[in]	r	抵抗値（オーム）
+			@return 絶対温度
+		*/
+		//-----------------------------------------------------------------//
+		template <bool EXACT = false>
+		static constexpr double kelvin(double r) noexcept
 		{
-			if(raw == 0) return 0.0f;  // 零除算を避ける
-			float thr = (static_cast<float>(REFR * ADNUM) / static_cast<float>(raw)) - static_cast<float>(REFR);
-			return thr;
+			double l = ntc_utils::ln<EXACT>(r);
+			return 1.0 / (COEF::A + COEF::B * l + COEF::C * l * l * l);
 		}
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  NTCTH テンプレート基本クラス
+		@param[in]	ADNUM	A/D 変換値の量子化最大値（１２ビットの場合４０９５ @n
+							１０ビットの場合、１０２３）
+		@param[in]	MODEL	サーミスタのモデル（ntc_b_model、ntc_sh_model）
+		@param[in]	REFR	分圧抵抗値（単位オーム）
+		@param[in]	thup	サーミスタが VCC 側の場合「true」、GND 側の場合「false」
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t ADNUM, class MODEL, uint32_t REFR, bool thup>
+	class NTCTH_base {
+	public:
+		static constexpr int16_t TEMP_MIN = -5500;	///< 温度の下限（1/100 ℃）
+		static constexpr int16_t TEMP_MAX = 25000;	///< 温度の上限（1/100 ℃）
 
-		// サーミスターが GND 側
-		static float thermistor_lower_(uint32_t raw)
+	private:
+		static constexpr uint32_t bits_(uint32_t n) noexcept
 		{
-			float thr = static_cast<float>(REFR * raw) / static_cast<float>(ADNUM - raw);
-			return thr;
+			uint32_t b = 0;
+			while((1u << b) < n) ++b;
+			return b;
 		}
 
+		// 変換表：２５６区間（A/D が８ビット以下なら、全ての値）
+		static constexpr uint32_t AD_BITS  = bits_(ADNUM + 1);
+		static constexpr uint32_t SHIFT    = AD_BITS > 8 ? AD_BITS - 8 : 0;
+		static constexpr uint32_t STEP     = 1 << SHIFT;
+		static constexpr uint32_t TABLE_NUM = ((ADNUM + STEP - 1) >> SHIFT) + 1;
+
+		// 分圧から抵抗値を求め、温度（1/100 ℃）にする
+		static constexpr int16_t centi_(uint32_t adn) noexcept
+		{
+			if(adn > ADNUM) adn = ADNUM;
+			double r = 0.0;
+			if(thup) {
+				if(adn == 0) return TEMP_MIN;
+				r = static_cast<double>(REFR) * static_cast<double>(ADNUM) / static_cast<double>(adn)
+					- static_cast<double>(REFR);
+				if(r <= 0.0) return TEMP_MAX;
+			} else {
+				if(adn >= ADNUM) return TEMP_MIN;
+				if(adn == 0) return TEMP_MAX;
+				r = static_cast<double>(REFR) * static_cast<double>(adn) / static_cast<double>(ADNUM - adn);
+			}
+			double t = (MODEL::kelvin(r) - ntc_utils::T0) * 100.0;
+			if(t < static_cast<double>(TEMP_MIN)) return TEMP_MIN;
+			if(t > static_cast<double>(TEMP_MAX)) return TEMP_MAX;
+			return static_cast<int16_t>(t < 0.0 ? t - 0.5 : t + 0.5);
+		}
+
+		struct table_t {
+			int16_t	tbl[TABLE_NUM];
+			constexpr table_t() noexcept : tbl{ } {
+				for(uint32_t i = 0; i < TABLE_NUM; ++i) {
+					tbl[i] = centi_(i << SHIFT);
+				}
+			}
+		};
+
+		static constexpr table_t table_ = table_t();
+
 	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	温度を取得（固定小数点）
+			@param[in]	adn		A/D 変換値
+			@return 温度（1/100 ℃）
+		 */
+		//-----------------------------------------------------------------//
+		static int16_t get_centi(uint16_t adn) noexcept
+		{
+			if(adn > ADNUM) adn = ADNUM;
+			uint32_t i = adn >> SHIFT;
+			if(SHIFT == 0 || i >= (TABLE_NUM - 1)) return table_.tbl[i];
+			int32_t a = table_.tbl[i];
+			int32_t d = table_.tbl[i + 1] - a;
+			return a + ((d * static_cast<int32_t>(adn & (STEP - 1))) >> SHIFT);
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	() オペレーター
 			@param[in]	adn		A/D 変換値
+			@return 温度（℃）
+		 */
+		//-----------------------------------------------------------------//
+		float operator () (uint16_t adn) const noexcept
+		{
+			return static_cast<float>(get_centi(adn)) * 0.01f;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	複数チャネルをまとめて変換
+			@param[in]	src		A/D 変換値の配列
+			@param[out]	dst		温度（1/100 ℃）の配列
+			@param[in]	num		チャネル数
 		 */
 		//-----------------------------------------------------------------//
-		float operator () (uint16_t adn) const
+		static void convert(const uint16_t* src, int16_t* dst, uint32_t num) noexcept
 		{
-			float thr;
+			while(num > 0) {
+				*dst++ = get_centi(*src++);
+				--num;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	式による温度計算（変換表を使わない、std::log による検証用）
+			@param[in]	adn		A/D 変換値
+			@return 温度（℃）
+		 */
+		//-----------------------------------------------------------------//
+		static float exact(uint16_t adn) noexcept
+		{
+			float r;
 			if(thup) {
-				thr = thermistor_upper_(adn);
+				if(adn == 0) return static_cast<float>(TEMP_MIN) * 0.01f;
+				r = static_cast<float>(REFR) * static_cast<float>(ADNUM) / static_cast<float>(adn)
+					- static_cast<float>(REFR);
 			} else {
-				thr = thermistor_lower_(adn);
+				if(adn >= ADNUM) return static_cast<float>(TEMP_MIN) * 0.01f;
+				r = static_cast<float>(REFR) * static_cast<float>(adn) / static_cast<float>(ADNUM - adn);
 			}
-			float THB;
-			float TR25;
-			get_para_(THB, TR25);
-			static constexpr float T0 = 298.15f;   ///< 絶対温度
-			float t = 1.0f / (std::log(thr / TR25) / THB + (1.0f / T0));
-			return t - 273.15f;
+			return static_cast<float>(MODEL::template kelvin<true>(r) - ntc_utils::T0);
 		}
 	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  NTCTH テンプレートクラス（B 定数モデル）
+		@param[in]	ADNUM	A/D 変換値の量子化最大値（１２ビットの場合４０９５ @n
+							１０ビットの場合、１０２３）
+		@param[in]	THM		サーミスタの型
+		@param[in]	REFR	分圧抵抗値（単位オーム）
+		@param[in]	thup	サーミスタが VCC 側の場合「true」、GND 側の場合「false」
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t ADNUM, thermistor THM, uint32_t REFR, bool thup>
+	class NTCTH : public NTCTH_base<ADNUM, ntc_b_model<THM>, REFR, thup> { };
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  NTCTH テンプレートクラス（Steinhart-Hart モデル）
+		@param[in]	ADNUM	A/D 変換値の量子化最大値
+		@param[in]	COEF	Steinhart-Hart 係数（A、B、C を持つ型）
+		@param[in]	REFR	分圧抵抗値（単位オーム）
+		@param[in]	thup	サーミスタが VCC 側の場合「true」、GND 側の場合「false」
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t ADNUM, class COEF, uint32_t REFR, bool thup>
+	class NTCTH_SH : public NTCTH_base<ADNUM, ntc_sh_model<COEF>, REFR, thup> { };
 }
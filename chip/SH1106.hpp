@@ -3,12 +3,13 @@
 /*!	@file
 	@brief	SH1106 LCD ドライバー
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2016 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2016, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
 #include <cstdint>
+#include "chip/lcd_page_base.hpp"
 
 namespace chip {
 
@@ -21,7 +22,7 @@ namespace chip {
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template <class CSI_IO, class CS, class A0>
-	class SSD1306 {
+	class SSD1306 : public lcd_page_base<SSD1306<CSI_IO, CS, A0>> {
 
 		CSI_IO&	csi_;
 
@@ -130,7 +131,7 @@ namespace chip {
 			uint8_t x = 0;
 			for(uint8_t page = ofs; page < (ofs + num); ++page) {
 				reg_select_(0);
-				csi_.xchg(0xB0 + j);          // set page address 0 to 7
+				csi_.xchg(0xB0 + page);       // set page address 0 to 7
 				csi_.xchg(0x00 | (x & 0xF));  // lower collum start address
 				csi_.xchg(0x10 | (x >> 4));   // higher collum start address
 				reg_select_(1);
@@ -3,7 +3,7 @@
 /*!	@file
 	@brief	SSD1306 LCD ドライバー
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2017, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -129,10 +129,27 @@ namespace chip {
 		*/
 		//-----------------------------------------------------------------//
 		void copy(const uint8_t* p) {
+			flush(p, 0xff);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き換えたページだけ転送
+			@param[in]	p		フレームバッファ（先頭）
+			@param[in]	dirty	書き換えたページのビット列（ビット０がページ０）
+		*/
+		//-----------------------------------------------------------------//
+		void flush(const uint8_t* p, uint32_t dirty) {
+			dirty &= 0xff;
+			if(dirty == 0) return;
+
 			chip_enable_();
 			reg_select_(0);
 			utils::delay::micro_second(1);
-			for(uint8_t j = 0; j < 8; ++j) {
+			for(uint8_t j = 0; j < 8; ++j, p += 128) {
+				if((dirty & (1 << j)) == 0) continue;
+				const uint8_t* src = p;
 				csi_.xchg(0xb0 + j);	// set page address 0 to 7
 				csi_.xchg(0x00);		// lower collum start address
 				csi_.xchg(0x10);		// higher collum start address
@@ -140,7 +157,7 @@ namespace chip {
 				reg_select_(1);
 				utils::delay::micro_second(1);
 				for(uint8_t i = 0; i < 128; ++i) {
-					csi_.xchg(*p++);
+					csi_.xchg(*src++);
 				}
 				utils::delay::micro_second(1);
 				reg_select_(0);
@@ -3,12 +3,13 @@
 /*!	@file
 	@brief	UC1701 LCD ドライバー
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2016 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2016, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
 #include <cstdint>
+#include "chip/lcd_page_base.hpp"
 #include "common/delay.hpp"
 
 namespace chip {
@@ -22,7 +23,7 @@ namespace chip {
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template <class CSI_IO, class CS, class A0>
-	class UC1701 {
+	class UC1701 : public lcd_page_base<UC1701<CSI_IO, CS, A0>> {
 
 		CSI_IO&	csi_;
 
@@ -4,57 +4,295 @@
 	@brief	WS2812B class @n
 			WorldSemi @n
 			Intelligent control LED integrated light source @n
-			http://www.world-semi.com/Certifications/WS2812B.html
-	@copyright	Copyright (C) 2022 Kunihito Hiramatsu @n
+			http://www.world-semi.com/Certifications/WS2812B.html @n
+			・１ビットを約 400ns の３スロット（H、データ、L）に展開し、 @n
+			  CMT のコンペアマッチで起動する DMAC で、ポートへ書き込む。 @n
+			  0: H(400ns) L(800ns), 1: H(800ns) L(400ns) @n
+			・同じポートの各ビットに、最大８本のストリップを接続して、並列に出力できる。 @n
+			・DMAC はポート（PODR）の８ビット全体に書き込むので、パターンには @n
+			  MASK 以外のビットの出力値を含める（送信開始時の PODR から作る）。 @n
+			  ※送信中に、MASK 以外のビットを書き換えると、送信の終わりまで @n
+			    パターンの値で上書きされる（送信中は書き換えない事）。 @n
+			・ガンマ／明るさの補正は、展開（エンコード）時にテーブルで行う。 @n
+			Ex: 定義例（PORT2 の B0、B1 に２本接続、最大 144 個） @n
+			  typedef device::PORT_BYTE<device::PORT2> LED_PORT; @n
+			  typedef chip::WS2812B<LED_PORT, device::CMT1, device::DMAC1, 144, 0b0000'0011> LED; @n
+			  LED	led_; @n
+			  led_.start(device::ICU::LEVEL::_4); @n
+			  led_.set_gamma(2.2f, 128); @n
+			  led_.encode(0, rgb, 144); @n
+			  led_.send();
+	@copyright	Copyright (C) 2022, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 	@author	平松邦仁 (hira@rvf-rc45.net)
 */
 //=========================================================================//
 #include <cstdint>
+#include <cmath>
+#include "common/renesas.hpp"
+#include "common/cmt_mgr.hpp"
 
 namespace chip {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  WS2812B テンプレートクラス
-		@param[in]	MTU_IO	MTU/GPT I/O クラス（PWM)
+		@param[in]	PORT	出力ポート（PORT_BYTE）
+		@param[in]	CMT		スロット周期に使う CMT チャネル（通常ベクターのチャネル）
+		@param[in]	DMAC	DMAC チャネル
+		@param[in]	NUM		１ストリップ当たりの最大 LED 数
+		@param[in]	MASK	利用するポートのビット（ストリップ）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class MTU_IO>
+	template <class PORT, class CMT, class DMAC, uint32_t NUM, uint8_t MASK = 0x01>
 	class WS2812B {
 
-		MTU_IO&		mtu_io_;
+		static_assert(MASK != 0, "MASK is empty.");
+		static_assert(std::is_same_v<std::remove_cv_t<decltype(CMT::CMI)>, device::ICU::VECTOR>,
+			"CMT must use a normal interrupt vector to start the DMAC.");
 
-		void output_(uint8_t n)
+	public:
+		static constexpr uint32_t SLOT_FREQ   = 2'500'000;	///< スロット周波数（400ns）
+		static constexpr uint32_t RESET_SLOTS = 750;		///< リセット期間（300us）
+		static constexpr uint32_t BUFF_SIZE   = NUM * 24 * 3 + RESET_SLOTS;	///< 出力バッファのサイズ
+		static constexpr uint32_t BIT_TOL_NS  = 150;		///< １ビット（３スロット）周期の許容誤差 [ns]
+
+		static_assert(BUFF_SIZE <= 65535, "NUM is too large for one DMA transfer.");
+
+	private:
+		// DMA 終了割り込み
+		class dma_task {
+		public:
+			static inline volatile bool busy_ = false;
+
+			void operator() () noexcept {
+				CMT::enable(false);
+				busy_ = false;
+			}
+		};
+
+		typedef device::dmac_mgr<DMAC, dma_task> DMAC_MGR;
+		typedef device::cmt_mgr<CMT> CMT_MGR;
+
+		DMAC_MGR	dmac_mgr_;
+		CMT_MGR		cmt_mgr_;
+
+		uint8_t		lut_[256];
+		uint8_t		keep_;	// パターンに含めている、MASK 以外のビット
+
+		static inline uint8_t	buff_[BUFF_SIZE];
+
+		static uint8_t keep_bits_() noexcept { return PORT::port_t::PO() & ~MASK; }
+
+		// MASK 以外のビットを、現在の出力値に合わせる
+		void update_keep_() noexcept
 		{
+			auto keep = keep_bits_();
+			if(keep == keep_) return;
+			for(uint32_t i = 0; i < BUFF_SIZE; ++i) {
+				buff_[i] = (buff_[i] & MASK) | keep;
+			}
+			keep_ = keep;
 		}
 
+		void sleep_() const noexcept { asm("nop"); }
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	コンストラクタ
-			@param[in]	mtu_io		MTU/GPT I/O クラス
 		 */
 		//-----------------------------------------------------------------//
-		WS2812B(MTU_IO& mtu_io) noexcept : mtu_io_(mtu_io)
-		{ }
+		WS2812B() noexcept : dmac_mgr_(), cmt_mgr_(), lut_{ 0 }, keep_(0)
+		{
+			for(uint32_t i = 0; i < 256; ++i) {
+				lut_[i] = i;
+			}
+		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	開始
-			@return エラーがあれば「false」を返す。
+			@param[in]	lvl		DMA 終了割り込みレベル
+			@return エラーがあれば「false」を返す。 @n
+					CMT で作れるスロット周期が、許容誤差を超える場合も「false」
 		 */
 		//-----------------------------------------------------------------//
-		bool start() noexcept
+		bool start(device::ICU::LEVEL lvl) noexcept
 		{
-			// PWM 周期設定（800KHz）
-			// mtu_io_.
+			if(lvl == device::ICU::LEVEL::NONE) return false;
+
+			PORT::port_t::PO = keep_bits_();  // MASK のビットだけ「0」にする
+			PORT::DIR = PORT::DIR() | MASK;
+
+			clear();
+
+			dmac_mgr_.start(lvl);
 
+			// CMT の割り込み要求は DMAC の起動要因として使う
+			if(!cmt_mgr_.start(SLOT_FREQ, lvl)) {
+				return false;
+			}
+			CMT::enable(false);
+
+			// PCLK によっては、分周比が合わずスロット周期がずれる（PCLKB 50MHz: 480ns）
+			auto rate = cmt_mgr_.get_rate(true);
+			uint32_t bit_ns = rate > 0 ? 3'000'000'000u / rate : 0;
+			uint32_t ref_ns = 3'000'000'000u / SLOT_FREQ;
+			if(bit_ns < (ref_ns - BIT_TOL_NS) || (ref_ns + BIT_TOL_NS) < bit_ns) {
+				cmt_mgr_.destroy();
+				return false;
+			}
 
 			return true;
 		}
-	};
 
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ガンマ／明るさテーブルの設定
+			@param[in]	gamma	ガンマ値（1.0 で補正なし）
+			@param[in]	bright	明るさ（０～２５５）
+		 */
+		//-----------------------------------------------------------------//
+		void set_gamma(float gamma, uint8_t bright = 255) noexcept
+		{
+			for(uint32_t i = 0; i < 256; ++i) {
+				float a = std::pow(static_cast<float>(i) / 255.0f, gamma);
+				lut_[i] = static_cast<uint8_t>(a * static_cast<float>(bright) + 0.5f);
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	出力バッファの消去（全 LED 消灯）
+		 */
+		//-----------------------------------------------------------------//
+		void clear() noexcept
+		{
+			while(probe()) sleep_();
+
+			keep_ = keep_bits_();
+			for(uint32_t i = 0; i < (NUM * 24); ++i) {
+				buff_[i * 3 + 0] = MASK | keep_;
+				buff_[i * 3 + 1] = keep_;
+				buff_[i * 3 + 2] = keep_;
+			}
+			for(uint32_t i = NUM * 24 * 3; i < BUFF_SIZE; ++i) {
+				buff_[i] = keep_;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	LED を１個設定
+			@param[in]	ch		ストリップ（ポートのビット位置）
+			@param[in]	idx		LED の位置
+			@param[in]	r		赤
+			@param[in]	g		緑
+			@param[in]	b		青
+		 */
+		//-----------------------------------------------------------------//
+		void set(uint32_t ch, uint32_t idx, uint8_t r, uint8_t g, uint8_t b) noexcept
+		{
+			if(ch >= 8 || idx >= NUM) return;
+
+			uint8_t m = 1 << ch;
+			if((MASK & m) == 0) return;
+
+			while(probe()) sleep_();
+
+			uint32_t grb = (static_cast<uint32_t>(lut_[g]) << 16)
+				| (static_cast<uint32_t>(lut_[r]) << 8) | lut_[b];
+			uint8_t* p = &buff_[idx * 24 * 3 + 1];
+			for(uint32_t i = 0; i < 24; ++i) {
+				if(grb & 0x800000) *p |= m;
+				else *p &= ~m;
+				grb <<= 1;
+				p += 3;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	LED 列をまとめて設定
+			@param[in]	ch		ストリップ（ポートのビット位置）
+			@param[in]	rgb		RGB の並び（１個３バイト）
+			@param[in]	num		個数
+		 */
+		//-----------------------------------------------------------------//
+		void encode(uint32_t ch, const uint8_t* rgb, uint32_t num) noexcept
+		{
+			if(rgb == nullptr || ch >= 8) return;
+
+			uint8_t m = 1 << ch;
+			if((MASK & m) == 0) return;
+
+			if(num > NUM) num = NUM;
+
+			while(probe()) sleep_();
+
+			uint8_t nm = ~m;
+			uint8_t* p = &buff_[1];
+			for(uint32_t n = 0; n < num; ++n) {
+				uint32_t grb = (static_cast<uint32_t>(lut_[rgb[1]]) << 16)
+					| (static_cast<uint32_t>(lut_[rgb[0]]) << 8) | lut_[rgb[2]];
+				rgb += 3;
+				for(uint32_t i = 0; i < 24; ++i) {
+					*p = (*p & nm) | (static_cast<uint8_t>(grb >> 23) & 1) * m;
+					grb <<= 1;
+					p += 3;
+				}
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	出力開始（DMA 転送、終了を待たない） @n
+					MASK 以外のビットが、前回から変わっていれば、パターンを更新する。
+			@return 出力中なら「false」
+		 */
+		//-----------------------------------------------------------------//
+		bool send() noexcept
+		{
+			if(probe()) return false;
+
+			update_keep_();
+			dma_task::busy_ = true;
+			CMT::CMCNT = 0;
+			if(!dmac_mgr_.start_trans(CMT::CMI, DMAC_MGR::trans_type::SP_DN_8,
+				reinterpret_cast<uint32_t>(buff_), PORT::port_t::PO.address, BUFF_SIZE, true)) {
+				dma_task::busy_ = false;
+				return false;
+			}
+			CMT::enable();
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	出力中か検査
+			@return 出力中なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool probe() const noexcept { return dma_task::busy_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	出力の終了を待つ
+		 */
+		//-----------------------------------------------------------------//
+		void sync() const noexcept
+		{
+			while(probe()) sleep_();
+		}
+	};
 }
@@ -0,0 +1,52 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	ページ単位で転送するモノクロ LCD のベース・クラス @n
+			ST7565、UC1701、SH1106 で共通の「flush」を提供する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2023 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+
+namespace chip {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ページ転送 LCD ベース・クラス @n
+				LCD は「copy(src, num, ofs)」を持つ事
+		@param[in]	LCD		LCD ドライバー（派生クラス）
+		@param[in]	WIDTH	１ページのバイト数
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class LCD, uint32_t WIDTH = 128>
+	class lcd_page_base {
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き換えたページだけ転送（連続したページはまとめて転送）
+			@param[in]	fb		フレームバッファ（先頭）
+			@param[in]	dirty	書き換えたページのビット列（ビット０がページ０）
+		*/
+		//-----------------------------------------------------------------//
+		void flush(const uint8_t* fb, uint32_t dirty) {
+			uint8_t page = 0;
+			while(dirty != 0) {
+				if(dirty & 1) {
+					uint8_t n = 0;
+					while(dirty & 1) {
+						++n;
+						dirty >>= 1;
+					}
+					static_cast<LCD*>(this)->copy(fb + page * WIDTH, n, page);
+					page += n;
+				} else {
+					dirty >>= 1;
+					++page;
+				}
+			}
+		}
+	};
+}
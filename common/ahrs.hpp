@@ -0,0 +1,262 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	姿勢推定（AHRS）クラス @n
+			・Mahony フィルター（相補フィルター、PI 補正）を固定小数点で計算する。 @n
+			・クォータニオンは Q30（1.0 = 1 << 30）で保持する。 @n
+			・ジャイロ、加速度は、センサーの生の値（int16_t）をそのまま入力する。 @n
+			・係数は start で一度だけ浮動小数点で計算し、更新は整数演算のみ。 @n
+			Ex: utils::ahrs ahrs_; @n
+			    ahrs_.start(1000.0f, 131.0f);  // 1KHz, ±250 deg/s @n
+			    ahrs_.calibrate(gyro, 1000);   // 静止中に呼ぶ @n
+			    ahrs_.update(accel, gyro);
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2023 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cmath>
+#include "common/intmath.hpp"
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  AHRS（Mahony）クラス
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class ahrs {
+	public:
+		static constexpr int32_t ONE = 1 << 30;	///< Q30 の 1.0
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	クォータニオン（Q30）
+		 */
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct quat_t {
+			int32_t	w;
+			int32_t	x;
+			int32_t	y;
+			int32_t	z;
+			quat_t() noexcept : w(ONE), x(0), y(0), z(0) { }
+		};
+
+	private:
+		static constexpr int64_t IB_LIMIT = static_cast<int64_t>(1) << 62;
+
+		quat_t		q_;
+
+		int32_t		kg_;	// ジャイロ LSB -> 半角/サンプル（Q46）
+		int32_t		kp_;	// 比例ゲイン（Q30）
+		int32_t		ki_;	// 積分ゲイン（Q40）
+		int64_t		ib_[3];	// 積分項（Q70）
+
+		int32_t		bias_[3];
+		int32_t		bias_sum_[3];
+		uint32_t	bias_cnt_;
+
+		static int32_t mul_(int32_t a, int32_t b) noexcept
+		{
+			return static_cast<int32_t>((static_cast<int64_t>(a) * b) >> 30);
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		 */
+		//-----------------------------------------------------------------//
+		ahrs() noexcept : q_(), kg_(0), kp_(0), ki_(0), ib_{ 0 },
+			bias_{ 0 }, bias_sum_{ 0 }, bias_cnt_(0) { }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	開始
+			@param[in]	rate	サンプリング周波数 [Hz]
+			@param[in]	lsb		ジャイロの感度 [LSB/(deg/s)]（MPU6050 ±250: 131）
+			@param[in]	kp		比例ゲイン
+			@param[in]	ki		積分ゲイン
+		 */
+		//-----------------------------------------------------------------//
+		void start(float rate, float lsb, float kp = 1.0f, float ki = 0.02f) noexcept
+		{
+			float hdt = 0.5f / rate;
+			kg_ = static_cast<int32_t>(hdt * (3.14159265f / 180.0f) / lsb * 70368744177664.0f + 0.5f);  // 2^46
+			kp_ = static_cast<int32_t>(kp * hdt * 1073741824.0f + 0.5f);  // 2^30
+			ki_ = static_cast<int32_t>(ki * hdt / rate * 1099511627776.0f + 0.5f);  // 2^40
+			reset();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	姿勢のリセット（ジャイロのバイアスは保持）
+		 */
+		//-----------------------------------------------------------------//
+		void reset() noexcept
+		{
+			q_ = quat_t();
+			ib_[0] = ib_[1] = ib_[2] = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ジャイロのバイアス校正（静止状態で、サンプル毎に呼ぶ）
+			@param[in]	gyr		ジャイロの値（x, y, z）
+			@param[in]	num		平均するサンプル数
+			@return 校正が完了したら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool calibrate(const int16_t* gyr, uint32_t num) noexcept
+		{
+			for(uint32_t i = 0; i < 3; ++i) bias_sum_[i] += gyr[i];
+			++bias_cnt_;
+			if(bias_cnt_ < num) return false;
+
+			for(uint32_t i = 0; i < 3; ++i) {
+				int32_t s = bias_sum_[i];
+				int32_t h = static_cast<int32_t>(bias_cnt_ / 2);
+				bias_[i] = (s >= 0 ? s + h : s - h) / static_cast<int32_t>(bias_cnt_);
+				bias_sum_[i] = 0;
+			}
+			bias_cnt_ = 0;
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ジャイロのバイアスを設定
+			@param[in]	x	X 軸
+			@param[in]	y	Y 軸
+			@param[in]	z	Z 軸
+		 */
+		//-----------------------------------------------------------------//
+		void set_bias(int16_t x, int16_t y, int16_t z) noexcept
+		{
+			bias_[0] = x;
+			bias_[1] = y;
+			bias_[2] = z;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ジャイロのバイアスを取得
+			@param[in]	axis	軸（0:X, 1:Y, 2:Z）
+			@return バイアス
+		 */
+		//-----------------------------------------------------------------//
+		int16_t get_bias(uint32_t axis) const noexcept { return bias_[axis % 3]; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	更新（サンプル毎に呼ぶ）
+			@param[in]	acc		加速度の値（x, y, z）
+			@param[in]	gyr		ジャイロの値（x, y, z）
+		 */
+		//-----------------------------------------------------------------//
+		void update(const int16_t* acc, const int16_t* gyr) noexcept
+		{
+			// ジャイロ：半角/サンプル（Q30）
+			int32_t g[3];
+			for(uint32_t i = 0; i < 3; ++i) {
+				g[i] = static_cast<int32_t>((static_cast<int64_t>(gyr[i] - bias_[i]) * kg_) >> 16);
+			}
+
+			// 加速度による補正（自由落下など、極端に小さい場合は使わない）
+			int32_t ax = acc[0];
+			int32_t ay = acc[1];
+			int32_t az = acc[2];
+			uint32_t n2 = static_cast<uint32_t>(ax * ax) + static_cast<uint32_t>(ay * ay) + static_cast<uint32_t>(az * az);
+			uint32_t n = intmath::sqrt32(n2).val;
+			if(n >= 256) {
+				int64_t rcp = (static_cast<int64_t>(1) << 46) / n;
+				ax = static_cast<int32_t>((ax * rcp) >> 16);
+				ay = static_cast<int32_t>((ay * rcp) >> 16);
+				az = static_cast<int32_t>((az * rcp) >> 16);
+
+				// クォータニオンから推定した重力方向
+				int32_t vx = 2 * (mul_(q_.x, q_.z) - mul_(q_.w, q_.y));
+				int32_t vy = 2 * (mul_(q_.w, q_.x) + mul_(q_.y, q_.z));
+				int32_t vz = mul_(q_.w, q_.w) - mul_(q_.x, q_.x) - mul_(q_.y, q_.y) + mul_(q_.z, q_.z);
+
+				// 誤差（外積）
+				int32_t e[3];
+				e[0] = mul_(ay, vz) - mul_(az, vy);
+				e[1] = mul_(az, vx) - mul_(ax, vz);
+				e[2] = mul_(ax, vy) - mul_(ay, vx);
+
+				for(uint32_t i = 0; i < 3; ++i) {
+					if(ki_ > 0) {
+						ib_[i] += static_cast<int64_t>(e[i]) * ki_;
+						if(ib_[i] > IB_LIMIT) ib_[i] = IB_LIMIT;
+						else if(ib_[i] < -IB_LIMIT) ib_[i] = -IB_LIMIT;
+					}
+					g[i] += mul_(e[i], kp_) + static_cast<int32_t>(ib_[i] >> 40);
+				}
+			} else {
+				for(uint32_t i = 0; i < 3; ++i) {
+					g[i] += static_cast<int32_t>(ib_[i] >> 40);
+				}
+			}
+
+			// クォータニオンの積分
+			int32_t w = q_.w;
+			int32_t x = q_.x;
+			int32_t y = q_.y;
+			int32_t z = q_.z;
+			q_.w -= mul_(x, g[0]) + mul_(y, g[1]) + mul_(z, g[2]);
+			q_.x += mul_(w, g[0]) + mul_(y, g[2]) - mul_(z, g[1]);
+			q_.y += mul_(w, g[1]) - mul_(x, g[2]) + mul_(z, g[0]);
+			q_.z += mul_(w, g[2]) + mul_(x, g[1]) - mul_(y, g[0]);
+
+			// 正規化（|q| ≒ 1 なので、1 / sqrt(n) ≒ (3 - n) / 2 で近似）
+			int64_t qq = static_cast<int64_t>(q_.w) * q_.w + static_cast<int64_t>(q_.x) * q_.x
+				+ static_cast<int64_t>(q_.y) * q_.y + static_cast<int64_t>(q_.z) * q_.z;
+			int32_t f = static_cast<int32_t>(((static_cast<int64_t>(3) << 60) - qq) >> 31);
+			q_.w = mul_(q_.w, f);
+			q_.x = mul_(q_.x, f);
+			q_.y = mul_(q_.y, f);
+			q_.z = mul_(q_.z, f);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	クォータニオンの取得
+			@return クォータニオン（Q30）
+		 */
+		//-----------------------------------------------------------------//
+		const quat_t& get_quat() const noexcept { return q_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	オイラー角の取得
+			@param[out]	roll	ロール [rad]
+			@param[out]	pitch	ピッチ [rad]
+			@param[out]	yaw		ヨー [rad]
+		 */
+		//-----------------------------------------------------------------//
+		void get_euler(float& roll, float& pitch, float& yaw) const noexcept
+		{
+			float w = static_cast<float>(q_.w) / static_cast<float>(ONE);
+			float x = static_cast<float>(q_.x) / static_cast<float>(ONE);
+			float y = static_cast<float>(q_.y) / static_cast<float>(ONE);
+			float z = static_cast<float>(q_.z) / static_cast<float>(ONE);
+			roll  = std::atan2(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y));
+			float s = 2.0f * (w * y - z * x);
+			if(s > 1.0f) s = 1.0f;
+			else if(s < -1.0f) s = -1.0f;
+			pitch = std::asin(s);
+			yaw   = std::atan2(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z));
+		}
+	};
+}
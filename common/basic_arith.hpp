@@ -49,6 +49,35 @@ namespace utils {
 
 		typedef bitset<uint16_t, error> error_t;
 
+
+		static constexpr uint32_t CODE_MAX   = 128;		///< コンパイル・コードの最大長
+		static constexpr uint32_t CONST_MAX  = 32;		///< 定数の最大数
+		static constexpr uint32_t SLOT_MAX   = 16;		///< シンボル・スロットの最大数
+		static constexpr uint32_t STACK_MAX  = 16;		///< 評価スタックの最大深さ
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	コンパイル済みコード（逆ポーランド） @n
+					0x00 to 0x3F: 定数のプッシュ @n
+					0x40 to 0x7F: シンボル・スロットのプッシュ @n
+					0x80 to 0x86: 演算子 @n
+					0xC0 to 0xFF: 関数（FUNC::NAME）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct code_t {
+			uint8_t		code_[CODE_MAX];
+			NVAL		cst_[CONST_MAX];
+			typename SYMBOL::NAME	sym_[SLOT_MAX];
+			uint16_t	len_;
+			uint8_t		cst_num_;
+			uint8_t		sym_num_;
+			uint8_t		stack_;
+
+			code_t() noexcept : code_{ }, cst_{ }, sym_{ }, len_(0), cst_num_(0), sym_num_(0), stack_(0) { }
+
+			void clear() noexcept { len_ = 0; cst_num_ = 0; sym_num_ = 0; stack_ = 0; }
+		};
+
 	private:
 
 		SYMBOL&		symbol_;
@@ -63,6 +92,21 @@ namespace utils {
 
 		uint32_t	nest_;
 
+		code_t*		code_;
+		uint32_t	depth_;
+
+		enum class OPC : uint8_t {
+			CONST = 0x00,	///< 定数（下位６ビットがインデックス）
+			SYM   = 0x40,	///< シンボル（下位６ビットがスロット）
+			NEG   = 0x80,
+			ADD,
+			SUB,
+			MUL,
+			DIV,
+			IDIV,			///< 「//」（除数の検査のみ）
+			POW,
+		};
+
 
 		// 関数内パラメーターの取得
 		bool param_(char* dst, uint32_t len) noexcept
@@ -98,6 +142,76 @@ namespace utils {
 		}
 
 
+		// 数値リテラルの変換
+		void literal_(NVAL& nval) noexcept
+		{
+			char tmp[NUMBER_NUM];
+			uint32_t idx = 0;
+			auto base = NVAL::BASE::DEC;
+			char back = 0;
+			do {
+				if(ch_ == '+' || ch_ == '-') {
+					if(base == NVAL::BASE::DEC && (back == 'E' || back == 'e')) {
+						tmp[idx] = ch_;
+						++idx;
+					} else {
+						break;
+					}
+				} else if(ch_ == '*' || ch_ == '/' || ch_ == ')' || ch_ == '^') {
+					break;
+				} else {
+					if(idx == 1 && back == '0') {
+						if(ch_ == 'X' || ch_ == 'x') {
+							base = NVAL::BASE::HEX;
+							ch_ = *tx_++;
+							continue;
+						} else if(ch_ == 'B' || ch_ == 'b') {
+							base = NVAL::BASE::BIN;
+							ch_ = *tx_++;
+							continue;
+						}
+					}
+					if(base == NVAL::BASE::DEC) {
+						if((ch_ >= '0' && ch_ <= '9') || ch_=='.' || ch_=='e' || ch_=='E') {
+							tmp[idx] = ch_;
+							idx++;
+						} else {
+							error_.set(error::number_fatal);
+							break;
+						}
+					} else if(base == NVAL::BASE::HEX) {
+						if((ch_ >= '0' && ch_ <= '9') || (ch_ >= 'A' && ch_ <= 'F')
+							|| (ch_ >= 'a' && ch_ <= 'f') || ch_ == '.') {
+							tmp[idx] = ch_;
+							idx++;
+						} else {
+							error_.set(error::number_fatal);
+							break;
+						}
+					} else if(base == NVAL::BASE::BIN) {
+						if(ch_ == '0' || ch_ == '1' || ch_ == '.') {
+							tmp[idx] = ch_;
+							idx++;
+						} else {
+							error_.set(error::number_fatal);
+							break;
+						}
+					}
+				}
+				if(idx >= (NUMBER_NUM - 1)) {
+					error_.set(error::buffer_fatal);
+					break;
+				}
+				back = ch_;
+				ch_ = *tx_++;
+			} while(ch_ != 0) ;
+			tmp[idx] = 0;
+			if(error_() == 0) {
+				nval.assign(tmp, base);
+			}
+		}
+
+
 		NVAL number_() noexcept
 		{
 			bool minus = false;
@@ -151,70 +265,7 @@ namespace utils {
 			if(ch_ == '(') {
 				nval = factor_();
 			} else {  // 0 - 9
-				char tmp[NUMBER_NUM];
-				uint32_t idx = 0;
-				auto base = NVAL::BASE::DEC;
-				char back = 0;
-				do {
-					if(ch_ == '+' || ch_ == '-') {
-						if(base == NVAL::BASE::DEC && (back == 'E' || back == 'e')) {
-							tmp[idx] = ch_;
-							++idx;
-						} else {
-							break;
-						}
-					} else if(ch_ == '*' || ch_ == '/' || ch_ == ')' || ch_ == '^') {
-						break;
-					} else {
-						if(idx == 1 && back == '0') {
-							if(ch_ == 'X' || ch_ == 'x') {
-								base = NVAL::BASE::HEX;
-								ch_ = *tx_++;
-								continue;
-							} else if(ch_ == 'B' || ch_ == 'b') {
-								base = NVAL::BASE::BIN;
-								ch_ = *tx_++;
-								continue;
-							}
-						}
-						if(base == NVAL::BASE::DEC) {
-							if((ch_ >= '0' && ch_ <= '9') || ch_=='.' || ch_=='e' || ch_=='E') {
-								tmp[idx] = ch_;
-								idx++;
-							} else {
-								error_.set(error::number_fatal);
-								break;
-							}
-						} else if(base == NVAL::BASE::HEX) {
-							if((ch_ >= '0' && ch_ <= '9') || (ch_ >= 'A' && ch_ <= 'F')
-								|| (ch_ >= 'a' && ch_ <= 'f') || ch_ == '.') {
-								tmp[idx] = ch_;
-								idx++;
-							} else {
-								error_.set(error::number_fatal);
-								break;
-							}
-						} else if(base == NVAL::BASE::BIN) {
-							if(ch_ == '0' || ch_ == '1' || ch_ == '.') {
-								tmp[idx] = ch_;
-								idx++;
-							} else {
-								error_.set(error::number_fatal);
-								break;
-							}
-						}
-					}
-					if(idx >= (NUMBER_NUM - 1)) {
-						error_.set(error::buffer_fatal);
-						break;
-					}
-					back = ch_;
-					ch_ = *tx_++;
-				} while(ch_ != 0) ;
-				tmp[idx] = 0;
-				if(error_() == 0) {
-					nval.assign(tmp, base);
-				}
+				literal_(nval);
 			}
 
 			if(minus) { nval = -nval; }
@@ -354,6 +405,311 @@ namespace utils {
 			return v;
 		}
 
+
+		// コードの追加（定数の畳み込みを含む）
+		void emit_(uint8_t op) noexcept
+		{
+			auto& c = *code_;
+			auto n = c.len_;
+			if(op == static_cast<uint8_t>(OPC::NEG)) {
+				if(n > 0 && c.code_[n - 1] < static_cast<uint8_t>(OPC::SYM)) {
+					auto& v = c.cst_[c.code_[n - 1]];
+					v = -v;
+					return;
+				}
+			} else if(op > static_cast<uint8_t>(OPC::NEG) && op < CODE_FUNC) {
+				if(depth_ > 0) --depth_;
+				if(n > 1 && c.code_[n - 1] < static_cast<uint8_t>(OPC::SYM)
+					&& c.code_[n - 2] < static_cast<uint8_t>(OPC::SYM)) {
+					auto& a = c.cst_[c.code_[n - 2]];
+					const auto& b = c.cst_[c.code_[n - 1]];
+					bool fold = true;
+					switch(static_cast<OPC>(op)) {
+					case OPC::ADD: a += b; break;
+					case OPC::SUB: a -= b; break;
+					case OPC::MUL: a *= b; break;
+					case OPC::DIV:
+						if(b == 0) fold = false;
+						else a /= b;
+						break;
+					case OPC::IDIV:
+						if(b == 0) fold = false;
+						break;
+					case OPC::POW: a.pow(b); break;
+					default: fold = false; break;
+					}
+					if(fold) {
+						--c.cst_num_;
+						--c.len_;
+						return;
+					}
+				}
+			}
+			if(n >= CODE_MAX) {
+				error_.set(error::buffer_fatal);
+				return;
+			}
+			c.code_[n] = op;
+			++c.len_;
+		}
+
+
+		void push_(uint8_t op) noexcept
+		{
+			++depth_;
+			if(depth_ > STACK_MAX) {
+				error_.set(error::buffer_fatal);
+				return;
+			}
+			if(depth_ > code_->stack_) code_->stack_ = depth_;
+			emit_(op);
+		}
+
+
+		void push_const_(const NVAL& nval) noexcept
+		{
+			auto& c = *code_;
+			if(c.cst_num_ >= CONST_MAX) {
+				error_.set(error::buffer_fatal);
+				return;
+			}
+			c.cst_[c.cst_num_] = nval;
+			push_(static_cast<uint8_t>(OPC::CONST) | c.cst_num_);
+			++c.cst_num_;
+		}
+
+
+		void push_symbol_(typename SYMBOL::NAME sc) noexcept
+		{
+			auto& c = *code_;
+			uint8_t slot = 0;
+			while(slot < c.sym_num_ && c.sym_[slot] != sc) ++slot;
+			if(slot == c.sym_num_) {
+				if(slot >= SLOT_MAX) {
+					error_.set(error::buffer_fatal);
+					return;
+				}
+				c.sym_[slot] = sc;
+				++c.sym_num_;
+			}
+			push_(static_cast<uint8_t>(OPC::SYM) | slot);
+		}
+
+
+		void cfunc_sub_(typename FUNC::NAME fc) noexcept
+		{
+			ch_ = *tx_++;
+			if(ch_ == '(') {
+				ch_ = *tx_++;
+				cexpression_();
+				if(ch_ == ')') {
+					ch_ = *tx_++;
+					emit_(static_cast<uint8_t>(fc));
+				} else {
+					error_.set(error::fatal);
+				}
+			} else {
+				error_.set(error::func_fatal);
+			}
+		}
+
+
+		void cnumber_() noexcept
+		{
+			bool minus = false;
+
+			if(ch_ == '-') {
+				minus = true;
+				ch_ = *tx_++;
+			} else if(ch_ == '+') {
+				ch_ = *tx_++;
+			}
+
+			NVAL nval;
+			if((ch_ >= '0' && ch_ <= '9') || ch_ == '(') {
+
+			} else if(ch_ <= 0x7f) {
+				typename SYMBOL::NAME sc;
+				auto tmp = symbol_.get_code(tx_ - 1, sc);
+				if(symbol_(sc, nval)) {
+					tx_ = tmp;
+					ch_ = *tx_++;
+					push_symbol_(sc);
+					if(minus) { emit_(static_cast<uint8_t>(OPC::NEG)); }
+					return;
+				} else {
+					typename FUNC::NAME fc;
+					auto tmp = func_.get_code(tx_ - 1, fc);
+					if(fc != FUNC::NAME::NONE) {
+						tx_ = tmp;
+						cfunc_sub_(fc);
+						if(minus) { emit_(static_cast<uint8_t>(OPC::NEG)); }
+						return;
+					}
+				}
+				error_.set(error::symbol_fatal);
+				return;
+			} else if(static_cast<uint8_t>(ch_) >= CODE_SYM) {
+				if(static_cast<uint8_t>(ch_) >= CODE_FUNC) {
+					cfunc_sub_(static_cast<typename FUNC::NAME>(ch_));
+				} else {
+					auto sc = static_cast<typename SYMBOL::NAME>(ch_);
+					if(symbol_(sc, nval)) {
+						ch_ = *tx_++;
+						push_symbol_(sc);
+					} else {
+						error_.set(error::symbol_fatal);
+					}
+				}
+				if(minus) { emit_(static_cast<uint8_t>(OPC::NEG)); }
+				return;
+			}
+
+			if(ch_ == '(') {
+				cfactor_();
+			} else {
+				literal_(nval);
+				if(error_() == 0) {
+					push_const_(nval);
+				}
+			}
+
+			if(minus) { emit_(static_cast<uint8_t>(OPC::NEG)); }
+		}
+
+
+		void cfactor_() noexcept
+		{
+			if(ch_ == '(') {
+				ch_ = *tx_++;
+				cexpression_();
+				if(ch_ == ')') {
+					ch_ = *tx_++;
+				} else {
+					error_.set(error::fatal);
+				}
+			} else {
+				cnumber_();
+			}
+		}
+
+
+		void cterm_() noexcept
+		{
+			cfactor_();
+			while(error_() == 0) {
+				switch(ch_) {
+				case '*':
+					ch_ = *tx_++;
+					cfactor_();
+					emit_(static_cast<uint8_t>(OPC::MUL));
+					break;
+				case '/':
+					ch_ = *tx_++;
+					if(ch_ == '/') {
+						ch_ = *tx_++;
+						cfactor_();
+						emit_(static_cast<uint8_t>(OPC::IDIV));
+					} else {
+						cfactor_();
+						emit_(static_cast<uint8_t>(OPC::DIV));
+					}
+					break;
+				case '^':
+					ch_ = *tx_++;
+					cfactor_();
+					emit_(static_cast<uint8_t>(OPC::POW));
+					break;
+				default:
+					return;
+				}
+			}
+		}
+
+
+		void cexpression_() noexcept
+		{
+			++nest_;
+			if(nest_ >= NEST_MAX) {
+				error_.set(error::nest_fatal);
+			}
+			cterm_();
+			while(error_() == 0) {
+				switch(ch_) {
+				case '+':
+					ch_ = *tx_++;
+					cterm_();
+					emit_(static_cast<uint8_t>(OPC::ADD));
+					break;
+				case '-':
+					ch_ = *tx_++;
+					cterm_();
+					emit_(static_cast<uint8_t>(OPC::SUB));
+					break;
+				default:
+					return;
+				}
+			}
+		}
+
+
+		// コードの実行
+		bool exec_(const code_t& code, const NVAL* slot, NVAL* stk, NVAL& out) noexcept
+		{
+			uint32_t sp = 0;
+			for(uint32_t i = 0; i < code.len_; ++i) {
+				auto op = code.code_[i];
+				if(op < static_cast<uint8_t>(OPC::SYM)) {
+					stk[sp] = code.cst_[op];
+					++sp;
+				} else if(op < static_cast<uint8_t>(OPC::NEG)) {
+					stk[sp] = slot[op & 0x3f];
+					++sp;
+				} else if(op >= CODE_FUNC) {
+					NVAL tmp;
+					if(!func_(static_cast<typename FUNC::NAME>(op), stk[sp - 1], tmp)) {
+						error_.set(error::func_fatal);
+						return false;
+					}
+					stk[sp - 1] = tmp;
+				} else if(op == static_cast<uint8_t>(OPC::NEG)) {
+					stk[sp - 1] = -stk[sp - 1];
+				} else {
+					--sp;
+					auto& a = stk[sp - 1];
+					const auto& b = stk[sp];
+					switch(static_cast<OPC>(op)) {
+					case OPC::ADD: a += b; break;
+					case OPC::SUB: a -= b; break;
+					case OPC::MUL: a *= b; break;
+					case OPC::DIV:
+						if(b == 0) {
+							error_.set(error::zero_divide);
+							return false;
+						}
+						a /= b;
+						break;
+					case OPC::IDIV:
+						if(b == 0) {
+							error_.set(error::zero_divide);
+							return false;
+						}
+						break;
+					case OPC::POW: a.pow(b); break;
+					default:
+						error_.set(error::fatal);
+						return false;
+					}
+				}
+			}
+			if(sp != 1) {
+				error_.set(error::fatal);
+				return false;
+			}
+			out = stk[0];
+			return true;
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -363,7 +719,8 @@ namespace utils {
 		*/
 		//-----------------------------------------------------------------//
 		basic_arith(SYMBOL& symbol, FUNC& func) noexcept : symbol_(symbol), func_(func),
-			tx_(nullptr), ch_(0), error_(), value_(), nest_(0)
+			tx_(nullptr), ch_(0), error_(), value_(), nest_(0),
+			code_(nullptr), depth_(0)
 		{ }
 
 
@@ -404,6 +761,127 @@ namespace utils {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンパイル @n
+					数式を逆ポーランドのコードに変換する。@n
+					定数同士の演算は、コンパイル時に畳み込まれる。@n
+					文法、エラー・コードは analize と同等。
+			@param[in]	text	解析テキスト
+			@param[out]	code	コンパイル済みコード
+			@return	文法にエラーがあった場合、「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool compile(const char* text, code_t& code) noexcept
+		{
+			code.clear();
+			if(text == nullptr) {
+				error_.set(error::fatal);
+				return false;
+			}
+
+			tx_ = text;
+			error_.clear();
+			nest_ = 0;
+			code_ = &code;
+			depth_ = 0;
+
+			ch_ = *tx_++;
+			if(ch_ != 0) {
+				cexpression_();
+			} else {
+				error_.set(error::fatal);
+			}
+			code_ = nullptr;
+
+			if(error_() != 0) {
+				code.clear();
+				return false;
+			} else if(ch_ != 0) {
+				error_.set(error::fatal);
+				code.clear();
+				return false;
+			}
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンパイル済みコードの評価 @n
+					シンボルの値は、評価時点のものが使われる。@n
+					結果は、() で取得出来る。
+			@param[in]	code	コンパイル済みコード
+			@return	エラーがあった場合、「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool run(const code_t& code) noexcept
+		{
+			error_.clear();
+			if(code.len_ == 0) {
+				error_.set(error::fatal);
+				return false;
+			}
+
+			NVAL slot[SLOT_MAX];
+			for(uint32_t i = 0; i < code.sym_num_; ++i) {
+				symbol_(code.sym_[i], slot[i]);
+			}
+			NVAL stk[STACK_MAX];
+			return exec_(code, slot, stk, value_);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンパイル済みコードの連続評価 @n
+					シンボル「var」に入力を与えながら評価する（グラフの描画など）。@n
+					他のシンボルは、最初に一度だけ取得される。@n
+					エラーとなった要素の出力は変更しない。
+			@param[in]	code	コンパイル済みコード
+			@param[in]	var		入力を与えるシンボル
+			@param[in]	src		入力列
+			@param[out]	dst		出力列
+			@param[in]	num		要素数
+			@param[out]	valid	要素毎の成否（不要なら「nullptr」）
+			@return	評価に成功した要素数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t run(const code_t& code, typename SYMBOL::NAME var, const NVAL* src, NVAL* dst,
+			uint32_t num, bool* valid = nullptr) noexcept
+		{
+			error_.clear();
+			if(code.len_ == 0 || src == nullptr || dst == nullptr) {
+				error_.set(error::fatal);
+				return 0;
+			}
+
+			NVAL slot[SLOT_MAX];
+			uint32_t vslot = SLOT_MAX;
+			for(uint32_t i = 0; i < code.sym_num_; ++i) {
+				if(code.sym_[i] == var) {
+					vslot = i;
+				} else {
+					symbol_(code.sym_[i], slot[i]);
+				}
+			}
+
+			NVAL stk[STACK_MAX];
+			error_t err;
+			uint32_t cnt = 0;
+			for(uint32_t i = 0; i < num; ++i) {
+				if(vslot < SLOT_MAX) slot[vslot] = src[i];
+				error_.clear();
+				bool ok = exec_(code, slot, stk, dst[i]);
+				if(ok) ++cnt;
+				else err = error_;
+				if(valid != nullptr) valid[i] = ok;
+			}
+			error_ = err;
+			return cnt;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	エラーを取得
@@ -2,15 +2,19 @@
 //=====================================================================//
 /*!	@file
 	@brief	CAN 通信解析クラス @n
-			std::map を使う場合、Makefile でのリンクを修正する (USER_DEFS = m stdc++) @n
+			・固定容量のオープンアドレス・ハッシュで ID を管理（動的メモリ確保無し） @n
+			・ID 毎の受信間隔（最小、平均、最大、ジッター）を計測 @n
+			・トリガー付きキャプチャー・リング @n
+			・candump/ASC 形式でのテキスト出力 @n
+			※時間は、受信フレームのタイムスタンプ（CAN ビット時間単位）を使う。@n
+			※全 ID で、フレーム間隔が 65535 ビット時間を超えると、間隔は正しく計測されない。
     @author 平松邦仁 (hira@rvf-rc45.net)
 	@copyright	Copyright (C) 2020, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
-#include <boost/unordered_map.hpp>
-#include <map>
+#include <algorithm>
 #include "common/can_io.hpp"
 #include "common/format.hpp"
 
@@ -20,31 +24,202 @@ namespace utils {
 	/*!
 		@brief  CAN 通信解析クラス
 		@param[in]	CAN_IO	can_io クラス型
+		@param[in]	IDN		管理する ID の最大数（２のべき乗）
+		@param[in]	CAPN	キャプチャー・リングのフレーム数（２のべき乗）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class CAN_IO>
+	template <class CAN_IO, uint32_t IDN = 256, uint32_t CAPN = 256>
 	class can_analize {
 
+		static_assert((IDN & (IDN - 1)) == 0, "IDN must be a power of two.");
+		static_assert((CAPN & (CAPN - 1)) == 0, "CAPN must be a power of two.");
+
+	public:
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  キャプチャー・モード
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		enum class CAPTURE : uint8_t {
+			STOP,		///< 停止
+			FREE,		///< 連続（古いフレームを上書き）
+			TRIGGER,	///< トリガー待ち（トリガー後 post フレームで停止）
+		};
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  出力フォーマット
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		enum class EXPORT : uint8_t {
+			CANDUMP,	///< SocketCAN candump -l 形式
+			ASC,		///< Vector ASC 形式
+		};
+
+	private:
+
 		CAN_IO&		can_io_;
 
 		typedef device::can_frame FRAME;
 		typedef device::can_io_def CANDEF;
 
+		static constexpr uint32_t EMPTY = 0xffff'ffff;
+
 		struct info_t {
+			uint32_t	id_;
 			uint32_t	count_;
 			FRAME		frame_;
-			info_t() : count_(0), frame_() { }
-			info_t(uint32_t count, const FRAME& frame) : count_(count), frame_(frame) { }
+			uint32_t	last_;		///< 最後の受信時間
+			uint32_t	period_;	///< 直前の受信間隔
+			uint32_t	min_;
+			uint32_t	max_;
+			uint64_t	sum_;
+			uint32_t	jitter_;	///< 受信間隔の変動（x16、RFC3550 方式の平滑化）
+			info_t() : id_(EMPTY), count_(0), frame_(), last_(0), period_(0),
+				min_(0), max_(0), sum_(0), jitter_(0) { }
+		};
+
+		info_t		info_[IDN];
+		uint32_t	id_num_;
+		uint32_t	id_lost_;
+
+		struct cap_t {
+			uint32_t	ts_;
+			FRAME		frame_;
 		};
 
-		// boost::unordered_map か std::map の選択
-		// std::map: 自動で ID の順序が整列する。
-		// boost::unordered_map: ハッシュによるので順番は不明。
-//		typedef boost::unordered_map<uint32_t, info_t> MAP;
-		typedef std::map<uint32_t, info_t> MAP;
-		MAP			map_;
+		struct filter_t {
+			uint32_t	id_;
+			uint32_t	mask_;
+			filter_t() : id_(0), mask_(0) { }
+			bool match(uint32_t id) const noexcept { return ((id ^ id_) & mask_) == 0; }
+		};
+
+		cap_t		cap_[CAPN];
+		uint32_t	cap_pos_;
+		uint32_t	cap_num_;
+		CAPTURE		cap_mode_;
+		filter_t	cap_filter_;
+		filter_t	trg_filter_;
+		uint32_t	post_;
+		bool		trg_;
+
+		uint32_t	ts_;		///< 32 ビットに拡張したタイムスタンプ
+		uint16_t	ts_last_;
+		bool		ts_init_;
+
+		static uint32_t hash_(uint32_t id) noexcept
+		{
+			return (id * 2654435761u) >> 16;
+		}
+
+
+		info_t* find_(uint32_t id) noexcept
+		{
+			auto i = hash_(id) & (IDN - 1);
+			for(uint32_t n = 0; n < IDN; ++n) {
+				auto& t = info_[i];
+				if(t.id_ == id) return &t;
+				if(t.id_ == EMPTY) return nullptr;
+				i = (i + 1) & (IDN - 1);
+			}
+			return nullptr;
+		}
+
+
+		const info_t* find_(uint32_t id) const noexcept
+		{
+			return const_cast<can_analize*>(this)->find_(id);
+		}
+
+
+		info_t* insert_(uint32_t id) noexcept
+		{
+			if(id_num_ >= (IDN - 1)) return nullptr;  // 空きを一つ残す
+			auto i = hash_(id) & (IDN - 1);
+			while(info_[i].id_ != EMPTY) {
+				i = (i + 1) & (IDN - 1);
+			}
+			info_[i] = info_t();
+			info_[i].id_ = id;
+			++id_num_;
+			return &info_[i];
+		}
+
+
+		// 線形探索の後方シフト削除
+		void erase_(info_t* t) noexcept
+		{
+			uint32_t i = t - info_;
+			uint32_t j = i;
+			while(1) {
+				j = (j + 1) & (IDN - 1);
+				if(info_[j].id_ == EMPTY) break;
+				auto k = hash_(info_[j].id_) & (IDN - 1);
+				// k が (i, j] の範囲外なら、i へ移動できる
+				if((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+					info_[i] = info_[j];
+					i = j;
+				}
+			}
+			info_[i].id_ = EMPTY;
+			--id_num_;
+		}
+
+
+		void update_(info_t& t, const FRAME& frm) noexcept
+		{
+			if(t.count_ > 0) {
+				auto p = ts_ - t.last_;
+				if(t.count_ == 1) {
+					t.min_ = p;
+					t.max_ = p;
+				} else {
+					if(p < t.min_) t.min_ = p;
+					if(p > t.max_) t.max_ = p;
+					int32_t d = static_cast<int32_t>(p - t.period_);
+					if(d < 0) d = -d;
+					t.jitter_ += d - ((t.jitter_ + 8) >> 4);
+				}
+				t.sum_ += p;
+				t.period_ = p;
+			}
+			t.last_ = ts_;
+			++t.count_;
+			t.frame_ = frm;
+		}
+
+
+		void capture_(const FRAME& frm) noexcept
+		{
+			if(cap_mode_ == CAPTURE::STOP) return;
+
+			if(cap_mode_ == CAPTURE::TRIGGER) {
+				if(!trg_ && trg_filter_.match(frm.get_id())) {
+					trg_ = true;
+				}
+			}
+			if(!cap_filter_.match(frm.get_id())) return;
+
+			auto& c = cap_[cap_pos_];
+			c.ts_ = ts_;
+			c.frame_ = frm;
+			cap_pos_ = (cap_pos_ + 1) & (CAPN - 1);
+			if(cap_num_ < CAPN) ++cap_num_;
+
+			if(trg_) {
+				if(post_ == 0) {
+					cap_mode_ = CAPTURE::STOP;
+				} else {
+					--post_;
+				}
+			}
+		}
+
 
-		void list_line_(const info_t& t) const
+		void list_line_(const info_t& t, bool verb) const
 		{
 			char ch;
 			if(t.frame_.get_RTR()) {
@@ -53,12 +228,28 @@ namespace utils {
 				ch = 'D';
 			}
 			if(t.frame_.get_IDE()) {
-				utils::format("%c %6u E:x%07X (%u)\n")
+				utils::format("%c %6u E:x%07X (%u)")
 					% ch % t.count_ % t.frame_.get_id() % t.frame_.get_id();
 			} else {
-				utils::format("%c %6u S:x%07X (%u)\n")
+				utils::format("%c %6u S:x%07X (%u)")
 					% ch % t.count_ % t.frame_.get_id() % t.frame_.get_id();
 			}
+			if(verb && t.count_ > 1) {
+				utils::format(" Period: %u/%u/%u, Jitter: %u")
+					% t.min_ % static_cast<uint32_t>(t.sum_ / (t.count_ - 1)) % t.max_
+					% ((t.jitter_ + 8) >> 4);
+			}
+			utils::format("\n");
+		}
+
+
+		void usec_(uint32_t ts, uint32_t& sec, uint32_t& usec) const noexcept
+		{
+			auto spd = can_io_.get_speed();
+			if(spd == 0) spd = 1;
+			uint64_t us = static_cast<uint64_t>(ts) * 1'000'000 / spd;
+			sec = us / 1'000'000;
+			usec = us % 1'000'000;
 		}
 
 	public:
@@ -68,7 +259,12 @@ namespace utils {
 			@param[in]	can_io	can_io インスタンス
 		*/
 		//-----------------------------------------------------------------//
-		can_analize(CAN_IO& can_io) noexcept : can_io_(can_io), map_() { }
+		can_analize(CAN_IO& can_io) noexcept : can_io_(can_io),
+			info_(), id_num_(0), id_lost_(0),
+			cap_(), cap_pos_(0), cap_num_(0), cap_mode_(CAPTURE::STOP),
+			cap_filter_(), trg_filter_(), post_(0), trg_(false),
+			ts_(0), ts_last_(0), ts_init_(false)
+		{ }
 
 
 		//-----------------------------------------------------------------//
@@ -82,13 +278,25 @@ namespace utils {
 			auto n = can_io_.get_recv_num();
 			while(n > 0) {
 				auto frm = can_io_.get_recv_frame();
-				auto it = map_.find(frm.get_id());
-				if(it != map_.end()) {  // 更新
-					it->second.count_++;
-					it->second.frame_ = frm;
+				uint16_t ts = frm.get_TS();
+				if(ts_init_) {
+					ts_ += static_cast<uint16_t>(ts - ts_last_);
+				} else {
+					ts_init_ = true;
+				}
+				ts_last_ = ts;
+
+				auto id = frm.get_id();
+				auto t = find_(id);
+				if(t == nullptr) {
+					t = insert_(id);
+				}
+				if(t != nullptr) {
+					update_(*t, frm);
 				} else {
-					map_.emplace(frm.get_id(), info_t(1, frm));
+					++id_lost_;
 				}
+				capture_(frm);
 				--n;
 			}
 		}
@@ -103,11 +311,11 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool clear(uint32_t id) noexcept
 		{
-			auto it = map_.find(id);
-			if(it == map_.end()) {
+			auto t = find_(id);
+			if(t == nullptr) {
 				return false;
 			}
-			map_.erase(it);
+			erase_(t);
 			return true;
 		}
 
@@ -119,7 +327,11 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		void clear_all() noexcept
 		{
-			map_.clear();
+			for(auto& t : info_) {
+				t.id_ = EMPTY;
+			}
+			id_num_ = 0;
+			id_lost_ = 0;
 		}
 
 
@@ -132,7 +344,42 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool find(uint32_t id) const noexcept
 		{
-			return map_.find(id) != map_.end();
+			return find_(id) != nullptr;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  テーブルが一杯で、記録出来なかったフレーム数を取得
+			@return フレーム数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_id_lost() const noexcept { return id_lost_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  受信間隔の取得
+			@param[in]	id		CAN/ID
+			@param[out]	min		最小間隔
+			@param[out]	avg		平均間隔
+			@param[out]	max		最大間隔
+			@param[out]	jitter	ジッター
+			@return 間隔が得られない場合「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool get_period(uint32_t id, uint32_t& min, uint32_t& avg, uint32_t& max, uint32_t& jitter)
+			const noexcept
+		{
+			auto t = find_(id);
+			if(t == nullptr || t->count_ < 2) {
+				return false;
+			}
+			min = t->min_;
+			avg = t->sum_ / (t->count_ - 1);
+			max = t->max_;
+			jitter = (t->jitter_ + 8) >> 4;
+			return true;
 		}
 
 
@@ -146,31 +393,42 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool list(uint32_t id, bool verb = false) noexcept
 		{
-			auto it = map_.find(id);
-			if(it == map_.end()) {
+			auto t = find_(id);
+			if(t == nullptr) {
 				return false;
 			}
-			list_line_(it->second);
+			list_line_(*t, verb);
 			return true;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  収集された CAN/ID の全リストを表示
+			@brief  収集された CAN/ID の全リストを表示（ID 順）
 			@param[in]	verb	詳細表示の場合「true」
 		*/
 		//-----------------------------------------------------------------//
 		void list_all(bool verb = false) noexcept
 		{
+			uint16_t idx[IDN];
 			uint32_t n = 0;
+			for(uint32_t i = 0; i < IDN; ++i) {
+				if(info_[i].id_ != EMPTY) {
+					idx[n] = i;
+					++n;
+				}
+			}
+			std::sort(idx, idx + n, [this](uint16_t a, uint16_t b) {
+				return info_[a].id_ < info_[b].id_;
+			});
+
 			uint32_t a = 0;
 			uint32_t r = 0;
 			uint32_t df = 0;
 			uint32_t rf = 0;
-			for(auto&& it : map_) {
-				const auto& t = it.second;
-				list_line_(t);
+			for(uint32_t i = 0; i < n; ++i) {
+				const auto& t = info_[idx[i]];
+				list_line_(t, verb);
 				a += t.count_;
 				r += t.frame_.get_DLC();
 				if(t.frame_.get_RTR()) {
@@ -178,10 +436,12 @@ namespace utils {
 				} else {
 					++df;
 				}
-				++n;
 			}
 			utils::format("ID = %u / Total = %u, Records = %u, Df = %u, Rf = %u\n")
 				% n % a % r % df % rf;
+			if(id_lost_ > 0) {
+				utils::format("ID table full, lost frames: %u\n") % id_lost_;
+			}
 		}
 
 
@@ -194,13 +454,146 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool dump(uint32_t id) noexcept
 		{
-			auto it = map_.find(id);
-			if(it == map_.end()) {
+			auto t = find_(id);
+			if(t == nullptr) {
 				return false;
 			}
-			list_line_(it->second);
-			CANDEF::list(it->second.frame_);
+			list_line_(*t, true);
+			CANDEF::list(t->frame_);
 			return true;
 		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  キャプチャー・フィルターの設定 @n
+					(ID & mask) が (id & mask) と一致するフレームだけを記録する。
+			@param[in]	id		CAN/ID
+			@param[in]	mask	マスク（０で全て通過）
+		*/
+		//-----------------------------------------------------------------//
+		void set_capture_filter(uint32_t id, uint32_t mask) noexcept
+		{
+			cap_filter_.id_ = id;
+			cap_filter_.mask_ = mask;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  キャプチャーの開始 @n
+					TRIGGER の場合、トリガー前のフレームもリングに残る。
+			@param[in]	mode	キャプチャー・モード
+			@param[in]	id		トリガー CAN/ID
+			@param[in]	mask	トリガー・マスク
+			@param[in]	post	トリガー後に記録するフレーム数
+		*/
+		//-----------------------------------------------------------------//
+		void start_capture(CAPTURE mode, uint32_t id = 0, uint32_t mask = 0, uint32_t post = CAPN / 2) noexcept
+		{
+			cap_mode_ = CAPTURE::STOP;
+			cap_pos_ = 0;
+			cap_num_ = 0;
+			trg_filter_.id_ = id;
+			trg_filter_.mask_ = mask;
+			post_ = post;
+			trg_ = false;
+			cap_mode_ = mode;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  キャプチャーの停止
+		*/
+		//-----------------------------------------------------------------//
+		void stop_capture() noexcept { cap_mode_ = CAPTURE::STOP; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  キャプチャー・モードの取得
+			@return キャプチャー・モード（停止後は STOP）
+		*/
+		//-----------------------------------------------------------------//
+		CAPTURE get_capture_mode() const noexcept { return cap_mode_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  キャプチャーされたフレーム数
+			@return フレーム数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_capture_num() const noexcept { return cap_num_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  キャプチャーされたフレームをテキストで出力 @n
+					一行毎に出力関数を呼ぶ（SCI、SD カードへの書き込みなど）
+			@param[in]	fmt		出力フォーマット
+			@param[in]	out		出力関数 void (const char* line)
+			@param[in]	dev		デバイス名（candump 形式）
+			@return 出力したフレーム数
+		*/
+		//-----------------------------------------------------------------//
+		template <class OUT>
+		uint32_t export_capture(EXPORT fmt, OUT out, const char* dev = "can0") const noexcept
+		{
+			char line[96];
+			if(fmt == EXPORT::ASC) {
+				out("base hex  timestamps absolute\n");
+				out("no internal events logged\n");
+			}
+
+			uint32_t org = (cap_pos_ - cap_num_) & (CAPN - 1);
+			uint32_t top = cap_[org].ts_;
+			for(uint32_t i = 0; i < cap_num_; ++i) {
+				const auto& c = cap_[(org + i) & (CAPN - 1)];
+				const auto& f = c.frame_;
+				uint32_t sec;
+				uint32_t usec;
+				auto dlc = f.get_DLC();
+				if(dlc > 8) dlc = 8;
+				if(fmt == EXPORT::CANDUMP) {
+					usec_(c.ts_, sec, usec);
+					utils::sformat("(%u.%06u) %s ", line, sizeof(line)) % sec % usec % dev;
+					if(f.get_IDE()) {
+						utils::sformat("%08X#", line, sizeof(line), true) % f.get_id();
+					} else {
+						utils::sformat("%03X#", line, sizeof(line), true) % f.get_id();
+					}
+					if(f.get_RTR()) {
+						utils::sformat("R", line, sizeof(line), true);
+					} else {
+						for(uint32_t j = 0; j < dlc; ++j) {
+							utils::sformat("%02X", line, sizeof(line), true)
+								% static_cast<uint16_t>(f.get_DATA(j));
+						}
+					}
+				} else {
+					usec_(c.ts_ - top, sec, usec);
+					utils::sformat("%4u.%06u 1  ", line, sizeof(line)) % sec % usec;
+					if(f.get_IDE()) {
+						utils::sformat("%Xx", line, sizeof(line), true) % f.get_id();
+					} else {
+						utils::sformat("%X", line, sizeof(line), true) % f.get_id();
+					}
+					if(f.get_RTR()) {
+						utils::sformat("  Rx   r", line, sizeof(line), true);
+					} else {
+						utils::sformat("  Rx   d %u", line, sizeof(line), true) % dlc;
+						for(uint32_t j = 0; j < dlc; ++j) {
+							utils::sformat(" %02X", line, sizeof(line), true)
+								% static_cast<uint16_t>(f.get_DATA(j));
+						}
+					}
+				}
+				utils::sformat("\n", line, sizeof(line), true);
+				out(line);
+			}
+			return cap_num_;
+		}
 	};
 }
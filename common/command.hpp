@@ -1,9 +1,11 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	コマンド入力クラス
+	@brief	コマンド入力クラス @n
+			・エコー、VT-100 ESC シーケンスはバッファに溜め、service 毎に @n
+			  sci_puts で一度に出力する。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2016, 2017 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2016, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -25,9 +27,10 @@ namespace utils {
     /*!
         @brief  command class
 		@param[in]	BUFN	バッファサイズ（最小でも９）
+		@param[in]	OUTN	出力バッファサイズ
     */
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <uint16_t BUFN>
+	template <uint16_t BUFN, uint16_t OUTN = 64>
 	class command {
 		char		buff_[BUFN];
 		int16_t		bpos_;
@@ -41,73 +44,52 @@ namespace utils {
 		bool	esc_;
 		uint8_t	esc_step_;
 
-		// VT-100 ESC シーケンス 
-		static void clear_line_() {
-			sci_putch(0x1b);
-			sci_putch('[');
-			sci_putch('0');
-			sci_putch('J');
-		}
+		char		out_[OUTN];
+		uint16_t	opos_;
 
-		static void save_cursor_() {
-			sci_putch(0x1b);
-			sci_putch('7');
+		void flush_() {
+			if(opos_ == 0) return;
+			out_[opos_] = 0;
+			sci_puts(out_);
+			opos_ = 0;
 		}
 
-		static void load_cursor_() {
-			sci_putch(0x1b);
-			sci_putch('8');
+		void putch_(char ch) {
+			if(opos_ >= (OUTN - 1)) flush_();
+			out_[opos_] = ch;
+			++opos_;
 		}
 
-		static void crlf_() {
-			sci_putch('\r');	///< CR
-			sci_putch('\n');	///< LF
+		void puts_(const char* str) {
+			while(*str != 0) putch_(*str++);
 		}
 
-	public:
-        //-----------------------------------------------------------------//
-        /*!
-            @brief  コンストラクター
-        */
-        //-----------------------------------------------------------------//
-		command() : bpos_(-1), pos_(0), len_(0), tab_top_(-1),
-			prompt_(nullptr), tab_(false), esc_(false), esc_step_(false)
-		{ buff_[0] = 0; }
+		// VT-100 ESC シーケンス 
+		void clear_line_() { puts_("\x1b[0J"); }
 
+		void save_cursor_() { puts_("\x1b" "7"); }
 
-        //-----------------------------------------------------------------//
-        /*!
-            @brief  プロムプト文字列を設定
-			@param[in]	text	文字列
-        */
-        //-----------------------------------------------------------------//
-		void set_prompt(const char* text) { prompt_ = text; }
+		void load_cursor_() { puts_("\x1b" "8"); }
 
+		void crlf_() { puts_("\r\n"); }
 
-        //-----------------------------------------------------------------//
-        /*!
-            @brief  サービス @n
-					※文字取得バッファが溢れない程度に呼び出す。
-			@return 「Enter」キーが押されたら「true」
-        */
-        //-----------------------------------------------------------------//
-		bool service()
+		bool service_()
 		{
 			if(bpos_ < 0 && pos_ == 0) {
-				if(prompt_ != nullptr) sci_puts(prompt_);
+				if(prompt_ != nullptr) puts_(prompt_);
 			}
 			bpos_ = pos_;
 			tab_ = false;
 			while(sci_length()) {
 				if(pos_ >= (BUFN - 1)) {	///< バッファが溢れた・・
-					sci_putch('\\');		///< バックスラッシュ
+					putch_('\\');		///< バックスラッシュ
 					buff_[BUFN - 1] = 0;
 					pos_ = 0;
 					bpos_ = -1;
 					crlf_();
 					return false;
 				} else if(pos_ >= (BUFN - 8)) {	///< バッファが溢れそうな警告
-					sci_putch('G' - 0x40);	///< Ctrl-G
+					putch_('G' - 0x40);	///< Ctrl-G
 				}
 
 				char ch = sci_getch();
@@ -125,9 +107,9 @@ namespace utils {
 				case 0x08:	// バックスペース
 					if(pos_) {
 						--pos_;
-						sci_putch(0x08);
+						putch_(0x08);
 						if(buff_[pos_] < 0x20) {
-							sci_putch(0x08);
+							putch_(0x08);
 						}
 					} else {
 						pos_ = 0;
@@ -168,12 +150,12 @@ namespace utils {
 						if(ch < 0x20) {	///< 他の ctrl コード
 							buff_[pos_] = ch;
 							++pos_;
-							sci_putch('^');
-							sci_putch(ch + 0x40);
+							putch_('^');
+							putch_(ch + 0x40);
 						} else {
 							buff_[pos_] = ch;
 							++pos_;
-							sci_putch(ch);
+							putch_(ch);
 						}
 						buff_[pos_] = 0;
 					}
@@ -183,6 +165,41 @@ namespace utils {
 			return false;
 		}
 
+	public:
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  コンストラクター
+        */
+        //-----------------------------------------------------------------//
+		command() : bpos_(-1), pos_(0), len_(0), tab_top_(-1),
+			prompt_(nullptr), tab_(false), esc_(false), esc_step_(false),
+			out_{ 0 }, opos_(0)
+		{ buff_[0] = 0; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  プロムプト文字列を設定
+			@param[in]	text	文字列
+        */
+        //-----------------------------------------------------------------//
+		void set_prompt(const char* text) { prompt_ = text; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  サービス @n
+					※文字取得バッファが溢れない程度に呼び出す。
+			@return 「Enter」キーが押されたら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool service()
+		{
+			auto ret = service_();
+			flush_();
+			return ret;
+		}
+
 
         //-----------------------------------------------------------------//
         /*!
@@ -301,7 +318,8 @@ namespace utils {
 			std::strcpy(&buff_[tab_top_], key);
 
 			load_cursor_();
-			sci_puts(key);
+			puts_(key);
+			flush_();
 		}
 	};
 }
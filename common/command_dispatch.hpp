@@ -0,0 +1,247 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	コマンド・ディスパッチャー・クラス @n
+			・コマンド名のハッシュ表で、コマンド行を関数に振り分ける。 @n
+			・関数は「ステップ」単位で呼ばれ、CONTINUE を返すと次の service で @n
+			  続きが呼ばれる（ダンプ、ディレクトリ・リストなど、時間のかかる @n
+			  コマンドでメインループを止めない）。 @n
+			・１回の service で呼ぶステップ数、又は時間（set_clock）を制限できる。 @n
+			Ex: utils::command<256> cmd_; @n
+			    utils::command_dispatch<utils::command<256>, 16> disp_(cmd_); @n
+			    disp_.add("dump", [&](const auto& cmd, uint32_t& step) { ...; }, "dump memory"); @n
+			    while(1) { disp_.service(); ... }
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2023 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <functional>
+#include "common/command.hpp"
+#include "common/format.hpp"
+
+namespace utils {
+
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+    /*!
+        @brief  コマンド・ディスパッチャー・クラス
+		@param[in]	CMD		コマンド入力クラス（utils::command）
+		@param[in]	NUM		登録できるコマンドの最大数
+    */
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class CMD, uint32_t NUM>
+	class command_dispatch {
+	public:
+
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+        /*!
+            @brief  コマンド関数の戻り値
+        */
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		enum class RESULT : uint8_t {
+			DONE,		///< 完了
+			CONTINUE,	///< 続きがある（次のステップを呼ぶ）
+			ERROR,		///< エラー
+		};
+
+		/// コマンド関数（step は最初０で、関数が自由に使える）
+		typedef std::function<RESULT (const CMD& cmd, uint32_t& step)> FUNC_TYPE;
+
+		/// 時間（任意の単位）を返す関数
+		typedef uint32_t (*CLOCK_FUNC)();
+
+	private:
+		struct entry_t {
+			uint32_t	hash;
+			const char*	name;
+			const char*	help;
+			FUNC_TYPE	func;
+		};
+
+		CMD&		cmd_;
+
+		entry_t		entry_[NUM];
+		uint32_t	num_;
+
+		int32_t		run_;		// 実行中のコマンド（-1 ならなし）
+		uint32_t	step_;
+
+		uint32_t	limit_;
+		CLOCK_FUNC	clock_;
+		uint32_t	budget_;
+
+		RESULT		last_;
+
+		static uint32_t hash_(const char* p, char sch) noexcept
+		{
+			uint32_t h = 2166136261u;  // FNV-1a
+			while(*p != 0 && *p != sch) {
+				h ^= static_cast<uint8_t>(*p);
+				h *= 16777619u;
+				++p;
+			}
+			return h;
+		}
+
+		int32_t find_() const noexcept
+		{
+			const char* p = cmd_.get_command();
+			while(*p == ' ') ++p;
+			auto h = hash_(p, ' ');
+			for(uint32_t i = 0; i < num_; ++i) {
+				if(entry_[i].hash == h && cmd_.cmp_word(0, entry_[i].name)) {
+					return i;
+				}
+			}
+			return -1;
+		}
+
+		void step_run_() noexcept
+		{
+			uint32_t n = 0;
+			uint32_t org = clock_ != nullptr ? clock_() : 0;
+			while(1) {
+				last_ = entry_[run_].func(cmd_, step_);
+				if(last_ != RESULT::CONTINUE) {
+					run_ = -1;
+					return;
+				}
+				++n;
+				if(limit_ > 0 && n >= limit_) break;
+				if(clock_ != nullptr && (clock_() - org) >= budget_) break;
+				if(limit_ == 0 && clock_ == nullptr) break;
+			}
+		}
+
+	public:
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  コンストラクター
+			@param[in]	cmd		コマンド入力クラス
+        */
+        //-----------------------------------------------------------------//
+		command_dispatch(CMD& cmd) noexcept : cmd_(cmd), entry_{ }, num_(0),
+			run_(-1), step_(0), limit_(1), clock_(nullptr), budget_(0),
+			last_(RESULT::DONE)
+		{ }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  コマンドの登録
+			@param[in]	name	コマンド名
+			@param[in]	func	コマンド関数
+			@param[in]	help	ヘルプ文字列（nullptr なら表示しない）
+			@return 登録できたら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool add(const char* name, FUNC_TYPE func, const char* help = nullptr) noexcept
+		{
+			if(name == nullptr || num_ >= NUM) return false;
+			auto& e = entry_[num_];
+			e.hash = hash_(name, 0);
+			e.name = name;
+			e.help = help;
+			e.func = func;
+			++num_;
+			return true;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  １回の service で呼ぶステップ数の上限
+			@param[in]	limit	ステップ数（０なら時間だけで制限）
+        */
+        //-----------------------------------------------------------------//
+		void set_limit(uint32_t limit) noexcept { limit_ = limit; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  １回の service で使う時間の上限
+			@param[in]	clock	時間を返す関数（nullptr なら時間で制限しない）
+			@param[in]	budget	時間の上限（clock の単位）
+        */
+        //-----------------------------------------------------------------//
+		void set_clock(CLOCK_FUNC clock, uint32_t budget) noexcept
+		{
+			clock_ = clock;
+			budget_ = budget;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  コマンドが実行中か
+			@return 実行中なら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool probe() const noexcept { return run_ >= 0; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  最後に完了したコマンドの結果
+			@return 結果
+        */
+        //-----------------------------------------------------------------//
+		RESULT get_last() const noexcept { return last_; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  実行中のコマンドを中断
+        */
+        //-----------------------------------------------------------------//
+		void abort() noexcept { run_ = -1; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  サービス（メインループから呼ぶ） @n
+					実行中のコマンドがあれば続きを、無ければ行入力を処理する。 @n
+					※実行中の入力は、SCI のバッファに残る。
+			@return 登録されていないコマンドが入力されたら「false」
+        */
+        //-----------------------------------------------------------------//
+		bool service() noexcept
+		{
+			if(run_ >= 0) {
+				step_run_();
+				return true;
+			}
+
+			if(!cmd_.service()) return true;
+			if(cmd_.get_words() == 0) return true;
+
+			auto i = find_();
+			if(i < 0) return false;
+
+			run_ = i;
+			step_ = 0;
+			step_run_();
+			return true;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  ヘルプ表示
+			@param[in]	spc		コマンド名の文字数
+        */
+        //-----------------------------------------------------------------//
+		void help(uint32_t spc = 20) const noexcept
+		{
+			for(uint32_t i = 0; i < num_; ++i) {
+				const auto& e = entry_[i];
+				if(e.help == nullptr) continue;
+				utils::format("%s") % e.name;
+				auto n = strlen(e.name);
+				while(n < spc) { utils::format(" "); ++n; }
+				utils::format("%s\n") % e.help;
+			}
+		}
+	};
+}
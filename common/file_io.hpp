@@ -4,9 +4,10 @@
 	@brief	ファイル・入出力クラス @n
 			※ FatFs のラッパー（ff14 以降が必要） @n
 			※ FatFs のファイル操作系をラップして fopen ぽい機能を提供する。@n
-			※ fopen と違って、バッファリング（キャッシュ）されない。
+			※ 標準ではバッファリング（キャッシュ）されない。@n
+			※ set_buffer でバッファを与えると、先読み、遅延書き込みを行う。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2018, 2020 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2018, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -68,6 +69,13 @@ namespace utils {
 		bool		open_;
 		bool		error_;
 
+		uint8_t*	buff_;		///< 先読み、遅延書き込み用バッファ
+		uint32_t	buff_size_;
+		FSIZE		buff_org_;	///< バッファ先頭のファイル位置
+		uint32_t	buff_pos_;	///< バッファ内の読み出し位置
+		uint32_t	buff_len_;	///< バッファ内の有効バイト数
+		bool		buff_write_;	///< 遅延書き込み中なら「true」
+
 		struct dir_list_t {
 			bool		ll_;
 			uint16_t	count_;
@@ -173,6 +181,89 @@ namespace utils {
 		static char current_path_[PATH_MAX_SIZE];
 #endif
 
+		// バッファの終端から、ファイル位置 end まで読む（バッファの空きで制限）
+		bool read_ahead_(FSIZE end) noexcept
+		{
+			auto cur = buff_org_ + buff_len_;
+			if(cur >= end) return true;
+			auto req = end - cur;
+			if(req > (buff_size_ - buff_len_)) req = buff_size_ - buff_len_;
+			if(req == 0) return true;
+			UINT rl = 0;
+			if(f_read(&fp_, &buff_[buff_len_], static_cast<UINT>(req), &rl) != FR_OK) {
+				error_ = true;
+				return false;
+			}
+			buff_len_ += rl;
+			return true;
+		}
+
+
+		// 先読みバッファを充填（ファイル位置がバッファ境界に揃う様に読む） @n
+		// peek の追加読み込みで境界を越えている場合は読まず、次の充填で揃える
+		bool fill_() noexcept
+		{
+			auto n = buff_len_ - buff_pos_;
+			if(n > 0 && buff_pos_ > 0) {  // 残りを先頭へ詰める
+				std::memmove(buff_, &buff_[buff_pos_], n);
+			}
+			buff_org_ += buff_pos_;
+			buff_len_ = n;
+			buff_pos_ = 0;
+
+			auto end = buff_org_ + buff_size_;
+			end -= end % buff_size_;
+			return read_ahead_(end);
+		}
+
+
+		// 遅延書き込みバッファの書き出し
+		bool flush_write_() noexcept
+		{
+			if(!buff_write_) return true;
+
+			bool ok = true;
+			if(buff_len_ > 0) {
+				UINT wl = 0;
+				if(f_write(&fp_, buff_, buff_len_, &wl) != FR_OK || wl != buff_len_) {
+					error_ = true;
+					ok = false;
+				}
+			}
+			buff_org_ += buff_len_;
+			buff_len_ = 0;
+			buff_pos_ = 0;
+			buff_write_ = false;
+			return ok;
+		}
+
+
+		// 先読み内容を破棄して、ファイル位置を論理位置へ戻す
+		bool drop_read_() noexcept
+		{
+			if(buff_write_ || buff_len_ == 0) return true;
+
+			auto pos = buff_org_ + buff_pos_;
+			buff_org_ = pos;
+			buff_len_ = 0;
+			buff_pos_ = 0;
+			if(f_lseek(&fp_, pos) != FR_OK) {
+				error_ = true;
+				return false;
+			}
+			return true;
+		}
+
+
+		// バッファ状態を初期化
+		void reset_buffer_() noexcept
+		{
+			buff_org_ = open_ ? f_tell(&fp_) : 0;
+			buff_pos_ = 0;
+			buff_len_ = 0;
+			buff_write_ = false;
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
@@ -181,7 +272,9 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		file_io_() noexcept :
 			fp_(),
-			open_(false), error_(false)
+			open_(false), error_(false),
+			buff_(nullptr), buff_size_(0),
+			buff_org_(0), buff_pos_(0), buff_len_(0), buff_write_(false)
 		{ }
 
 
@@ -374,10 +467,65 @@ namespace utils {
 			}
 			open_ = true;
 			error_ = false;
+			reset_buffer_();
 			return true;
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	先読み、遅延書き込みバッファの設定 @n
+					※セクタ（FF_MIN_SS）単位の大きさを与える事で、@n
+					ファイル位置がセクタ境界に揃った状態で読み書きされる。@n
+					※「nullptr」を与えるとバッファを使わない。@n
+					※バッファ使用中に at() で直接操作してはならない。
+			@param[in]	buff	バッファ
+			@param[in]	size	バッファのサイズ（FF_MIN_SS の倍数）
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool set_buffer(void* buff, uint32_t size) noexcept
+		{
+			if(buff != nullptr && (size == 0 || (size % FF_MIN_SS) != 0)) {
+				return false;
+			}
+			bool ok = flush_write_() && drop_read_();
+			buff_ = static_cast<uint8_t*>(buff);
+			buff_size_ = buff != nullptr ? size : 0;
+			reset_buffer_();
+			return ok;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	バッファ済みデータの参照（ゼロ・コピー） @n
+					※読み進めるには seek(SEEK::CUR, n) を使う。@n
+					※参照は、次の読み書き操作まで有効。
+			@param[in]	n	必要なバイト数（バッファサイズ以下）
+			@return 先頭ポインター（n バイト揃わない場合「nullptr」）
+		*/
+		//-----------------------------------------------------------------//
+		const void* peek(uint32_t n) noexcept
+		{
+			if(!open_ || buff_ == nullptr || n > buff_size_) return nullptr;
+
+			if(!flush_write_()) return nullptr;
+			if((buff_len_ - buff_pos_) < n) {
+				if(!fill_()) return nullptr;
+				// 境界合わせで不足した場合、不足分をセクタ境界まで追加で読む
+				if((buff_len_ - buff_pos_) < n) {
+					auto end = buff_org_ + buff_pos_ + n;
+					end += FF_MIN_SS - 1;
+					end -= end % FF_MIN_SS;
+					if(!read_ahead_(end)) return nullptr;
+				}
+				if((buff_len_ - buff_pos_) < n) return nullptr;
+			}
+			return &buff_[buff_pos_];
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	ファイル・ディスクリプタへの参照
@@ -420,8 +568,11 @@ namespace utils {
 			if(!open_) {
 				return false;
 			}
+			bool ok = flush_write_();
 			open_ = false;
-			return f_close(&fp_) == FR_OK;
+			buff_len_ = 0;
+			buff_pos_ = 0;
+			return (f_close(&fp_) == FR_OK) && ok;
 		}
 
 
@@ -437,13 +588,51 @@ namespace utils {
 		{
 			if(!open_) return 0; 
 
-			UINT rl = 0;
-			FRESULT res = f_read(&fp_, dst, len, &rl);
-			if(res != FR_OK) {
-				error_ = true;
-				return 0;
+			if(buff_ == nullptr) {
+				UINT rl = 0;
+				FRESULT res = f_read(&fp_, dst, len, &rl);
+				if(res != FR_OK) {
+					error_ = true;
+					return 0;
+				}
+				return rl;
+			}
+
+			if(!flush_write_()) return 0;
+
+			auto out = static_cast<uint8_t*>(dst);
+			uint32_t total = 0;
+			while(len > 0) {
+				auto n = buff_len_ - buff_pos_;
+				if(n > 0) {
+					if(n > len) n = len;
+					std::memcpy(out, &buff_[buff_pos_], n);
+					buff_pos_ += n;
+					out += n;
+					len -= n;
+					total += n;
+					continue;
+				}
+				auto pos = buff_org_ + buff_len_;
+				if(len >= buff_size_ && (pos % buff_size_) == 0) {  // 大きな要求はバッファを通さない
+					UINT rl = 0;
+					auto req = len - (len % buff_size_);
+					if(f_read(&fp_, out, req, &rl) != FR_OK) {
+						error_ = true;
+						break;
+					}
+					buff_org_ = pos + rl;
+					buff_pos_ = 0;
+					buff_len_ = 0;
+					out += rl;
+					len -= rl;
+					total += rl;
+					if(rl < req) break;
+					continue;
+				}
+				if(!fill_() || buff_len_ == 0) break;
 			}
-			return rl;
+			return total;
 		}
 
 
@@ -471,6 +660,11 @@ namespace utils {
 		//-----------------------------------------------------------------//
 		bool get_char(char& ch) noexcept
 		{
+			if(buff_ != nullptr && buff_pos_ < buff_len_ && !buff_write_) {
+				ch = static_cast<char>(buff_[buff_pos_]);
+				++buff_pos_;
+				return true;
+			}
 			char tmp[1];
 			if(read(tmp, 1) != 1) {
 				return false;
@@ -492,13 +686,51 @@ namespace utils {
 		{
 			if(!open_) return 0; 
 
-			UINT wl = 0;
-			FRESULT res = f_write(&fp_, src, len, &wl);
-			if(res != FR_OK) {
-				error_ = true;
-				return 0;
+			if(buff_ == nullptr) {
+				UINT wl = 0;
+				FRESULT res = f_write(&fp_, src, len, &wl);
+				if(res != FR_OK) {
+					error_ = true;
+					return 0;
+				}
+				return wl;
 			}
-			return wl;
+
+			if(!drop_read_()) return 0;
+			buff_write_ = true;
+
+			auto in = static_cast<const uint8_t*>(src);
+			uint32_t total = 0;
+			while(len > 0) {
+				if(buff_len_ == 0 && len >= buff_size_ && (buff_org_ % buff_size_) == 0) {  // 大きな要求はバッファを通さない
+					UINT wl = 0;
+					auto req = len - (len % buff_size_);
+					if(f_write(&fp_, in, req, &wl) != FR_OK) {
+						error_ = true;
+						break;
+					}
+					buff_org_ += wl;
+					in += wl;
+					len -= wl;
+					total += wl;
+					if(wl < req) break;
+					continue;
+				}
+				// 境界まで溜める
+				auto lim = buff_size_ - (buff_org_ % buff_size_);
+				auto n = lim - buff_len_;
+				if(n > len) n = len;
+				std::memcpy(&buff_[buff_len_], in, n);
+				buff_len_ += n;
+				in += n;
+				len -= n;
+				total += n;
+				if(buff_len_ >= lim) {
+					if(!flush_write_()) break;
+					buff_write_ = true;
+				}
+			}
+			return total;
 		}
 
 
@@ -513,6 +745,28 @@ namespace utils {
 		bool seek(SEEK seek, FSIZE ofs) noexcept
 		{
 			if(!open_) return false;
+			if(buff_ != nullptr) {
+				if(!flush_write_()) return false;
+				FSIZE pos;
+				switch(seek) {
+				case SEEK::SET: pos = ofs; break;
+				case SEEK::CUR: pos = tell() + ofs; break;
+				case SEEK::END: pos = get_file_size() - ofs; break;
+				default: return false;
+				}
+				if(pos >= buff_org_ && pos <= (buff_org_ + buff_len_)) {  // 先読み範囲内
+					buff_pos_ = pos - buff_org_;
+					return true;
+				}
+				buff_org_ = pos;
+				buff_pos_ = 0;
+				buff_len_ = 0;
+				if(f_lseek(&fp_, pos) != FR_OK) {
+					error_ = true;
+					return false;
+				}
+				return true;
+			}
 			FRESULT ret;
 			switch(seek) {
 			case SEEK::SET:
@@ -552,6 +806,9 @@ namespace utils {
 		FSIZE tell() const noexcept
 		{
 			if(!open_) return 0;
+			if(buff_ != nullptr) {
+				return buff_write_ ? (buff_org_ + buff_len_) : (buff_org_ + buff_pos_);
+			}
 			return f_tell(&fp_);
 		}
 
@@ -565,6 +822,7 @@ namespace utils {
 		bool eof() const noexcept
 		{
 			if(!open_) return false;
+			if(buff_ != nullptr && !buff_write_ && buff_pos_ < buff_len_) return false;
 			return f_eof(&fp_);
 		}
 
@@ -587,13 +845,18 @@ namespace utils {
 		FSIZE get_file_size() const noexcept
 		{
 			if(!open_) return 0;
+			if(buff_ != nullptr && buff_write_) {
+				auto end = buff_org_ + buff_len_;
+				return end > f_size(&fp_) ? end : f_size(&fp_);
+			}
 			return f_size(&fp_);
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	ファイル・フラッシュ
+			@brief	ファイル・フラッシュ @n
+					※遅延書き込み中のデータも書き出す。
 			@return 正常なら「true」
 		*/
 		//-----------------------------------------------------------------//
@@ -601,7 +864,8 @@ namespace utils {
 		{
 			if(!open_) return false;
 
-			return f_sync(&fp_) == FR_OK;
+			bool ok = flush_write_();
+			return (f_sync(&fp_) == FR_OK) && ok;
 		}
 
 
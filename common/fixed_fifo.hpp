@@ -92,6 +92,34 @@ namespace utils {
 		}
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  格納ポイントをまとめて移動
+			@param[in]	n	移動数（空き容量を超えてはならない）
+        */
+        //-----------------------------------------------------------------//
+		inline void put_go(uint32_t n) noexcept {
+			auto put = put_ + n;
+			if(put >= SIZE) {
+				put -= SIZE;
+			}
+			put_ = put;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  連続して格納可能な数を返す（バッファ終端で折り返さない範囲）
+			@return	連続格納可能な数
+        */
+        //-----------------------------------------------------------------//
+		auto space_linear() const noexcept {
+			uint32_t spc = space();
+			uint32_t lin = SIZE - put_;
+			return spc < lin ? spc : lin;
+		}
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  値の格納
@@ -104,6 +132,39 @@ namespace utils {
 		}
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  空き容量を返す
+			@return	空き容量
+        */
+        //-----------------------------------------------------------------//
+		auto space() const noexcept { return SIZE - 1 - length(); }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  値の一括格納（空き容量を超えた分は格納しない）
+			@param[in]	src	格納元
+			@param[in]	len	格納数
+			@return	格納した数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t put(const UNIT* src, uint32_t len) noexcept {
+			uint32_t spc = space();
+			if(len > spc) len = spc;
+			uint32_t put = put_;
+			for(uint32_t i = 0; i < len; ++i) {
+				buff_[put] = src[i];
+				++put;
+				if(put >= SIZE) {
+					put = 0;
+				}
+			}
+			put_ = put;
+			return len;
+		}
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  値の取得参照を得る
@@ -131,6 +192,35 @@ namespace utils {
 		}
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  取得ポイントをまとめて移動
+			@param[in]	n	移動数（格納数を超えてはならない）
+        */
+        //-----------------------------------------------------------------//
+		inline void get_go(uint32_t n) noexcept {
+			auto get = get_ + n;
+			if(get >= SIZE) {
+				get -= SIZE;
+			}
+			get_ = get;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  連続して取得可能な数を返す（バッファ終端で折り返さない範囲）
+			@return	連続取得可能な数
+        */
+        //-----------------------------------------------------------------//
+		auto length_linear() const noexcept {
+			auto put = put_;
+			auto get = get_;
+			if(put >= get) return (put - get);
+			else return (SIZE - get);
+		}
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  値の取得
@@ -144,6 +234,30 @@ namespace utils {
 		}
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  値の一括取得
+			@param[out]	dst	取得先
+			@param[in]	len	取得数
+			@return	取得した数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t get(UNIT* dst, uint32_t len) noexcept {
+			uint32_t n = length();
+			if(len > n) len = n;
+			uint32_t get = get_;
+			for(uint32_t i = 0; i < len; ++i) {
+				dst[i] = buff_[get];
+				++get;
+				if(get >= SIZE) {
+					get = 0;
+				}
+			}
+			get_ = get;
+			return len;
+		}
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  get 位置を返す
@@ -160,5 +274,68 @@ namespace utils {
         */
         //-----------------------------------------------------------------//
 		inline auto pos_put() const noexcept { return put_; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  待っているタスクへの通知（割り込み側から呼ぶ） @n
+					※待つ事が無いので何もしない（RTOS 用の stream_fifo と同じ API）
+        */
+        //-----------------------------------------------------------------//
+		void notify_from_isr() noexcept { }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  待っているタスクへの通知（タスク側から呼ぶ） @n
+					※待つ事が無いので何もしない（RTOS 用の stream_fifo と同じ API）
+        */
+        //-----------------------------------------------------------------//
+		void notify() noexcept { }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  格納数を待つ（待たずに、現在の状態を返す）
+			@param[in]	n		格納数
+			@param[in]	timeout	タイムアウト（使わない）
+			@return	格納数が n 以上なら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool wait_length(uint32_t n, uint32_t /* timeout */ = 0) noexcept { return length() >= n; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  空き容量を待つ（待たずに、現在の状態を返す）
+			@param[in]	n		空き容量
+			@param[in]	timeout	タイムアウト（使わない）
+			@return	空き容量が n 以上なら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool wait_space(uint32_t n, uint32_t /* timeout */ = 0) noexcept { return space() >= n; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  書き込み領域の予約（コピー無し、RTOS 用の stream_fifo と同じ API）
+			@param[out]	ptr		書き込み先
+			@return	連続して書き込める数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t reserve(UNIT*& ptr) noexcept
+		{
+			ptr = &put_at();
+			return space_linear();
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  予約した領域の確定
+			@param[in]	n	書き込んだ数
+        */
+        //-----------------------------------------------------------------//
+		void commit(uint32_t n) noexcept { put_go(n); }
 	};
 }
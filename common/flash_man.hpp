@@ -1,83 +1,576 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	Flash memory マネージャー
+	@brief	Flash memory マネージャー（データ・フラッシュ用キー／バリュー・ストア） @n
+			・レコードは追記のみで、CRC とシーケンス番号を持つ。 @n
+			・マウント時に一度だけ全体を読んで、RAM 上にハッシュ索引を作る。 @n
+			・書き込み途中の電源断は CRC で検出し、そのレコードは無効になる。 @n
+			・複数ブロックをまとめた「セグメント」単位で追記、回収（GC）、消去を行う。 @n
+			・新しいセグメントは順番に巡回して使い（ラウンド・ロビン）、消去回数は @n
+			  セグメント・ヘッダーに記録する。 @n
+			※RX600/RX700 の「device::flash_io」（DATA_SIZE、DATA_BLOCK_SIZE）を前提とする。 @n
+			※データ・フラッシュの消去状態は読み出し値が不定なので、空きの判定は @n
+			  「erase_check」で行う。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2017, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
-#include "common/renesas.hpp"
+#include <cstdint>
+#include <cstring>
 
 namespace utils {
 
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  flash_man class @n
-				データ列の構造：@n
-				+0: ID (2 bytes) @n
-				+2: TM (2 bytes) タイムスタンプ（数値が一番大きいものが最新）@n
-				+4: SZ (2 bytes) サイズ
+				セグメントの構造：@n
+				+0: MAGIC (4 bytes) @n
+				+4: 消去回数 (4 bytes) @n
+				+8: 消去回数の反転 (4 bytes) @n
+				+12: レコード...  @n
+				レコードの構造（４バイト境界）：@n
+				+0: KEY (2 bytes) @n
+				+2: LEN (2 bytes) データ長（０は削除） @n
+				+4: SEQ (4 bytes) シーケンス番号（数値が一番大きいものが最新）@n
+				+8: DATA (LEN bytes, ４バイト境界まで 0xFF) @n
+				+n: CRC32 (4 bytes) KEY から DATA まで
 		@param[in]	FIO		フラッシュ I/O
-		@param[in]	OMAX	オープン最大
+		@param[in]	KEYN	キー（索引）の最大数（２のべき乗）
+		@param[in]	SEGB	１セグメントのブロック数
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class FIO, uint32_t OMAX = 4>
+	template <class FIO, uint32_t KEYN = 64, uint32_t SEGB = 16>
 	class flash_man {
+	public:
+		static constexpr uint32_t SEG_SIZE  = FIO::DATA_BLOCK_SIZE * SEGB;		///< セグメントのサイズ
+		static constexpr uint32_t SEG_NUM   = FIO::DATA_SIZE / SEG_SIZE;		///< セグメント数
+		static constexpr uint32_t HEAD_SIZE = 12;								///< セグメント・ヘッダーのサイズ
+		static constexpr uint32_t REC_SIZE  = 12;								///< レコードの管理サイズ
+		static constexpr uint32_t DATA_MAX  = SEG_SIZE - HEAD_SIZE - REC_SIZE;	///< データ長の最大
+		static constexpr uint16_t KEY_NONE  = 0xffff;							///< 無効キー
+
+		static_assert(KEYN >= 2 && (KEYN & (KEYN - 1)) == 0, "KEYN must be a power of two.");
+		static_assert(SEG_SIZE <= 65535, "SEGB is too large.");
+		static_assert(SEG_NUM >= 3, "At least three segments are required.");
 
-		FIO&	fio_;
+	private:
+		static constexpr uint32_t MAGIC     = 0x3153564b;	// "KVS1"
+		static constexpr uint32_t INDEX_NUM = KEYN * 2;
+		static constexpr uint32_t RESERVE   = 1;	///< GC 用に残す空きセグメント数
+		static constexpr uint32_t GC_LOW    = 2;	///< バックグラウンド GC を始める空きセグメント数
+		static constexpr uint32_t WEAR_GAP  = 256;	///< 静的ウェアレベリングを行う消去回数の差
+
+		enum class seg_state : uint8_t {
+			DIRTY,		///< ヘッダーが無効（消去が必要）
+			OPEN,		///< 追記可能
+			SEALED,		///< 追記不可
+		};
 
-		// 制限：　１ファイル、最大３２Ｋバイトまで
-		struct head_t {
-			uint16_t	id;		///< file ID
-			uint16_t	nx_sz;	///< (B15:1)next block, (B15:0)total size
+		struct seg_t {
+			uint32_t	ecnt;	///< 消去回数
+			uint16_t	end;	///< 有効なレコードの終端
+			uint16_t	live;	///< 索引から参照されているバイト数
+			seg_state	state;
 		};
 
+		struct index_t {
+			uint16_t	key;
+			uint16_t	len;
+			uint32_t	addr;
+			uint32_t	seq;
+		};
+
+		FIO&		fio_;
+
+		seg_t		seg_[SEG_NUM];
+		index_t		index_[INDEX_NUM];
+
+		uint32_t	seq_;
+		uint32_t	max_ecnt_;
+		uint32_t	active_;
+
+		uint32_t	gc_seg_;	///< 回収中のセグメント（SEG_NUM で無し）
+		uint32_t	gc_pos_;
+		uint32_t	gc_blk_;	///< 消去中のブロック（SEGB で無し）
+
+		bool		mount_;
+
+		static uint32_t crc_(uint32_t crc, const void* src, uint32_t len) noexcept
+		{
+			static constexpr uint32_t tbl[16] = {
+				0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+				0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+				0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+				0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+			};
+			const uint8_t* p = static_cast<const uint8_t*>(src);
+			while(len > 0) {
+				crc ^= *p++;
+				crc = (crc >> 4) ^ tbl[crc & 15];
+				crc = (crc >> 4) ^ tbl[crc & 15];
+				--len;
+			}
+			return crc;
+		}
+
+		static uint32_t total_(uint32_t len) noexcept { return REC_SIZE + ((len + 3) & ~3); }
+
+		static uint32_t base_(uint32_t seg) noexcept { return seg * SEG_SIZE; }
+
+		static uint32_t hash_(uint16_t key) noexcept
+		{
+			return (static_cast<uint32_t>(key) * 0x9E3779B1) >> 16;
+		}
+
+		uint32_t find_(uint16_t key) const noexcept
+		{
+			auto i = hash_(key);
+			for(uint32_t n = 0; n < INDEX_NUM; ++n) {
+				i &= INDEX_NUM - 1;
+				if(index_[i].key == key) return i;
+				if(index_[i].key == KEY_NONE) break;
+				++i;
+			}
+			return INDEX_NUM;
+		}
+
+		uint32_t insert_(uint16_t key) noexcept
+		{
+			auto i = hash_(key);
+			for(uint32_t n = 0; n < INDEX_NUM; ++n) {
+				i &= INDEX_NUM - 1;
+				if(index_[i].key == key) return i;
+				if(index_[i].key == KEY_NONE) {
+					index_[i].key = key;
+					index_[i].len = 0;
+					index_[i].addr = 0;
+					index_[i].seq = 0;
+					return i;
+				}
+				++i;
+			}
+			return INDEX_NUM;
+		}
+
+		// 索引から削除（後ろの要素を詰めて、探索が途切れないようにする）
+		void erase_(uint32_t i) noexcept
+		{
+			auto& t = index_[i];
+			if(t.seq != 0) {
+				seg_[t.addr / SEG_SIZE].live -= total_(t.len);
+			}
+			auto j = i;
+			while(1) {
+				j = (j + 1) & (INDEX_NUM - 1);
+				if(j == i || index_[j].key == KEY_NONE) break;
+				auto h = hash_(index_[j].key) & (INDEX_NUM - 1);
+				// 本来の位置が (i, j] にある要素はそのまま
+				if(i <= j ? (i < h && h <= j) : (i < h || h <= j)) continue;
+				index_[i] = index_[j];
+				i = j;
+			}
+			index_[i].key = KEY_NONE;
+		}
+
+		uint32_t key_num_() const noexcept
+		{
+			uint32_t n = 0;
+			for(uint32_t i = 0; i < INDEX_NUM; ++i) {
+				if(index_[i].key != KEY_NONE) ++n;
+			}
+			return n;
+		}
+
+		// 索引に削除レコードがあるか？（seg が有効なら、そのセグメント内に限る）
+		bool tomb_(uint32_t seg = SEG_NUM) const noexcept
+		{
+			for(uint32_t i = 0; i < INDEX_NUM; ++i) {
+				const auto& t = index_[i];
+				if(t.key == KEY_NONE || t.len != 0) continue;
+				if(seg >= SEG_NUM || (t.addr / SEG_SIZE) == seg) return true;
+			}
+			return false;
+		}
+
+		// 索引の付け替え（参照バイト数も更新）
+		void link_(index_t& t, uint16_t len, uint32_t addr, uint32_t seq) noexcept
+		{
+			if(t.seq != 0) {
+				seg_[t.addr / SEG_SIZE].live -= total_(t.len);
+			}
+			t.len = len;
+			t.addr = addr;
+			t.seq = seq;
+			seg_[addr / SEG_SIZE].live += total_(len);
+		}
+
+		// ブロック境界を跨がないように消去チェック
+		bool blank_(uint32_t org, uint32_t len) noexcept
+		{
+			while(len > 0) {
+				uint32_t n = FIO::DATA_BLOCK_SIZE - (org % FIO::DATA_BLOCK_SIZE);
+				if(n > len) n = len;
+				if(!fio_.erase_check(org, n)) return false;
+				org += n;
+				len -= n;
+			}
+			return true;
+		}
+
+		bool write_head_(uint32_t seg) noexcept
+		{
+			uint32_t h[3] = { MAGIC, seg_[seg].ecnt, ~seg_[seg].ecnt };
+			if(!fio_.write(base_(seg), h, sizeof(h))) {
+				seg_[seg].state = seg_state::DIRTY;
+				return false;
+			}
+			seg_[seg].end = HEAD_SIZE;
+			seg_[seg].live = 0;
+			seg_[seg].state = seg_state::OPEN;
+			return true;
+		}
+
+		// ブロックを後ろから消去する（ヘッダーのあるブロックが最後）
+		bool erase_block_(uint32_t seg, uint32_t blk) noexcept
+		{
+			uint32_t org = base_(seg) + blk * FIO::DATA_BLOCK_SIZE;
+			if(fio_.erase_check(org)) return true;
+			return fio_.erase(org);
+		}
+
+		bool erase_seg_(uint32_t seg) noexcept
+		{
+			seg_[seg].state = seg_state::DIRTY;
+			for(uint32_t i = 0; i < SEGB; ++i) {
+				if(!erase_block_(seg, SEGB - 1 - i)) return false;
+			}
+			++seg_[seg].ecnt;
+			if(seg_[seg].ecnt > max_ecnt_) max_ecnt_ = seg_[seg].ecnt;
+			return write_head_(seg);
+		}
+
+		bool is_free_(uint32_t seg) const noexcept
+		{
+			if(seg == active_ || seg == gc_seg_) return false;
+			if(seg_[seg].state == seg_state::DIRTY) return true;
+			return seg_[seg].state == seg_state::OPEN && seg_[seg].end == HEAD_SIZE;
+		}
+
+		uint32_t free_num_() const noexcept
+		{
+			uint32_t n = 0;
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				if(is_free_(i)) ++n;
+			}
+			return n;
+		}
+
+		// 次の空きセグメントを巡回して選ぶ
+		bool alloc_() noexcept
+		{
+			for(uint32_t i = 1; i <= SEG_NUM; ++i) {
+				auto s = (active_ + i) % SEG_NUM;
+				if(!is_free_(s)) continue;
+				if(seg_[s].state == seg_state::DIRTY) {
+					if(!erase_seg_(s)) continue;
+				}
+				if(active_ < SEG_NUM && seg_[active_].state == seg_state::OPEN) {
+					seg_[active_].state = seg_state::SEALED;
+				}
+				active_ = s;
+				return true;
+			}
+			return false;
+		}
+
+		// アクティブ・セグメントに len バイトの空きを確保（GC からも使う）
+		bool room_(uint32_t len, bool gc) noexcept
+		{
+			if(active_ < SEG_NUM && seg_[active_].state == seg_state::OPEN
+				&& (seg_[active_].end + len) <= SEG_SIZE) {
+				return true;
+			}
+			if(!gc && free_num_() <= RESERVE) return false;
+			return alloc_();
+		}
+
+		bool write_rec_(uint32_t org, uint16_t key, const void* src, uint16_t len, uint32_t seq) noexcept
+		{
+			uint32_t h[2] = { static_cast<uint32_t>(key) | (static_cast<uint32_t>(len) << 16), seq };
+			uint32_t crc = crc_(0xffffffff, h, sizeof(h));
+			crc = ~crc_(crc, src, len);
+
+			if(!fio_.write(org, h, sizeof(h))) return false;
+			org += sizeof(h);
+			uint32_t n = len & ~3;
+			if(n > 0) {
+				if(!fio_.write(org, src, n)) return false;
+				org += n;
+			}
+			if(len & 3) {
+				uint8_t tmp[4] = { 0xff, 0xff, 0xff, 0xff };
+				std::memcpy(tmp, static_cast<const uint8_t*>(src) + n, len & 3);
+				if(!fio_.write(org, tmp, 4)) return false;
+				org += 4;
+			}
+			return fio_.write(org, &crc, 4);
+		}
+
+		// レコードの検証（有効ならヘッダーを返す）
+		bool check_rec_(uint32_t org, uint32_t lim, uint32_t h[2]) noexcept
+		{
+			if((org + REC_SIZE) > lim) return false;
+			if(!fio_.read(org, h, 8)) return false;
+			uint16_t key = h[0] & 0xffff;
+			uint32_t len = h[0] >> 16;
+			if(key == KEY_NONE || len > DATA_MAX || (org + total_(len)) > lim) return false;
+
+			uint32_t crc = crc_(0xffffffff, h, 8);
+			uint32_t pos = org + 8;
+			while(len > 0) {
+				uint8_t tmp[32];
+				uint32_t n = len > sizeof(tmp) ? sizeof(tmp) : len;
+				if(!fio_.read(pos, tmp, n)) return false;
+				crc = crc_(crc, tmp, n);
+				pos += n;
+				len -= n;
+			}
+			pos = (pos + 3) & ~3;
+			uint32_t c;
+			if(!fio_.read(pos, &c, 4)) return false;
+			return c == ~crc;
+		}
+
+		void scan_seg_(uint32_t seg, uint32_t& last) noexcept
+		{
+			auto& t = seg_[seg];
+			auto org = base_(seg);
+			uint32_t h[3];
+			if(!fio_.read(org, h, sizeof(h)) || h[0] != MAGIC || h[1] != ~h[2]) {
+				t.ecnt = 0;  // 不明な場合は、マウント後に最大値とする
+				t.end = HEAD_SIZE;
+				t.state = seg_state::DIRTY;
+				return;
+			}
+			t.ecnt = h[1];
+			if(t.ecnt > max_ecnt_) max_ecnt_ = t.ecnt;
 
-		uint32_t free_()
+			uint32_t pos = HEAD_SIZE;
+			while(pos < SEG_SIZE) {
+				uint32_t r[2];
+				if(!check_rec_(org + pos, org + SEG_SIZE, r)) break;
+				uint16_t key = r[0] & 0xffff;
+				uint16_t len = r[0] >> 16;
+				auto idx = insert_(key);
+				if(idx < INDEX_NUM) {
+					auto& e = index_[idx];
+					if(e.seq == 0 || static_cast<int32_t>(r[1] - e.seq) > 0) {
+						link_(e, len, org + pos, r[1]);
+					}
+				}
+				if(static_cast<int32_t>(r[1] - seq_) >= 0) {
+					seq_ = r[1] + 1;
+					last = seg;
+				}
+				pos += total_(len);
+			}
+			t.end = pos;
+			// 残りが消去状態なら追記可能
+			if(pos < SEG_SIZE && blank_(org + pos, SEG_SIZE - pos)) {
+				t.state = seg_state::OPEN;
+			} else {
+				t.state = seg_state::SEALED;
+			}
+		}
+
+		// 削除レコード（org）より古い、同じキーのレコードが残っているか？
+		bool older_(uint16_t key, uint32_t org) noexcept
 		{
-			uint32_t pos = 0;
-			while(pos < FIO::data_flash_size) {
-				if(fio_.erase_check(pos)) {
-					return pos;
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				if(seg_[i].state == seg_state::DIRTY) continue;
+				auto base = base_(i);
+				uint32_t pos = HEAD_SIZE;
+				while(pos < seg_[i].end) {
+					uint32_t h;
+					if(!fio_.read(base + pos, &h, 4)) return true;
+					uint32_t len = h >> 16;
+					if(len > DATA_MAX) break;
+					if((h & 0xffff) == key && (base + pos) != org) return true;
+					pos += total_(len);
 				}
-				pos += FIO::data_flash_block;
 			}
-			return FIO::data_flash_size;
+			return false;
 		}
 
+		// 回収するセグメントを選ぶ
+		uint32_t victim_(bool wear) const noexcept
+		{
+			// 空きセグメントが無い場合、有効なレコードがアクティブ・セグメントに収まる事
+			uint32_t room = SEG_SIZE;
+			if(free_num_() == 0) {
+				room = 0;
+				if(active_ < SEG_NUM && seg_[active_].state == seg_state::OPEN) {
+					room = SEG_SIZE - seg_[active_].end;
+				}
+			}
+			uint32_t seg = SEG_NUM;
+			uint32_t best = 0;
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				if(i == active_ || seg_[i].state != seg_state::SEALED) continue;
+				if(seg_[i].live > room) continue;
+				if(wear) {
+					// 書き換えの無いデータが、消去回数の少ないセグメントを占有している
+					if((max_ecnt_ - seg_[i].ecnt) > WEAR_GAP) return i;
+				} else {
+					// 回収量が同じなら、消去回数の少ない方
+					uint32_t dead = SEG_SIZE - HEAD_SIZE - seg_[i].live;
+					if(dead > best || (dead == best && seg < SEG_NUM && seg_[i].ecnt < seg_[seg].ecnt)) {
+						best = dead;
+						seg = i;
+					}
+				}
+			}
+			return seg;
+		}
 
-		uint32_t scan_(uint16_t id) const
+		// GC を１ステップ進める（レコード１個のコピー、又はブロック１個の消去）
+		bool gc_step_(bool wear) noexcept
 		{
-			uint32_t pos = 0;
-			uint32_t match = FIO::data_flash_size;
-			while(pos < FIO::data_flash_size) {
-				uint32_t d = FIO::data_flash_block;
-				if(!fio_.erase_check(pos)) {
-					head_t h;
-					fio_.read(pos, &h, sizeof(head_t));
-					if(h.id == id) {
-						match = pos;
-						uint16_t s = h.size;
-						d = s / (FIO::data_flash_block - sizeof(head_t));
-						if(d == 0) ++d;
-						d *= FIO::data_flash_block;
+			if(gc_seg_ >= SEG_NUM) {
+				gc_seg_ = victim_(wear);
+				if(gc_seg_ >= SEG_NUM) return false;
+				gc_pos_ = HEAD_SIZE;
+				gc_blk_ = SEGB;
+			}
+
+			auto org = base_(gc_seg_);
+			if(gc_pos_ < seg_[gc_seg_].end) {
+				uint32_t h[2];
+				if(!fio_.read(org + gc_pos_, h, 8)) return false;
+				uint16_t key = h[0] & 0xffff;
+				uint16_t len = h[0] >> 16;
+				auto tot = total_(len);
+				auto idx = find_(key);
+				if(idx < INDEX_NUM && index_[idx].addr == (org + gc_pos_)) {
+					// 古いレコードが無い削除レコードは、コピーせずに索引から外す
+					// ※同じセグメントに古いレコードがあると、消去途中の電源断で復活するので残す
+					if(len == 0 && !older_(key, org + gc_pos_)) {
+						erase_(idx);
+						gc_pos_ += tot;
+						return true;
 					}
+					if(!room_(tot, true)) return false;
+					auto dst = base_(active_) + seg_[active_].end;
+					// レコードをそのまま（シーケンス番号も同じ）コピー
+					for(uint32_t n = 0; n < tot; ) {
+						uint8_t tmp[32];
+						uint32_t l = (tot - n) > sizeof(tmp) ? sizeof(tmp) : (tot - n);
+						if(!fio_.read(org + gc_pos_ + n, tmp, l)) {
+							// 途中までコピーした場合、アクティブ・セグメントは閉じる
+							if(n > 0) seg_[active_].state = seg_state::SEALED;
+							return false;
+						}
+						if(!fio_.write(dst + n, tmp, l)) {
+							seg_[active_].state = seg_state::SEALED;
+							return false;
+						}
+						n += l;
+					}
+					seg_[active_].end += tot;
+					link_(index_[idx], len, dst, index_[idx].seq);
 				}
-				pos += d;
+				gc_pos_ += tot;
+				return true;
+			}
+
+			// 全てコピーしたら、後ろのブロックから消去
+			if(gc_blk_ >= SEGB) {
+				seg_[gc_seg_].state = seg_state::DIRTY;
+				gc_blk_ = 0;
+			}
+			if(!erase_block_(gc_seg_, SEGB - 1 - gc_blk_)) return false;
+			++gc_blk_;
+			if(gc_blk_ < SEGB) return true;
+
+			auto& t = seg_[gc_seg_];
+			++t.ecnt;
+			if(t.ecnt > max_ecnt_) max_ecnt_ = t.ecnt;
+			write_head_(gc_seg_);
+			gc_seg_ = SEG_NUM;
+			return true;
+		}
+
+		bool gc_run_() noexcept
+		{
+			bool ret = false;
+			do {
+				if(!gc_step_(false)) return ret;
+				ret = true;
+			} while(gc_seg_ < SEG_NUM) ;
+			return ret;
+		}
+
+		// 索引が一杯の場合、削除レコードを GC で回収する
+		bool reclaim_() noexcept
+		{
+			if(gc_seg_ >= SEG_NUM && victim_(false) >= SEG_NUM) {
+				// 回収できるセグメントが無い場合、アクティブ・セグメントを閉じる
+				// ※アクティブ・セグメントに削除レコードが無ければ、閉じても索引は空かない
+				if(active_ >= SEG_NUM || seg_[active_].end == HEAD_SIZE || !tomb_(active_)) return false;
+				if(free_num_() <= RESERVE || !alloc_()) return false;
 			}
-			return match;
+			return gc_run_();
 		}
 
+		bool append_(uint16_t key, const void* src, uint16_t len) noexcept
+		{
+			if(!mount_ || key == KEY_NONE) return false;
+
+			auto idx = find_(key);
+			if(idx >= INDEX_NUM) {
+				if(len == 0) return true;  // 削除済み
+				// 削除レコードが無ければ、GC しても索引は空かない
+				if(key_num_() >= KEYN && !tomb_()) return false;
+				uint32_t n = 0;
+				while(key_num_() >= KEYN) {
+					if(n >= SEG_NUM || !reclaim_()) return false;
+					++n;
+				}
+			}
+
+			auto tot = total_(len);
+			uint32_t n = 0;
+			while(!room_(tot, false)) {
+				if(n >= SEG_NUM || !gc_run_()) return false;
+				++n;
+			}
+
+			idx = insert_(key);
+			if(idx >= INDEX_NUM) return false;
+
+			auto org = base_(active_) + seg_[active_].end;
+			if(!write_rec_(org, key, src, len, seq_)) {
+				seg_[active_].state = seg_state::SEALED;
+				seg_[active_].end = SEG_SIZE;
+				return false;
+			}
+			seg_[active_].end += tot;
+			link_(index_[idx], len, org, seq_);
+			++seq_;
+			return true;
+		}
 
 	public:
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  コンストラクタ
+			@param[in]	fio		フラッシュ I/O
 		*/
 		//-----------------------------------------------------------------//
-		flash_man(FIO& fio) : fio_(fio) { }
+		flash_man(FIO& fio) : fio_(fio), seg_{ }, index_{ }, seq_(1), max_ecnt_(0),
+			active_(SEG_NUM), gc_seg_(SEG_NUM), gc_pos_(0), gc_blk_(SEGB), mount_(false) { }
 
 
 		//-----------------------------------------------------------------//
@@ -91,77 +584,205 @@ namespace utils {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  フリー領域の取得
-			@return フリー領域の取得
+			@brief  マウント（全セグメントを１回走査して、索引を作る）
+			@return 常に「true」
 		*/
 		//-----------------------------------------------------------------//
-		uint32_t get_free() const {
-			uint32_t space = 0;
-			for(uint32_t i = 0; i < FIO::data_flash_bank; ++i) {
-				if(fio_.erase_check(i)) {
-					space += FIO::data_flash_block - sizeof(head_t);
+		bool mount()
+		{
+			for(uint32_t i = 0; i < INDEX_NUM; ++i) {
+				index_[i].key = KEY_NONE;
+			}
+			seq_ = 1;
+			max_ecnt_ = 0;
+			active_ = SEG_NUM;
+			gc_seg_ = SEG_NUM;
+			gc_blk_ = SEGB;
+
+			uint32_t last = SEG_NUM;
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				seg_[i].live = 0;
+			}
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				scan_seg_(i, last);
+			}
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				if(seg_[i].state == seg_state::DIRTY) seg_[i].ecnt = max_ecnt_;
+			}
+
+			// 最後に書き込んだセグメントへ追記を続ける
+			if(last < SEG_NUM && seg_[last].state == seg_state::OPEN) {
+				active_ = last;
+			} else {
+				// 空きが無い場合は、GC で空きができるまで追記できない
+				active_ = last < SEG_NUM ? last : SEG_NUM - 1;
+				alloc_();
+			}
+			// 途中まで使ったその他のセグメントは追記しない
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				if(i != active_ && seg_[i].state == seg_state::OPEN && seg_[i].end > HEAD_SIZE) {
+					seg_[i].state = seg_state::SEALED;
 				}
 			}
-			return space;
+
+			mount_ = true;
+			return true;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  ファイルがあるか？
-			@param[in]	id	ファイルＩＤ
-			@return ある場合「true」
+			@brief  フォーマット（全消去してマウント）
+			@return エラーなら「false」
 		*/
 		//-----------------------------------------------------------------//
-		bool probe(uint16_t id) const
+		bool format()
 		{
-			return scan_(id) < FIO::data_flash_size;
+			mount_ = false;
+			// 消去回数は引き継ぐ
+			max_ecnt_ = 0;
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				uint32_t h[3];
+				if(fio_.read(base_(i), h, sizeof(h)) && h[0] == MAGIC && h[1] == ~h[2]) {
+					seg_[i].ecnt = h[1];
+				} else {
+					seg_[i].ecnt = 0;
+				}
+				if(seg_[i].ecnt > max_ecnt_) max_ecnt_ = seg_[i].ecnt;
+			}
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				if(!erase_seg_(i)) return false;
+			}
+			return mount();
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  書き込み
-			@param[in]	id		ＩＤ
-			@param[in]	src		ソース
-			@param[in]	size	サイズ（バイト）
-			@return エラーなら「false」
+			@brief  バックグラウンド処理（GC を１ステップ進める） @n
+					※メインループなどから定期的に呼ぶ
 		*/
 		//-----------------------------------------------------------------//
-		bool write(uint16_t id, const void* src, uint32_t size)
+		void service()
 		{
-			uint32_t pos = free_();
-			if(pos >= FIO::data_flash_size) {
-				return false;
+			if(!mount_) return;
+
+			if(gc_seg_ < SEG_NUM) {
+				gc_step_(false);
+				return;
 			}
-			uint32_t fsb = (FIO::data_flash_size - pos) / FIO::data_flash_block;
-			uint32_t fs  = fsb * (FIO::data_flash_block - sizeof(head_t));
-			if(fs < size) {
-				return false;
+			if(free_num_() <= GC_LOW && gc_step_(false)) return;
+			gc_step_(true);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  フリー領域の取得
+			@return 書き込めるバイト数（回収可能な領域を含む）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_free() const {
+			uint32_t used = 0;
+			for(uint32_t i = 0; i < SEG_NUM; ++i) {
+				used += seg_[i].live;
 			}
+			uint32_t space = (SEG_NUM - RESERVE) * (SEG_SIZE - HEAD_SIZE);
+			return space > used ? space - used : 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  キーがあるか？
+			@param[in]	key	キー
+			@return ある場合「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool probe(uint16_t key) const
+		{
+			auto idx = find_(key);
+			return idx < INDEX_NUM && index_[idx].len > 0;
+		}
 
-			head_t t;
-			t.id = id;
-//			t.size = 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  データ長の取得
+			@param[in]	key	キー
+			@return データ長（無い場合０）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_length(uint16_t key) const
+		{
+			auto idx = find_(key);
+			if(idx >= INDEX_NUM) return 0;
+			return index_[idx].len;
+		}
 
 
-			return false;
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  書き込み
+			@param[in]	key		キー
+			@param[in]	src		ソース
+			@param[in]	size	サイズ（バイト、１～DATA_MAX）
+			@return エラーなら「false」
+		*/
+		//-----------------------------------------------------------------//
+		bool write(uint16_t key, const void* src, uint32_t size)
+		{
+			if(src == nullptr || size == 0 || size > DATA_MAX) return false;
+
+			return append_(key, src, size);
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  読み込み
-			@param[in]	id		ＩＤ
-			@param[in]	dst		転送先
+			@param[in]	key		キー
+			@param[out]	dst		転送先
 			@param[in]	size	サイズ（バイト）
+			@return 読み込んだバイト数（無い場合０）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t read(uint16_t key, void* dst, uint32_t size)
+		{
+			auto idx = find_(key);
+			if(idx >= INDEX_NUM || dst == nullptr) return 0;
+			const auto& t = index_[idx];
+			if(size > t.len) size = t.len;
+			if(size == 0) return 0;
+			if(!fio_.read(t.addr + 8, dst, size)) return 0;
+			return size;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  削除
+			@param[in]	key		キー
 			@return エラーなら「false」
 		*/
 		//-----------------------------------------------------------------//
-		bool read(int desc, void* dst, uint32_t size)
+		bool remove(uint16_t key)
 		{
-			return false;
+			return append_(key, nullptr, 0);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  セグメントの消去回数を取得
+			@param[in]	seg		セグメント
+			@return 消去回数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_erase_count(uint32_t seg) const
+		{
+			if(seg >= SEG_NUM) return 0;
+			return seg_[seg].ecnt;
 		}
 	};
 }
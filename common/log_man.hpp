@@ -2,9 +2,12 @@
 //=====================================================================//
 /*!	@file
 	@brief	ログ・マネージャー・クラス @n
-			・バックアップ可能な、領域を使ったログメモリー
+			・バックアップ可能な、領域を使ったログメモリー @n
+			・追加文字は RAM にバッファリングし、行単位、又は、一定時間毎に書き込む @n
+			・管理ヘッダーは、シーケンス番号付きで複数スロットに順番に書き込む @n
+			（書き込み中の電源断でも、一つ前のヘッダーで復帰する）
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2017 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2017, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -17,21 +20,83 @@ namespace utils {
     /*!
         @brief  log_man クラス
 		@param[in]	MEMIO	メモリー入出力
+		@param[in]	BUFF	追加文字のバッファサイズ
+		@param[in]	SLOT	管理ヘッダーのスロット数
     */
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class MEMIO>
+	template <class MEMIO, uint32_t BUFF = 64, uint32_t SLOT = 4>
 	class log_man {
 
-		static constexpr uint32_t offset_ = 8;
-		static constexpr uint32_t uniq_id_ = 0x1a3c5976;  // 初期化判定ユニークコード
+		static constexpr uint32_t uniq_id_ = 0x1a3c5977;  // 初期化判定ユニークコード
 
 		struct area_t {
 			uint32_t	id_;
+			uint32_t	seq_;	///< シーケンス番号（コミット毎に増加）
 			uint16_t	pos_;
 			uint16_t	len_;
+			uint32_t	sum_;	///< チェック・サム
 		};
 
+		static constexpr uint32_t TOP   = sizeof(area_t) * SLOT;	///< データ領域の先頭
+		static constexpr uint32_t LIMIT = MEMIO::SIZE - TOP;		///< データ領域のサイズ
+		static constexpr uint32_t MAX_LEN = LIMIT - BUFF;		///< 記録長の上限（未コミット分を重ねない）
+
+		static_assert(SLOT > 0, "log_man: SLOT must be one or more");
+		static_assert(MEMIO::SIZE > (TOP + BUFF), "log_man: MEMIO area too small");
+		static_assert(LIMIT <= 65535, "log_man: MEMIO area too large");
+
 		area_t		area_;
+		char		buff_[BUFF];
+		uint16_t	bpos_;
+		uint16_t	interval_;
+		uint16_t	count_;
+		uint32_t	commit_;
+
+		static uint32_t sum_(const area_t& a) noexcept
+		{
+			uint32_t s = a.id_ ^ 0x5a5a'a5a5;
+			s = (s << 5) ^ (s >> 27) ^ a.seq_;
+			s = (s << 5) ^ (s >> 27) ^ ((static_cast<uint32_t>(a.pos_) << 16) | a.len_);
+			return s;
+		}
+
+
+		// データ領域へ書き込み（リングの折り返しを考慮）
+		static void write_(uint16_t pos, const char* src, uint32_t len) noexcept
+		{
+			while(len > 0) {
+				uint32_t n = LIMIT - pos;
+				if(n > len) n = len;
+				MEMIO::copy(src, n, TOP + pos);
+				src += n;
+				len -= n;
+				pos = 0;
+			}
+		}
+
+
+		// データ領域から読み出し（リングの折り返しを考慮）
+		static void read_(uint16_t pos, char* dst, uint32_t len) noexcept
+		{
+			while(len > 0) {
+				uint32_t n = LIMIT - pos;
+				if(n > len) n = len;
+				MEMIO::copy(TOP + pos, n, dst);
+				dst += n;
+				len -= n;
+				pos = 0;
+			}
+		}
+
+
+		// ヘッダーを次のスロットへ書き込む
+		void commit_area_() noexcept
+		{
+			++area_.seq_;
+			area_.sum_ = sum_(area_);
+			MEMIO::copy(&area_, sizeof(area_t), (area_.seq_ % SLOT) * sizeof(area_t));
+			++commit_;
+		}
 
 	public:
         //-----------------------------------------------------------------//
@@ -39,7 +104,7 @@ namespace utils {
             @brief  コンストラクター
         */
         //-----------------------------------------------------------------//
-		log_man() noexcept { }
+		log_man() noexcept : area_(), buff_{ }, bpos_(0), interval_(0), count_(0), commit_(0) { }
 
 
         //-----------------------------------------------------------------//
@@ -52,24 +117,42 @@ namespace utils {
 			area_.id_ = uniq_id_;
 			area_.pos_ = 0;
 			area_.len_ = 0;
-			MEMIO::copy(&area_, sizeof(area_t), 0x0000);
+			bpos_ = 0;
+			// 全スロットを書き換えて、古いヘッダーを無効にする
+			for(uint32_t i = 0; i < SLOT; ++i) {
+				commit_area_();
+			}
 		}
 
 
         //-----------------------------------------------------------------//
         /*!
             @brief  開始 @n
-					※ワークメモリーが無効状態なら初期化する。
+					※全スロットから、有効で最も新しいヘッダーを選ぶ。@n
+					※有効なヘッダーが無ければ初期化する。
 			@return ワークメモリーが有効なら「true」
         */
         //-----------------------------------------------------------------//
 		bool start() noexcept
 		{
 			MEMIO::start();
-			MEMIO::copy(0x0000, sizeof(area_t), &area_);
-			if(area_.id_ == uniq_id_) {
+			bpos_ = 0;
+			count_ = 0;
+			bool valid = false;
+			for(uint32_t i = 0; i < SLOT; ++i) {
+				area_t a;
+				MEMIO::copy(i * sizeof(area_t), sizeof(area_t), &a);
+				if(a.id_ != uniq_id_ || a.sum_ != sum_(a)) continue;
+				if(a.pos_ >= LIMIT || a.len_ > MAX_LEN) continue;
+				if(!valid || static_cast<int32_t>(a.seq_ - area_.seq_) > 0) {
+					area_ = a;
+					valid = true;
+				}
+			}
+			if(valid) {
 				return true;
 			}
+			area_.seq_ = 0;
 			clear();
 			return false;
 		}
@@ -77,19 +160,65 @@ namespace utils {
 
         //-----------------------------------------------------------------//
         /*!
-            @brief  文字追加
+            @brief  コミット間隔の設定 @n
+					※ service() の呼び出し回数で指定、０で無効
+			@param[in]	interval	コミット間隔
+        */
+        //-----------------------------------------------------------------//
+		void set_interval(uint16_t interval) noexcept { interval_ = interval; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  バッファリングされた文字を書き込み、ヘッダーを更新
+        */
+        //-----------------------------------------------------------------//
+		void flush() noexcept
+		{
+			count_ = 0;
+			if(bpos_ == 0) return;
+
+			uint32_t len = bpos_;
+			write_(area_.pos_, buff_, len);
+			area_.pos_ = (area_.pos_ + len) % LIMIT;
+			len += area_.len_;
+			area_.len_ = len > MAX_LEN ? MAX_LEN : len;
+			bpos_ = 0;
+			commit_area_();
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  サービス（定期的に呼ぶ） @n
+					※設定間隔毎に、バッファリングされた文字をコミットする。
+        */
+        //-----------------------------------------------------------------//
+		void service() noexcept
+		{
+			if(interval_ == 0 || bpos_ == 0) return;
+
+			++count_;
+			if(count_ >= interval_) {
+				flush();
+			}
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  文字追加 @n
+					※改行、又は、バッファが一杯になるとコミットする。
 			@param[in]	ch	文字
         */
         //-----------------------------------------------------------------//
 		void putch(char ch) noexcept
 		{
-			MEMIO::put8(sizeof(area_t) + area_.pos_, ch);
-			++area_.pos_;
-			uint16_t limit = MEMIO::SIZE - sizeof(area_t);
-			if(area_.pos_ >= limit) area_.pos_ = 0;
-			++area_.len_;
-			if(area_.len_ > limit) area_.len_ = limit;
-			MEMIO::copy(&area_, sizeof(area_t), 0x0000);
+			buff_[bpos_] = ch;
+			++bpos_;
+			if(ch == '\n' || bpos_ >= BUFF) {
+				flush();
+			}
 		}
 
 
@@ -113,13 +242,22 @@ namespace utils {
 
         //-----------------------------------------------------------------//
         /*!
-            @brief  記録長の取得
+            @brief  記録長の取得（コミット済み）
 			@return 記録長
         */
         //-----------------------------------------------------------------//
 		uint16_t get_length() const noexcept { return area_.len_; }
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  ヘッダーのコミット回数を取得
+			@return コミット回数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t get_commit_count() const noexcept { return commit_; }
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  文字の取得
@@ -131,14 +269,54 @@ namespace utils {
 		{
 			if(area_.len_ == 0) return 0;
 
-			pos += area_.pos_ - area_.len_;
-			pos %= MEMIO::SIZE - sizeof(area_t);
+			pos = (pos + LIMIT + area_.pos_ - area_.len_) % LIMIT;
 			uint8_t data;
-			if(MEMIO::get8(pos + sizeof(area_t), data)) {
+			if(MEMIO::get8(pos + TOP, data)) {
 				return static_cast<char>(data);
 			} else {
 				return 0;
 			}
 		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  まとめて読み出し
+			@param[in]	pos	取得位置
+			@param[out]	dst	格納先
+			@param[in]	len	長さ
+			@return 読み出した長さ
+        */
+        //-----------------------------------------------------------------//
+		uint32_t read(uint16_t pos, char* dst, uint32_t len) const noexcept
+		{
+			if(dst == nullptr || pos >= area_.len_) return 0;
+
+			if(len > static_cast<uint32_t>(area_.len_ - pos)) len = area_.len_ - pos;
+			read_((pos + LIMIT + area_.pos_ - area_.len_) % LIMIT, dst, len);
+			return len;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  全記録を、ブロック単位で出力（SCI への出力など）
+			@param[in]	out	出力関数 void (const char* src, uint32_t len)
+			@return 出力した長さ
+        */
+        //-----------------------------------------------------------------//
+		template <class OUT>
+		uint32_t stream(OUT out) const noexcept
+		{
+			char tmp[BUFF];
+			uint32_t pos = 0;
+			while(pos < area_.len_) {
+				auto n = read(pos, tmp, sizeof(tmp));
+				if(n == 0) break;
+				out(tmp, n);
+				pos += n;
+			}
+			return pos;
+		}
 	};
 }
@@ -1,14 +1,17 @@
 #pragma once
 //=========================================================================//
 /*!	@file
-	@brief	モニター（メモリの読出し、書き込み）
+	@brief	モニター（メモリの読出し、書き込み） @n
+			・コマンドは command_dispatch で振り分け、ダンプは service 毎に @n
+			  １行ずつ出力する（メインループを止めない）。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2022 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2022, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=========================================================================//
 #include "common/command.hpp"
+#include "common/command_dispatch.hpp"
 #include "common/format.hpp"
 #include "common/input.hpp"
 #include "common/fixed_string.hpp"
@@ -41,8 +44,15 @@ namespace utils {
 		typedef command<256> CMD;
 		CMD 	cmd_;		
 
+		typedef command_dispatch<CMD, 10> DISP;
+		typedef typename DISP::RESULT RESULT;
+		DISP	disp_;
+
 		bool	init_;
 
+		uint32_t	dump_org_;
+		uint32_t	dump_end_;
+
 		uint32_t step_() const noexcept
 		{
 			switch(b_width_) {
@@ -114,9 +124,9 @@ namespace utils {
 			}
 		}
 
-		void dump_(uint32_t org, uint32_t end) const noexcept
+		// １行（１６バイト境界まで）をダンプして、次のアドレスを返す
+		uint32_t dump_line_(uint32_t org, uint32_t end) const noexcept
 		{
-			org &= mask_();
 			if((org & 0xf) != 0) {
 				utils::format("%08X:") % org;
 				for(uint32_t i = 0; i < (org & 0xf); ++i) {
@@ -126,7 +136,7 @@ namespace utils {
 					utils::format("   ");
 				}
 			}
-			while(org <= end) {
+			do {
 				if((org & 0xf) == 8) {
 					utils::format(" ");
 				} else if((org & 0xf) == 0) {
@@ -134,13 +144,9 @@ namespace utils {
 				}
 				data_(org);
 				org += step_();
-				if((org & 0xf) == 0) {
-					utils::format("\n");
-				}
-			}
-			if((org & 0xf) != 0) {
-				utils::format("\n");
-			}
+			} while(org <= end && (org & 0xf) != 0) ;
+			utils::format("\n");
+			return org;
 		}
 
 		void read_(uint32_t org) const noexcept
@@ -176,84 +182,17 @@ namespace utils {
 			LIST,
 		};
 
-	public:
-		//-----------------------------------------------------------------//
-		/*!
-			@brief  コンストラクター
-		*/
-		//-----------------------------------------------------------------//
-		monitor() noexcept :
-			sym_cnt_(0), sym_adr_{ 0 }, sym_str_{ },
-			b_width_(B_WIDTH::BYTE), address_(0),
-			cmd_(), init_(false)
-		{ }
-
-
-		//-----------------------------------------------------------------//
-		/*!
-			@brief  サービス（コマンド解析）
-		*/
-		//-----------------------------------------------------------------//
-		void service() noexcept
+		// 引数の解析（読み出し、書き込みは、ここで行う）
+		bool args_(const CMD& cmd, OPR opr, uint32_t& org, uint32_t& end) noexcept
 		{
-			if(!init_) {
-				init_ = true;
-				cmd_.set_prompt("# ");
-			}
-
-			if(!cmd_.service()) {
-				return;
-			}
-
-			uint32_t cmdn = cmd_.get_words();
-			if(cmdn == 0) return;
-
-			if(cmdn == 1 && cmd_.cmp_word(0, "help")) {
-				utils::format("d[ump] [org] [end]      Dump memory.\n");
-				utils::format("r[ead] [org]            Read memory.\n");
-				utils::format("w[rite] org data ...    Write memory.\n");
-				utils::format("bus [124]               Current bus width\n");
-//				utils::format("sym address name        Set symbol\n");
-//				utils::format("list [name] ...         List symbol\n");
-				return;
-			}
-
-			auto opr = OPR::NONE;
-			if(cmdn >= 1) {
-				if(cmd_.cmp_word(0, "dump")) {
-					opr = OPR::DUMP;
-				} else if(cmd_.cmp_word(0, "d")) {
-					opr = OPR::DUMP;
-				} else if(cmd_.cmp_word(0, "read")) {
-					opr = OPR::READ;
-				} else if(cmd_.cmp_word(0, "r")) {
-					opr = OPR::READ;
-				} else if(cmd_.cmp_word(0, "write")) {
-					opr = OPR::WRITE;
-				} else if(cmd_.cmp_word(0, "w")) {
-					opr = OPR::WRITE;
-				} else if(cmd_.cmp_word(0, "bus")) {
-					opr = OPR::BUS;
-//				} else if(cmd_.cmp_word(0, "sym")) {
-//					opr = OPR::SYM;
-//				} else if(cmd_.cmp_word(0, "list")) {
-//					opr = OPR::LIST;
-				}
-			}
-			if(opr == OPR::NONE) {
-				char tmp[256];
-				cmd_.get_word(0, tmp, sizeof(tmp));
-				utils::format("Monitor command: '%s' ?\n") % tmp;
-				return;
-			}
-
+			uint32_t cmdn = cmd.get_words();
 			uint32_t n = 1;
-			uint32_t org = address_;
-			uint32_t end = address_ + 16 - step_();
+			org = address_;
+			end = address_ + 16 - step_();
 			uint32_t m = 0;
 			while(n < cmdn) {
 				char tmp[64];
-				cmd_.get_word(n, tmp, sizeof(tmp));
+				cmd.get_word(n, tmp, sizeof(tmp));
 				uint32_t v = 0;
 				if((utils::input("%x", tmp) % v).status()) {
 					if(m == 0) {
@@ -281,7 +220,7 @@ namespace utils {
 					}
 				} else {
 					utils::format("Value: '%s' ?\n") % tmp;
-					return;
+					return false;
 				}
 				++n;
 			}
@@ -295,43 +234,133 @@ namespace utils {
 								m = 0;
 							}
 #endif
-			switch(opr) {
-			case OPR::DUMP:
+			return true;
+		}
+
+		RESULT dump_cmd_(const CMD& cmd, uint32_t& step) noexcept
+		{
+			if(step == 0) {
+				uint32_t org;
+				uint32_t end;
+				if(!args_(cmd, OPR::DUMP, org, end)) return RESULT::ERROR;
 				if(org > end) {
 					end = org + 16;
 				}
 				if((end & 0xf) != 0xf) {
 					end |= 0xf;
 				}
-				dump_(org, end);
+				dump_org_ = org & mask_();
+				dump_end_ = end;
 				address_ = end + step_();
-				break;
-			case OPR::READ:
-				if(cmdn == 1) {
-					read_(address_);
-					address_ += step_();
-				}
-				break;
-			case OPR::WRITE:
-				if(cmdn == 1) {
-					utils::format("Write param fail.\n");
-				}
-				break;
-			case OPR::BUS:
-				if(org == 1) b_width_ = B_WIDTH::BYTE;
-				else if(org == 2) b_width_ = B_WIDTH::WORD;
-				else if(org == 4) b_width_ = B_WIDTH::LONG;
-				else { 
-					utils::format("Bus width fail: %x\n") % org;
-				}
-				break;
-			case OPR::LIST:
-				if(cmdn == 1) {
-					list_();
+				step = 1;
+			}
+			dump_org_ = dump_line_(dump_org_, dump_end_);
+			if(dump_org_ > dump_end_ || dump_org_ == 0) return RESULT::DONE;
+			return RESULT::CONTINUE;
+		}
+
+		RESULT read_cmd_(const CMD& cmd) noexcept
+		{
+			uint32_t org;
+			uint32_t end;
+			if(!args_(cmd, OPR::READ, org, end)) return RESULT::ERROR;
+			if(cmd.get_words() == 1) {
+				read_(address_);
+				address_ += step_();
+			}
+			return RESULT::DONE;
+		}
+
+		RESULT write_cmd_(const CMD& cmd) noexcept
+		{
+			uint32_t org;
+			uint32_t end;
+			if(!args_(cmd, OPR::WRITE, org, end)) return RESULT::ERROR;
+			if(cmd.get_words() == 1) {
+				utils::format("Write param fail.\n");
+				return RESULT::ERROR;
+			}
+			return RESULT::DONE;
+		}
+
+		RESULT bus_cmd_(const CMD& cmd) noexcept
+		{
+			uint32_t org;
+			uint32_t end;
+			if(!args_(cmd, OPR::BUS, org, end)) return RESULT::ERROR;
+			if(org == 1) b_width_ = B_WIDTH::BYTE;
+			else if(org == 2) b_width_ = B_WIDTH::WORD;
+			else if(org == 4) b_width_ = B_WIDTH::LONG;
+			else { 
+				utils::format("Bus width fail: %x\n") % org;
+				return RESULT::ERROR;
+			}
+			return RESULT::DONE;
+		}
+
+		static void unknown_(const CMD& cmd) noexcept
+		{
+			char tmp[256];
+			cmd.get_word(0, tmp, sizeof(tmp));
+			utils::format("Monitor command: '%s' ?\n") % tmp;
+		}
+
+		void init_dispatch_() noexcept
+		{
+			auto dump = [this](const CMD& cmd, uint32_t& step) { return dump_cmd_(cmd, step); };
+			auto read = [this](const CMD& cmd, uint32_t& /* step */) { return read_cmd_(cmd); };
+			auto write = [this](const CMD& cmd, uint32_t& /* step */) { return write_cmd_(cmd); };
+			disp_.add("dump", dump);
+			disp_.add("d", dump);
+			disp_.add("read", read);
+			disp_.add("r", read);
+			disp_.add("write", write);
+			disp_.add("w", write);
+			disp_.add("bus", [this](const CMD& cmd, uint32_t& /* step */) { return bus_cmd_(cmd); });
+			disp_.add("help", [](const CMD& cmd, uint32_t& /* step */) {
+				if(cmd.get_words() != 1) {
+					unknown_(cmd);
+					return RESULT::ERROR;
 				}
-				break;
-			default:
-				break;
+				utils::format("d[ump] [org] [end]      Dump memory.\n");
+				utils::format("r[ead] [org]            Read memory.\n");
+				utils::format("w[rite] org data ...    Write memory.\n");
+				utils::format("bus [124]               Current bus width\n");
+//				utils::format("sym address name        Set symbol\n");
+//				utils::format("list [name] ...         List symbol\n");
+				return RESULT::DONE;
+			});
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		monitor() noexcept :
+			sym_cnt_(0), sym_adr_{ 0 }, sym_str_{ },
+			b_width_(B_WIDTH::BYTE), address_(0),
+			cmd_(), disp_(cmd_), init_(false), dump_org_(0), dump_end_(0)
+		{ }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  サービス（コマンド解析） @n
+					ダンプなどの長いコマンドは、呼ぶ毎に少しずつ実行する。
+		*/
+		//-----------------------------------------------------------------//
+		void service() noexcept
+		{
+			if(!init_) {
+				init_ = true;
+				cmd_.set_prompt("# ");
+				init_dispatch_();
+			}
+
+			if(!disp_.service()) {
+				unknown_(cmd_);
 			}
 		}
 	};
@@ -157,6 +157,15 @@ namespace mpfr {
 		auto get_rnd() const noexcept { return rnd_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief  double に変換（グラフの座標など、精度が不要な場合）
+			@return double 値
+		*/
+		//-----------------------------------------------------------------//
+		double get_double() const noexcept { return mpfr_get_d(t_, rnd_); }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief  円周率を取得
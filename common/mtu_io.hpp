@@ -709,37 +709,40 @@ namespace device {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief  位相係数モード開始（モード１）@n
-					・MTCLKA, MTCLKB に入力された位相の異なる信号でカウンター更新
-			@param[in]	ch		出力チャネル
-			@param[in]	level	割り込みレベル
+			@brief  位相計数モード開始（モード１）@n
+					・MTU1 は MTCLKA, MTCLKB、MTU2 は MTCLKC, MTCLKD に入力された @n
+					  位相の異なる信号（Ａ相、Ｂ相）の全エッジで TCNT を増減する。 @n
+					・TCNT は１６ビットで循環するので、上位は呼び出し側で拡張する。 @n
+					・端子は PSEL のオーダーで選択する。
 			@return 成功なら「true」
 		*/
 		//-----------------------------------------------------------------//
-		bool start_count_phase(typename MTUX::CHANNEL ch, ICU::LEVEL level = 0) noexcept
+		bool start_count_phase() noexcept
 		{
-			// 工事中
-			if(peripheral::MTU1 == MTUX::PERIPHERAL || peripheral::MTU2 == MTUX::PERIPHERAL) {
+			port_map_mtu::CHANNEL pha;
+			port_map_mtu::CHANNEL phb;
+			if(peripheral::MTU1 == MTUX::PERIPHERAL) {
+				pha = port_map_mtu::CHANNEL::CLK_A;
+				phb = port_map_mtu::CHANNEL::CLK_B;
+			} else if(peripheral::MTU2 == MTUX::PERIPHERAL) {
+				pha = port_map_mtu::CHANNEL::CLK_C;
+				phb = port_map_mtu::CHANNEL::CLK_D;
 			} else {
 				return false;
 			}
 
 			power_mgr::turn(MTUX::PERIPHERAL);
 
-			intr_level_ = level;
-#if 0
-			bool pena = (ot != OUTPUT_TYPE::NONE);
-			port_map_mtu::turn(MTUX::PERIPHERAL, MTUX::get_port_map_channel(ch), pena, PSEL);
-
-			set_output_type_(ch, ot, match);
+			if(!port_map_mtu::turn_clock(pha, true, PSEL) || !port_map_mtu::turn_clock(phb, true, PSEL)) {
+				power_mgr::turn(MTUX::PERIPHERAL, false);
+				return false;
+			}
 
-			set_TCR_(ch, dv);
-			MTUX::TMDR1.MD = 0b0100;  // 位相係数 mode 1
+			MTUX::enable(false);
+			MTUX::TIER = 0x00;
+			MTUX::TCR = 0x00;  // 位相計数モードではカウントクロックは無視される
+			MTUX::TMDR1.MD = 0b0100;  // 位相計数 mode 1
 
-			// 各チャネルに相当するジャネラルレジスタ
-			tt_.tgr_adr_ = MTUX::TGRA.address + static_cast<uint32_t>(ch) * 2;
-			wr16_(tt_.tgr_adr_, match - 1);
-#endif
 			MTUX::TCNT = 0;
 			MTUX::enable();
 
@@ -781,7 +784,7 @@ namespace device {
 //			icu_mgr::set_level(MTUX::get_vec(MTUX::interrupt::OVF), 0);
 //			port_map::turn(MTUX::PERIPHERAL, static_cast<port_map::channel>(ch), false);
 			power_mgr::turn(MTUX::PERIPHERAL, false);
-			intr_level_ = 0;
+			intr_level_ = ICU::LEVEL::NONE;
 		}
 
 
@@ -2,10 +2,15 @@
 //=====================================================================//
 /*!	@file
 	@brief	NMEA デコード・クラス（GPS 測位コードパース）@n
-			for GTPA013 @n
-			初期ボーレートは９６００で行う。
+			for GTPA013, u-blox @n
+			初期ボーレートは９６００で行う。@n
+			・SCI の FIFO から一文字ずつ、行バッファを使わずにデコードする。@n
+			・トーカー（GP/GL/GA/GB/GQ/GN）を問わず、GGA/RMC/GSV/VTG を処理する。@n
+			・チェックサムが一致したセンテンスだけを反映する。@n
+			・緯度、経度などは、固定小数点の数値に直接変換する。@n
+			・UBX-NAV-PVT（バイナリ）も受け付ける。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2016, 2019 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2016, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -29,9 +34,27 @@ namespace utils {
 
 		static constexpr uint32_t FAST_BAUDRATE = 57600;
 		static constexpr uint32_t UPDATE_FAST_RATE = 10;	///< 10Hz
+		static constexpr uint32_t LINE_MAX = 100;			///< センテンスの最大長（規格は８２）
 
 	public:
-		static constexpr uint32_t SINFO_MAX = 14;		///< 衛星情報の最大数
+		static constexpr uint32_t SINFO_MAX = 32;		///< 衛星情報の最大数
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  トーカー（測位システム）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		enum class TALKER : uint8_t {
+			NONE,	///< 無し
+			GP,		///< GPS
+			GL,		///< GLONASS
+			GA,		///< Galileo
+			GB,		///< BeiDou（GB, BD）
+			GQ,		///< QZSS（GQ, QZ）
+			GN,		///< 複合
+			OTHER,	///< その他
+		};
+
 
 		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 		/*!
@@ -39,45 +62,148 @@ namespace utils {
 		*/
 		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 		struct sat_info {
-			char	no_[4] ;  		///< 衛星番号
-			char	elv_[4];	///< 衛星仰角(Elevation)、０～９０度
-			char	azi_[4];	///< 衛星方位角(Azimuth)、０～３５９度
-			char	cn_[4];		///< キャリア／ノイズ比、０～９９dB
-
-			sat_info() {
-				no_[0] = 0;
-				elv_[0] = 0;
-				azi_[0] = 0;
-				cn_[0] = 0;
-			}
+			TALKER		talker_;	///< 測位システム
+			uint8_t		no_;		///< 衛星番号
+			uint8_t		elv_;		///< 衛星仰角(Elevation)、０～９０度
+			uint16_t	azi_;		///< 衛星方位角(Azimuth)、０～３５９度
+			uint8_t		cn_;		///< キャリア／ノイズ比、０～９９dB
+
+			sat_info() noexcept : talker_(TALKER::NONE), no_(0), elv_(0), azi_(0), cn_(0) { }
+		};
+
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  測位情報（固定小数点）
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct fix_t {
+			uint32_t	time_;		///< UTC 時間（０時からのミリ秒）
+			uint8_t		day_;		///< 日
+			uint8_t		mon_;		///< 月（１～１２）
+			uint8_t		year_;		///< 年（２０００年からの年数）
+			uint8_t		quality_;	///< 品質（０で無効）
+			int32_t		lat_;		///< 緯度（1e-7 度、南緯は負）
+			int32_t		lon_;		///< 経度（1e-7 度、西経は負）
+			int32_t		alt_;		///< 海抜高度（mm）
+			uint32_t	speed_;		///< 対地速度（mm/s）
+			uint32_t	course_;	///< 進行方向（1e-2 度）
+			uint16_t	hdop_;		///< 水平精度低下率（x100）
+			uint8_t		satellite_;	///< 使用衛星数
+			bool		valid_;		///< 測位が有効なら「true」
+
+			fix_t() noexcept : time_(0), day_(0), mon_(0), year_(0), quality_(0),
+				lat_(0), lon_(0), alt_(0), speed_(0), course_(0), hdop_(0),
+				satellite_(0), valid_(false) { }
 		};
 
 	private:
-		SCI_IO&		sci_;
+		enum class STATE : uint8_t {
+			WAIT,
+			NMEA,
+			SUM1,
+			SUM2,
+			UBX_SYNC,
+			UBX_CLASS,
+			UBX_ID,
+			UBX_LEN1,
+			UBX_LEN2,
+			UBX_PAYLOAD,
+			UBX_CKA,
+			UBX_CKB,
+		};
 
-		uint16_t	sci_errc_;
+		enum class SENT : uint8_t {
+			NONE,
+			GGA,
+			RMC,
+			GSV,
+			VTG,
+		};
+
+		struct sent_t {
+			char	name[4];
+			SENT	sent;
+		};
+
+		struct talker_t {
+			char	name[3];
+			TALKER	talker;
+		};
+
+		static constexpr sent_t sent_tbl_[] = {
+			{ "GGA", SENT::GGA },
+			{ "RMC", SENT::RMC },
+			{ "GSV", SENT::GSV },
+			{ "VTG", SENT::VTG },
+		};
+
+		static constexpr talker_t talker_tbl_[] = {
+			{ "GP", TALKER::GP },
+			{ "GL", TALKER::GL },
+			{ "GA", TALKER::GA },
+			{ "GB", TALKER::GB },
+			{ "BD", TALKER::GB },
+			{ "GQ", TALKER::GQ },
+			{ "QZ", TALKER::GQ },
+			{ "GN", TALKER::GN },
+		};
 
-		uint16_t	pos_;
-		char		line_[256];
+		SCI_IO&		sci_;
 
-		char		time_[12];  // 時間
-		char		lat_[12];   // 緯度(latitude)
-		char		ns_[2];     // 北緯、南緯
-		char		lon_[12];   // 経度(longitude)
-		char		ew_[2];     // 東経、西経
-		char		q_[2];      // 品質
-		char		satellite_[4];  // 衛星数
-		char		hq_[4];		// 水平精度低下率
-		char		alt_[6];	// 海抜高度(Altitude above sea level)
-		char		alt_unit_[2];	// 海抜高度単位
+		uint16_t	sci_errc_;
 
-		char		date_[8];   // 日付
+		// ストリーム解析の状態
+		STATE		state_;
+		SENT		sent_;
+		TALKER		talker_;
+		uint8_t		csum_;
+		uint8_t		rsum_;
+		uint8_t		field_;
+		uint8_t		len_;
+		char		key_[5];
+
+		// フィールドの数値変換
+		uint32_t	fint_;
+		uint8_t		fdig_;
+		uint8_t		flen_;
+		char		fch_;
+		bool		fdot_;
+
+		fix_t		fix_;
+		fix_t		work_;
+
+		// GSV の作業領域
+		uint8_t		gsv_msg_;
+		uint8_t		gsv_num_;
+		sat_info	gsv_[4];
 
-		uint16_t	sidx_;
 		sat_info	sinfo_[SINFO_MAX];	// 衛星情報
 
+		// UBX の作業領域
+		uint8_t		ubx_class_;
+		uint8_t		ubx_id_;
+		uint16_t	ubx_len_;
+		uint16_t	ubx_pos_;
+		uint8_t		ubx_cka_;
+		uint8_t		ubx_ckb_;
+		uint32_t	ubx_acc_;
+		uint8_t		ubx_hms_[3];
+		uint8_t		ubx_flags_;
+
 		uint32_t	id_;
 		uint32_t	iid_;
+		uint32_t	sentence_;
+		uint32_t	sum_errc_;
+		bool		gga_;
+
+		mutable char	time_str_[12];
+		mutable char	date_str_[8];
+		mutable char	lat_str_[12];
+		mutable char	lon_str_[12];
+		mutable char	q_str_[4];
+		mutable char	hq_str_[8];
+		mutable char	alt_str_[12];
 
 		device::ICU::LEVEL	intr_;
 		uint16_t	update_real_rate_;
@@ -86,23 +212,6 @@ namespace utils {
 		uint32_t	baud_real_rate_;
 		uint32_t	baud_fast_rate_;
 
-		static uint16_t word_(const char* src)
-		{
-			const char* top = src;
-			char ch;
-			while((ch = *src++) != 0) {
-				if(ch == ',' || ch == '*') return src - top;
-			}
-			return 0;
-		}
-
-		static void copy_word_(char* dst, const char* src, uint16_t len)
-		{
-			std::strncpy(dst, src, len);
-			dst[len] = 0;
-		}
-
-
 		static int32_t get_dec_(const char* t, uint16_t n = 0)
 		{
 			int32_t val = 0;
@@ -123,73 +232,346 @@ namespace utils {
 		}
 
 
-		bool parse_()
+		static int hex_(char ch) noexcept
 		{
-			if(line_[0] != '$') return false;
+			if(ch >= '0' && ch <= '9') return ch - '0';
+			else if(ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+			else if(ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+			return -1;
+		}
 
-			if(std::strncmp(&line_[1], "GPGGA,", 6) == 0) {
-				const char* p = &line_[7];
-				uint16_t n = 0;
-				uint16_t l;
-				while((l = word_(p)) != 0) {
-					if(n == 0) copy_word_(time_, p, l - 1);
-					else if(n == 1) copy_word_(lat_, p, l - 1);
-					else if(n == 2) copy_word_(ns_, p, l - 1);
-					else if(n == 3) copy_word_(lon_, p, l - 1);
-					else if(n == 4) copy_word_(ew_, p, l - 1);
-					else if(n == 5) copy_word_(q_, p, l - 1);
-					else if(n == 6) copy_word_(satellite_, p, l - 1);
-					else if(n == 7) copy_word_(hq_, p, l - 1);
-					else if(n == 8) copy_word_(alt_, p, l - 1);
-					else if(n == 9) copy_word_(alt_unit_, p, l - 1);
-					else {
-						break;
-					}
-					p += l;
-					++n;
+
+		// 小数点以下 dig 桁の固定小数点としてフィールドの値を取得
+		uint32_t value_(uint8_t dig) const noexcept
+		{
+			auto v = fint_;
+			auto n = fdig_;
+			while(n < dig) { v *= 10; ++n; }
+			while(n > dig) { v /= 10; --n; }
+			return v;
+		}
+
+
+		// ddmm.mmmmm 形式を 1e-7 度へ
+		int32_t latlon_() const noexcept
+		{
+			auto v = value_(5);
+			auto deg = v / 10'000'000;
+			auto min = v % 10'000'000;
+			return deg * 10'000'000 + min * 100 / 60;
+		}
+
+
+		static void sign_(int32_t& v, bool neg) noexcept
+		{
+			if(v < 0) v = -v;
+			if(neg) v = -v;
+		}
+
+
+		uint32_t time_ms_() const noexcept
+		{
+			auto v = value_(3);
+			auto ms = v % 1000;
+			v /= 1000;
+			return (((v / 10000) * 60 + (v / 100) % 100) * 60 + v % 100) * 1000 + ms;
+		}
+
+
+		void field_clear_() noexcept
+		{
+			fint_ = 0;
+			fdig_ = 0;
+			flen_ = 0;
+			fch_ = 0;
+			fdot_ = false;
+		}
+
+
+		void field_char_(char ch) noexcept
+		{
+			if(field_ == 0) {
+				if(flen_ < sizeof(key_)) key_[flen_] = ch;
+			} else if(ch >= '0' && ch <= '9') {
+				if(fint_ < 400'000'000) {
+					fint_ = fint_ * 10 + (ch - '0');
+					if(fdot_) ++fdig_;
 				}
-			} else if(std::strncmp(&line_[1], "GPRMC,", 6) == 0) {
-				const char* p = &line_[7];
-				uint16_t n = 0;
-				uint16_t l;
-				while((l = word_(p)) != 0) {
-					if(n == 8) copy_word_(date_, p, l - 1);
-					p += l;
-					++n;
+			} else if(ch == '.') {
+				fdot_ = true;
+			} else if(fch_ == 0) {
+				fch_ = ch;
+			}
+			++flen_;
+		}
+
+
+		// センテンス種別の判定（テーブル）
+		void parse_key_() noexcept
+		{
+			sent_ = SENT::NONE;
+			if(flen_ != 5) return;
+
+			talker_ = TALKER::OTHER;
+			for(const auto& t : talker_tbl_) {
+				if(t.name[0] == key_[0] && t.name[1] == key_[1]) {
+					talker_ = t.talker;
+					break;
 				}
-			} else if(std::strncmp(&line_[1], "GPGSV,", 6) == 0) {  // 衛星情報
-				const char* p = &line_[7];
-				uint16_t sidx = 0;
-				uint16_t n = 0;
-				uint16_t l;
-				while((l = word_(p)) != 0) {
-					if(n == 1) {
-						char tmp[4];
-						copy_word_(tmp, p, l - 1);
-						sidx = get_dec_(tmp);
-						sidx *= 4;
-					} else if(n >= 3) {
-						if(*(p - 1) == '*') break;
-						auto& t = sinfo_[sidx % SINFO_MAX];
-						auto mod = (n - 3) % 4;
-						if(mod == 0) {
-							copy_word_(t.no_, p, l - 1);
-						} else if(mod == 1) copy_word_(t.elv_, p, l - 1);
-						else if(mod == 2) copy_word_(t.azi_, p, l - 1);
-						else if(mod == 3) {
-							copy_word_(t.cn_, p, l - 1);
-							++sidx;
-						}
-					}
-					p += l;
-					++n;
+			}
+			for(const auto& t : sent_tbl_) {
+				if(t.name[0] == key_[2] && t.name[1] == key_[3] && t.name[2] == key_[4]) {
+					sent_ = t.sent;
+					break;
 				}
-				++iid_;
-			} else if(std::strncmp(&line_[1], "GPVTG,", 6) == 0) {
+			}
+		}
+
+
+		void gga_field_() noexcept
+		{
+			if(flen_ == 0) return;
+
+			switch(field_) {
+			case 1: work_.time_ = time_ms_(); break;
+			case 2: work_.lat_ = latlon_(); break;
+			case 3: sign_(work_.lat_, fch_ == 'S'); break;
+			case 4: work_.lon_ = latlon_(); break;
+			case 5: sign_(work_.lon_, fch_ == 'W'); break;
+			case 6: work_.quality_ = fint_; break;
+			case 7: work_.satellite_ = fint_; break;
+			case 8: work_.hdop_ = value_(2); break;
+			case 9:
+				work_.alt_ = value_(3);
+				if(fch_ == '-') work_.alt_ = -work_.alt_;
+				break;
+			default:
+				break;
+			}
+		}
+
+
+		void rmc_field_() noexcept
+		{
+			if(flen_ == 0) return;
+
+			switch(field_) {
+			case 1: work_.time_ = time_ms_(); break;
+			case 2: work_.valid_ = fch_ == 'A'; break;
+			case 3: work_.lat_ = latlon_(); break;
+			case 4: sign_(work_.lat_, fch_ == 'S'); break;
+			case 5: work_.lon_ = latlon_(); break;
+			case 6: sign_(work_.lon_, fch_ == 'W'); break;
+			case 7: work_.speed_ = static_cast<uint64_t>(value_(3)) * 1852 / 3600; break;  // knot -> mm/s
+			case 8: work_.course_ = value_(2); break;
+			case 9:
+				work_.day_  = fint_ / 10000;
+				work_.mon_  = (fint_ / 100) % 100;
+				work_.year_ = fint_ % 100;
+				break;
+			default:
+				break;
+			}
+		}
+
+
+		void vtg_field_() noexcept
+		{
+			if(flen_ == 0) return;
+
+			switch(field_) {
+			case 1: work_.course_ = value_(2); break;
+			case 7: work_.speed_ = value_(3) * 10 / 36; break;  // km/h -> mm/s
+			default:
+				break;
+			}
+		}
+
+
+		void gsv_field_() noexcept
+		{
+			if(field_ == 2) {
+				gsv_msg_ = fint_;
+				return;
+			}
+			if(field_ < 4) return;
+			auto i = (field_ - 4) / 4;
+			if(i >= 4) return;
+			auto& t = gsv_[i];
+			switch((field_ - 4) % 4) {
+			case 0:
+				t.no_ = fint_;
+				t.talker_ = talker_;
+				if(flen_ > 0) gsv_num_ = i + 1;
+				break;
+			case 1: t.elv_ = fint_; break;
+			case 2: t.azi_ = fint_; break;
+			case 3: t.cn_ = fint_; break;
+			}
+		}
+
+
+		void field_end_() noexcept
+		{
+			switch(sent_) {
+			case SENT::GGA: gga_field_(); break;
+			case SENT::RMC: rmc_field_(); break;
+			case SENT::GSV: gsv_field_(); break;
+			case SENT::VTG: vtg_field_(); break;
+			default: break;
+			}
+			field_clear_();
+		}
+
+
+		void commit_gsv_() noexcept
+		{
+			if(gsv_msg_ == 1) {  // 最初のメッセージで、同じ測位システムの情報を消去
+				for(auto& t : sinfo_) {
+					if(t.talker_ == talker_) t.talker_ = TALKER::NONE;
+				}
+			}
+			// NMEA 4.10 の信号 ID（最後のフィールド）を衛星番号と取り違えない
+			uint32_t n = field_ > 3 ? (field_ - 3) / 4 : 0;
+			if(n > gsv_num_) n = gsv_num_;
+			uint32_t j = 0;
+			for(uint32_t i = 0; i < n; ++i) {
+				while(j < SINFO_MAX && sinfo_[j].talker_ != TALKER::NONE) ++j;
+				if(j >= SINFO_MAX) break;
+				sinfo_[j] = gsv_[i];
+			}
+			++iid_;
+		}
+
+
+		// チェックサムが一致したセンテンスを反映
+		bool commit_() noexcept
+		{
+			++sentence_;
+			switch(sent_) {
+			case SENT::GGA:
+				fix_ = work_;
+				gga_ = true;
 				++id_;
 				return true;
-			} else {
-//				utils::format("ND: '%s'\n") % line_;
+			case SENT::RMC:
+				fix_ = work_;
+				if(!gga_) {
+					++id_;
+					return true;
+				}
+				break;
+			case SENT::VTG:
+				fix_ = work_;
+				break;
+			case SENT::GSV:
+				commit_gsv_();
+				break;
+			default:
+				break;
+			}
+			return false;
+		}
+
+
+		// UBX-NAV-PVT ペイロードの逐次変換（直近４バイトをリトルエンディアンで保持）
+		void ubx_pvt_(uint8_t ch) noexcept
+		{
+			ubx_acc_ = (ubx_acc_ >> 8) | (static_cast<uint32_t>(ch) << 24);
+			switch(ubx_pos_) {
+			case 5:  work_.year_ = (ubx_acc_ >> 16) % 100; break;
+			case 6:  work_.mon_ = ch; break;
+			case 7:  work_.day_ = ch; break;
+			case 8:  ubx_hms_[0] = ch; break;
+			case 9:  ubx_hms_[1] = ch; break;
+			case 10: ubx_hms_[2] = ch; break;
+			case 19:
+				{
+					int32_t ms = static_cast<int32_t>(ubx_acc_) / 1'000'000;
+					if(ms < 0) ms = 0;
+					work_.time_ = ((ubx_hms_[0] * 60 + ubx_hms_[1]) * 60 + ubx_hms_[2]) * 1000 + ms;
+				}
+				break;
+			case 20: work_.quality_ = ch >= 2 ? 1 : 0; break;  // fixType
+			case 21: ubx_flags_ = ch; break;
+			case 23: work_.satellite_ = ch; break;
+			case 27: work_.lon_ = static_cast<int32_t>(ubx_acc_); break;
+			case 31: work_.lat_ = static_cast<int32_t>(ubx_acc_); break;
+			case 39: work_.alt_ = static_cast<int32_t>(ubx_acc_); break;  // hMSL
+			case 63: work_.speed_ = ubx_acc_; break;  // gSpeed
+			case 67: work_.course_ = static_cast<int32_t>(ubx_acc_) / 1000; break;  // headMot
+			case 77: work_.hdop_ = ubx_acc_ >> 16; break;  // pDOP
+			default:
+				break;
+			}
+		}
+
+
+		void ubx_sum_(uint8_t ch) noexcept
+		{
+			ubx_cka_ += ch;
+			ubx_ckb_ += ubx_cka_;
+		}
+
+
+		bool ubx_char_(uint8_t ch) noexcept
+		{
+			switch(state_) {
+			case STATE::UBX_SYNC:
+				state_ = ch == 0x62 ? STATE::UBX_CLASS : STATE::WAIT;
+				ubx_cka_ = 0;
+				ubx_ckb_ = 0;
+				break;
+			case STATE::UBX_CLASS:
+				ubx_class_ = ch;
+				ubx_sum_(ch);
+				state_ = STATE::UBX_ID;
+				break;
+			case STATE::UBX_ID:
+				ubx_id_ = ch;
+				ubx_sum_(ch);
+				state_ = STATE::UBX_LEN1;
+				break;
+			case STATE::UBX_LEN1:
+				ubx_len_ = ch;
+				ubx_sum_(ch);
+				state_ = STATE::UBX_LEN2;
+				break;
+			case STATE::UBX_LEN2:
+				ubx_len_ |= static_cast<uint16_t>(ch) << 8;
+				ubx_sum_(ch);
+				ubx_pos_ = 0;
+				work_ = fix_;
+				ubx_flags_ = 0;
+				state_ = ubx_len_ > 0 ? STATE::UBX_PAYLOAD : STATE::UBX_CKA;
+				break;
+			case STATE::UBX_PAYLOAD:
+				ubx_sum_(ch);
+				if(ubx_class_ == 0x01 && ubx_id_ == 0x07 && ubx_len_ == 92) {
+					ubx_pvt_(ch);
+				}
+				++ubx_pos_;
+				if(ubx_pos_ >= ubx_len_) state_ = STATE::UBX_CKA;
+				break;
+			case STATE::UBX_CKA:
+				state_ = ch == ubx_cka_ ? STATE::UBX_CKB : STATE::WAIT;
+				if(state_ == STATE::WAIT) ++sum_errc_;
+				break;
+			case STATE::UBX_CKB:
+				state_ = STATE::WAIT;
+				if(ch != ubx_ckb_) {
+					++sum_errc_;
+				} else if(ubx_class_ == 0x01 && ubx_id_ == 0x07 && ubx_len_ == 92) {
+					work_.valid_ = (ubx_flags_ & 1) != 0;  // gnssFixOK
+					fix_ = work_;
+					++sentence_;
+					++id_;
+					return true;
+				}
+				break;
+			default:
+				state_ = STATE::WAIT;
+				break;
 			}
 			return false;
 		}
@@ -209,12 +591,21 @@ namespace utils {
 		}
 
 
+		static void latlon_str_(int32_t v, const char* form, char* dst, uint32_t len) noexcept
+		{
+			if(v < 0) v = -v;
+			auto deg = v / 10'000'000;
+			auto min = (static_cast<uint32_t>(v % 10'000'000) * 6 + 50) / 100;  // 1e-4 分
+			if(min > 599999) min = 599999;
+			utils::sformat(form, dst, len) % deg % (min / 10000) % (min % 10000);
+		}
+
+
 		void init_()
 		{
 			no_recv_cnt_ = 0;
 			sci_.auto_crlf(false);
-			line_[0] = 0;
-			pos_ = 0;
+			state_ = STATE::WAIT;
 		}
 
 	public:
@@ -223,11 +614,17 @@ namespace utils {
             @brief  コンストラクター
         */
         //-----------------------------------------------------------------//
-		nmea_dec(SCI_IO& sci) noexcept : sci_(sci), sci_errc_(0), pos_(0), line_{ 0 },
-			time_{ 0 }, lat_{ 0 }, ns_{ 0 }, lon_{ 0 },
-			ew_{ 0 }, q_{ 0 }, satellite_{ 0 }, hq_{ 0 },
-			alt_{ 0 }, alt_unit_{ 0 }, date_{ 0 },
-			sidx_(0), id_(0), iid_(0), intr_(device::ICU::LEVEL::NONE),
+		nmea_dec(SCI_IO& sci) noexcept : sci_(sci), sci_errc_(0),
+			state_(STATE::WAIT), sent_(SENT::NONE), talker_(TALKER::NONE),
+			csum_(0), rsum_(0), field_(0), len_(0), key_{ 0 },
+			fint_(0), fdig_(0), flen_(0), fch_(0), fdot_(false),
+			fix_(), work_(), gsv_msg_(0), gsv_num_(0), gsv_{ }, sinfo_{ },
+			ubx_class_(0), ubx_id_(0), ubx_len_(0), ubx_pos_(0), ubx_cka_(0), ubx_ckb_(0),
+			ubx_acc_(0), ubx_hms_{ 0 }, ubx_flags_(0),
+			id_(0), iid_(0), sentence_(0), sum_errc_(0), gga_(false),
+			time_str_{ 0 }, date_str_{ 0 }, lat_str_{ 0 }, lon_str_{ 0 },
+			q_str_{ 0 }, hq_str_{ 0 }, alt_str_{ 0 },
+			intr_(device::ICU::LEVEL::NONE),
 			update_real_rate_(0), update_fast_rate_(0),
 			no_recv_cnt_(0),
 			baud_real_rate_(0), baud_fast_rate_(0)
@@ -252,13 +649,46 @@ namespace utils {
 		uint32_t get_iid() const noexcept { return iid_; }
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  受理したセンテンス数を取得
+			@return センテンス数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t get_sentence_count() const noexcept { return sentence_; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  チェックサム・エラー数を取得
+			@return チェックサム・エラー数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t get_sum_error_count() const noexcept { return sum_errc_; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  測位情報（固定小数点）を取得
+			@return 測位情報
+        */
+        //-----------------------------------------------------------------//
+		const fix_t& get_fix() const noexcept { return fix_; }
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  時間を取得 (hhmmss.ss) 000000.00 to 235959.99
 			@return 時間
         */
         //-----------------------------------------------------------------//
-		const char* get_time() const noexcept { return time_; }
+		const char* get_time() const noexcept
+		{
+			auto t = fix_.time_;
+			utils::sformat("%02u%02u%02u.%02u", time_str_, sizeof(time_str_))
+				% (t / 3600'000) % ((t / 60'000) % 60) % ((t / 1000) % 60) % ((t % 1000) / 10);
+			return time_str_;
+		}
 
 
         //-----------------------------------------------------------------//
@@ -267,7 +697,13 @@ namespace utils {
 			@return 日付
         */
         //-----------------------------------------------------------------//
-		const char* get_date() const noexcept { return date_; }
+		const char* get_date() const noexcept
+		{
+			utils::sformat("%02u%02u%02u", date_str_, sizeof(date_str_))
+				% static_cast<uint32_t>(fix_.day_) % static_cast<uint32_t>(fix_.mon_)
+				% static_cast<uint32_t>(fix_.year_);
+			return date_str_;
+		}
 
 
         //-----------------------------------------------------------------//
@@ -277,16 +713,17 @@ namespace utils {
         */
         //-----------------------------------------------------------------//
 		time_t get_gmtime() const noexcept {
-			if(time_[0] == 0) {
+			if(fix_.mon_ == 0) {
 				return 0;
 			}
+			auto t = fix_.time_ / 1000;
 			tm ts;
-			ts.tm_sec  = get_dec_(&time_[4], 2);
-			ts.tm_min  = get_dec_(&time_[2], 2);
-			ts.tm_hour = get_dec_(&time_[0], 2);
-			ts.tm_mday = get_dec_(&date_[0], 2);
-			ts.tm_mon  = get_dec_(&date_[2], 2) - 1;
-			ts.tm_year = get_dec_(&date_[4], 2);
+			ts.tm_sec  = t % 60;
+			ts.tm_min  = (t / 60) % 60;
+			ts.tm_hour = t / 3600;
+			ts.tm_mday = fix_.day_;
+			ts.tm_mon  = fix_.mon_ - 1;
+			ts.tm_year = fix_.year_;
 			ts.tm_year += 100;  // 起点１９００年
 			return mktime_gmt(&ts);
 		}
@@ -294,11 +731,15 @@ namespace utils {
 
         //-----------------------------------------------------------------//
         /*!
-            @brief  緯度を取得 (dddmm.mmmm)
+            @brief  緯度を取得 (ddmm.mmmm)
 			@return 緯度
         */
         //-----------------------------------------------------------------//
-		const char* get_lat() const noexcept { return lat_; }
+		const char* get_lat() const noexcept
+		{
+			latlon_str_(fix_.lat_, "%02d%02u.%04u", lat_str_, sizeof(lat_str_));
+			return lat_str_;
+		}
 
 
         //-----------------------------------------------------------------//
@@ -307,7 +748,29 @@ namespace utils {
 			@return 経度
         */
         //-----------------------------------------------------------------//
-		const char* get_lon() const noexcept { return lon_; }
+		const char* get_lon() const noexcept
+		{
+			latlon_str_(fix_.lon_, "%03d%02u.%04u", lon_str_, sizeof(lon_str_));
+			return lon_str_;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  緯度を取得（固定小数点）
+			@return 緯度（1e-7 度、南緯は負）
+        */
+        //-----------------------------------------------------------------//
+		int32_t get_lat_fixed() const noexcept { return fix_.lat_; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  経度を取得（固定小数点）
+			@return 経度（1e-7 度、西経は負）
+        */
+        //-----------------------------------------------------------------//
+		int32_t get_lon_fixed() const noexcept { return fix_.lon_; }
 
 
         //-----------------------------------------------------------------//
@@ -374,7 +837,11 @@ namespace utils {
 			@return 品質
         */
         //-----------------------------------------------------------------//
-		const char* get_quality() const noexcept { return q_; }
+		const char* get_quality() const noexcept
+		{
+			utils::sformat("%u", q_str_, sizeof(q_str_)) % static_cast<uint32_t>(fix_.quality_);
+			return q_str_;
+		}
 
 
         //-----------------------------------------------------------------//
@@ -383,12 +850,7 @@ namespace utils {
 			@return 衛星数
         */
         //-----------------------------------------------------------------//
-		int get_satellite_num() const noexcept
-		{
-			int n = 0;
-			utils::input("%d", satellite_) % n;
-			return n;
-		}
+		int get_satellite_num() const noexcept { return fix_.satellite_; }
 
 
         //-----------------------------------------------------------------//
@@ -397,7 +859,11 @@ namespace utils {
 			@return 水平品質
         */
         //-----------------------------------------------------------------//
-		const char* get_holizontal_quality() const noexcept { return hq_; }
+		const char* get_holizontal_quality() const noexcept
+		{
+			utils::sformat("%u.%02u", hq_str_, sizeof(hq_str_)) % (fix_.hdop_ / 100) % (fix_.hdop_ % 100);
+			return hq_str_;
+		}
 
 
         //-----------------------------------------------------------------//
@@ -406,7 +872,17 @@ namespace utils {
 			@return 海抜高度
         */
         //-----------------------------------------------------------------//
-		const char* get_altitude() const noexcept { return alt_; }
+		const char* get_altitude() const noexcept
+		{
+			int32_t a = fix_.alt_;
+			const char* sign = "";
+			if(a < 0) {
+				a = -a;
+				sign = "-";
+			}
+			utils::sformat("%s%d.%01d", alt_str_, sizeof(alt_str_)) % sign % (a / 1000) % ((a % 1000) / 100);
+			return alt_str_;
+		}
 
 
         //-----------------------------------------------------------------//
@@ -415,12 +891,13 @@ namespace utils {
 			@return 海抜高度単位
         */
         //-----------------------------------------------------------------//
-		const char* get_altitude_unit() const noexcept { return alt_unit_; }
+		const char* get_altitude_unit() const noexcept { return "M"; }
 
 
         //-----------------------------------------------------------------//
         /*!
-            @brief  衛星情報の取得
+            @brief  衛星情報の取得 @n
+					※未使用のスロットは、talker_ が TALKER::NONE になる。
 			@param[in]	idx	衛星インデックス
 			@return 衛星情報
         */
@@ -481,6 +958,93 @@ namespace utils {
 		}
 
 
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  一文字入力（ストリーム解析） @n
+					※ service() から呼ばれる、他の入力元を使う場合に直接呼ぶ。
+			@param[in]	ch	文字
+			@return 測位情報が更新されたら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool feed(char ch) noexcept
+		{
+			if(state_ >= STATE::UBX_SYNC) {
+				return ubx_char_(static_cast<uint8_t>(ch));
+			}
+
+			if(ch == '$') {
+				state_ = STATE::NMEA;
+				csum_ = 0;
+				field_ = 0;
+				len_ = 0;
+				sent_ = SENT::NONE;
+				work_ = fix_;
+				gsv_msg_ = 0;
+				gsv_num_ = 0;
+				field_clear_();
+				return false;
+			} else if(state_ == STATE::WAIT && static_cast<uint8_t>(ch) == 0xb5) {
+				state_ = STATE::UBX_SYNC;
+				return false;
+			}
+
+			switch(state_) {
+			case STATE::NMEA:
+				++len_;
+				if(len_ > LINE_MAX || ch < ' ' || static_cast<uint8_t>(ch) >= 0x7f) {  // 異常なセンテンス
+					state_ = STATE::WAIT;
+				} else if(ch == '*') {
+					if(field_ == 0) parse_key_();
+					field_end_();
+					state_ = STATE::SUM1;
+				} else {
+					csum_ ^= static_cast<uint8_t>(ch);
+					if(ch == ',') {
+						if(field_ == 0) {
+							parse_key_();
+							if(sent_ == SENT::NONE) {  // 対象外のセンテンスは読み捨てる
+								state_ = STATE::WAIT;
+								break;
+							}
+						}
+						field_end_();
+						++field_;
+					} else {
+						field_char_(ch);
+					}
+				}
+				break;
+			case STATE::SUM1:
+				{
+					auto n = hex_(ch);
+					if(n < 0) {
+						state_ = STATE::WAIT;
+					} else {
+						rsum_ = n << 4;
+						state_ = STATE::SUM2;
+					}
+				}
+				break;
+			case STATE::SUM2:
+				{
+					state_ = STATE::WAIT;
+					auto n = hex_(ch);
+					if(n < 0) break;
+					rsum_ |= n;
+					if(rsum_ != csum_) {
+						++sum_errc_;
+						break;
+					}
+					return commit_();
+				}
+				break;
+			default:
+				break;
+			}
+			return false;
+		}
+
+
         //-----------------------------------------------------------------//
         /*!
             @brief  サービス @n
@@ -494,6 +1058,7 @@ namespace utils {
 			if(errc != sci_errc_) {
 				sci_errc_ = errc;
 				sci_.flush_recv();
+				state_ = STATE::WAIT;
 				++no_recv_cnt_;
 				if(no_recv_cnt_ >= (60 * 5)) {  // ５秒間受信が無い場合、ボーレートを変更
 					if(baud_real_rate_ == 9600) {  // 9600 で通信出来てないので、高速になってるかも
@@ -515,20 +1080,8 @@ namespace utils {
 			}
 			no_recv_cnt_ = 0;
 			while(len > 0) {
-				auto ch = sci_.getch();
-				if(ch == 0x0d) {
-					line_[pos_] = 0;
-					ret = parse_();
-					pos_ = 0;
-				} else {
-					if(ch >= ' ' && ch <= 0x7f) {  // CTRL コードは無視する。
-						if(pos_ < (sizeof(line_) - 1)) {
-							line_[pos_] = ch;
-							++pos_;
-						} else {
-							pos_ = 0;
-						}
-					}
+				if(feed(sci_.getch())) {
+					ret = true;
 				}
 				--len;
 			}
@@ -1,9 +1,12 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	RX グループ・QSPI I/O 制御
+	@brief	RX グループ・QSPI I/O 制御 @n
+			・send/recv は、通信幅（シングル、デュアル、クアッド）を転送毎に切り替え、 @n
+			  last が「false」の間は QSSL をアサートしたまま保持する。 @n
+			・DMAC チャネルを指定すると、大きな受信はダミー送信（TXDMY）と DMAC で行う。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2018, 2022 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2018, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -13,6 +16,8 @@
 
 namespace device {
 
+	template <class DMAC, class TASK> class dmac_mgr;
+
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  QSPI ベース・クラス
@@ -62,20 +67,66 @@ namespace device {
 	/*!
 		@brief  QSPI 制御クラス
 		@param[in]	QSPI	QSPI 定義クラス
+		@param[in]	DMAC	受信に使う DMAC チャネル（void の場合、CPU 転送のみ）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template <class QSPI>
+	template <class QSPI, class DMAC = void>
 	class qspi_io : public qspi_base {
 
+		static constexpr bool USE_DMA = !std::is_void_v<DMAC>;
+		static constexpr uint32_t DMA_MIN   = 32;		///< DMA を使う最小の受信数
+		static constexpr uint32_t DMA_LIMIT = 65535;	///< DMA １回の最大転送数
+
+		typedef std::conditional_t<USE_DMA, dmac_mgr<DMAC, utils::null_task>, utils::null_task> DMAC_MGR;
+
 		const device::port_map_qspi::group_t&		group_;
 
 		uint8_t	level_;
 
 		DLEN	dlen_;
 
+		uint16_t	cmd_;
+
+		DMAC_MGR	dmac_mgr_;
+
 		// 便宜上のスリープ
 		void sleep_() { asm("nop"); }
 
+		uint16_t command_(WIDTH width, bool rd, bool keep) const noexcept
+		{
+			uint16_t cmd = cmd_ | QSPI::SPCMD[0].SPIMOD.b(static_cast<uint8_t>(width));
+			if(rd && width != WIDTH::SINGLE) cmd |= QSPI::SPCMD[0].SPRW.b();
+			if(keep) cmd |= QSPI::SPCMD[0].SSLKP.b();
+			return cmd;
+		}
+
+		uint8_t xfer_(uint8_t data, WIDTH width, bool rd, bool keep) noexcept
+		{
+			QSPI::SPCMD[0] = command_(width, rd, keep);
+			QSPI::SPDR8 = data;
+			while(QSPI::SPSR.SPRFF() == 0) sleep_();
+			return QSPI::SPDR8();
+		}
+
+		void recv_dma_(uint8_t* dst, uint32_t size, WIDTH width, bool keep) noexcept
+		{
+			if constexpr (USE_DMA) {
+				QSPI::SPCMD[0] = command_(width, true, keep);
+				QSPI::SPBMUL0 = size;
+				QSPI::SPBFCR.RXTRG = 0;  // １バイト毎に要求
+				dmac_mgr_.start_trans(QSPI::RX_VEC, DMAC_MGR::trans_type::SN_DP_8,
+					QSPI::SPDR8.address, reinterpret_cast<uint32_t>(dst), size);
+				QSPI::SPCR.SPRIE = 1;
+				QSPI::SPDCR.TXDMY = 1;  // ダミー送信で転送開始
+				while(dmac_mgr_.get_count() != 0) sleep_();
+				while(QSPI::SPSR.TREND() == 0) sleep_();
+				QSPI::SPDCR.TXDMY = 0;
+				QSPI::SPCR.SPRIE = 0;
+				QSPI::SPBMUL0 = 1;
+				icu_mgr::set_dmac(DMAC::PERIPHERAL, ICU::VECTOR::NONE);
+			}
+		}
+
 
 		bool clock_div_(uint32_t speed, uint8_t& brdv, uint8_t& spbr) noexcept
 		{
@@ -111,7 +162,7 @@ namespace device {
 		*/
 		//-----------------------------------------------------------------//
 		qspi_io(const device::port_map_qspi::group_t& group) noexcept :
-			group_(group), level_(0), dlen_(DLEN::W8)
+			group_(group), level_(0), dlen_(DLEN::W8), cmd_(0), dmac_mgr_()
 		{ }
 
 
@@ -154,9 +205,15 @@ namespace device {
 			bool cpol = static_cast<uint8_t>(phase) & 1;
 			bool cpha = (static_cast<uint8_t>(phase) >> 1) & 1;
 
-			QSPI::SPCMD[0] = QSPI::SPCMD[0].BRDV.b(brdv)
+			cmd_ = QSPI::SPCMD[0].BRDV.b(brdv)
 				| QSPI::SPCMD[0].SPB.b(static_cast<uint8_t>(dlen))
 				| QSPI::SPCMD[0].CPOL.b(cpol) | QSPI::SPCMD[0].CPHA.b(cpha);
+			QSPI::SPCMD[0] = cmd_;
+			QSPI::SPBMUL0 = 1;
+
+			if constexpr (USE_DMA) {
+				dmac_mgr_.start();
+			}
 
 			QSPI::SPCR.MSTR = 1;
 
@@ -168,13 +225,15 @@ namespace device {
 
 		//----------------------------------------------------------------//
 		/*!
-			@brief	SSL を許可
-			@param[in]	ena		SSL の値
+			@brief	SSL を保持（次の転送の後も QSSL をアサートしたままにする）
+			@param[in]	ena		保持する場合「true」
 		*/
 		//----------------------------------------------------------------//
 		void enable_ssl(bool ena) noexcept
 		{
-//			QSPI::SPCMD[0].
+			cmd_ &= ~QSPI::SPCMD[0].SSLKP.b();
+			if(ena) cmd_ |= QSPI::SPCMD[0].SSLKP.b();
+			QSPI::SPCMD[0] = cmd_;
 		}
 
 
@@ -188,7 +247,7 @@ namespace device {
 		//----------------------------------------------------------------//
 		uint32_t xchg(uint32_t data = 0, WIDTH width = WIDTH::SINGLE) noexcept
 		{
-			QSPI::SPCMD[0].SPB = static_cast<uint8_t>(width);
+			QSPI::SPCMD[0].SPIMOD = static_cast<uint8_t>(width);
 			switch(dlen_) {
 			case DLEN::W8:
 				QSPI::SPDR8 = data;
@@ -201,7 +260,7 @@ namespace device {
 				break;
 			}
 	
-			while(QSPI::SPSR.SPRF() == 0) sleep_();
+			while(QSPI::SPSR.SPRFF() == 0) sleep_();
 	
 			switch(dlen_) {
 			case DLEN::W8:
@@ -220,15 +279,17 @@ namespace device {
 			@param[in]	src	送信ソース
 			@param[in]	cnt	送信サイズ（バイト）
 			@param[in]	width	通信幅（指定しないと１ビット）
+			@param[in]	last	最後の転送で QSSL をネゲートする場合「true」
 			@return 転送サイズを返す（バイト）
 		*/
 		//-----------------------------------------------------------------//
-		uint32_t send(const void* src, uint32_t size, WIDTH width = WIDTH::SINGLE) noexcept
+		uint32_t send(const void* src, uint32_t size, WIDTH width = WIDTH::SINGLE, bool last = true) noexcept
 		{
 			auto org = static_cast<const uint8_t*>(src);
 			auto end = org + size;
 			while(org < end) {
-				xchg(*org, width);
+				bool keep = !last || (org + 1) < end;
+				xfer_(*org, width, false, keep);
 				++org;
 			}
 			return size;
@@ -240,13 +301,26 @@ namespace device {
 			@brief  シリアル受信
 			@param[out]	dst	受信先
 			@param[in]	cnt	受信サイズ
+			@param[in]	width	通信幅（指定しないと１ビット）
+			@param[in]	last	最後の転送で QSSL をネゲートする場合「true」
 		*/
 		//-----------------------------------------------------------------//
-		void recv(uint8_t* dst, uint16_t size) noexcept
+		void recv(uint8_t* dst, uint32_t size, WIDTH width = WIDTH::SINGLE, bool last = true) noexcept
 		{
+			if constexpr (USE_DMA) {
+				// 最後の１バイトは、QSSL の制御の為 CPU で転送する
+				while(size > DMA_MIN) {
+					uint32_t len = size - 1;
+					if(len > DMA_LIMIT) len = DMA_LIMIT;
+					recv_dma_(dst, len, width, true);
+					dst += len;
+					size -= len;
+				}
+			}
 			auto end = dst + size;
 			while(dst < end) {
-				*dst = xchg();
+				bool keep = !last || (dst + 1) < end;
+				*dst = xfer_(0xff, width, true, keep);
 				++dst;
 			}
 		}
@@ -0,0 +1,451 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	FreeRTOS 用ストリーム・クラス @n
+			・stream_fifo: fixed_fifo と同じ API の FIFO で、データ、空きを @n
+			  タスク通知で待てる（vTaskDelay のポーリングが不要）。 @n
+			  reserve/commit、peek/consume で、コピーせずに読み書きできる。 @n
+			  sci_io、sound_out のバッファとして使うと、割り込み側から通知される。 @n
+			・stream_buffer、message_buffer: FreeRTOS の同名の API の薄いラッパー。 @n
+			※通知する割り込みのレベルは、configMAX_SYSCALL_INTERRUPT_PRIORITY 以下にする事。 @n
+			※タスク通知（インデックス０）を使うので、待つタスクは、他の用途で @n
+			  タスク通知を使う場合、余分な起床があり得る（内部で再検査する）。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2023 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include "common/fixed_fifo.hpp"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stream_buffer.h"
+#include "message_buffer.h"
+
+namespace utils {
+
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+    /*!
+        @brief  タスク通知付き FIFO クラス（読み出し、書き込みは、各１コンテキスト）
+		@param[in]	UNIT	基本形
+		@param[in]	SIZE	バッファサイズ（最低２）
+    */
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class UNIT, uint32_t SIZE>
+	class stream_fifo : public fixed_fifo<UNIT, SIZE> {
+
+		typedef fixed_fifo<UNIT, SIZE> BASE;
+
+		volatile TaskHandle_t	reader_;
+		volatile TaskHandle_t	writer_;
+		volatile uint32_t		want_length_;
+		volatile uint32_t		want_space_;
+
+		static bool running_() noexcept
+		{
+			return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+		}
+
+		// 条件を満たすまで、タスク通知で待つ
+		template <class COND>
+		bool wait_(volatile TaskHandle_t& h, COND cond, TickType_t timeout) noexcept
+		{
+			if(cond()) return true;
+			if(!running_() || timeout == 0) return false;
+
+			h = xTaskGetCurrentTaskHandle();
+			// 登録後に再検査（その間の通知は、カウントとして残る）
+			while(!cond()) {
+				if(ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+					break;
+				}
+			}
+			h = nullptr;
+			return cond();
+		}
+
+	public:
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  コンストラクター
+        */
+        //-----------------------------------------------------------------//
+		stream_fifo() noexcept : BASE(), reader_(nullptr), writer_(nullptr),
+			want_length_(1), want_space_(1)
+		{ }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  格納数を待つ
+			@param[in]	n		格納数
+			@param[in]	timeout	タイムアウト（ティック）
+			@return	格納数が n 以上なら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool wait_length(uint32_t n, TickType_t timeout = portMAX_DELAY) noexcept
+		{
+			want_length_ = n;
+			return wait_(reader_, [=]() { return BASE::length() >= n; }, timeout);
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  空き容量を待つ
+			@param[in]	n		空き容量
+			@param[in]	timeout	タイムアウト（ティック）
+			@return	空き容量が n 以上なら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool wait_space(uint32_t n, TickType_t timeout = portMAX_DELAY) noexcept
+		{
+			want_space_ = n;
+			return wait_(writer_, [=]() { return BASE::space() >= n; }, timeout);
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  待っているタスクへの通知（割り込み側から呼ぶ）
+        */
+        //-----------------------------------------------------------------//
+		void notify_from_isr() noexcept
+		{
+			BaseType_t woken = pdFALSE;
+			TaskHandle_t h = reader_;
+			if(h != nullptr && BASE::length() >= want_length_) {
+				reader_ = nullptr;
+				vTaskNotifyGiveFromISR(h, &woken);
+			}
+			h = writer_;
+			if(h != nullptr && BASE::space() >= want_space_) {
+				writer_ = nullptr;
+				vTaskNotifyGiveFromISR(h, &woken);
+			}
+			portYIELD_FROM_ISR(woken);
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  待っているタスクへの通知（タスク側から呼ぶ）
+        */
+        //-----------------------------------------------------------------//
+		void notify() noexcept
+		{
+			TaskHandle_t h = reader_;
+			if(h != nullptr && BASE::length() >= want_length_) {
+				reader_ = nullptr;
+				xTaskNotifyGive(h);
+			}
+			h = writer_;
+			if(h != nullptr && BASE::space() >= want_space_) {
+				writer_ = nullptr;
+				xTaskNotifyGive(h);
+			}
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  書き込み領域の予約（コピー無し）
+			@param[out]	ptr		書き込み先
+			@return	連続して書き込める数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t reserve(UNIT*& ptr) noexcept
+		{
+			ptr = &BASE::put_at();
+			return BASE::space_linear();
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  予約した領域の確定（タスク側、読み出しタスクへ通知する）
+			@param[in]	n	書き込んだ数
+        */
+        //-----------------------------------------------------------------//
+		void commit(uint32_t n) noexcept
+		{
+			BASE::put_go(n);
+			notify();
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  読み出し領域の参照（コピー無し）
+			@param[out]	ptr		読み出し元
+			@return	連続して読み出せる数
+        */
+        //-----------------------------------------------------------------//
+		uint32_t peek(const UNIT*& ptr) const noexcept
+		{
+			ptr = &BASE::get_at();
+			return BASE::length_linear();
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  参照した領域の解放（タスク側、書き込みタスクへ通知する）
+			@param[in]	n	読み出した数
+        */
+        //-----------------------------------------------------------------//
+		void consume(uint32_t n) noexcept
+		{
+			BASE::get_go(n);
+			notify();
+		}
+	};
+
+
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+    /*!
+        @brief  FreeRTOS ストリーム・バッファ・クラス
+    */
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class stream_buffer {
+
+		StreamBufferHandle_t	h_;
+
+	public:
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  コンストラクター
+        */
+        //-----------------------------------------------------------------//
+		stream_buffer() noexcept : h_(nullptr) { }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  デストラクター
+        */
+        //-----------------------------------------------------------------//
+		~stream_buffer() { if(h_ != nullptr) vStreamBufferDelete(h_); }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  開始
+			@param[in]	size	バッファサイズ（バイト）
+			@param[in]	trigger	読み出しタスクを起こすバイト数
+			@return	成功なら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool start(size_t size, size_t trigger = 1) noexcept
+		{
+			if(h_ == nullptr) {
+				h_ = xStreamBufferCreate(size, trigger);
+			}
+			return h_ != nullptr;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  送信
+			@param[in]	src		送信元
+			@param[in]	len		バイト数
+			@param[in]	timeout	タイムアウト（ティック）
+			@return	送信したバイト数
+        */
+        //-----------------------------------------------------------------//
+		size_t send(const void* src, size_t len, TickType_t timeout = portMAX_DELAY) noexcept
+		{
+			return xStreamBufferSend(h_, src, len, timeout);
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  受信
+			@param[out]	dst		受信先
+			@param[in]	len		最大バイト数
+			@param[in]	timeout	タイムアウト（ティック）
+			@return	受信したバイト数
+        */
+        //-----------------------------------------------------------------//
+		size_t recv(void* dst, size_t len, TickType_t timeout = portMAX_DELAY) noexcept
+		{
+			return xStreamBufferReceive(h_, dst, len, timeout);
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  割り込みからの送信
+			@param[in]	src		送信元
+			@param[in]	len		バイト数
+			@return	送信したバイト数
+        */
+        //-----------------------------------------------------------------//
+		size_t send_from_isr(const void* src, size_t len) noexcept
+		{
+			BaseType_t woken = pdFALSE;
+			auto n = xStreamBufferSendFromISR(h_, src, len, &woken);
+			portYIELD_FROM_ISR(woken);
+			return n;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  割り込みからの受信
+			@param[out]	dst		受信先
+			@param[in]	len		最大バイト数
+			@return	受信したバイト数
+        */
+        //-----------------------------------------------------------------//
+		size_t recv_from_isr(void* dst, size_t len) noexcept
+		{
+			BaseType_t woken = pdFALSE;
+			auto n = xStreamBufferReceiveFromISR(h_, dst, len, &woken);
+			portYIELD_FROM_ISR(woken);
+			return n;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  格納されているバイト数
+			@return	バイト数
+        */
+        //-----------------------------------------------------------------//
+		size_t length() const noexcept { return xStreamBufferBytesAvailable(h_); }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  空きバイト数
+			@return	バイト数
+        */
+        //-----------------------------------------------------------------//
+		size_t space() const noexcept { return xStreamBufferSpacesAvailable(h_); }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  トリガー・レベルの設定
+			@param[in]	trigger	読み出しタスクを起こすバイト数
+			@return	成功なら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool set_trigger(size_t trigger) noexcept
+		{
+			return xStreamBufferSetTriggerLevel(h_, trigger) == pdTRUE;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  リセット（待っているタスクが無い場合だけ）
+			@return	成功なら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool reset() noexcept { return xStreamBufferReset(h_) == pdPASS; }
+	};
+
+
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+    /*!
+        @brief  FreeRTOS メッセージ・バッファ・クラス
+    */
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	class message_buffer {
+
+		MessageBufferHandle_t	h_;
+
+	public:
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  コンストラクター
+        */
+        //-----------------------------------------------------------------//
+		message_buffer() noexcept : h_(nullptr) { }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  デストラクター
+        */
+        //-----------------------------------------------------------------//
+		~message_buffer() { if(h_ != nullptr) vMessageBufferDelete(h_); }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  開始
+			@param[in]	size	バッファサイズ（バイト、メッセージ毎に長さの分が加わる）
+			@return	成功なら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool start(size_t size) noexcept
+		{
+			if(h_ == nullptr) {
+				h_ = xMessageBufferCreate(size);
+			}
+			return h_ != nullptr;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  メッセージの送信
+			@param[in]	src		送信元
+			@param[in]	len		バイト数
+			@param[in]	timeout	タイムアウト（ティック）
+			@return	送信できたら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool send(const void* src, size_t len, TickType_t timeout = portMAX_DELAY) noexcept
+		{
+			return xMessageBufferSend(h_, src, len, timeout) == len;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  メッセージの受信
+			@param[out]	dst		受信先
+			@param[in]	len		受信先の大きさ
+			@param[in]	timeout	タイムアウト（ティック）
+			@return	メッセージの長さ（０なら受信無し）
+        */
+        //-----------------------------------------------------------------//
+		size_t recv(void* dst, size_t len, TickType_t timeout = portMAX_DELAY) noexcept
+		{
+			return xMessageBufferReceive(h_, dst, len, timeout);
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  割り込みからのメッセージ送信
+			@param[in]	src		送信元
+			@param[in]	len		バイト数
+			@return	送信できたら「true」
+        */
+        //-----------------------------------------------------------------//
+		bool send_from_isr(const void* src, size_t len) noexcept
+		{
+			BaseType_t woken = pdFALSE;
+			auto n = xMessageBufferSendFromISR(h_, src, len, &woken);
+			portYIELD_FROM_ISR(woken);
+			return n == len;
+		}
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  空きバイト数
+			@return	バイト数
+        */
+        //-----------------------------------------------------------------//
+		size_t space() const noexcept { return xMessageBufferSpaceAvailable(h_); }
+	};
+}
@@ -0,0 +1,348 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	ジョブ・スケジューラー（タイマー・ホイール、遅延実行） @n
+			・ジョブは優先度付きで登録し、メインループの service で実行する。 @n
+			・割り込み関数からは post でジョブを起動できる（１バイトの書き込みだけ @n
+			  なので、多重割り込みでも安全、実行前の重複した post はまとめられる）。 @n
+			・周期、又はワンショットのタイマーは、２段のタイマー・ホイールで管理し、 @n
+			  ジョブ数に関係無く、１ティック当たり一定の処理で済む。 @n
+			・ティックは、cmt_mgr の割り込みカウンターをそのまま使う。 @n
+			Ex: utils::scheduler<16> sch_; @n
+			    auto id = sch_.add([](){ LED::P = !LED::P(); }, 1); @n
+			    sch_.start(cmt_.get_counter()); @n
+			    sch_.start_timer(id, 500, 500);  // 500 ティック毎 @n
+			    while(1) { cmt_.sync(); sch_.service(cmt_.get_counter()); }
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2023 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <functional>
+
+namespace utils {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  ジョブ・スケジューラー・クラス
+		@param[in]	NUM		ジョブの最大数（３２以下）
+		@param[in]	SLOT	ホイール１段のスロット数（２のべき乗）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t NUM, uint32_t SLOT = 64>
+	class scheduler {
+
+		static_assert(NUM > 0 && NUM <= 32, "NUM is 1 to 32");
+		static_assert(SLOT >= 4 && (SLOT & (SLOT - 1)) == 0, "SLOT is power of 2");
+
+	public:
+		typedef std::function<void ()> FUNC_TYPE;
+
+		/// 時間（任意の単位）を返す関数（実行時間の統計用）
+		typedef uint32_t (*CLOCK_FUNC)();
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief  ジョブの統計
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct stat_t {
+			uint32_t	run;	///< 実行回数
+			uint32_t	total;	///< 実行時間の合計（CLOCK_FUNC の単位）
+			uint32_t	max;	///< 最大実行時間
+			uint32_t	late;	///< タイマーの最大遅れ（ティック）
+
+			stat_t() noexcept : run(0), total(0), max(0), late(0) { }
+		};
+
+	private:
+		static constexpr uint32_t MASK = SLOT - 1;
+		static constexpr uint32_t SHIFT = __builtin_ctz(SLOT);
+		static constexpr int8_t NONE = -1;
+
+		struct job_t {
+			FUNC_TYPE	func;
+			uint8_t		pri;
+			int8_t		next;	// ホイールのリスト
+			int8_t		prev;
+			int16_t		slot;	// ホイールの位置（-1 なら無し）
+			uint32_t	expire;
+			uint32_t	period;
+			stat_t		stat;
+		};
+
+		job_t		job_[NUM];
+		uint32_t	num_;
+		int8_t		order_[NUM];	// 優先度順
+
+		volatile uint8_t	pending_[NUM];
+
+		int8_t		head_[SLOT * 2];	// [0, SLOT): １段目、[SLOT, SLOT * 2): ２段目
+		uint32_t	cur_;
+
+		CLOCK_FUNC	clock_;
+
+		void link_(uint32_t id) noexcept
+		{
+			auto& j = job_[id];
+			uint32_t delta = j.expire - cur_;
+			uint32_t s;
+			if(delta < SLOT) {
+				s = j.expire & MASK;
+			} else {
+				s = SLOT + ((j.expire >> SHIFT) & MASK);
+			}
+			j.slot = s;
+			j.prev = NONE;
+			j.next = head_[s];
+			if(j.next != NONE) job_[j.next].prev = id;
+			head_[s] = id;
+		}
+
+		void unlink_(uint32_t id) noexcept
+		{
+			auto& j = job_[id];
+			if(j.slot < 0) return;
+			if(j.prev != NONE) job_[j.prev].next = j.next;
+			else head_[j.slot] = j.next;
+			if(j.next != NONE) job_[j.next].prev = j.prev;
+			j.slot = -1;
+		}
+
+		// ２段目のスロットを１段目へ移す
+		void cascade_(uint32_t s) noexcept
+		{
+			int8_t id = head_[s];
+			head_[s] = NONE;
+			while(id != NONE) {
+				int8_t next = job_[id].next;
+				job_[id].slot = -1;
+				link_(id);
+				id = next;
+			}
+		}
+
+		void tick_(uint32_t now) noexcept
+		{
+			++cur_;
+			if((cur_ & MASK) == 0) {
+				cascade_(SLOT + ((cur_ >> SHIFT) & MASK));
+			}
+			auto s = cur_ & MASK;
+			int8_t id = head_[s];
+			while(id != NONE) {
+				int8_t next = job_[id].next;
+				auto& j = job_[id];
+				if(j.expire == cur_) {
+					unlink_(id);
+					pending_[id] = 1;
+					uint32_t late = now - cur_;
+					if(late > j.stat.late) j.stat.late = late;
+					if(j.period > 0) {
+						j.expire += j.period;
+						link_(id);
+					}
+				}
+				id = next;
+			}
+		}
+
+		void run_(uint32_t id) noexcept
+		{
+			auto& j = job_[id];
+			uint32_t org = clock_ != nullptr ? clock_() : 0;
+			if(j.func) j.func();
+			++j.stat.run;
+			if(clock_ != nullptr) {
+				uint32_t t = clock_() - org;
+				j.stat.total += t;
+				if(t > j.stat.max) j.stat.max = t;
+			}
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+		*/
+		//-----------------------------------------------------------------//
+		scheduler() noexcept : job_{ }, num_(0), order_{ 0 }, pending_{ 0 },
+			cur_(0), clock_(nullptr)
+		{
+			for(uint32_t i = 0; i < (SLOT * 2); ++i) head_[i] = NONE;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	開始（現在のティックを設定し、タイマーを全て止める）
+			@param[in]	now		現在のティック（cmt_mgr::get_counter() など）
+		*/
+		//-----------------------------------------------------------------//
+		void start(uint32_t now) noexcept
+		{
+			for(uint32_t i = 0; i < (SLOT * 2); ++i) head_[i] = NONE;
+			for(uint32_t i = 0; i < num_; ++i) job_[i].slot = -1;
+			cur_ = now;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	実行時間を計る関数を設定
+			@param[in]	clock	時間を返す関数（nullptr なら計らない）
+		*/
+		//-----------------------------------------------------------------//
+		void set_clock(CLOCK_FUNC clock) noexcept { clock_ = clock; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ジョブの登録（メインループから呼ぶ）
+			@param[in]	func	ジョブの関数
+			@param[in]	pri		優先度（０が最も高い）
+			@return ジョブ ID（登録できない場合「-1」）
+		*/
+		//-----------------------------------------------------------------//
+		int32_t add(FUNC_TYPE func, uint8_t pri = 0) noexcept
+		{
+			if(num_ >= NUM) return -1;
+			uint32_t id = num_;
+			auto& j = job_[id];
+			j.func = func;
+			j.pri = pri;
+			j.next = NONE;
+			j.prev = NONE;
+			j.slot = -1;
+			j.expire = 0;
+			j.period = 0;
+			j.stat = stat_t();
+			pending_[id] = 0;
+
+			// 同じ優先度では、登録順
+			uint32_t n = num_;
+			while(n > 0 && job_[order_[n - 1]].pri > pri) {
+				order_[n] = order_[n - 1];
+				--n;
+			}
+			order_[n] = id;
+			++num_;
+			return id;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ジョブの起動要求（割り込み関数からも呼べる）
+			@param[in]	id	ジョブ ID
+		*/
+		//-----------------------------------------------------------------//
+		void post(uint32_t id) noexcept
+		{
+			if(id < NUM) pending_[id] = 1;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	タイマーの開始（メインループから呼ぶ）
+			@param[in]	id		ジョブ ID
+			@param[in]	delay	最初の起動までのティック数（１以上）
+			@param[in]	period	周期（０ならワンショット）
+			@return 成功なら「true」
+		*/
+		//-----------------------------------------------------------------//
+		bool start_timer(uint32_t id, uint32_t delay, uint32_t period = 0) noexcept
+		{
+			if(id >= num_ || delay == 0) return false;
+			unlink_(id);
+			job_[id].expire = cur_ + delay;
+			job_[id].period = period;
+			link_(id);
+			return true;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	タイマーの停止（メインループから呼ぶ）
+			@param[in]	id		ジョブ ID
+		*/
+		//-----------------------------------------------------------------//
+		void stop_timer(uint32_t id) noexcept
+		{
+			if(id >= num_) return;
+			unlink_(id);
+			job_[id].period = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	サービス（メインループから呼ぶ） @n
+					ホイールを now まで進め、起動要求のあるジョブを優先度順に @n
+					実行する（各ジョブは１回の service で最大１回）。
+			@param[in]	now		現在のティック
+			@return 実行したジョブの数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t service(uint32_t now) noexcept
+		{
+			while(cur_ != now) {
+				tick_(now);
+			}
+
+			uint32_t done = 0;
+			uint32_t cnt = 0;
+			while(1) {
+				// 実行中に、より高い優先度のジョブが起動される場合があるので、毎回先頭から探す
+				int32_t id = -1;
+				for(uint32_t i = 0; i < num_; ++i) {
+					auto n = order_[i];
+					if(pending_[n] != 0 && (done & (1 << n)) == 0) {
+						id = n;
+						break;
+					}
+				}
+				if(id < 0) break;
+				pending_[id] = 0;
+				done |= 1 << id;
+				run_(id);
+				++cnt;
+			}
+			return cnt;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	現在のティックを取得
+			@return 現在のティック
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_tick() const noexcept { return cur_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ジョブの統計を取得
+			@param[in]	id	ジョブ ID
+			@return 統計
+		*/
+		//-----------------------------------------------------------------//
+		const stat_t& get_stat(uint32_t id) const noexcept { return job_[id % NUM].stat; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ジョブの統計をクリア
+		*/
+		//-----------------------------------------------------------------//
+		void clear_stat() noexcept
+		{
+			for(uint32_t i = 0; i < num_; ++i) job_[i].stat = stat_t();
+		}
+	};
+}
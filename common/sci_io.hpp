@@ -7,8 +7,13 @@
 			  通常の非同期通信では、ボーレートの設定範囲と精度が異なるだけです。 @n
 			・SCI の機能によって、ポーリングが出来ない場合があります。 @n
 			   SCIx::SSR_RDRF 定数が false の場合はポーリング不可です。 @n
-			・DMAC による転送をサポートしていませんが、必要性を感じていません。 @n
-			・同期通信で、ブロック転送を行うような場合は、必要かもしれません。 @n
+			・DMAC チャネルを指定すると、送信バッファの連続領域を DMAC で TDR へ転送する。 @n
+			  （送信割り込みは、DMA ブロック毎に１回となる） @n
+			・受信は RXI 割り込みで行い、read() でまとめて取り出す。 @n
+			  probe_recv_idle() を定期的に呼ぶ事で、受信の途切れ（アイドル）を検出できる。 @n
+			・FreeRTOS では、バッファに utils::stream_fifo（common/rtos_stream.hpp）を使うと、 @n
+			  getch、putch、write は、ポーリングせずにタスク通知で待つ。 @n
+			  （割り込みレベルは、configMAX_SYSCALL_INTERRUPT_PRIORITY 以下にする事） @n
 			Ex: 定義例 @n
 			・受信バッファ、送信バッファの大きさは、最低１６バイトは必要です。 @n
 			・ボーレート、サービスする内容に応じて適切に設定して下さい。 @n
@@ -43,6 +48,9 @@
 			Ex: RS-485 を利用する場合の定義例 @n
 			  	typedef device::PORT<device::PORT3, device::bitpos::B3> RS485_DE;   // for MAX3485 DE @n
 				typedef device::sci_io<RS485_CH, RS485_RXB, RS485_TXB, device::port_map::ORDER::SECOND, device::sci_io_base::FLOW_CTRL::RS485, RS485_DE> RS485; @n
+			Ex: DMAC 送信を利用する場合の定義例 @n
+				typedef device::sci_io<device::SCI1, RBF, SBF, device::port_map::ORDER::FIRST, @n
+					device::sci_io_base::FLOW_CTRL::NONE, device::NULL_PORT, device::DMAC1> SCI; @n
 			コンパイル時アサート： @n
 			・コンパイル時に、ボーレートの設定誤差を計算して、止める事が出来ます。(通常 3.2%) @n
 			Ex: static_assert(SCI::probe_baud(baud), "Failed baud rate accuracy test"); @n
@@ -56,10 +64,13 @@
 //=========================================================================//
 #include "common/renesas.hpp"
 #include "common/fixed_fifo.hpp"
+#include "common/intr_utils.hpp"
 #include "common/sci_io_base.hpp"
 
 namespace device {
 
+	template <class DMAC, class TASK> class dmac_mgr;
+
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	/*!
 		@brief  SCI I/O 制御クラス
@@ -69,10 +80,12 @@ namespace device {
 		@param[in]	PSEL	ポート候補
 		@param[in]	FLCT	フロー制御型
 		@param[in]	RTS		制御ポート（RTS/RS-485_DE）
+		@param[in]	DMAC	送信に使う DMAC チャネル（void の場合、割り込みのみ）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template <class SCI, class RBF, class SBF, port_map::ORDER PSEL = port_map::ORDER::FIRST,
-		typename sci_io_base::FLOW_CTRL FLCT = sci_io_base::FLOW_CTRL::NONE, class RTS = NULL_PORT>
+		typename sci_io_base::FLOW_CTRL FLCT = sci_io_base::FLOW_CTRL::NONE, class RTS = NULL_PORT,
+		class DMAC = void>
 	class sci_io : public sci_io_base {
 
 		static_assert(RBF::size() > 8, "Receive buffer is too small.");
@@ -83,21 +96,74 @@ namespace device {
 		typedef RBF rbf_type;
 		typedef SBF sbf_type;
 
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	転送統計
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct stat_trans_t {
+			uint32_t	rxi_;		///< 受信割り込み回数
+			uint32_t	txi_;		///< 送信割り込み回数
+			uint32_t	dma_;		///< DMA 転送回数
+			uint32_t	recv_;		///< 受信バイト数
+			uint32_t	send_;		///< 送信バイト数
+
+			stat_trans_t() noexcept : rxi_(0), txi_(0), dma_(0), recv_(0), send_(0) { }
+		};
+
 	private:
 
 		static constexpr char XON  = 0x11;  ///< 送信再開 CTRL-Q
 		static constexpr char XOFF = 0x13;  ///< 送信中断 CTRL-S
 
+		static constexpr bool USE_DMA = !std::is_void_v<DMAC>;
+		static constexpr uint32_t DMA_LIMIT = 65535;	///< DMA １回の最大転送数
+
+		// DMA 終了（送信バッファを進め、TXI を CPU 側に戻す） @n
+		// DMAC が無いデバイスでも定義できるように、DMAC、icu_mgr に依存させる
+		template <class D, class MGR>
+		static void dma_end_() noexcept
+		{
+			send_.get_go(dma_len_);
+			stat_.send_ += dma_len_;
+			dma_len_ = 0;
+			send_.notify_from_isr();
+			MGR::set_dmac(D::PERIPHERAL, ICU::VECTOR::NONE);
+			// 最後のバイトの TXI が、経路を戻す前に DMAC 側で発生した場合、txi_task_ は呼ばれない。
+			// 送信が終わっていれば（TDR も空）、要求を消して、ここで続きを送るか、送信を止める。
+			if(SCI::SCR.TIE() && SCI::SSR.TEND()) {
+				ICU::IR[SCI::TXI] = 0;
+				txi_service_();
+			}
+		}
+
+		// DMA 終了割り込み
+		class dma_task {
+		public:
+			void operator() () noexcept {
+				if constexpr (USE_DMA) {
+					dma_end_<DMAC, icu_mgr>();
+				}
+			}
+		};
+
+		typedef std::conditional_t<USE_DMA, dmac_mgr<DMAC, dma_task>, utils::null_task> DMAC_MGR;
+
 		const port_map_order::sci_port_t&	port_map_;
 
 		static inline RBF	recv_;
 		static inline SBF	send_;
 
+		static inline DMAC_MGR	dmac_mgr_;
+		static inline volatile uint32_t	dma_len_;
+
 		ICU::LEVEL	level_;
 		bool		auto_crlf_;
 		uint32_t	baud_;
+		uint32_t	idle_rxi_;
 		static inline volatile bool		stop_;
 		static inline volatile uint16_t	errc_;
+		static inline volatile stat_trans_t	stat_;
 
 		// ※マルチタスクの場合適切な実装をする
 		void sleep_() noexcept
@@ -121,6 +187,7 @@ namespace device {
 				err = true;
 			}
 			volatile uint8_t rd = SCI::RDR();
+			++stat_.rxi_;
 			if(err) {
 				++errc_;
 			} else {
@@ -142,13 +209,41 @@ namespace device {
 			}
 #endif	
 				recv_.put(rd);
+				++stat_.recv_;
+				recv_.notify_from_isr();
 			}
 		}
 
-		static INTERRUPT_FUNC void txi_task_()
+		// TDR が空の時に呼ぶ、DMA が使える場合、連続領域をまとめて転送する @n
+		// ISR: 割り込み側から呼ぶ場合「true」（タスク側の通知と使い分ける）
+		template <bool ISR>
+		static void send_next_() noexcept
+		{
+			char ch = send_.get();
+			++stat_.send_;
+			if constexpr (USE_DMA) {
+				uint32_t n = send_.length_linear();
+				if(n > DMA_LIMIT) n = DMA_LIMIT;
+				if(n > 0) {
+					// DMA を先に起動し、TDR への書き込みで発生する TXI を DMAC で受ける
+					dma_len_ = n;
+					dmac_mgr_.start_trans(SCI::TXI, DMAC_MGR::trans_type::SP_DN_8,
+						reinterpret_cast<uint32_t>(&send_.get_at()), SCI::TDR.address, n, true);
+					++stat_.dma_;
+				}
+			}
+			SCI::TDR = ch;
+			if constexpr (ISR) {
+				send_.notify_from_isr();
+			} else {
+				send_.notify();
+			}
+		}
+
+		static void txi_service_() noexcept
 		{
 			if(send_.length() > 0) {
-				SCI::TDR = send_.get();
+				send_next_<true>();
 			} else {
 				SCI::SCR.TIE = 0;
 				if(FLCT == FLOW_CTRL::RS485) {
@@ -157,6 +252,12 @@ namespace device {
 			}
 		}
 
+		static INTERRUPT_FUNC void txi_task_()
+		{
+			++stat_.txi_;
+			txi_service_();
+		}
+
 		static inline void tei_task_()
 		{
 			if(send_.length() == 0) {
@@ -193,6 +294,18 @@ namespace device {
 		}
 
 
+		void send_start_() noexcept
+		{
+			if(SCI::SCR.TIE() == 0) {
+				if(FLCT == FLOW_CTRL::RS485) {
+					RTS::P = 1;
+				}
+				SCI::SCR.TIE = 1;
+				send_next_<false>();
+			}
+		}
+
+
 		static constexpr bool calc_rate_(uint32_t baud,
 			uint8_t& brr_, uint8_t& cks_, uint8_t& mddr_, bool& abcs_, bool& bgdm_, bool& brme_) noexcept
 		{
@@ -255,7 +368,7 @@ namespace device {
 			const port_map_order::sci_port_t& sci_port = port_map_order::sci_port_t()) noexcept :
 			port_map_(sci_port),
 			level_(ICU::LEVEL::NONE),
-			auto_crlf_(autocrlf), baud_(0) {
+			auto_crlf_(autocrlf), baud_(0), idle_rxi_(0) {
 			stop_ = false;
 			errc_ = 0;
 		}
@@ -270,6 +383,40 @@ namespace device {
 		static uint16_t get_error_count() noexcept { return errc_; }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送統計の取得 @n
+					取得間隔の時間で割れば、スループットが求まる。
+			@return 転送統計
+		 */
+		//-----------------------------------------------------------------//
+		static stat_trans_t get_stat_trans() noexcept
+		{
+			stat_trans_t t;
+			t.rxi_  = stat_.rxi_;
+			t.txi_  = stat_.txi_;
+			t.dma_  = stat_.dma_;
+			t.recv_ = stat_.recv_;
+			t.send_ = stat_.send_;
+			return t;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送統計のリセット
+		 */
+		//-----------------------------------------------------------------//
+		static void reset_stat_trans() noexcept
+		{
+			stat_.rxi_  = 0;
+			stat_.txi_  = 0;
+			stat_.dma_  = 0;
+			stat_.recv_ = 0;
+			stat_.send_ = 0;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	LF 時、CR 自動送出
@@ -358,6 +505,8 @@ namespace device {
 			stop_ = false;
 			recv_.clear();
 			send_.clear();
+			dma_len_ = 0;
+			idle_rxi_ = 0;
 
 			if(!power_mgr::turn(SCI::PERIPHERAL)) {
 				return false;
@@ -408,6 +557,11 @@ namespace device {
 			baud_ = baud;
 
 			set_intr_(level_);
+			if constexpr (USE_DMA) {
+				if(level_ != ICU::LEVEL::NONE) {
+					dmac_mgr_.start(level_);
+				}
+			}
 
 			bool stop = 0;
 			bool pm = 0;
@@ -562,7 +716,7 @@ namespace device {
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	SCI 文字出力 @n
-					送信バッファの容量が７／８以上の場合は、空になるまで待つ。（フロー制御が無い場合）
+					送信バッファに空きが無い場合は、空きが出来るまで待つ。
 			@param[in]	ch	文字コード
 		 */
 		//-----------------------------------------------------------------//
@@ -576,19 +730,9 @@ namespace device {
 				if(b) {
 					SCI::SSR.ORER = 0;
 				}
-				if(FLCT == FLOW_CTRL::NONE) {
-					if(send_.length() >= (send_.size() * 7 / 8)) {
-						while(send_.length() != 0) sleep_();
-					}
-				}
+				while(!send_.wait_space(1)) sleep_();
 				send_.put(ch);
-				if(SCI::SCR.TIE() == 0) {
-					if(FLCT == FLOW_CTRL::RS485) {
-						RTS::P = 1;
-					}
-					SCI::SCR.TIE = 1;
-					SCI::TDR = send_.get();
-				}
+				send_start_();
 			} else {
 				while(SCI::SSR.TEND() == 0) sleep_();
 				SCI::TDR = ch;
@@ -596,6 +740,40 @@ namespace device {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	SCI バイナリー出力（CR 自動送出は行わない） @n
+					送信バッファへまとめて格納し、送信を開始する。 @n
+					送信バッファに入りきらない場合は、空きが出来るまで待つ。
+			@param[in]	src	送信データ
+			@param[in]	len	送信バイト数
+		 */
+		//-----------------------------------------------------------------//
+		void write(const void* src, uint32_t len) noexcept
+		{
+			if(src == nullptr) return;
+			auto p = static_cast<const char*>(src);
+			if(level_ != ICU::LEVEL::NONE) {
+				while(len > 0) {
+					auto n = send_.put(p, len);
+					if(n > 0) {
+						send_start_();
+						p += n;
+						len -= n;
+					} else if(!send_.wait_space(1)) {
+						sleep_();
+					}
+				}
+			} else {
+				while(len > 0) {
+					while(SCI::SSR.TEND() == 0) sleep_();
+					SCI::TDR = *p++;
+					--len;
+				}
+			}
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	入力文字数を取得
@@ -637,7 +815,7 @@ namespace device {
 		char getch() noexcept
 		{
 			if(level_ != ICU::LEVEL::NONE) {  // 割り込み受信
-				while(recv_.length() == 0) {
+				while(!recv_.wait_length(1)) {
 					sleep_();
 				}
 				auto ch = recv_.get();
@@ -655,6 +833,55 @@ namespace device {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	受信データをまとめて取得（ノンブロック）
+			@param[out]	dst	格納先
+			@param[in]	len	最大バイト数
+			@return 取得したバイト数
+		 */
+		//-----------------------------------------------------------------//
+		uint32_t read(void* dst, uint32_t len) noexcept
+		{
+			if(dst == nullptr) return 0;
+			auto p = static_cast<char*>(dst);
+			if(level_ != ICU::LEVEL::NONE) {
+				auto n = recv_.get(p, len);
+				if(FLCT == FLOW_CTRL::HARD || FLCT == FLOW_CTRL::SOFT_HARD) {
+					if(n > 0 && recv_.length() == 0) {
+						RTS::P = 1;
+					}
+				}
+				return n;
+			} else {
+				uint32_t n = 0;
+				while(n < len && recv_length() > 0) {
+					p[n] = SCI::RDR();
+					++n;
+				}
+				return n;
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	受信アイドルの検査 @n
+					一定周期（１ミリ秒など）で呼び出す。 @n
+					前回の呼び出しから受信が無く、受信バッファにデータがある場合、 @n
+					受信の途切れとして「true」を返す。（read() でまとめて取り出す）
+			@return 受信アイドルなら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool probe_recv_idle() noexcept
+		{
+			auto rxi = stat_.rxi_;
+			bool idle = (rxi == idle_rxi_) && recv_.length() > 0;
+			idle_rxi_ = rxi;
+			return idle;
+		}
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	文字列出力
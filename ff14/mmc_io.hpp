@@ -604,5 +604,14 @@ namespace fatfs {
 		 */
 		//-----------------------------------------------------------------//
 		bool get_mount() const noexcept { return mount_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	FatFs コンテキストの取得（マウント中のみ有効）
+			@return FatFs コンテキスト
+		 */
+		//-----------------------------------------------------------------//
+		const FATFS& get_fatfs() const noexcept { return fatfs_; }
 	};
 }
@@ -2,13 +2,15 @@
 //=====================================================================//
 /*!	@file
 	@brief	RX600 グループ、SDHI（SD ホストインターフェース）FatFS ドライバー @n
-			SDHI インターフェースを使った SD カードアクセス
+			SDHI インターフェースを使った SD カードアクセス @n
+			DMAC を指定し、割り込みレベルを設定すると、データ転送に DMA を使う。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2017, 2020 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2017, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
+#include <type_traits>
 #include "common/renesas.hpp"
 #include "ff14/source/ff.h"
 #include "ff14/source/diskio.h"
@@ -32,11 +34,30 @@ namespace fatfs {
 		@param[in]	POW		電源制御ポート・クラス
 		@param[in]	WPRT	書き込み禁止ポート・クラス
 		@param[in]	PSEL	ポート候補（port_map.hpp 参照）
+		@param[in]	DMAC	データ転送に使う DMAC クラス（void の場合 CPU 転送）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template <class SDHI, class POW, class WPRT = device::NULL_PORT,
-		device::port_map::ORDER PSEL = device::port_map::ORDER::FIRST>
+		device::port_map::ORDER PSEL = device::port_map::ORDER::FIRST, class DMAC = void>
 	class sdhi_io {
+	public:
+
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	転送統計
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct stat_trans_t {
+			uint32_t	read_;		///< 読み出しセクター数
+			uint32_t	write_;		///< 書き込みセクター数
+			uint32_t	dma_;		///< DMA 転送回数
+			uint32_t	wait_;		///< DMA 完了待ちループ数（約 1us 単位）
+			uint32_t	error_;		///< エラー数
+
+			stat_trans_t() noexcept : read_(0), write_(0), dma_(0), wait_(0), error_(0) { }
+		};
+
+	private:
 
 //		typedef utils::format debug_format;
 		typedef utils::null_format debug_format;
@@ -73,7 +94,28 @@ namespace fatfs {
 		static constexpr int ACMD41_LOOP_MAX  = 1000;
 		static constexpr int CMD3_LOOP_MAX    = 3;
 		static constexpr int BRE_LOOP_LIMIT   = 1000;
-		static constexpr int BWE_LOOP_LIMIT   = 1000;
+		static constexpr uint32_t DATA_LOOP_LIMIT = 1'000'000;	///< データ待ち (1us 単位、1 秒)
+		static constexpr uint32_t DMA_LOOP_LIMIT  = 5'000'000;	///< DMA 完了待ち (1us 単位、5 秒)
+
+		static constexpr bool USE_DMA = !std::is_void_v<DMAC>;
+
+		// DMA 終了割り込み
+		class dma_task {
+		public:
+			static inline volatile bool end_ = false;
+
+			void operator() () noexcept {
+				end_ = true;
+			}
+		};
+
+		typedef std::conditional_t<USE_DMA, device::dmac_mgr<DMAC, dma_task>, utils::null_task> DMAC_MGR;
+
+		enum class trans : uint8_t {
+			NONE,	///< 転送無し
+			DMA,	///< DMA 転送中
+			DONE,	///< CPU 転送済み
+		};
 
 		FATFS		fatfs_;
 		DSTATUS		stat_;			// Disk status
@@ -89,6 +131,11 @@ namespace fatfs {
 		uint32_t	rca_id_;
 		uint32_t	cid_[4];
 
+		DMAC_MGR	dmac_mgr_;
+		trans		trans_;
+		DRESULT		trans_ret_;
+		stat_trans_t	stat_trans_;
+
 		// SD command
 		enum class command : uint32_t {
                               // 引数　       応答　転送　説明
@@ -294,6 +341,107 @@ namespace fatfs {
 		}
 
 
+		// 転送コマンドを発行して、応答を待つ
+		bool send_cmd_block_(command cmd, uint32_t arg, UINT count, bool dma) noexcept
+		{
+			SDHI::SDSIZE   = 512;
+			SDHI::SDSTOP   = 0x00000100;  // for multi block
+			SDHI::SDBLKCNT = count;  // for multi block
+			if constexpr (USE_DMA) {
+				SDHI::SDDMAEN = dma ? SDHI::SDDMAEN.DMAEN.b() : 0;
+			}
+			SDHI::SDARG    = arg;
+			SDHI::SDCMD = static_cast<uint32_t>(cmd);
+			while(SDHI::SDSTS1.RSPEND() == 0) {
+				auto st = SDHI::SDSTS2();
+				if(st & SDHI::SDSTS2.CRCE.b()) {
+					debug_format("CMD%d CRC Error (CRCE)\n") % static_cast<uint32_t>(cmd);
+					return false;
+				}
+				if(st & SDHI::SDSTS2.CMDE.b()) {
+					debug_format("CMD%d Command error (CMDE)\n") % static_cast<uint32_t>(cmd);
+					return false;
+				}
+				if(st & SDHI::SDSTS2.RSPTO.b()) {
+					debug_format("CMD%d Response Timeout (RSPTO)\n") % static_cast<uint32_t>(cmd);
+					return false;
+				}
+			}
+			SDHI::SDSTS1 = 0x0000FFFE;
+			return true;
+		}
+
+
+		// SDHI のバッファ・ステータス待ち（BRE/BWE）
+		bool wait_buff_(bool read) noexcept
+		{
+			uint32_t loop = 0;
+			while((read ? SDHI::SDSTS2.BRE() : SDHI::SDSTS2.BWE()) == 0) {
+				if(loop >= DATA_LOOP_LIMIT) {
+					debug_format("%s time out\n") % (read ? "BRE" : "BWE");
+					return false;
+				}
+				auto st = SDHI::SDSTS2();
+				if(st & SDHI::SDSTS2.DTO.b()) {
+					debug_format("DTO error\n");
+					return false;
+				}
+				if(st & SDHI::SDSTS2.CRCE.b()) {
+					debug_format("CRC error\n");
+					return false;
+				}
+				++loop;
+				utils::delay::micro_second(1);
+			}
+			return true;
+		}
+
+		bool wait_bre_() noexcept { return wait_buff_(true); }
+
+		bool wait_bwe_() noexcept { return wait_buff_(false); }
+
+
+		// DMA 転送の開始（割り込みが無い、又はアライメントが合わない場合は使わない）
+		bool start_dma_(const void* buff, UINT count, bool read) noexcept
+		{
+			if constexpr (USE_DMA) {
+				if(intr_lvl_ == device::ICU::LEVEL::NONE) return false;
+				if((reinterpret_cast<uint32_t>(buff) & 0x3) != 0) return false;
+
+				dma_task::end_ = false;
+				auto adr = reinterpret_cast<uint32_t>(buff);
+				if(read) {
+					return dmac_mgr_.start_trans(SDHI::SBFA_VEC, DMAC_MGR::trans_type::SN_DP_32,
+						SDHI::SDBUFR.address, adr, count * (512 / 4), true);
+				} else {
+					return dmac_mgr_.start_trans(SDHI::SBFA_VEC, DMAC_MGR::trans_type::SP_DN_32,
+						adr, SDHI::SDBUFR.address, count * (512 / 4), true);
+				}
+			} else {
+				return false;
+			}
+		}
+
+
+		void stop_dma_() noexcept
+		{
+			if constexpr (USE_DMA) {
+				dmac_mgr_.stop();
+				SDHI::SDDMAEN = 0;
+			}
+		}
+
+
+		bool dma_end_() const noexcept
+		{
+			if constexpr (USE_DMA) {
+				return dma_task::end_ || dmac_mgr_.get_count() == 0;
+			} else {
+				return true;
+			}
+		}
+
+
 		static void cdeti_task_() noexcept {
 		}
 
@@ -323,13 +471,15 @@ namespace fatfs {
 			stat_(STA_NOINIT), card_type_(0),
 			mount_delay_(0), intr_lvl_(device::ICU::LEVEL::NONE),
 			cd_(false), mount_(false), start_(false),
-			onew_(onew), rca_id_(0)
+			onew_(onew), rca_id_(0), cid_{ 0 },
+			dmac_mgr_(), trans_(trans::NONE), trans_ret_(RES_OK), stat_trans_()
 		{ }
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	開始
+			@brief	開始 @n
+					※DMAC が指定されていて、割り込みレベルが有効なら、DMA 転送を使う。
 			@param[in]	lvl		割り込みレベル（０の場合、ポーリング）
 		 */
 		//-----------------------------------------------------------------//
@@ -359,6 +509,11 @@ namespace fatfs {
 				set_interrupt_task(nullptr, static_cast<uint32_t>(SDHI::SBFA_VEC));
 			}
 			device::icu_mgr::set_level(SDHI::SBFA_VEC, intr_lvl_);
+			if constexpr (USE_DMA) {
+				if(intr_lvl_ != device::ICU::LEVEL::NONE) {
+					dmac_mgr_.start(intr_lvl_);
+				}
+			}
 
 			start_ = true;
 		}
@@ -693,64 +848,79 @@ namespace fatfs {
 		//-----------------------------------------------------------------//
 		DRESULT disk_read(BYTE drv, void* buff, DWORD sector, UINT count) noexcept
 		{
+			auto ret = start_read(drv, buff, sector, count);
+			if(ret != RES_OK) {
+				return ret;
+			}
+			return sync_trans();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・セクター
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[in]	buff	Pointer to the data to be written	
+			@param[in]	sector	Start sector number (LBA)
+			@param[in]	count	Sector count (1..128)
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_write(BYTE drv, const void* buff, DWORD sector, UINT count) noexcept
+		{
+			auto ret = start_write(drv, buff, sector, count);
+			if(ret != RES_OK) {
+				return ret;
+			}
+			return sync_trans();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リード・セクターの開始（非同期） @n
+					※DMA が使えない場合（割り込み無し、奇数アドレス）は、@n
+					ここで転送を完了する。@n
+					※結果は「sync_trans」で受け取る、それまで「buff」を触ってはならない。
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[out]	buff	Pointer to the data buffer to store read data
+			@param[in]	sector	Start sector number (LBA)
+			@param[in]	count	Sector count (1..128)
+			@return 転送を開始できたら「RES_OK」
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT start_read(BYTE drv, void* buff, DWORD sector, UINT count) noexcept
+		{
+			if(trans_ != trans::NONE) return RES_ERROR;
+			if(count == 0) return RES_PARERR;
 			if(!SDHI::SDSTS1.SDCDMON()) return RES_NOTRDY;
 			if(disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
 
 			// Convert LBA to byte address if needed
 			if(!(card_type_ & CT_BLOCK)) sector *= 512;
 
-///			utils::format("disk_read: sector: %d, count: %d\n") % sector % count;
-
-			SDHI::SDSIZE   = 512;
-//			SDHI::SDIMSK1  = 0x0000FFFE;
-//			SDHI::SDIMSK2  = 0x00007F80;
-			SDHI::SDSTOP   = 0x00000100;  // for multi block
-			SDHI::SDBLKCNT = count;  // for multi block read
-			SDHI::SDARG    = sector;
 			command cmd = count > 1 ? command::CMD18 : command::CMD17;
-			const char* cmdstr = cmd == command::CMD17 ? "CMD17" : "CMD18";
-			SDHI::SDCMD = static_cast<uint32_t>(cmd);
-			while(SDHI::SDSTS1.RSPEND() == 0) {
-				if(SDHI::SDSTS2.CRCE()) {
-					debug_format("%s CRC Error (CRCE)\n") % cmdstr;
-					return RES_ERROR;
-				}
-				if(SDHI::SDSTS2.CMDE()) {
-					debug_format("%s Command error (CMDE)\n") % cmdstr;
-					return RES_ERROR;
-				}
-				if(SDHI::SDSTS2.RSPTO()) {
-					debug_format("%s Response Timeout (RSPTO)\n") % cmdstr;
-					return RES_ERROR;
-				}
+			bool dma = start_dma_(buff, count, true);
+			if(!send_cmd_block_(cmd, sector, count, dma)) {
+				stop_dma_();
+				return RES_ERROR;
 			}
-			SDHI::SDSTS1 = 0x0000FFFE;
-			auto sp10 = SDHI::SDRSP10();
-///			utils::format("%s: Response: %08X\n") % cmdstr % sp10;
+			stat_trans_.read_ += count;
 
-			while(count > 0) {
+			if(dma) {
+				trans_ = trans::DMA;
+				++stat_trans_.dma_;
+				return RES_OK;
+			}
 
-				uint32_t loop = 0;
-				while(SDHI::SDSTS2.BRE() == 0) {
-					if(loop >= 10000) {
-						debug_format("%s time out\n") % cmdstr;
-						return RES_ERROR;
-					}
-					auto st = SDHI::SDSTS2();
-					if(st & SDHI::SDSTS2.DTO.b()) {
-						debug_format("%s DTO error\n") % cmdstr;
-						return RES_ERROR;
-					}
-					if(st & SDHI::SDSTS2.CRCE.b()) {
-						debug_format("%s CRC error\n") % cmdstr;
-						return RES_ERROR;
-					}
-					++loop;
-					utils::delay::micro_second(100);
+			trans_ = trans::DONE;
+			trans_ret_ = RES_OK;
+			while(count > 0) {
+				if(!wait_bre_()) {
+					// 後始末をして、エラーを返す（DMA 経路と同じ）
+					trans_ret_ = RES_ERROR;
+					return sync_trans();
 				}
-
 				SDHI::SDSTS2 = 0x0000FEFF;
-///				utils::format("%s BRE: OK\n") % cmdstr;
 
 				if((reinterpret_cast<uint32_t>(buff) & 0x3) == 0) {
 					uint32_t* p = static_cast<uint32_t*>(buff);
@@ -769,35 +939,27 @@ namespace fatfs {
 				}
 				--count;
 			}
-
-///			utils::format("Data trans: OK\n");
-
-			if(!wait_acend_()) {
-				debug_format("Read: ACEND time out\n");
-				return RES_ERROR;				
-			}
-
-			SDHI::SDSTS1 = 0x0000FFFB;
-			{
-///				auto sp10 = SDHI::SDRSP10();
-///				utils::format("Data end: 0x%08X\n") % sp10;
-			}
-
-			return count ? RES_ERROR : RES_OK;
+			return RES_OK;
 		}
 
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	ライト・セクター
+			@brief	ライト・セクターの開始（非同期） @n
+					※DMA が使えない場合（割り込み無し、奇数アドレス）は、@n
+					ここで転送を完了する。@n
+					※結果は「sync_trans」で受け取る、それまで「buff」を書き換えてはならない。
 			@param[in]	drv		Physical drive nmuber (0)
 			@param[in]	buff	Pointer to the data to be written	
 			@param[in]	sector	Start sector number (LBA)
 			@param[in]	count	Sector count (1..128)
+			@return 転送を開始できたら「RES_OK」
 		 */
 		//-----------------------------------------------------------------//
-		DRESULT disk_write(BYTE drv, const void* buff, DWORD sector, UINT count) noexcept
+		DRESULT start_write(BYTE drv, const void* buff, DWORD sector, UINT count) noexcept
 		{
+			if(trans_ != trans::NONE) return RES_ERROR;
+			if(count == 0) return RES_PARERR;
 			if(!SDHI::SDSTS1.SDCDMON()) return RES_NOTRDY;
 			if(disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
 			if(WPRT::BIT_POS != device::bitpos::NONE) {
@@ -808,44 +970,29 @@ namespace fatfs {
 
 			SDHI::SDSTS1 = 0;
 			SDHI::SDSTS2 = 0;
-			SDHI::SDSIZE = 512;
 
-			SDHI::SDSTOP   = 0x00000100;  // for multi block
-			SDHI::SDBLKCNT = count;  // for multi block read
-			SDHI::SDARG    = sector;
 			command cmd = count > 1 ? command::CMD25 : command::CMD24;
-			const char* cmdstr = cmd == command::CMD25 ? "CMD25" : "CMD24";
-			SDHI::SDCMD = static_cast<uint32_t>(cmd);
+			bool dma = start_dma_(buff, count, false);
+			if(!send_cmd_block_(cmd, sector, count, dma)) {
+				stop_dma_();
+				return RES_ERROR;
+			}
+			stat_trans_.write_ += count;
 
-			while(SDHI::SDSTS1.RSPEND() == 0) {
-				if(SDHI::SDSTS2() & (SDHI::SDSTS2.CMDE.b() | SDHI::SDSTS2.RSPTO.b())) {
-					return RES_ERROR;
-				}
+			if(dma) {
+				trans_ = trans::DMA;
+				++stat_trans_.dma_;
+				return RES_OK;
 			}
-			SDHI::SDSTS1 = 0x0000FFFE;
-//			auto sp54 = SDHI::SDRSP54();
 
+			trans_ = trans::DONE;
+			trans_ret_ = RES_OK;
 			while(count > 0) {
-
-				uint32_t loop = 0;
-				while(SDHI::SDSTS2.BWE() == 0) {
-					if(loop >= BWE_LOOP_LIMIT) {
-						debug_format("%s time out\n") % cmdstr;
-						return RES_ERROR;
-					}
-					auto st = SDHI::SDSTS2();
-					if(st & SDHI::SDSTS2.DTO.b()) {
-						debug_format("%s DTO error\n") % cmdstr;
-						return RES_ERROR;
-					}
-					if(st & SDHI::SDSTS2.CRCE.b()) {
-						debug_format("%s CRC error\n") % cmdstr;
-						return RES_ERROR;
-					}
-					++loop;
-					utils::delay::micro_second(100);
+				if(!wait_bwe_()) {
+					// 後始末をして、エラーを返す（DMA 経路と同じ）
+					trans_ret_ = RES_ERROR;
+					return sync_trans();
 				}
-
 				SDHI::SDSTS2 = 0xFDFF;
 
 				if((reinterpret_cast<uint32_t>(buff) & 0x3) == 0) {
@@ -866,18 +1013,90 @@ namespace fatfs {
 				}
 				--count;
 			}
+			return RES_OK;
+		}
 
-			if(!wait_acend_()) {
-				debug_format("Write: ACEND time out\n");
-				return RES_ERROR;				
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送中か検査（非同期）
+			@return 転送中なら「true」
+		 */
+		//-----------------------------------------------------------------//
+		bool probe_trans() const noexcept
+		{
+			if(trans_ != trans::DMA) return false;
+			if(SDHI::SDSTS2() & (SDHI::SDSTS2.DTO.b() | SDHI::SDSTS2.CRCE.b())) return false;
+			return !dma_end_();
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送の完了を待つ（非同期）
+			@return 転送結果
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT sync_trans() noexcept
+		{
+			if(trans_ == trans::NONE) return RES_OK;
+
+			DRESULT ret = RES_OK;
+			if(trans_ == trans::DMA) {
+				uint32_t loop = 0;
+				while(!dma_end_()) {
+					auto st = SDHI::SDSTS2();
+					if(st & (SDHI::SDSTS2.DTO.b() | SDHI::SDSTS2.CRCE.b())) {
+						debug_format("DMA trans error: %08X\n") % st;
+						ret = RES_ERROR;
+						break;
+					}
+					if(loop >= DMA_LOOP_LIMIT) {
+						debug_format("DMA trans time out\n");
+						ret = RES_ERROR;
+						break;
+					}
+					++loop;
+					utils::delay::micro_second(1);
+				}
+				stat_trans_.wait_ += loop;
+				stop_dma_();
+			} else {
+				ret = trans_ret_;
 			}
+			trans_ = trans::NONE;
 
+			if(!wait_acend_()) {
+				debug_format("Trans: ACEND time out\n");
+				ret = RES_ERROR;
+			}
 			SDHI::SDSTS1 = 0x0000FFFB;
-
-			return count != 0 ? RES_ERROR : RES_OK;
+			if(ret != RES_OK) {
+				++stat_trans_.error_;
+			}
+			return ret;
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送統計の取得 @n
+					※wait_ は DMA 転送の完了待ちループ数（約 1us 単位）で、@n
+					CPU が転送に拘束された時間の目安になる。
+			@return 転送統計
+		 */
+		//-----------------------------------------------------------------//
+		const stat_trans_t& get_stat_trans() const noexcept { return stat_trans_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	転送統計のリセット
+		 */
+		//-----------------------------------------------------------------//
+		void reset_stat_trans() noexcept { stat_trans_ = stat_trans_t(); }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	I/O コントロール
@@ -986,9 +1205,18 @@ namespace fatfs {
          */
         //-----------------------------------------------------------------//
         bool get_mount() const noexcept { return mount_; }
+
+
+        //-----------------------------------------------------------------//
+        /*!
+            @brief  FatFs コンテキストの取得（マウント中のみ有効）
+            @return FatFs コンテキスト
+         */
+        //-----------------------------------------------------------------//
+        const FATFS& get_fatfs() const noexcept { return fatfs_; }
 	};
 
 	// テンプレート関数、実態の定義
-	template <class SDHI, class POW, class WPRT, device::port_map::ORDER PSEL>
-		volatile uint32_t sdhi_io<SDHI, POW, WPRT, PSEL>::i_count_ = 0;
+	template <class SDHI, class POW, class WPRT, device::port_map::ORDER PSEL, class DMAC>
+		volatile uint32_t sdhi_io<SDHI, POW, WPRT, PSEL, DMAC>::i_count_ = 0;
 }
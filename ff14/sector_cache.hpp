@@ -0,0 +1,489 @@
+#pragma once
+//=====================================================================//
+/*!	@file
+	@brief	FatFs セクター・キャッシュ @n
+			disk_read/disk_write と、デバイス・ドライバー（mmc_io, sdhi_io）の間に置く。@n
+			・N-way セット・アソシアティブ（LRU）@n
+			・単一セクターの書き込みはライトバック（CTRL_SYNC、flush で書き出す）@n
+			・連続する単一セクターの読み出しを検出して先読みする @n
+			・FAT 領域のセクターはピン留めして、追い出さない
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2023 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdint>
+#include <cstring>
+#include "ff14/source/ff.h"
+#include "ff14/source/diskio.h"
+
+namespace fatfs {
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  セクター・バッファ（NUM が０なら領域を持たない）
+		@param[in]	NUM		セクター数
+		@param[in]	SIZE	セクターのサイズ
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <uint32_t NUM, uint32_t SIZE>
+	struct sector_buff {
+		uint32_t	buff_[NUM][SIZE / 4];  // DMA 転送の為、４バイト境界に置く
+
+		uint32_t* operator [] (uint32_t idx) noexcept { return buff_[idx]; }
+	};
+
+	template <uint32_t SIZE>
+	struct sector_buff<0, SIZE> {
+		uint32_t* operator [] (uint32_t /* idx */) noexcept { return nullptr; }
+	};
+
+
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	/*!
+		@brief  セクター・キャッシュ・テンプレートクラス
+		@param[in]	IO		デバイス・ドライバー・クラス（mmc_io, sdhi_io）
+		@param[in]	SETS	セット数
+		@param[in]	WAYS	ウェイ数（連想度）
+		@param[in]	AHEAD	先読みセクター数（０なら先読みしない）
+	*/
+	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+	template <class IO, uint32_t SETS = 8, uint32_t WAYS = 2, uint32_t AHEAD = 4>
+	class sector_cache {
+
+		static constexpr uint32_t SECTOR_SIZE = FF_MIN_SS;
+		static constexpr uint32_t LINES = SETS * WAYS;
+
+		static_assert(SETS > 0 && WAYS > 0, "sector_cache: SETS/WAYS must be one or more");
+
+		static constexpr uint8_t VALID = 0b001;
+		static constexpr uint8_t DIRTY = 0b010;
+		static constexpr uint8_t PIN   = 0b100;
+
+	public:
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		/*!
+			@brief	キャッシュ統計
+		*/
+		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
+		struct stat_t {
+			uint32_t	hit_;			///< ヒット数
+			uint32_t	miss_;			///< ミス数
+			uint32_t	evict_;			///< 追い出し数
+			uint32_t	write_back_;	///< ライトバック数
+			uint32_t	ahead_;			///< 先読み回数
+			uint32_t	read_cmd_;		///< デバイスへの読み出し要求数
+			uint32_t	write_cmd_;		///< デバイスへの書き込み要求数
+
+			stat_t() noexcept : hit_(0), miss_(0), evict_(0), write_back_(0), ahead_(0),
+				read_cmd_(0), write_cmd_(0) { }
+		};
+
+	private:
+		struct line_t {
+			LBA_t		sector_;
+			uint32_t	time_;
+			uint8_t		flags_;
+		};
+
+		IO&			io_;
+
+		line_t		line_[LINES];
+		uint32_t	buff_[LINES][SECTOR_SIZE / 4];  // DMA 転送の為、４バイト境界に置く
+		sector_buff<(AHEAD > 0 ? AHEAD + 1 : 0), SECTOR_SIZE>	ahead_buff_;  // 先読みしない場合は無し
+
+		BYTE		drv_;
+		uint32_t	time_;
+		LBA_t		last_;
+		LBA_t		pin_org_;
+		LBA_t		pin_end_;
+		LBA_t		sector_num_;
+		stat_t		stat_;
+
+		int find_(LBA_t sector) const noexcept
+		{
+			uint32_t i = (sector % SETS) * WAYS;
+			for(uint32_t w = 0; w < WAYS; ++w) {
+				const auto& t = line_[i + w];
+				if((t.flags_ & VALID) != 0 && t.sector_ == sector) {
+					return i + w;
+				}
+			}
+			return -1;
+		}
+
+
+		bool pin_area_(LBA_t sector) const noexcept
+		{
+			return pin_org_ <= sector && sector < pin_end_;
+		}
+
+
+		// ピン留め可能か（各セットに、最低１ウェイは残す）
+		bool pin_ok_(LBA_t sector) const noexcept
+		{
+			uint32_t i = (sector % SETS) * WAYS;
+			uint32_t n = 0;
+			for(uint32_t w = 0; w < WAYS; ++w) {
+				if(line_[i + w].flags_ & PIN) ++n;
+			}
+			return (n + 1) < WAYS;
+		}
+
+
+		bool write_back_(uint32_t idx) noexcept
+		{
+			auto& t = line_[idx];
+			++stat_.write_cmd_;
+			if(io_.disk_write(drv_, reinterpret_cast<const BYTE*>(buff_[idx]), t.sector_, 1) != RES_OK) {
+				return false;
+			}
+			t.flags_ &= ~DIRTY;
+			++stat_.write_back_;
+			return true;
+		}
+
+
+		// 追い出す候補を選ぶ（空き、又は、ピン留めされていない LRU）
+		int victim_(LBA_t sector) noexcept
+		{
+			uint32_t i = (sector % SETS) * WAYS;
+			int idx = -1;
+			for(uint32_t w = 0; w < WAYS; ++w) {
+				const auto& t = line_[i + w];
+				if((t.flags_ & VALID) == 0) {
+					return i + w;
+				}
+				if(t.flags_ & PIN) continue;
+				if(idx < 0 || static_cast<int32_t>(t.time_ - line_[idx].time_) < 0) {
+					idx = i + w;
+				}
+			}
+			if(idx < 0) return -1;
+
+			if(line_[idx].flags_ & DIRTY) {
+				if(!write_back_(idx)) return -1;
+			}
+			++stat_.evict_;
+			return idx;
+		}
+
+
+		int insert_(LBA_t sector, const void* src, uint8_t flags) noexcept
+		{
+			auto idx = victim_(sector);
+			if(idx < 0) return -1;
+
+			if(pin_area_(sector) && pin_ok_(sector)) {
+				flags |= PIN;
+			}
+			auto& t = line_[idx];
+			t.flags_ = 0;
+			std::memcpy(buff_[idx], src, SECTOR_SIZE);
+			t.sector_ = sector;
+			t.time_ = ++time_;
+			t.flags_ = VALID | flags;
+			return idx;
+		}
+
+
+		// 要求セクターから AHEAD セクターを、まとめて読み込む
+		DRESULT read_ahead_(BYTE* buff, LBA_t sector) noexcept
+		{
+			if(sector_num_ == 0) {
+				DWORD n = 0;
+				if(io_.disk_ioctl(drv_, GET_SECTOR_COUNT, &n) != RES_OK || n == 0) {
+					n = static_cast<DWORD>(-1);
+				}
+				sector_num_ = n;
+			}
+			uint32_t num = AHEAD + 1;
+			if(sector >= sector_num_) {
+				num = 1;
+			} else if((sector_num_ - sector) < num) {
+				num = sector_num_ - sector;
+			}
+
+			++stat_.read_cmd_;
+			auto ret = io_.disk_read(drv_, reinterpret_cast<BYTE*>(ahead_buff_[0]), sector, num);
+			if(ret != RES_OK) {
+				return ret;
+			}
+			std::memcpy(buff, ahead_buff_[0], SECTOR_SIZE);
+			insert_(sector, ahead_buff_[0], 0);
+			for(uint32_t i = 1; i < num; ++i) {
+				if(find_(sector + i) < 0) {  // キャッシュ済み（書き換え済み）は上書きしない
+					insert_(sector + i, ahead_buff_[i], 0);
+				}
+			}
+			++stat_.ahead_;
+			return RES_OK;
+		}
+
+	public:
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	コンストラクター
+			@param[in]	io	デバイス・ドライバー
+		 */
+		//-----------------------------------------------------------------//
+		sector_cache(IO& io) noexcept : io_(io), line_{ }, buff_{ }, ahead_buff_{ },
+			drv_(0), time_(0), last_(0), pin_org_(0), pin_end_(0), sector_num_(0), stat_()
+		{ }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ピン留めする領域の設定 @n
+					※通常は FAT 領域を指定する。
+			@param[in]	org	開始セクター
+			@param[in]	num	セクター数
+		 */
+		//-----------------------------------------------------------------//
+		void set_pin(LBA_t org, LBA_t num) noexcept
+		{
+			pin_org_ = org;
+			pin_end_ = org + num;
+			for(auto& t : line_) {
+				t.flags_ &= ~PIN;
+			}
+			for(auto& t : line_) {
+				if((t.flags_ & VALID) != 0 && pin_area_(t.sector_) && pin_ok_(t.sector_)) {
+					t.flags_ |= PIN;
+				}
+			}
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	FAT 領域をピン留めする @n
+					※マウント後、f_getfree などで得た FATFS を渡す。
+			@param[in]	fs	FATFS 構造体
+		 */
+		//-----------------------------------------------------------------//
+		void set_pin(const FATFS* fs) noexcept
+		{
+			if(fs == nullptr) {
+				set_pin(0, 0);
+				return;
+			}
+			set_pin(fs->fatbase, static_cast<LBA_t>(fs->fsize) * fs->n_fats);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	書き換えられたセクターを全て書き出す
+			@return 成功なら「RES_OK」
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT flush() noexcept
+		{
+			DRESULT ret = RES_OK;
+			for(uint32_t i = 0; i < LINES; ++i) {
+				if((line_[i].flags_ & (VALID | DIRTY)) == (VALID | DIRTY)) {
+					if(!write_back_(i)) ret = RES_ERROR;
+				}
+			}
+			return ret;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュを無効にする（書き出しはしない） @n
+					※カードの交換時など
+		 */
+		//-----------------------------------------------------------------//
+		void invalidate() noexcept
+		{
+			for(auto& t : line_) {
+				t.flags_ = 0;
+			}
+			last_ = 0;
+			sector_num_ = 0;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	初期化
+			@param[in]	drv		Physical drive nmuber (0)
+			@return ステータス
+		 */
+		//-----------------------------------------------------------------//
+		DSTATUS disk_initialize(BYTE drv) noexcept
+		{
+			invalidate();
+			return io_.disk_initialize(drv);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ステータス
+			@param[in]	drv		Physical drive nmuber (0)
+			@return ステータス
+		 */
+		//-----------------------------------------------------------------//
+		DSTATUS disk_status(BYTE drv) const noexcept { return io_.disk_status(drv); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	リード・セクター @n
+					※複数セクターの読み出しは、デバイスから直接読み、@n
+					キャッシュにある（新しい）内容で上書きする。
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[out]	buff	Pointer to the data buffer to store read data
+			@param[in]	sector	Start sector number (LBA)
+			@param[in]	count	Sector count (1..128)
+			@return 結果
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_read(BYTE drv, BYTE* buff, LBA_t sector, UINT count) noexcept
+		{
+			drv_ = drv;
+			if(count == 1) {
+				auto idx = find_(sector);
+				if(idx >= 0) {
+					++stat_.hit_;
+					line_[idx].time_ = ++time_;
+					std::memcpy(buff, buff_[idx], SECTOR_SIZE);
+					last_ = sector;
+					return RES_OK;
+				}
+				++stat_.miss_;
+				bool seq = sector == (last_ + 1);
+				last_ = sector;
+				if(AHEAD > 0 && seq) {
+					return read_ahead_(buff, sector);
+				}
+				++stat_.read_cmd_;
+				auto ret = io_.disk_read(drv, buff, sector, 1);
+				if(ret == RES_OK) {
+					insert_(sector, buff, 0);
+				}
+				return ret;
+			}
+
+			++stat_.read_cmd_;
+			auto ret = io_.disk_read(drv, buff, sector, count);
+			if(ret != RES_OK) {
+				return ret;
+			}
+			for(UINT i = 0; i < count; ++i) {
+				auto idx = find_(sector + i);
+				if(idx >= 0 && (line_[idx].flags_ & DIRTY) != 0) {
+					std::memcpy(buff + i * SECTOR_SIZE, buff_[idx], SECTOR_SIZE);
+				}
+			}
+			last_ = sector + count - 1;
+			return RES_OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ライト・セクター @n
+					※単一セクターはキャッシュに書き、複数セクターはデバイスへ直接書く。
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[in]	buff	Pointer to the data to be written
+			@param[in]	sector	Start sector number (LBA)
+			@param[in]	count	Sector count (1..128)
+			@return 結果
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_write(BYTE drv, const BYTE* buff, LBA_t sector, UINT count) noexcept
+		{
+			drv_ = drv;
+			if(count == 1) {
+				auto idx = find_(sector);
+				if(idx >= 0) {
+					++stat_.hit_;
+					auto& t = line_[idx];
+					std::memcpy(buff_[idx], buff, SECTOR_SIZE);
+					t.time_ = ++time_;
+					t.flags_ |= DIRTY;
+					return RES_OK;
+				}
+				++stat_.miss_;
+				if(insert_(sector, buff, DIRTY) >= 0) {
+					return RES_OK;
+				}
+			}
+
+			// 直接書き込み、キャッシュにあれば内容を合わせる
+			++stat_.write_cmd_;
+			auto ret = io_.disk_write(drv, buff, sector, count);
+			if(ret != RES_OK) {
+				return ret;
+			}
+			for(UINT i = 0; i < count; ++i) {
+				auto idx = find_(sector + i);
+				if(idx >= 0) {
+					std::memcpy(buff_[idx], buff + i * SECTOR_SIZE, SECTOR_SIZE);
+					line_[idx].flags_ &= ~DIRTY;
+				}
+			}
+			return RES_OK;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	I/O コントロール @n
+					※CTRL_SYNC で、書き換えられたセクターを書き出す。
+			@param[in]	drv		Physical drive nmuber (0)
+			@param[in]	ctrl	Control code
+			@param[in]	buff	Buffer to send/receive control data
+			@return 結果
+		 */
+		//-----------------------------------------------------------------//
+		DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void* buff) noexcept
+		{
+			drv_ = drv;
+			if(ctrl == CTRL_SYNC) {
+				auto ret = flush();
+				auto st = io_.disk_ioctl(drv, ctrl, buff);
+				return ret != RES_OK ? ret : st;
+			}
+			return io_.disk_ioctl(drv, ctrl, buff);
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュ統計の取得
+			@return キャッシュ統計
+		 */
+		//-----------------------------------------------------------------//
+		const stat_t& get_stat() const noexcept { return stat_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	キャッシュ統計のリセット
+		 */
+		//-----------------------------------------------------------------//
+		void reset_stat() noexcept { stat_ = stat_t(); }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	書き出されていないセクター数を取得
+			@return セクター数
+		 */
+		//-----------------------------------------------------------------//
+		uint32_t get_dirty_num() const noexcept
+		{
+			uint32_t n = 0;
+			for(const auto& t : line_) {
+				if((t.flags_ & (VALID | DIRTY)) == (VALID | DIRTY)) ++n;
+			}
+			return n;
+		}
+	};
+}
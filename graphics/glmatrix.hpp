@@ -341,7 +341,7 @@ namespace gl {
 		 */
 		//-----------------------------------------------------------------//
 		const matrix_type& get_projection_matrix() const {
-			return acc_[mode::projection];
+			return acc_[static_cast<int>(mode::projection)];
 		};
 
 
@@ -352,7 +352,7 @@ namespace gl {
 		 */
 		//-----------------------------------------------------------------//
 		const matrix_type& get_modelview_matrix() const {
-			return acc_[mode::modelview];
+			return acc_[static_cast<int>(mode::modelview)];
 		};
 
 
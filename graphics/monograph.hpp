@@ -1,14 +1,21 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	モノクロ・グラフィックス・クラス
+	@brief	モノクロ・グラフィックス・クラス @n
+			・フレームバッファは、SSD1306/SH1106/ST7565/UC1701 と同じページ（縦８ドット） @n
+			  単位の並び。 @n
+			・塗りつぶし、反転、イメージ（フォント）描画は、ページ内のバイト単位で処理する。 @n
+			・書き換えたページを記録し、チップドライバーの「flush」で変更ページだけ転送できる。 @n
+			  lcd_.flush(bitmap_.fb(), bitmap_.get_dirty()); @n
+			  bitmap_.clear_dirty();
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2016, 2017 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2016, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
 #include <cstdint>
+#include <cstring>
 
 namespace graphics {
 
@@ -50,21 +57,99 @@ namespace graphics {
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 	template <uint16_t WIDTH, uint16_t HEIGHT, class AFONT = afont_null, class KFONT = kfont_null>
 	class monograph {
+	public:
+		static constexpr uint16_t PAGE_NUM = HEIGHT / 8;	///< ページ数
+
+		static_assert(PAGE_NUM <= 32, "HEIGHT is too large for dirty page tracking.");
 
+	private:
 		KFONT& kfont_;
 
 		uint8_t	fb_[WIDTH * HEIGHT / 8];
 
+		uint32_t	dirty_;
+
 		uint16_t	code_;
 		uint8_t		cnt_;
 
+		enum class span_op : uint8_t {
+			SET,
+			RESET,
+			REVERSE,
+		};
+
+		bool clip_(int16_t& x, int16_t& y, int16_t& w, int16_t& h) const
+		{
+			if(x < 0) { w += x; x = 0; }
+			if(y < 0) { h += y; y = 0; }
+			if((x + w) > static_cast<int16_t>(WIDTH)) w = WIDTH - x;
+			if((y + h) > static_cast<int16_t>(HEIGHT)) h = HEIGHT - y;
+			return w > 0 && h > 0;
+		}
+
+		// ページ内の水平スパン（m: ページ内の縦方向マスク）
+		void span_(int16_t x, int16_t w, uint16_t page, uint8_t m, span_op op)
+		{
+			uint8_t* p = &fb_[page * WIDTH + x];
+			dirty_ |= 1 << page;
+			switch(op) {
+			case span_op::SET:
+				if(m == 0xff) {
+					std::memset(p, 0xff, w);
+				} else {
+					while(w > 0) { *p++ |= m; --w; }
+				}
+				break;
+			case span_op::RESET:
+				if(m == 0xff) {
+					std::memset(p, 0x00, w);
+				} else {
+					m = ~m;
+					while(w > 0) { *p++ &= m; --w; }
+				}
+				break;
+			case span_op::REVERSE:
+				if(m == 0xff) {
+					while(w > 0 && (reinterpret_cast<uintptr_t>(p) & 3) != 0) { *p++ ^= 0xff; --w; }
+					auto q = reinterpret_cast<uint32_t*>(p);
+					while(w >= 4) { *q++ ^= 0xffffffff; w -= 4; }
+					p = reinterpret_cast<uint8_t*>(q);
+				}
+				while(w > 0) { *p++ ^= m; --w; }
+				break;
+			}
+		}
+
+		void rect_(int16_t x, int16_t y, int16_t w, int16_t h, span_op op)
+		{
+#ifdef LED16X16
+			for(int16_t i = y; i < (y + h); ++i) {
+				for(int16_t j = x; j < (x + w); ++j) {
+					if(op == span_op::SET) point_set(j, i);
+					else if(op == span_op::RESET) point_reset(j, i);
+					else point_reverse(j, i);
+				}
+			}
+#else
+			if(!clip_(x, y, w, h)) return;
+			int16_t ye = y + h;
+			for(uint16_t page = y >> 3; page <= ((ye - 1) >> 3); ++page) {
+				int16_t top = page * 8;
+				uint8_t m = 0xff;
+				if(y > top) m &= 0xff << (y - top);
+				if(ye < (top + 8)) m &= 0xff >> (top + 8 - ye);
+				span_(x, w, page, m, op);
+			}
+#endif
+		}
+
 	public:
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	コンストラクター
 		*/
 		//-----------------------------------------------------------------//
-		monograph(KFONT& kf) : kfont_(kf), code_(0), cnt_(0) { }
+		monograph(KFONT& kf) : kfont_(kf), dirty_(0), code_(0), cnt_(0) { }
 
 
 		//-----------------------------------------------------------------//
@@ -136,7 +221,35 @@ namespace graphics {
 			@return フレームバッファのページ数
 		*/
 		//-----------------------------------------------------------------//
-		uint8_t page_num() const { return HEIGHT / 8; }
+		uint8_t page_num() const { return PAGE_NUM; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	書き換えたページを取得
+			@return 書き換えたページのビット列（ビット０がページ０）
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_dirty() const { return dirty_; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	書き換えページの記録を消去（転送後に呼ぶ）
+		*/
+		//-----------------------------------------------------------------//
+		void clear_dirty() { dirty_ = 0; }
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	全ページを書き換えとして記録（全画面を転送させる）
+		*/
+		//-----------------------------------------------------------------//
+		void mark_dirty() {
+			if(PAGE_NUM >= 32) dirty_ = 0xffffffff;
+			else dirty_ = (1 << PAGE_NUM) - 1;
+		}
 
 
 		//-----------------------------------------------------------------//
@@ -149,10 +262,11 @@ namespace graphics {
 		void point_set(int16_t x, int16_t y) {
 			if(static_cast<uint16_t>(x) >= WIDTH) return;
 			if(static_cast<uint16_t>(y) >= HEIGHT) return;
+			dirty_ |= 1 << (y >> 3);
 #ifdef LED16X16
 			fb_[((x & 8) >> 3) + (y << 1)] |= (1 << (x & 7));
 #else
-			fb_[((y & 0xf8) << 4) + x] |= (1 << (y & 7));
+			fb_[(y >> 3) * WIDTH + x] |= (1 << (y & 7));
 #endif
 		}
 
@@ -167,10 +281,11 @@ namespace graphics {
 		void point_reset(int16_t x, int16_t y) {
 			if(static_cast<uint16_t>(x) >= WIDTH) return;
 			if(static_cast<uint16_t>(y) >= HEIGHT) return;
+			dirty_ |= 1 << (y >> 3);
 #ifdef LED16X16
 			fb_[((x & 8) >> 3) + (y << 1)] &= ~(1 << (x & 7));
 #else
-			fb_[((y & 0xf8) << 4) + x] &= ~(1 << (y & 7));
+			fb_[(y >> 3) * WIDTH + x] &= ~(1 << (y & 7));
 #endif
 		}
 
@@ -185,10 +300,11 @@ namespace graphics {
 		void point_reverse(int16_t x, int16_t y) {
 			if(static_cast<uint16_t>(x) >= WIDTH) return;
 			if(static_cast<uint16_t>(y) >= HEIGHT) return;
+			dirty_ |= 1 << (y >> 3);
 #ifdef LED16X16
 			fb_[((x & 8) >> 3) + (y << 1)] ^= (1 << (x & 7));
 #else
-			fb_[((y & 0xf8) << 4) + x] ^= (1 << (y & 7));
+			fb_[(y >> 3) * WIDTH + x] ^= (1 << (y & 7));
 #endif
 		}
 
@@ -204,19 +320,7 @@ namespace graphics {
 		*/
 		//-----------------------------------------------------------------//
 		void fill(int16_t x, int16_t y, int16_t w, int16_t h, bool c) {
-			if(c) {
-				for(int16_t i = y; i < (y + h); ++i) {
-					for(int16_t j = x; j < (x + w); ++j) {
-						point_set(j, i);
-					}
-				}
-			} else {
-				for(int16_t i = y; i < (y + h); ++i) {
-					for(int16_t j = x; j < (x + w); ++j) {
-						point_reset(j, i);
-					}
-				}
-			}
+			rect_(x, y, w, h, c ? span_op::SET : span_op::RESET);
 		}
 
 
@@ -230,11 +334,7 @@ namespace graphics {
 		*/
 		//-----------------------------------------------------------------//
 		void reverse(int16_t x, int16_t y, int16_t w, int16_t h) {
-			for(int16_t i = y; i < (y + h); ++i) {
-				for(int16_t j = x; j < (x + w); ++j) {
-					point_reverse(j, i);
-				}
-			}
+			rect_(x, y, w, h, span_op::REVERSE);
 		}
 
 
@@ -245,9 +345,8 @@ namespace graphics {
 		*/
 		//-----------------------------------------------------------------//
 		void flash(uint8_t c) {
-			for(uint16_t i = 0; i < (WIDTH * HEIGHT / 8); ++i) {
-				fb_[i] = c;
-			}
+			std::memset(fb_, c, sizeof(fb_));
+			mark_dirty();
 		}
 
 
@@ -320,23 +419,13 @@ namespace graphics {
 		*/
 		//-----------------------------------------------------------------//
 		void frame(int16_t x, int16_t y, int16_t w, int16_t h, bool c) {
-			for(int16_t i = 0; i < w; ++i) {
-				if(c) {
-					point_set(x + i, y);
-					point_set(x + i, y + h - 1);
-				} else {
-					point_reset(x + i, y);
-					point_reset(x + i, y + h - 1);
-				}
+			if(w > 0) {
+				fill(x, y, w, 1, c);
+				fill(x, y + h - 1, w, 1, c);
 			}
-			for(int16_t i = 0; i < h; ++i) {
-				if(c) {
-					point_set(x, y + i);
-					point_set(x + w - 1, y + i);
-				} else {
-					point_reset(x, y + i);
-					point_reset(x + w - 1, y + i);
-				}
+			if(h > 0) {
+				fill(x, y, 1, h, c);
+				fill(x + w - 1, y, 1, h, c);
 			}
 		}
 
@@ -356,6 +445,48 @@ namespace graphics {
 			if(img == nullptr) return;
 
 			const uint8_t* p = static_cast<const uint8_t*>(img);
+#ifndef LED16X16
+			// 縦の並び（カラム）に変換して、ページ単位で OR する
+			if(w <= 32 && h <= 24) {
+				uint32_t col[32];
+				for(uint8_t j = 0; j < w; ++j) col[j] = 0;
+				uint8_t k = 1;
+				uint8_t c = *p++;
+				for(uint8_t i = 0; i < h; ++i) {
+					for(uint8_t j = 0; j < w; ++j) {
+						if(c & k) col[j] |= 1 << i;
+						k <<= 1;
+						if(k == 0) {
+							k = 1;
+							c = *p++;
+						}
+					}
+				}
+				for(uint8_t j = 0; j < w; ++j) {
+					int16_t xx = x + j;
+					if(static_cast<uint16_t>(xx) >= WIDTH) continue;
+					uint32_t v = col[j];
+					int16_t yy = y;
+					if(yy < 0) {
+						if(yy <= -static_cast<int16_t>(h)) return;
+						v >>= -yy;
+						yy = 0;
+					}
+					v <<= yy & 7;
+					uint16_t page = yy >> 3;
+					while(v != 0 && page < PAGE_NUM) {
+						uint8_t b = v;
+						if(b != 0) {
+							fb_[page * WIDTH + xx] |= b;
+							dirty_ |= 1 << page;
+						}
+						v >>= 8;
+						++page;
+					}
+				}
+				return;
+			}
+#endif
 			uint8_t k = 1;
 			uint8_t c = *p++;
 			for(uint8_t i = 0; i < h; ++i) {
@@ -557,6 +688,33 @@ namespace graphics {
 			h -= 2;
 			++y;
 			w -= 2;
+#ifndef LED16X16
+			fill(x, y, w, h, false);
+			int16_t n = l < w ? l : w;
+			// 市松模様（（i ^ j) & 1 の点）をカラム毎のバイトパターンで描く
+			int16_t cx = x;
+			int16_t cy = y;
+			int16_t cw = n;
+			int16_t ch = h;
+			if(clip_(cx, cy, cw, ch)) {
+				int16_t ye = cy + ch;
+				for(uint16_t page = cy >> 3; page <= ((ye - 1) >> 3); ++page) {
+					int16_t top = page * 8;
+					uint8_t m = 0xff;
+					if(cy > top) m &= 0xff << (cy - top);
+					if(ye < (top + 8)) m &= 0xff >> (top + 8 - ye);
+					uint8_t* p = &fb_[page * WIDTH + cx];
+					for(int16_t i = cx - x; i < (cx - x + cw); ++i) {
+						uint8_t pat = ((i ^ (top - y)) & 1) ? 0x55 : 0xaa;
+						*p++ |= pat & m;
+					}
+					dirty_ |= 1 << page;
+				}
+			}
+			if(l < w && l != 0) {
+				fill(x + l, y, 1, h, true);
+			}
+#else
 			for(uint8_t j = 0; j < h; ++j) {
 				for(uint8_t i = 0; i < w; ++i) {
 					if(i < l) {
@@ -572,6 +730,7 @@ namespace graphics {
 					}
 				}
 			}
+#endif
 		}
 	};
 }
@@ -3,11 +3,12 @@
 /*!	@file
 	@brief	3D Shape
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2021 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2021, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
+#include <cmath>
 #include "common/vtx.hpp"
 #include "graphics/color.hpp"
 #include "graphics/tgl_base.hpp"
@@ -68,22 +69,30 @@ namespace graphics {
 	    	for(int i = 5; i >= 0; i--) {
 	    		tgl_.Color(c[i]);
         		tgl_.Begin(prim);
-//        		tgl_.Normal(&n[i]);
+        		tgl_.Normal(n[i]);
 				tgl_.TexCoord(vtx::fpos(0.0f, 0.0f));
         		tgl_.Vertex(v[faces[i][0]]);
-//        		tgl_.Normal(&n[i]);
+        		tgl_.Normal(n[i]);
 				tgl_.TexCoord(vtx::fpos(1.0f, 0.0f));
         		tgl_.Vertex(v[faces[i][1]]);
-//        		tgl_.Normal(&n[i]);
+        		tgl_.Normal(n[i]);
 				tgl_.TexCoord(vtx::fpos(1.0f, 1.0f));
         		tgl_.Vertex(v[faces[i][2]]);
-//        		tgl_.Normal(&n[i]);
+        		tgl_.Normal(n[i]);
 				tgl_.TexCoord(vtx::fpos(0.0f, 1.0f));
         		tgl_.Vertex(v[faces[i][3]]);
         		tgl_.End();
   	    	}
 	    }
 
+		void sphere_vertex_(const vtx::fvtx& rad, float a, float b) noexcept
+		{
+			vtx::fvtx p(std::cos(a) * std::cos(b), std::sin(a) * std::cos(b), std::sin(b));
+			// 楕円体の法線は、各軸の半径で割った方向
+			tgl_.Normal(vtx::normalize(vtx::fvtx(p.x / rad.x, p.y / rad.y, p.z / rad.z)));
+			tgl_.Vertex(vtx::fvtx(p.x * rad.x, p.y * rad.y, p.z * rad.z));
+		}
+
 #if 0
 		void create_dome_vertex_(const vtx::fvtx& rad, uint32_t div)
 		{
@@ -156,7 +165,7 @@ namespace graphics {
 		/*!
 			@brief	塗りつぶされた球の描画
             @param[in] rad		半径
-            @param[in] div		分割数（最小８）
+            @param[in] div		分割数（最小８、頂点が入りきらない場合は減らす）
 		*/
 		//-----------------------------------------------------------------//
 		void SolidSphere(const vtx::fvtx& rad, uint32_t div)
@@ -164,17 +173,30 @@ namespace graphics {
 			if(rad.x <= 0.0f || rad.y <= 0.0f || rad.z <= 0.0f) return;
 
 			if(div < 8) div = 8;
-#if 0
-			create_dome_vertex_(rad, div);
-			for(uint32_t i = div; i < vertices_.size(); ++i) {
-				auto v = vertices_[i];
-				v.position.z = -v.position.z;
-				v.normal = vtx::normalize(v.position);
-				vertices_.push_back(v);
+			div &= ~1;
+			// 頂点数は 2 x div x div、入りきらない場合は分割数を減らす
+			uint32_t space = tgl_.get_vertex_space();
+			while(div > 8 && (2 * div * div) > space) div -= 2;
+			if((2 * div * div) > space) return;
+
+			// 経度 div 分割、緯度 div / 2 分割の帯を４角形で描画
+			uint32_t qd = div / 2;
+			float da = vtx::get_pi<float>() * 2.0f / static_cast<float>(div);
+			float db = vtx::get_pi<float>() / static_cast<float>(qd);
+			for(uint32_t j = 0; j < qd; ++j) {
+				float b0 = static_cast<float>(j) * db - vtx::get_pi<float>() * 0.5f;
+				float b1 = b0 + db;
+				tgl_.Begin(PTYPE::QUAD);
+				for(uint32_t i = 0; i < div; ++i) {
+					float a0 = static_cast<float>(i) * da;
+					float a1 = a0 + da;
+					sphere_vertex_(rad, a0, b0);
+					sphere_vertex_(rad, a1, b0);
+					sphere_vertex_(rad, a1, b1);
+					sphere_vertex_(rad, a0, b1);
+				}
+				tgl_.End();
 			}
-			make_triangle_sphere_();
-			gen_glbuffer_();
-#endif
 		}
     };
 }
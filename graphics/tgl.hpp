@@ -1,13 +1,17 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	Tiny 3D Glaphics Library (Tiny OpenGL)
+	@brief	Tiny 3D Glaphics Library (Tiny OpenGL) @n
+			・頂点変換は、描画前に全頂点をまとめて行う（SoA 配置）@n
+			・視錐台でクリッピングし、裏面除去を行う @n
+			・Z バッファ、グーロー・シェーディングは、ソフトウェアで描画する
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2018, 2021 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2018, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
+#include <cmath>
 #include "common/vtx.hpp"
 #include "graphics/color.hpp"
 #include "graphics/glmatrix.hpp"
@@ -42,6 +46,14 @@ namespace graphics {
 		uint32_t	vtx_idx_;
 		vtx_t		vtxs_[VNUM];
 
+		// 変換済み頂点（クリップ座標、SoA）
+		float		cx_[VNUM];
+		float		cy_[VNUM];
+		float		cz_[VNUM];
+		float		cw_[VNUM];
+		uint8_t		code_[VNUM];	// 視錐台のアウト・コード
+		uint8_t		lum_[VNUM];		// 輝度（0～255）
+
 		// プリミティブ関係
 		struct dt_t {
 			PTYPE		pt_;
@@ -79,20 +91,395 @@ namespace graphics {
 
 		uint32_t	flags_;
 
-		bool test_cw_(const vtx::spos* p, int32_t num) noexcept
+		vtx::fvtx	light_;		// 光源の方向（視点座標系、正規化）
+		float		ambient_;	// 環境光
+
+		uint16_t*	depth_;		// Z バッファ（フレームバッファと同じ並び）
+
+		// クリップ座標の頂点
+		struct cv_t {
+			float	x;
+			float	y;
+			float	z;
+			float	w;
+			float	l;	// 輝度
+		};
+
+		// スクリーン座標の頂点（x, y は 1/16 ピクセル）
+		struct pv_t {
+			int32_t	x;
+			int32_t	y;
+			int32_t	z;	// 0～65535
+			int32_t	l;	// 0～255
+		};
+
+		static constexpr uint32_t CLIP_MAX = 16;  // クリップ後の最大頂点数
+
+		// ビューポート（1/16 ピクセル）
+		int32_t		vp_ox_;
+		int32_t		vp_oy_;
+		int32_t		vp_w_;
+		int32_t		vp_h_;
+
+		bool get_flag_(CTRL ctrl) const noexcept { return (flags_ & (1 << static_cast<uint32_t>(ctrl))) != 0; }
+
+
+		static float plane_(const cv_t& v, uint32_t pl) noexcept
+		{
+			switch(pl) {
+			case 0: return v.w + v.x;
+			case 1: return v.w - v.x;
+			case 2: return v.w + v.y;
+			case 3: return v.w - v.y;
+			case 4: return v.w + v.z;  // near
+			default: return v.w - v.z;  // far
+			}
+		}
+
+
+		static uint8_t out_code_(const cv_t& v) noexcept
+		{
+			uint8_t code = 0;
+			for(uint32_t pl = 0; pl < 6; ++pl) {
+				if(plane_(v, pl) < 0.0f) code |= 1 << pl;
+			}
+			return code;
+		}
+
+
+		static cv_t lerp_(const cv_t& a, const cv_t& b, float t) noexcept
+		{
+			cv_t v;
+			v.x = a.x + (b.x - a.x) * t;
+			v.y = a.y + (b.y - a.y) * t;
+			v.z = a.z + (b.z - a.z) * t;
+			v.w = a.w + (b.w - a.w) * t;
+			v.l = a.l + (b.l - a.l) * t;
+			return v;
+		}
+
+
+		// 全頂点の変換（行列、法線の計算を一括で行う）
+		void transform_() noexcept
+		{
+			MATRIX::matrix_type wm;
+			matrix_.world_matrix(wm);
+			const float* m = wm();
+
+			for(uint32_t i = 0; i < vtx_idx_; ++i) {
+				const auto& p = vtxs_[i].p_;
+				cx_[i] = m[0] * p.x + m[4] * p.y + m[ 8] * p.z + m[12];
+				cy_[i] = m[1] * p.x + m[5] * p.y + m[ 9] * p.z + m[13];
+				cz_[i] = m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14];
+				cw_[i] = m[3] * p.x + m[7] * p.y + m[11] * p.z + m[15];
+			}
+			for(uint32_t i = 0; i < vtx_idx_; ++i) {
+				cv_t v = { cx_[i], cy_[i], cz_[i], cw_[i], 0.0f };
+				code_[i] = out_code_(v);
+			}
+
+			if(!get_flag_(CTRL::LIGHTING)) return;
+
+			const float* mm = matrix_.get_modelview_matrix()();
+			for(uint32_t i = 0; i < vtx_idx_; ++i) {
+				if(!vtxs_[i].normal_) {
+					lum_[i] = 255;
+					continue;
+				}
+				const auto& n = vtxs_[i].n_;
+				float x = mm[0] * n.x + mm[4] * n.y + mm[ 8] * n.z;
+				float y = mm[1] * n.x + mm[5] * n.y + mm[ 9] * n.z;
+				float z = mm[2] * n.x + mm[6] * n.y + mm[10] * n.z;
+				float len = x * x + y * y + z * z;
+				float d = 0.0f;
+				if(len > 0.0f) {
+					d = (x * light_.x + y * light_.y + z * light_.z) / std::sqrt(len);
+					if(d < 0.0f) d = 0.0f;
+				}
+				float l = ambient_ + (1.0f - ambient_) * d;
+				if(l > 1.0f) l = 1.0f;
+				lum_[i] = static_cast<uint8_t>(l * 255.0f);
+			}
+		}
+
+
+		cv_t get_cv_(uint32_t idx) const noexcept
+		{
+			cv_t v = { cx_[idx], cy_[idx], cz_[idx], cw_[idx], static_cast<float>(lum_[idx]) };
+			return v;
+		}
+
+
+		pv_t project_(const cv_t& v) const noexcept
+		{
+			float iw = 1.0f / v.w;
+			pv_t p;
+			p.x = static_cast<int32_t>(v.x * iw * vp_w_) + (vp_w_ / 2) + vp_ox_;
+			p.y = static_cast<int32_t>(v.y * iw * vp_h_) + (vp_h_ / 2) + vp_oy_;
+			int32_t z = static_cast<int32_t>((v.z * iw * 0.5f + 0.5f) * 65535.0f);
+			if(z < 0) z = 0; else if(z > 65535) z = 65535;
+			p.z = z;
+			p.l = static_cast<int32_t>(v.l);
+			return p;
+		}
+
+
+		// 多角形を視錐台でクリップ（Sutherland–Hodgman）
+		static uint32_t clip_poly_(cv_t* poly, uint32_t n, uint8_t code) noexcept
 		{
-			for(int32_t i = 0; i < (num - 1); ++i) {
-				auto n = i + 1;
-				if(p[i].y >= p[n].y) {
-					if(p[i].x < p[n].x) return true;  // CW
-					else if(p[i].x > p[n].x) return false;  // CCW
-				} else {
-					if(p[i].x > p[n].x) return true;  // CW
-					else if(p[i].x < p[n].x) return false;  // CCW
+			cv_t tmp[CLIP_MAX];
+			for(uint32_t pl = 0; pl < 6; ++pl) {
+				if((code & (1 << pl)) == 0) continue;
+				uint32_t m = 0;
+				for(uint32_t i = 0; i < n; ++i) {
+					const auto& a = poly[i];
+					const auto& b = poly[(i + 1) % n];
+					auto da = plane_(a, pl);
+					auto db = plane_(b, pl);
+					if(da >= 0.0f) {
+						if(m < CLIP_MAX) tmp[m++] = a;
+					}
+					if((da >= 0.0f) != (db >= 0.0f)) {
+						if(m < CLIP_MAX) tmp[m++] = lerp_(a, b, da / (da - db));
+					}
 				}
+				n = m;
+				for(uint32_t i = 0; i < n; ++i) poly[i] = tmp[i];
+				if(n < 3) return 0;
 			}
-			// 判定が出来ない場合は「false」
-			return false;
+			return n;
+		}
+
+
+		// 線分を視錐台でクリップ
+		static bool clip_line_(cv_t& a, cv_t& b, uint8_t code) noexcept
+		{
+			float t0 = 0.0f;
+			float t1 = 1.0f;
+			for(uint32_t pl = 0; pl < 6; ++pl) {
+				if((code & (1 << pl)) == 0) continue;
+				auto da = plane_(a, pl);
+				auto db = plane_(b, pl);
+				if(da < 0.0f && db < 0.0f) return false;
+				float t = da / (da - db);
+				if(da < 0.0f) {
+					if(t > t0) t0 = t;
+				} else if(db < 0.0f) {
+					if(t < t1) t1 = t;
+				}
+			}
+			if(t0 > t1) return false;
+			cv_t aa = lerp_(a, b, t0);
+			cv_t bb = lerp_(a, b, t1);
+			a = aa;
+			b = bb;
+			return true;
+		}
+
+
+		// 符号付き面積（反時計回りが正）
+		static int32_t area_(const pv_t* p, uint32_t n) noexcept
+		{
+			int32_t a = 0;
+			for(uint32_t i = 0; i < n; ++i) {
+				const auto& s = p[i];
+				const auto& t = p[(i + 1) % n];
+				a += (s.x * t.y - t.x * s.y) >> 4;
+			}
+			return a;
+		}
+
+
+		static uint16_t shade_(uint16_t c, int32_t l) noexcept
+		{
+			uint32_t r = (((c >> 11) & 0x1f) * l) >> 8;
+			uint32_t g = (((c >>  5) & 0x3f) * l) >> 8;
+			uint32_t b = (( c        & 0x1f) * l) >> 8;
+			return (r << 11) | (g << 5) | b;
+		}
+
+
+		// トップ・レフト規則（上辺、左辺以外は、辺上のピクセルを含めない）
+		static int32_t edge_bias_(int32_t dx, int32_t dy) noexcept
+		{
+			return (dy < 0 || (dy == 0 && dx > 0)) ? 0 : -1;
+		}
+
+
+		// 三角形のラスタライズ（ハーフスペース、Z バッファ、グーロー）
+		// 共有する辺のピクセルは、トップ・レフト規則で片方の三角形だけが描く
+		void raster_tri_(const pv_t& a, pv_t b, pv_t c, uint16_t col) noexcept
+		{
+			typedef typename RDR::glc_type GLC;
+
+			int32_t area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			if(area == 0) return;
+			if(area < 0) {
+				std::swap(b, c);
+				area = -area;
+			}
+
+			// ピクセル単位の範囲（ビューポートと画面でクリップ）
+			int32_t x0 = std::min(a.x, std::min(b.x, c.x)) >> 4;
+			int32_t x1 = (std::max(a.x, std::max(b.x, c.x)) + 15) >> 4;
+			int32_t y0 = std::min(a.y, std::min(b.y, c.y)) >> 4;
+			int32_t y1 = (std::max(a.y, std::max(b.y, c.y)) + 15) >> 4;
+			x0 = std::max(x0, std::max(vp_ox_ >> 4, static_cast<int32_t>(0)));
+			y0 = std::max(y0, std::max(vp_oy_ >> 4, static_cast<int32_t>(0)));
+			x1 = std::min(x1, std::min((vp_ox_ + vp_w_) >> 4, static_cast<int32_t>(GLC::width)));
+			y1 = std::min(y1, std::min((vp_oy_ + vp_h_) >> 4, static_cast<int32_t>(GLC::height)));
+			if(x0 >= x1 || y0 >= y1) return;
+
+			// Z、輝度の勾配（1 ピクセル当たり、Z は 8 ビット、輝度は 16 ビットの小数部）
+			float ia = 16.0f / static_cast<float>(area);
+			float zb = b.z - a.z;
+			float zc = c.z - a.z;
+			float lb = b.l - a.l;
+			float lc = c.l - a.l;
+			float bx = b.x - a.x;
+			float by = b.y - a.y;
+			float cx = c.x - a.x;
+			float cy = c.y - a.y;
+			float dzdx = (zb * cy - zc * by) * ia;
+			float dzdy = (zc * bx - zb * cx) * ia;
+			float dldx = (lb * cy - lc * by) * ia;
+			float dldy = (lc * bx - lb * cx) * ia;
+
+			int32_t px = (x0 << 4) + 8;
+			int32_t py = (y0 << 4) + 8;
+			float ox = static_cast<float>(px - a.x) / 16.0f;
+			float oy = static_cast<float>(py - a.y) / 16.0f;
+			int32_t zr = static_cast<int32_t>((a.z + dzdx * ox + dzdy * oy) * 256.0f);
+			int32_t lr = static_cast<int32_t>((a.l + dldx * ox + dldy * oy) * 65536.0f);
+			int32_t zdx = static_cast<int32_t>(dzdx * 256.0f);
+			int32_t zdy = static_cast<int32_t>(dzdy * 256.0f);
+			int32_t ldx = static_cast<int32_t>(dldx * 65536.0f);
+			int32_t ldy = static_cast<int32_t>(dldy * 65536.0f);
+
+			// エッジ関数（内側で全て正）
+			int32_t e0 = (c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x);
+			int32_t e1 = (a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x);
+			int32_t e2 = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+			e0 += edge_bias_(c.x - b.x, c.y - b.y);
+			e1 += edge_bias_(a.x - c.x, a.y - c.y);
+			e2 += edge_bias_(b.x - a.x, b.y - a.y);
+			int32_t e0dx = -(c.y - b.y) << 4;
+			int32_t e1dx = -(a.y - c.y) << 4;
+			int32_t e2dx = -(b.y - a.y) << 4;
+			int32_t e0dy = (c.x - b.x) << 4;
+			int32_t e1dy = (a.x - c.x) << 4;
+			int32_t e2dy = (b.x - a.x) << 4;
+
+			auto* fb = rdr_.at_fb();
+			bool depth = depth_ != nullptr && get_flag_(CTRL::DEPTH_TEST);
+			bool light = get_flag_(CTRL::LIGHTING);
+			for(int32_t y = y0; y < y1; ++y) {
+				int32_t f0 = e0;
+				int32_t f1 = e1;
+				int32_t f2 = e2;
+				int32_t z = zr;
+				int32_t l = lr;
+				uint32_t ofs = y * GLC::line_width + x0;
+				for(int32_t x = x0; x < x1; ++x) {
+					if((f0 | f1 | f2) >= 0) {
+						bool draw = true;
+						if(depth) {
+							int32_t zz = z >> 8;
+							if(zz < 0) zz = 0; else if(zz > 65535) zz = 65535;
+							if(zz < depth_[ofs]) {
+								depth_[ofs] = zz;
+							} else {
+								draw = false;
+							}
+						}
+						if(draw) {
+							if(light) {
+								int32_t ll = l >> 16;
+								if(ll < 0) ll = 0; else if(ll > 255) ll = 255;
+								fb[ofs] = shade_(col, ll);
+							} else {
+								fb[ofs] = col;
+							}
+						}
+					}
+					f0 += e0dx;
+					f1 += e1dx;
+					f2 += e2dx;
+					z += zdx;
+					l += ldx;
+					++ofs;
+				}
+				e0 += e0dy;
+				e1 += e1dy;
+				e2 += e2dy;
+				zr += zdy;
+				lr += ldy;
+			}
+		}
+
+
+		// 多角形（三角形、４角形）の描画
+		void draw_poly_(const uint32_t* idx, uint32_t n, const share_color& col, bool soft) noexcept
+		{
+			uint8_t cand = 0xff;
+			uint8_t cor  = 0;
+			for(uint32_t i = 0; i < n; ++i) {
+				cand &= code_[idx[i]];
+				cor  |= code_[idx[i]];
+			}
+			if(cand != 0) return;  // 全て視錐台の外
+
+			cv_t cv[CLIP_MAX];
+			for(uint32_t i = 0; i < n; ++i) {
+				cv[i] = get_cv_(idx[i]);
+			}
+			bool clip = false;
+			if(cor != 0) {
+				n = clip_poly_(cv, n, cor);
+				if(n < 3) return;
+				clip = true;
+			}
+
+			pv_t pv[CLIP_MAX];
+			for(uint32_t i = 0; i < n; ++i) {
+				pv[i] = project_(cv[i]);
+			}
+			if(get_flag_(CTRL::CULL_FACE) && area_(pv, n) <= 0) return;
+
+			if(soft) {
+				for(uint32_t i = 1; i < (n - 1); ++i) {
+					raster_tri_(pv[0], pv[i], pv[i + 1], col.rgb565);
+				}
+				return;
+			}
+
+			vtx::spos sp[CLIP_MAX];
+			for(uint32_t i = 0; i < n; ++i) {
+				sp[i].set(pv[i].x, pv[i].y);
+			}
+			if(!clip && n == 4) {
+				rdr_.quad_d(sp[0], sp[1], sp[2], sp[3], true);
+			} else {
+				for(uint32_t i = 1; i < (n - 1); ++i) {
+					rdr_.triangle_d(sp[0], sp[i], sp[i + 1], true);
+				}
+			}
+		}
+
+
+		void draw_line_(uint32_t i0, uint32_t i1) noexcept
+		{
+			if((code_[i0] & code_[i1]) != 0) return;
+
+			auto a = get_cv_(i0);
+			auto b = get_cv_(i1);
+			auto cor = code_[i0] | code_[i1];
+			if(cor != 0) {
+				if(!clip_line_(a, b, cor)) return;
+			}
+			auto pa = project_(a);
+			auto pb = project_(b);
+			rdr_.line_d(vtx::spos(pa.x, pa.y), vtx::spos(pb.x, pb.y));
 		}
 
 	public:
@@ -108,7 +495,10 @@ namespace graphics {
 			color_(0, 0, 0),
 			matrix_(),
 			tex_{ }, bind_hnd_(TNUM),
-			flags_(0)
+			flags_(0),
+			light_(0.0f, 0.0f, 1.0f), ambient_(0.2f),
+			depth_(nullptr),
+			vp_ox_(0), vp_oy_(0), vp_w_(0), vp_h_(0)
 		{ }
 
 
@@ -161,6 +551,8 @@ namespace graphics {
 		//-----------------------------------------------------------------//
 		void End() noexcept
 		{
+			if(dt_idx_ >= PNUM) return;
+
 			if(dts_[dt_idx_].org_ == vtx_idx_) {
 				return;
 			}
@@ -169,6 +561,15 @@ namespace graphics {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	登録できる残りの頂点数を取得
+			@return	残りの頂点数
+		*/
+		//-----------------------------------------------------------------//
+		uint32_t get_vertex_space() const noexcept { return VNUM - vtx_idx_; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	色設定
@@ -346,9 +747,44 @@ namespace graphics {
 		//-----------------------------------------------------------------//
 		void enable(CTRL ctrl, bool ena = true) noexcept
 		{
+			if(ena) {
+				flags_ |= 1 << static_cast<uint32_t>(ctrl);
+			} else {
+				flags_ &= ~(1 << static_cast<uint32_t>(ctrl));
+			}
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	光源の設定（平行光源）
+			@param[in]	dir		光源への方向（視点座標系）
+			@param[in]	amb		環境光（0.0 ～ 1.0）
+		*/
+		//-----------------------------------------------------------------//
+		void Light(const vtx::fvtx& dir, float amb = 0.2f) noexcept
+		{
+			float len = std::sqrt(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+			if(len > 0.0f) {
+				light_.x = dir.x / len;
+				light_.y = dir.y / len;
+				light_.z = dir.z / len;
+			}
+			ambient_ = amb;
+		}
+
+
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	Z バッファの設定 @n
+					※フレームバッファと同じ並び（line_width x height）の領域を渡す。@n
+					※renderring 毎に、ビューポートの範囲を消去する。
+			@param[in]	depth	Z バッファ（nullptr なら使わない）
+		*/
+		//-----------------------------------------------------------------//
+		void set_depth_buffer(uint16_t* depth) noexcept { depth_ = depth; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	マトリックス・クラスへの参照
@@ -360,78 +796,83 @@ namespace graphics {
 
 		//-----------------------------------------------------------------//
 		/*!
-			@brief	レンダリング
+			@brief	レンダリング @n
+					※CTRL::DEPTH_TEST、CTRL::LIGHTING が有効な場合、三角形、４角形は @n
+					ソフトウェアで描画し、それ以外は DRW2D で描画する。
 		*/
 		//-----------------------------------------------------------------//
 		void renderring() noexcept
 		{
-			MATRIX::matrix_type wm;
-			matrix_.world_matrix(wm);
+			typedef typename RDR::glc_type GLC;
 
 			int ox;
 			int oy;
 			int w;
 			int h;
 			matrix_.get_viewport(ox, oy, w, h);  // drw2d for fixed point
-			ox <<= 4;
-			oy <<= 4;
-			w <<= 4;
-			h <<= 4;
+			vp_ox_ = ox << 4;
+			vp_oy_ = oy << 4;
+			vp_w_ = w << 4;
+			vp_h_ = h << 4;
+
+			transform_();
+
+			bool soft = get_flag_(CTRL::DEPTH_TEST) || get_flag_(CTRL::LIGHTING);
+			if(soft) {
+				rdr_.flush();  // DRW2D の描画完了を待つ
+				if(depth_ != nullptr && get_flag_(CTRL::DEPTH_TEST)) {
+					int32_t x0 = std::max(ox, 0);
+					int32_t y0 = std::max(oy, 0);
+					int32_t x1 = std::min(ox + w, static_cast<int>(GLC::width));
+					int32_t y1 = std::min(oy + h, static_cast<int>(GLC::height));
+					for(int32_t y = y0; y < y1; ++y) {
+						auto* p = &depth_[y * GLC::line_width];
+						for(int32_t x = x0; x < x1; ++x) p[x] = 0xffff;
+					}
+				}
+			}
 
 			rdr_.set_back_color(def_color::Black);
 
+			rdr_.set_texture(tex_[0].image_, tex_[0].size_, d2_mode_rgba8888);
+
 			for(uint32_t i = 0; i < dt_idx_; ++i) {
 				const auto& t = dts_[i];
 				rdr_.set_fore_color(t.col_);
 
-
-				rdr_.set_texture(tex_[0].image_, tex_[0].size_, d2_mode_rgba8888);
-
-
-				uint32_t k = 0;
-				vtx::spos tmp[16];
-				for(uint32_t j = t.org_; j < t.end_; ++j) {
-					vtx::fvtx dst;
-					matrix_.vertex_screen(wm, vtxs_[j].p_, dst);
-					tmp[k].x = static_cast<int16_t>(dst.x * w) + (w / 2) + ox;
-					tmp[k].y = static_cast<int16_t>(dst.y * h) + (h / 2) + oy;
-					++k;
-					{
-						vtx::fvtx4 dst;
-						const auto& st = vtxs_[j].t_;
-						matrix_.vertex_world(wm, vtx::fvtx(st.x, st.y, 0.0f), dst);
-					}
-				}
+				uint32_t k = t.end_ - t.org_;
+				uint32_t o = t.org_;
 				switch(t.pt_) {
 				case PTYPE::POINTS:
 
 					break;
 				case PTYPE::LINES:
-					for(uint32_t j = 0; j < k; j += 2) {
-						rdr_.line_d(tmp[j], tmp[j+1]);
+					for(uint32_t j = 0; (j + 1) < k; j += 2) {
+						draw_line_(o + j, o + j + 1);
 					}
 					break;
 				case PTYPE::LINE_STRIP:
-					for(uint32_t j = 0; j < (k - 1); ++j) {
-						rdr_.line_d(tmp[j], tmp[j+1]);
+					for(uint32_t j = 0; (j + 1) < k; ++j) {
+						draw_line_(o + j, o + j + 1);
 					}
 					break;
 				case PTYPE::LINE_LOOP:
-					// if(!test_cw_(tmp, k)) break;  // ccw を描画しない
 					for(uint32_t j = 0; j < k; ++j) {
 						auto n = j + 1;
 						if(n >= k) n = 0;
-						rdr_.line_d(tmp[j], tmp[n]);
+						draw_line_(o + j, o + n);
 					}
 					break;
 				case PTYPE::QUAD:
-					for(uint32_t j = 0; j < k; j += 4) {
-						rdr_.quad_d(tmp[j+0], tmp[j+1], tmp[j+2], tmp[j+3], true);
+					for(uint32_t j = 0; (j + 3) < k; j += 4) {
+						uint32_t idx[4] = { o + j, o + j + 1, o + j + 2, o + j + 3 };
+						draw_poly_(idx, 4, t.col_, soft);
 					}
 					break;
 				case PTYPE::TRIANGLE:
-					for(uint32_t j = 0; j < k; j += 3) {
-						rdr_.triangle_d(tmp[j+0], tmp[j+1], tmp[j+2], true);
+					for(uint32_t j = 0; (j + 2) < k; j += 3) {
+						uint32_t idx[3] = { o + j, o + j + 1, o + j + 2 };
+						draw_poly_(idx, 3, t.col_, soft);
 					}
 					break;
 				default:
@@ -441,6 +882,10 @@ namespace graphics {
 
 			dt_idx_ = 0;
 			vtx_idx_ = 0;
+			for(uint32_t i = 0; i < VNUM; ++i) {
+				vtxs_[i].normal_ = false;
+				vtxs_[i].texture_ = false;
+			}
 		}
 	};
 }
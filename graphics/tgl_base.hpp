@@ -3,7 +3,7 @@
 /*!	@file
 	@brief	Tiny 3D Glaphics Library (Tiny OpenGL)
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2021 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2021, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -44,6 +44,9 @@ namespace graphics {
 		//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
 		enum class CTRL : uint8_t {
 			NONE,
+			CULL_FACE,		///< 裏面（時計回り）を描画しない
+			DEPTH_TEST,		///< Z バッファを使う（ソフトウェア描画）
+			LIGHTING,		///< 頂点の法線でグーロー・シェーディング（ソフトウェア描画）
 		};
 
 
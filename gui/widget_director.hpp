@@ -1,14 +1,18 @@
 #pragma once
 //=====================================================================//
 /*!	@file
-	@brief	Widget ディレクター
+	@brief	Widget ディレクター @n
+			・タッチは、フィルター後のタッチ点（get_point）を使う。 @n
+			・at_gesture_func を設定すると、タッチクラスのジェスチャー・イベントを @n
+			  その位置にある widget と共に通知する。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2019, 2022 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2019, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
 //=====================================================================//
 #include <array>
+#include <functional>
 #include "gui/widget.hpp"
 #include "gui/group.hpp"
 #include "gui/frame.hpp"
@@ -60,6 +64,9 @@ namespace gui {
 
 		typedef std::array<widget_t, WNUM> WIDGETS; 
 
+		typedef typename TOUCH::gesture_t GESTURE;
+		typedef std::function<void(const GESTURE& g, widget* w)> GESTURE_FUNC_TYPE;
+
 	private:
 		using GLC = typename RDR::glc_type;
 
@@ -72,6 +79,22 @@ namespace gui {
 
 		widget*		current_;
 
+		GESTURE_FUNC_TYPE	gesture_func_;
+
+
+		// 位置にある widget（後に登録した物が手前）
+		widget* find_(const vtx::spos& pos) noexcept
+		{
+			widget* w = nullptr;
+			for(auto& t : widgets_) {
+				if(t.w_ == nullptr) continue;
+				if(t.w_->get_state() != widget::STATE::ENABLE) continue;
+				auto loc = vtx::srect(t.w_->get_final_position(), t.w_->get_location().size);
+				if(loc.is_focus(pos)) w = t.w_;
+			}
+			return w;
+		}
+
 
 		// ipass 自分を含めない場合「false」
 		// 「子」のリストを作成
@@ -122,10 +145,21 @@ namespace gui {
 		//-----------------------------------------------------------------//
 		widget_director(RDR& rdr, TOUCH& touch) noexcept :
 			rdr_(rdr), touch_(touch), widgets_(),
-			back_color_(graphics::def_color::Black), current_(nullptr)
+			back_color_(graphics::def_color::Black), current_(nullptr),
+			gesture_func_()
 		{ }
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	ジェスチャー関数への参照 @n
+					設定すると、update でジェスチャー・イベントを全て取り出す。
+			@return ジェスチャー関数
+		*/
+		//-----------------------------------------------------------------//
+		GESTURE_FUNC_TYPE& at_gesture_func() noexcept { return gesture_func_; }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	全クリア
@@ -302,8 +336,8 @@ namespace gui {
 		{
 			// 状態の生成とGUIへ反映
 			{
-				auto num = touch_.get_touch_num();
-				const auto& tp = touch_.get_touch_pos(0);
+				auto num = touch_.get_point_num();
+				const auto& tp = touch_.get_primary();
 				for(auto& t : widgets_) {
 					if(t.w_ == nullptr) continue;
 					if(!t.init_) {  // 初期化プロセス
@@ -336,6 +370,13 @@ namespace gui {
 				}
 			}
 
+			if(gesture_func_) {
+				GESTURE g;
+				while(touch_.get_gesture(g)) {
+					gesture_func_(g, find_(g.pos));
+				}
+			}
+
 			for(auto& t : widgets_) {
 				if(t.w_ == nullptr) continue;
 				if(t.w_->get_state() == widget::STATE::ENABLE) {
@@ -0,0 +1,192 @@
+//=====================================================================//
+/*!	@file
+	@brief	utils::flash_man のホスト・テスト @n
+			・データ・フラッシュのモデル（消去前の上書きを検出）の上で動かす。 @n
+			・索引が一杯の時、新しいキーの書き込みは消去を繰り返さずに失敗する事。 @n
+			・読み出しエラーでのマウントが、内容を壊さない事。 @n
+			・ランダムな書き込み／削除／再マウント／GC で、内容が一致する事。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2023 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/flash_man.hpp"
+
+namespace {
+
+	// device::flash_io のデータ・フラッシュ部分のモデル
+	struct flash_model {
+		static constexpr uint32_t DATA_SIZE = 32768;
+		static constexpr uint32_t DATA_BLOCK_SIZE = 64;
+
+		uint8_t		mem[DATA_SIZE];
+		bool		erased[DATA_SIZE];
+		uint32_t	erase_count;
+		uint32_t	fail_at;	// この回数目の read を失敗させる（０なら無効）
+		uint32_t	reads;
+
+		flash_model() : erase_count(0), fail_at(0), reads(0)
+		{
+			memset(mem, 0xff, sizeof(mem));
+			for(auto& e : erased) e = true;
+		}
+
+		bool read(uint32_t org, void* dst, uint32_t len)
+		{
+			if(fail_at != 0 && ++reads == fail_at) return false;
+			memcpy(dst, &mem[org], len);
+			return true;
+		}
+
+		bool write(uint32_t org, const void* src, uint32_t len)
+		{
+			for(uint32_t i = 0; i < len; ++i) {
+				if(!erased[org + i]) {
+					printf("  overwrite without erase: %u\n", org + i);
+					abort();
+				}
+				erased[org + i] = false;
+			}
+			memcpy(&mem[org], src, len);
+			return true;
+		}
+
+		bool erase(uint32_t org)
+		{
+			++erase_count;
+			memset(&mem[org], 0xff, DATA_BLOCK_SIZE);
+			for(uint32_t i = 0; i < DATA_BLOCK_SIZE; ++i) erased[org + i] = true;
+			return true;
+		}
+
+		bool erase_check(uint32_t org, uint32_t len = DATA_BLOCK_SIZE)
+		{
+			for(uint32_t i = 0; i < len; ++i) {
+				if(!erased[org + i]) return false;
+			}
+			return true;
+		}
+	};
+
+	typedef utils::flash_man<flash_model, 8, 4> FLASH_MAN;
+
+	flash_model	fio_;
+	FLASH_MAN	fm_(fio_);
+
+
+	bool full_index_test_()
+	{
+		fm_.format();
+		uint32_t v = 0;
+		for(uint16_t k = 0; k < 8; ++k) {
+			v = k;
+			if(!fm_.write(k, &v, 4)) {
+				printf("  full: write(%u) fail\n", k);
+				return false;
+			}
+		}
+
+		// 索引が一杯：新しいキーは失敗し、既存キーの更新は続けられる
+		auto org = fio_.erase_count;
+		uint32_t new_ok = 0;
+		for(uint32_t i = 0; i < 100; ++i) {
+			v = i;
+			if(fm_.write(100 + i, &v, 4)) ++new_ok;
+			for(uint16_t k = 0; k < 8; ++k) {
+				if(!fm_.write(k, &v, 4)) {
+					printf("  full: update(%u) fail\n", k);
+					return false;
+				}
+			}
+		}
+		// 既存キーの更新 800 回分の GC だけで済む事
+		auto erases = fio_.erase_count - org;
+		if(new_ok != 0 || erases > 200) {
+			printf("  full: new-key ok %u, erases %u\n", new_ok, erases);
+			return false;
+		}
+
+		// 削除すれば、新しいキーを書ける
+		fm_.remove(3);
+		if(!fm_.write(200, &v, 4)) {
+			printf("  full: write after remove fail\n");
+			return false;
+		}
+		fm_.remove(200);
+		return true;
+	}
+
+
+	bool read_fail_test_()
+	{
+		// full_index_test_ の後の状態（キー 3 以外は 99）
+		for(uint32_t f = 1; f < 400; f += 7) {
+			fio_.fail_at = f;
+			fio_.reads = 0;
+			fm_.mount();
+			fio_.fail_at = 0;
+			fm_.mount();
+			for(uint16_t k = 0; k < 8; ++k) {
+				if(k == 3) continue;
+				uint32_t r = 0;
+				if(fm_.read(k, &r, 4) != 4 || r != 99) {
+					printf("  read fail at %u: key %u lost\n", f, k);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+
+	bool stress_test_()
+	{
+		fm_.format();
+		static constexpr uint16_t KEYS = 16;
+		uint32_t shadow[KEYS];
+		bool has[KEYS] = { };
+		for(uint32_t it = 0; it < 200000; ++it) {
+			uint16_t k = rand() % KEYS;
+			if((rand() % 4) == 0) {
+				if(fm_.remove(k)) has[k] = false;
+			} else {
+				uint32_t x = rand();
+				uint32_t buf[8];
+				for(auto& b : buf) b = x;
+				uint32_t len = 4 + (rand() % 8) * 4;
+				if(fm_.write(k, buf, len)) {
+					has[k] = true;
+					shadow[k] = x;
+				}
+			}
+			if((it % 997) == 0) fm_.mount();
+			if((it % 3) == 0) fm_.service();
+
+			for(uint16_t j = 0; j < KEYS; ++j) {
+				bool p = fm_.probe(j);
+				uint32_t r = 0;
+				if(p != has[j] || (p && (fm_.read(j, &r, 4) != 4 || r != shadow[j]))) {
+					printf("  stress: iteration %u, key %u mismatch\n", it, j);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+
+int main()
+{
+	srand(1);
+
+	bool ok = full_index_test_() && read_fail_test_() && stress_test_();
+
+	printf("  %s\n", ok ? "pass" : "fail");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+//=====================================================================//
+/*!	@file
+	@brief	utils::scheduler のホスト・テスト @n
+			・ランダムなティックの進み（取りこぼし有り）で、タイマーが期限の @n
+			  service で１回だけ起動される事を確認する。 @n
+			・カウンターの折り返し、２段目からのカスケード、再設定、停止も含む。 @n
+			・post による起動と、優先度順の実行を確認する。
+    @author 平松邦仁 (hira@rvf-rc45.net)
+	@copyright	Copyright (C) 2023 Kunihito Hiramatsu @n
+				Released under the MIT license @n
+				https://github.com/hirakuni45/RX/blob/master/LICENSE
+*/
+//=====================================================================//
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "common/scheduler.hpp"
+
+namespace {
+
+	static constexpr uint32_t JOB_NUM = 32;
+
+	bool timer_test_(uint32_t trial)
+	{
+		// SLOT を小さくして、２段目とカスケードを多く通す
+		utils::scheduler<JOB_NUM, 8> sch;
+		// カウンターの折り返し直前から始める
+		uint32_t now = 0xffffffff - (rand() % 5000);
+		sch.start(now);
+
+		uint32_t expect[JOB_NUM];
+		uint32_t period[JOB_NUM];
+		bool armed[JOB_NUM];
+		uint32_t fired[JOB_NUM];
+		for(uint32_t i = 0; i < JOB_NUM; ++i) {
+			sch.add([i, &fired]() { ++fired[i]; }, rand() % 4);
+		}
+
+		auto arm = [&](uint32_t i, uint32_t delay, uint32_t per) {
+			sch.start_timer(i, delay, per);
+			expect[i] = now + delay;
+			period[i] = per;
+			armed[i] = true;
+		};
+		for(uint32_t i = 0; i < JOB_NUM; ++i) {
+			uint32_t delay = 1 + rand() % ((rand() & 1) ? 20 : 3000);
+			uint32_t per = (rand() % 3) != 0 ? 0 : 1 + rand() % 200;
+			arm(i, delay, per);
+		}
+
+		for(uint32_t step = 0; step < 20000; ++step) {
+			// 時々、ティックを取りこぼす
+			now += 1 + ((rand() % 10) == 0 ? rand() % 5 : 0);
+			for(uint32_t i = 0; i < JOB_NUM; ++i) fired[i] = 0;
+			sch.service(now);
+
+			// 期限が (前回, now] にあるタイマーは、丁度１回起動される（周期の重複はまとめる）
+			for(uint32_t i = 0; i < JOB_NUM; ++i) {
+				bool due = false;
+				while(armed[i] && static_cast<int32_t>(now - expect[i]) >= 0) {
+					due = true;
+					if(period[i] > 0) expect[i] += period[i];
+					else armed[i] = false;
+				}
+				if(due != (fired[i] > 0) || fired[i] > 1) {
+					printf("  trial %u, step %u, job %u: due %d, fired %u\n",
+						trial, step, i, due, fired[i]);
+					return false;
+				}
+			}
+
+			if((rand() % 500) == 0) {
+				uint32_t i = rand() % JOB_NUM;
+				arm(i, 1 + rand() % 5000, (rand() & 1) ? 0 : 1 + rand() % 300);
+			}
+			if((rand() % 700) == 0) {
+				uint32_t i = rand() % JOB_NUM;
+				sch.stop_timer(i);
+				armed[i] = false;
+			}
+		}
+		return true;
+	}
+
+
+	bool post_test_()
+	{
+		utils::scheduler<4> sch;
+		std::vector<int> log;
+		int32_t a = -1;
+		uint32_t a_run = 0;
+		// 最初の実行で自分自身を post する
+		a = sch.add([&log, &sch, &a, &a_run]() {
+			log.push_back(0);
+			if(a_run++ == 0) sch.post(a);
+		}, 2);
+		auto b = sch.add([&log]() { log.push_back(1); }, 0);
+		// 実行中に、より高い優先度のジョブを起動する
+		auto c = sch.add([&log, &sch, b]() { log.push_back(2); sch.post(b); }, 1);
+		sch.start(0);
+
+		sch.post(a);
+		sch.post(a);  // 重複した post はまとめられる
+		sch.post(c);
+		auto n = sch.service(0);
+		// c(pri 1) -> b(pri 0, c から post) -> a(pri 2)
+		std::vector<int> ref = { 2, 1, 0 };
+		if(n != 3 || log != ref) {
+			printf("  post: run %u, order", n);
+			for(auto v : log) printf(" %d", v);
+			printf("\n");
+			return false;
+		}
+
+		// 実行済みのジョブの再 post は、次の service へ回される
+		log.clear();
+		n = sch.service(0);
+		if(n != 1 || log.size() != 1 || log[0] != 0) {
+			printf("  post: re-post not deferred (run %u)\n", n);
+			return false;
+		}
+		n = sch.service(0);
+		if(n != 0) {
+			printf("  post: spurious run %u\n", n);
+			return false;
+		}
+		return true;
+	}
+}
+
+
+int main()
+{
+	srand(3);
+
+	bool ok = true;
+	for(uint32_t trial = 0; trial < 200; ++trial) {
+		if(!timer_test_(trial)) {
+			ok = false;
+			break;
+		}
+	}
+	if(!post_test_()) ok = false;
+
+	printf("  %s\n", ok ? "pass" : "fail");
+	return ok ? 0 : 1;
+}
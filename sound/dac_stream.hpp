@@ -5,9 +5,12 @@
 			内蔵 D/A に、連続した値を流す。 @n
 			MTU を基準タイマーとして利用する。 @n
 			DMAC を使って、D/A に値を書き込む。 @n
-			出力の GND レベルは中心電圧とする。
+			出力の GND レベルは中心電圧とする。 @n
+			SOUND_OUT の FIFO が utils::stream_fifo の場合、DMAC 終了割り込みから、 @n
+			空きを待つタスクへ通知する（FreeRTOS では、DMAC の割り込みレベルを @n
+			configMAX_SYSCALL_INTERRUPT_PRIORITY 以下にする事、MTU は制限無し）。
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2020, 2022 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2020, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -70,6 +73,7 @@ namespace sound {
 				auto p = static_cast<itv_t*>(itv_t_ptr_);
 				DMAC::DMCNT.DTE = 1;  // DMA を再スタート
 				p->wpos_ = 0;
+				p->sound_out_.notify_from_isr();
 			}
 		};
 
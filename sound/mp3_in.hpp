@@ -433,19 +433,29 @@ namespace sound {
 				mad_synth_frame(&mad_synth_, &mad_frame_);
 
 				// 1152 sample / frame
-				for(uint32_t i = 0; i < mad_synth_.pcm.length; ++i) {
-					while((out.at_fifo().size() - out.at_fifo().length()) < 64) {
+				bool mono = MAD_NCHANNELS(&mad_frame_.header) == 1;
+				uint32_t i = 0;
+				while(i < mad_synth_.pcm.length) {
+					// stream_fifo なら、空きが出来るまでタスク通知で待つ
+					while(!out.at_fifo().wait_space(64, 10)) {
 						system_delay(1);
 					}
-					typename AOUT::WAVE t;
-					if(MAD_NCHANNELS(&mad_frame_.header) == 1) {
-						t.l_ch = t.r_ch = MadFixedToSshort(mad_synth_.pcm.samples[0][i]);
-					} else {
-						t.l_ch = MadFixedToSshort(mad_synth_.pcm.samples[0][i]);
-						t.r_ch = MadFixedToSshort(mad_synth_.pcm.samples[1][i]);
+					// FIFO の連続領域へ直接書き込む
+					typename AOUT::WAVE* dst;
+					uint32_t n = out.at_fifo().reserve(dst);
+					if(n > (mad_synth_.pcm.length - i)) n = mad_synth_.pcm.length - i;
+					for(uint32_t j = 0; j < n; ++j) {
+						auto& t = dst[j];
+						if(mono) {
+							t.l_ch = t.r_ch = MadFixedToSshort(mad_synth_.pcm.samples[0][i + j]);
+						} else {
+							t.l_ch = MadFixedToSshort(mad_synth_.pcm.samples[0][i + j]);
+							t.r_ch = MadFixedToSshort(mad_synth_.pcm.samples[1][i + j]);
+						}
 					}
-					out.at_fifo().put(t);
-					++pos;
+					out.at_fifo().commit(n);
+					i += n;
+					pos += n;
 				}
 
 				{
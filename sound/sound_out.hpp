@@ -3,7 +3,7 @@
 /*!	@file
 	@brief	サウンド出力バッファ
     @author 平松邦仁 (hira@rvf-rc45.net)
-	@copyright	Copyright (C) 2018, 2020 Kunihito Hiramatsu @n
+	@copyright	Copyright (C) 2018, 2023 Kunihito Hiramatsu @n
 				Released under the MIT license @n
 				https://github.com/hirakuni45/RX/blob/master/LICENSE
 */
@@ -49,14 +49,16 @@ namespace sound {
 		@param[in]	T		基本型
 		@param[in]	BFS		fifo バッファのサイズ
 		@param[in]	OUTS	出力バッファのサイズ（外部ハードウェアの仕様による）
+		@param[in]	FIFO_T	fifo クラス（FreeRTOS では utils::stream_fifo<wave_t<T>, BFS> @n
+							にすると、デコーダー・タスクは空きを通知で待てる）
 	*/
 	//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
-	template<typename T, uint32_t BFS, uint32_t OUTS>
+	template<typename T, uint32_t BFS, uint32_t OUTS, class FIFO_T = utils::fixed_fifo<wave_t<T>, BFS>>
 	class sound_out {
 	public:
 		typedef T value_type;
 		typedef wave_t<T> WAVE;
-		typedef utils::fixed_fifo<WAVE, BFS> FIFO;
+		typedef FIFO_T FIFO;
 
 		static constexpr uint16_t PEAK_LEVEL_FRAME = 400;	///< 400 sample (48KHz : 0.5sec)
 
@@ -250,6 +252,16 @@ namespace sound {
 		}
 
 
+		//-----------------------------------------------------------------//
+		/*!
+			@brief	FIFO の空きを待っているタスクへ通知 @n
+					※FreeRTOS では、configMAX_SYSCALL_INTERRUPT_PRIORITY 以下の @n
+					割り込みから呼ぶ（service を呼ぶ割り込みより低くて良い）
+		*/
+		//-----------------------------------------------------------------//
+		void notify_from_isr() noexcept { fifo_.notify_from_isr(); }
+
+
 		//-----------------------------------------------------------------//
 		/*!
 			@brief	波形バッファサイズの取得
@@ -331,44 +331,62 @@ namespace sound {
 				}
 				if(bits_ == 16) {
 					const uint16_t* src = reinterpret_cast<const uint16_t*>(tmp);
-					for(uint32_t i = 0; i < 256; ++i) {
-						while((out.at_fifo().size() - out.at_fifo().length()) < 64) {
+					uint32_t i = 0;
+					while(i < 256) {
+						// stream_fifo なら、空きが出来るまでタスク通知で待つ
+						while(!out.at_fifo().wait_space(64, 10)) {
 							system_delay(1);
 						}
-						typename SOUND_OUT::WAVE t;
-						if(get_channel() == 2) {
-							t.l_ch = src[0];
-							t.r_ch = src[1];
-							src += 2;
-						} else {
-							t.l_ch = src[0];
-							t.r_ch = t.l_ch;
-							++src;
+						// FIFO の連続領域へ直接書き込む
+						typename SOUND_OUT::WAVE* dst;
+						uint32_t n = out.at_fifo().reserve(dst);
+						if(n > (256 - i)) n = 256 - i;
+						for(uint32_t j = 0; j < n; ++j) {
+							auto& t = dst[j];
+							if(get_channel() == 2) {
+								t.l_ch = src[0];
+								t.r_ch = src[1];
+								src += 2;
+							} else {
+								t.l_ch = src[0];
+								t.r_ch = t.l_ch;
+								++src;
+							}
 						}
-						out.at_fifo().put(t);
-						++pos;
+						out.at_fifo().commit(n);
+						i += n;
+						pos += n;
 					}
 				} else {  // 8 bits
 					const uint8_t* src = reinterpret_cast<const uint8_t*>(tmp);
-					for(uint32_t i = 0; i < 256; ++i) {
-						while((out.at_fifo().size() - out.at_fifo().length()) < 64) {
+					uint32_t i = 0;
+					while(i < 256) {
+						// stream_fifo なら、空きが出来るまでタスク通知で待つ
+						while(!out.at_fifo().wait_space(64, 10)) {
 							system_delay(1);
 						}
-						typename SOUND_OUT::WAVE t;
-						if(get_channel() == 2) {
-							t.l_ch = static_cast<uint16_t>(src[0] ^ 0x80) << 8;
-							t.l_ch |= (src[0] & 0x7f) << 1;
-							t.r_ch = static_cast<uint16_t>(src[1] ^ 0x80) << 8;
-							t.r_ch |= (src[1] & 0x7f) << 1;
-							src += 2;
-						} else {
-							t.l_ch = static_cast<uint16_t>(src[0] ^ 0x80) << 8;
-							t.l_ch |= (src[0] & 0x7f) << 1;
-							t.r_ch = t.l_ch;
-							++src;
+						// FIFO の連続領域へ直接書き込む
+						typename SOUND_OUT::WAVE* dst;
+						uint32_t n = out.at_fifo().reserve(dst);
+						if(n > (256 - i)) n = 256 - i;
+						for(uint32_t j = 0; j < n; ++j) {
+							auto& t = dst[j];
+							if(get_channel() == 2) {
+								t.l_ch = static_cast<uint16_t>(src[0] ^ 0x80) << 8;
+								t.l_ch |= (src[0] & 0x7f) << 1;
+								t.r_ch = static_cast<uint16_t>(src[1] ^ 0x80) << 8;
+								t.r_ch |= (src[1] & 0x7f) << 1;
+								src += 2;
+							} else {
+								t.l_ch = static_cast<uint16_t>(src[0] ^ 0x80) << 8;
+								t.l_ch |= (src[0] & 0x7f) << 1;
+								t.r_ch = t.l_ch;
+								++src;
+							}
 						}
-						out.at_fifo().put(t);
-						++pos;
+						out.at_fifo().commit(n);
+						i += n;
+						pos += n;
 					}
 				}
 